@@ -194,8 +194,9 @@ public:
   virtual size_t getAddressCount() const = 0;
 
   virtual size_t getWalletDepositCount() const = 0;  
-  virtual std::vector<DepositsInBlockInfo> getDeposits(const Crypto::Hash &blockHash, size_t count) const = 0;
-  virtual std::vector<DepositsInBlockInfo> getDeposits(uint32_t blockIndex, size_t count) const = 0;
+  // With skipEmptyBlocks only blocks that have wallet deposits are returned
+  virtual std::vector<DepositsInBlockInfo> getDeposits(const Crypto::Hash &blockHash, size_t count, bool skipEmptyBlocks = false) const = 0;
+  virtual std::vector<DepositsInBlockInfo> getDeposits(uint32_t blockIndex, size_t count, bool skipEmptyBlocks = false) const = 0;
 
   virtual std::string getAddress(size_t index) const = 0;
   virtual KeyPair getAddressSpendKey(size_t index) const = 0;
@@ -225,14 +226,22 @@ public:
 
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash &transactionHash) const = 0;
 
-  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash &blockHash, size_t count) const = 0;
-  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const = 0;
+  // With skipEmptyBlocks only blocks that have wallet transactions are returned
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash &blockHash, size_t count, bool skipEmptyBlocks = false) const = 0;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count, bool skipEmptyBlocks = false) const = 0;
+  // Same as getTransactions with skipEmptyBlocks, restricted to transactions carrying the given payment ID
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByPaymentId(const Crypto::Hash &paymentId, const Crypto::Hash &blockHash, size_t count) const = 0;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByPaymentId(const Crypto::Hash &paymentId, uint32_t blockIndex, size_t count) const = 0;
+  // Same as getTransactions with skipEmptyBlocks, restricted to transactions with transfers for any of the given addresses
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByAddresses(const std::vector<std::string> &addresses, const Crypto::Hash &blockHash, size_t count) const = 0;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByAddresses(const std::vector<std::string> &addresses, uint32_t blockIndex, size_t count) const = 0;
 
 
 
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const = 0;
   virtual uint32_t getBlockCount() const = 0;
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const = 0;
+  virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions(const std::vector<std::string> &addresses) const = 0;
   virtual std::vector<size_t> getDelayedTransactionIds() const = 0;
 
   virtual size_t transfer(const TransactionParameters &sendingTransaction, Crypto::SecretKey &transactionSK) = 0;
@@ -10,6 +10,7 @@
 #include <boost/range/combine.hpp>
 
 #include "Common/StringTools.h"
+#include "CryptoNoteCore/BlockSummary.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/Currency.h"
@@ -201,11 +202,11 @@ bool BlockchainExplorerDataBuilder::fillTransactionDetails(const Transaction& tr
     transactionDetails.blockHeight = blockHeight;
     transactionDetails.blockHash = blockHash;
     if (timestamp == 0) {
-      Block block;
-      if (!core.getBlockByHash(blockHash, block)) {
+      BlockSummary summary;
+      if (!core.getBlockSummary(blockHash, summary)) {
         return false;
       }
-      transactionDetails.timestamp = block.timestamp;
+      transactionDetails.timestamp = summary.timestamp;
     }
   }
 
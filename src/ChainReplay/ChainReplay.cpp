@@ -0,0 +1,280 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+#include <boost/utility/value_init.hpp>
+
+#include "CheckpointData.h"
+#include "Common/CommandLine.h"
+#include "Common/StringTools.h"
+#include "Common/Util.h"
+#include "CryptoNoteCore/Blockchain.h"
+#include "CryptoNoteCore/Checkpoints.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/ITimeProvider.h"
+#include "CryptoNoteCore/SwappedVector.h"
+#include "CryptoNoteCore/TransactionPool.h"
+#include "CryptoNoteCore/VerificationContext.h"
+#include "Logging/ConsoleLogger.h"
+#include "Logging/LoggerRef.h"
+
+namespace po = boost::program_options;
+
+using namespace CryptoNote;
+
+namespace {
+
+const command_line::arg_descriptor<uint32_t>    arg_height      = {"height", "Replay the blocks below this height, all stored blocks when 0", 0};
+const command_line::arg_descriptor<std::string> arg_checkpoints = {"checkpoints", "Replay with checkpoints (on), without them (off) or once each way (both)", "both"};
+const command_line::arg_descriptor<std::string> arg_checkpoints_file = {"checkpoints-file", "CSV file with the checkpoints to replay with instead of the default ones", ""};
+const command_line::arg_descriptor<std::string> arg_temp_dir    = {"temp-dir", "Directory the replayed blockchain is created in, the system one by default", ""};
+const command_line::arg_descriptor<uint32_t>    arg_progress    = {"progress", "Report the progress every this many blocks, never when 0", 10000};
+const command_line::arg_descriptor<bool>        arg_indexes     = {"enable-blockchain-indexes", "Build the explorer indexes while replaying, as the daemon does with this option"};
+const command_line::arg_descriptor<bool>        arg_testnet     = {"testnet", "Replay a testnet data directory"};
+const command_line::arg_descriptor<int>         arg_log_level   = {"log-level", "Log level of the replayed blockchain", Logging::WARNING};
+
+typedef std::chrono::steady_clock::duration Duration;
+typedef SwappedVector<Blockchain::BlockEntry> StoredBlocks;
+
+// The pool and the blockchain of a node, linked as the core links them
+struct ReplayNode {
+  ReplayNode(const Currency& currency, Logging::ILogger& log, bool indexes) :
+    pool(currency, blockchain, timeProvider, log), blockchain(currency, pool, log, indexes) {
+  }
+
+  RealTimeProvider timeProvider;
+  tx_memory_pool pool;
+  Blockchain blockchain;
+};
+
+struct ReplayResult {
+  uint32_t blocks;
+  uint64_t transactions;
+  Duration read;
+  Duration pool;
+  Duration addNewBlock;
+  Blockchain::BlockPushTimes pushTimes;
+};
+
+double seconds(Duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+// Feeds every stored block above the genesis one to a blockchain created empty in the directory, the way blocks come
+// from the network: the transactions go to the pool first, then the block goes to addNewBlock, which takes them out
+ReplayResult replay(const Currency& currency, StoredBlocks& source, uint32_t height, Checkpoints&& checkpoints,
+  const std::string& directory, bool indexes, uint32_t progress, Logging::ILogger& log) {
+  ReplayNode node(currency, log, indexes);
+  node.blockchain.setCheckpoints(std::move(checkpoints));
+  if (!node.blockchain.init(directory, false)) {
+    throw std::runtime_error("failed to create the blockchain in " + directory);
+  }
+
+  ReplayResult result = ReplayResult();
+  Blockchain::BlockPushTimes genesisTimes = node.blockchain.getBlockPushTimes();
+  auto progressStart = std::chrono::steady_clock::now();
+  for (uint32_t i = 1; i < height; ++i) {
+    auto readStart = std::chrono::steady_clock::now();
+    const Blockchain::BlockEntry& entry = source[i];
+    auto poolStart = std::chrono::steady_clock::now();
+    result.read += poolStart - readStart;
+    for (size_t j = 1; j < entry.transactions.size(); ++j) {
+      tx_verification_context tvc = boost::value_initialized<tx_verification_context>();
+      if (!node.pool.add_tx(entry.transactions[j].tx, tvc, true, i)) {
+        throw std::runtime_error("the transaction pool rejected transaction " +
+          Common::podToHex(entry.transactions[j].getHash()) + " of block " + std::to_string(i));
+      }
+    }
+
+    auto addStart = std::chrono::steady_clock::now();
+    result.pool += addStart - poolStart;
+    block_verification_context bvc = boost::value_initialized<block_verification_context>();
+    if (!node.blockchain.addNewBlock(entry.bl, bvc) || !bvc.m_added_to_main_chain) {
+      throw std::runtime_error("block " + std::to_string(i) + " " + Common::podToHex(entry.getHash()) +
+        " wasn't added to the main chain, a higher --log-level shows why");
+    }
+
+    auto addEnd = std::chrono::steady_clock::now();
+    result.addNewBlock += addEnd - addStart;
+    ++result.blocks;
+    result.transactions += entry.transactions.size() - 1;
+    if (progress != 0 && i % progress == 0) {
+      std::cout << "  height " << i << " of " << height << ", " << std::fixed << std::setprecision(1) <<
+        progress / seconds(addEnd - progressStart) << " blocks/s" << std::endl;
+      progressStart = addEnd;
+    }
+  }
+
+  Blockchain::BlockPushTimes pushTimes = node.blockchain.getBlockPushTimes();
+  result.pushTimes.blocks = pushTimes.blocks - genesisTimes.blocks;
+  result.pushTimes.transactions = pushTimes.transactions - genesisTimes.transactions;
+  result.pushTimes.targetCalculating = pushTimes.targetCalculating - genesisTimes.targetCalculating;
+  result.pushTimes.longhashCalculating = pushTimes.longhashCalculating - genesisTimes.longhashCalculating;
+  result.pushTimes.transactionValidation = pushTimes.transactionValidation - genesisTimes.transactionValidation;
+  result.pushTimes.indexUpdate = pushTimes.indexUpdate - genesisTimes.indexUpdate;
+  result.pushTimes.total = pushTimes.total - genesisTimes.total;
+  return result;
+}
+
+void reportPhase(const std::string& name, Duration duration, const ReplayResult& result, Duration replayTime) {
+  std::cout << "  " << std::setw(30) << std::left << name << std::right << std::fixed << std::setprecision(3) <<
+    std::setw(12) << seconds(duration) << " s" << std::setprecision(1) << std::setw(12) <<
+    seconds(duration) * 1000000 / std::max<uint32_t>(result.blocks, 1) << " us/block" << std::setw(8) <<
+    seconds(duration) * 100 / std::max(seconds(replayTime), 1e-9) << " %" << std::endl;
+}
+
+void report(const std::string& name, const ReplayResult& result) {
+  Duration replayTime = result.read + result.pool + result.addNewBlock;
+  const Blockchain::BlockPushTimes& push = result.pushTimes;
+  std::cout << name << ": " << result.blocks << " blocks, " << result.transactions << " transactions in " <<
+    std::fixed << std::setprecision(3) << seconds(replayTime) << " s" << std::endl;
+  std::cout << "  " << std::setprecision(1) << result.blocks / std::max(seconds(replayTime), 1e-9) << " blocks/s, " <<
+    result.transactions / std::max(seconds(replayTime), 1e-9) << " transactions/s" << std::endl;
+  reportPhase("reading the stored blocks", result.read, result, replayTime);
+  reportPhase("adding transactions to pool", result.pool, result, replayTime);
+  reportPhase("addNewBlock", result.addNewBlock, result, replayTime);
+  reportPhase("  target calculating", push.targetCalculating, result, replayTime);
+  reportPhase("  longhash calculating", push.longhashCalculating, result, replayTime);
+  reportPhase("  transaction validation", push.transactionValidation, result, replayTime);
+  reportPhase("  index update", push.indexUpdate, result, replayTime);
+  reportPhase("  other", result.addNewBlock - push.targetCalculating - push.longhashCalculating -
+    push.transactionValidation - push.indexUpdate, result, replayTime);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  po::options_description desc_general("General options");
+  command_line::add_arg(desc_general, command_line::arg_help);
+  po::options_description desc_params("Replay options");
+  command_line::add_arg(desc_params, command_line::arg_data_dir, Tools::getDefaultDataDirectory());
+  command_line::add_arg(desc_params, arg_height);
+  command_line::add_arg(desc_params, arg_checkpoints);
+  command_line::add_arg(desc_params, arg_checkpoints_file);
+  command_line::add_arg(desc_params, arg_temp_dir);
+  command_line::add_arg(desc_params, arg_progress);
+  command_line::add_arg(desc_params, arg_indexes);
+  command_line::add_arg(desc_params, arg_testnet);
+  command_line::add_arg(desc_params, arg_log_level);
+
+  po::options_description desc_all;
+  desc_all.add(desc_general).add(desc_params);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_all, [&]() {
+    po::store(po::parse_command_line(argc, argv, desc_all), vm);
+    if (command_line::get_arg(vm, command_line::arg_help)) {
+      std::cout << "Replays the blocks stored in a data directory into a new blockchain and measures how long adding "
+        "them takes. The daemon using the data directory must be stopped" << std::endl;
+      std::cout << desc_all << std::endl;
+      return false;
+    }
+
+    po::notify(vm);
+    return true;
+  });
+
+  if (!r) {
+    return 1;
+  }
+
+  Logging::ConsoleLogger log(static_cast<Logging::Level>(command_line::get_arg(vm, arg_log_level)));
+  boost::filesystem::path directory;
+  try {
+    std::string checkpoints = command_line::get_arg(vm, arg_checkpoints);
+    if (checkpoints != "on" && checkpoints != "off" && checkpoints != "both") {
+      throw std::runtime_error("--checkpoints must be on, off or both");
+    }
+
+    // The default checkpoints are those of the main network, the daemon doesn't use them on testnet either
+    bool testnet = command_line::get_arg(vm, arg_testnet);
+    std::string checkpointsFile = command_line::get_arg(vm, arg_checkpoints_file);
+    if (checkpoints != "off" && testnet && checkpointsFile.empty()) {
+      if (checkpoints == "on") {
+        throw std::runtime_error("there are no default checkpoints for testnet, use --checkpoints-file");
+      }
+
+      checkpoints = "off";
+    }
+
+    CurrencyBuilder currencyBuilder(log);
+    currencyBuilder.testnet(testnet);
+    Currency currency = currencyBuilder.currency();
+
+    // The stored blocks are only read, but the files would be created if they didn't exist
+    std::string dataDirectory = command_line::get_arg(vm, command_line::arg_data_dir);
+    std::string blocksFile = dataDirectory + "/" + currency.blocksFileName();
+    std::string indexesFile = dataDirectory + "/" + currency.blockIndexesFileName();
+    if (!boost::filesystem::exists(blocksFile) || !boost::filesystem::exists(indexesFile)) {
+      throw std::runtime_error("no stored blocks in " + dataDirectory);
+    }
+
+    StoredBlocks source;
+    if (!source.open(blocksFile, indexesFile, 1024)) {
+      throw std::runtime_error("failed to open the stored blocks in " + dataDirectory);
+    }
+
+    if (source.empty() || source[0].getHash() != currency.genesisBlockHash()) {
+      throw std::runtime_error("the stored blocks don't start with the genesis block of this network");
+    }
+
+    uint32_t height = static_cast<uint32_t>(source.size());
+    if (command_line::get_arg(vm, arg_height) != 0) {
+      height = std::min(height, command_line::get_arg(vm, arg_height));
+    }
+
+    std::string tempDirectory = command_line::get_arg(vm, arg_temp_dir);
+    directory = (tempDirectory.empty() ? boost::filesystem::temp_directory_path() :
+      boost::filesystem::path(tempDirectory)) / boost::filesystem::unique_path("moonbank-replay-%%%%-%%%%-%%%%");
+    bool indexes = command_line::get_arg(vm, arg_indexes);
+    uint32_t progress = command_line::get_arg(vm, arg_progress);
+    std::cout << "Replaying " << height - 1 << " blocks of " << dataDirectory << " in " << directory.string() <<
+      std::endl;
+    for (bool withCheckpoints : { false, true }) {
+      if (checkpoints != "both" && withCheckpoints != (checkpoints == "on")) {
+        continue;
+      }
+
+      Checkpoints blockchainCheckpoints(log);
+      if (withCheckpoints && !checkpointsFile.empty()) {
+        if (!blockchainCheckpoints.load_checkpoints_from_file(checkpointsFile)) {
+          throw std::runtime_error("failed to load the checkpoints from " + checkpointsFile);
+        }
+      } else if (withCheckpoints) {
+        for (const auto& checkpoint : CHECKPOINTS) {
+          blockchainCheckpoints.add_checkpoint(checkpoint.height, checkpoint.blockId);
+        }
+      }
+
+      std::string name = withCheckpoints ? "With checkpoints" : "Without checkpoints";
+      std::cout << name << "..." << std::endl;
+      ReplayResult result = replay(currency, source, height, std::move(blockchainCheckpoints), directory.string(),
+        indexes, progress, log);
+      boost::filesystem::remove_all(directory);
+      report(name, result);
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Replay failed: " << e.what() << std::endl;
+    boost::system::error_code ignore;
+    if (!directory.empty()) {
+      boost::filesystem::remove_all(directory, ignore);
+    }
+
+    return 1;
+  }
+
+  return 0;
+}
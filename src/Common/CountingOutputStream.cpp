@@ -0,0 +1,23 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "CountingOutputStream.h"
+
+namespace Common {
+
+CountingOutputStream::CountingOutputStream() : size(0) {
+}
+
+size_t CountingOutputStream::writeSome(const void* data, size_t size) {
+  this->size += size;
+  return size;
+}
+
+size_t CountingOutputStream::getSize() const {
+  return size;
+}
+
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "CpuAffinity.h"
+
+#if defined(__linux__)
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace Common {
+
+#if defined(__linux__)
+
+namespace {
+
+// Parses a kernel CPU list such as "0-3,8,10-11"
+bool parseCpuList(const std::string& text, cpu_set_t& cpus) {
+  CPU_ZERO(&cpus);
+  std::istringstream stream(text);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+
+    unsigned first;
+    unsigned last;
+    char separator;
+    std::istringstream rangeStream(range);
+    if (!(rangeStream >> first)) {
+      return false;
+    }
+
+    if (rangeStream >> separator) {
+      if (separator != '-' || !(rangeStream >> last) || last < first) {
+        return false;
+      }
+    } else {
+      last = first;
+    }
+
+    for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; ++cpu) {
+      CPU_SET(cpu, &cpus);
+    }
+  }
+
+  return true;
+}
+
+}
+
+std::vector<unsigned> getAvailableCpus(int numaNode) {
+  std::vector<unsigned> result;
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof allowed, &allowed) != 0) {
+    return result;
+  }
+
+  if (numaNode >= 0) {
+    std::ifstream file("/sys/devices/system/node/node" + std::to_string(numaNode) + "/cpulist");
+    std::string text;
+    cpu_set_t nodeCpus;
+    if (!std::getline(file, text) || !parseCpuList(text, nodeCpus)) {
+      return result;
+    }
+
+    CPU_AND(&allowed, &allowed, &nodeCpus);
+  }
+
+  for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &allowed)) {
+      result.push_back(cpu);
+    }
+  }
+
+  return result;
+}
+
+bool setThreadAffinity(const std::vector<unsigned>& cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (unsigned cpu : cpus) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &set);
+    }
+  }
+
+  return CPU_COUNT(&set) != 0 && pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0;
+}
+
+#else
+
+std::vector<unsigned> getAvailableCpus(int numaNode) {
+  return std::vector<unsigned>();
+}
+
+bool setThreadAffinity(const std::vector<unsigned>& cpus) {
+  return false;
+}
+
+#endif
+
+}
@@ -0,0 +1,22 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <vector>
+
+namespace Common {
+
+// CPUs the process may run on, only those of the NUMA node unless it is negative. Empty where it isn't known, which is
+// everywhere but on Linux
+std::vector<unsigned> getAvailableCpus(int numaNode = -1);
+// Restricts the calling thread to the CPUs, memory it touches first then comes from their NUMA node. False if the
+// platform can't do it or the CPUs can't be used
+bool setThreadAffinity(const std::vector<unsigned>& cpus);
+
+}
@@ -290,6 +290,9 @@ public:
   uint8_t* suffix();
   uint64_t suffixSize() const;
   void resizeSuffix(uint64_t newSuffixSize);
+  // Grows the suffix in place. Unlike resizeSuffix() it does not copy the file, so it is not atomic:
+  // a crash can leave a partially written tail which readers must be able to detect
+  void appendSuffix(const void* data, uint64_t dataSize);
 
   void rename(const std::string& newPath, std::error_code& ec);
   void rename(const std::string& newPath);
@@ -742,6 +745,30 @@ void FileMappedVector<T>::resizeSuffix(uint64_t newSuffixSize) {
   }
 }
 
+template<class T>
+void FileMappedVector<T>::appendSuffix(const void* data, uint64_t dataSize) {
+  assert(isOpened());
+
+  if (m_file.path() != m_path) {
+    throw std::runtime_error("Vector is mapped to a .bak file due to earlier errors");
+  }
+
+  if (dataSize == 0) {
+    return;
+  }
+
+  uint64_t oldFileSize = m_file.size();
+  m_file.resize(oldFileSize + dataSize);
+  m_suffixSize += dataSize;
+
+  const uint8_t* source = static_cast<const uint8_t*>(data);
+  std::copy(source, source + dataSize, m_file.data() + oldFileSize);
+
+  if (m_autoFlush) {
+    m_file.flush(m_file.data() + oldFileSize, dataSize);
+  }
+}
+
 template<class T>
 void FileMappedVector<T>::rename(const std::string& newPath, std::error_code& ec) {
   m_file.rename(newPath, ec);
@@ -0,0 +1,208 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Common {
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+// The format requires the last match to start at least 12 bytes before the end and the last 5 bytes to be literals
+const size_t MATCH_START_LIMIT = 12;
+const size_t LAST_LITERALS = 5;
+const unsigned HASH_BITS = 16;
+const uint32_t NO_POSITION = UINT32_MAX;
+
+uint32_t read32(const uint8_t* p) {
+  uint32_t value;
+  memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+uint32_t hash32(uint32_t value) {
+  return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+void writeLength(size_t length, std::string& out) {
+  while (length >= 255) {
+    out += static_cast<char>(255);
+    length -= 255;
+  }
+
+  out += static_cast<char>(length);
+}
+
+void writeSequence(const uint8_t* literals, size_t literalCount, size_t offset, size_t matchLength, std::string& out) {
+  size_t matchCode = matchLength - MIN_MATCH;
+  out += static_cast<char>((std::min<size_t>(literalCount, 15) << 4) | std::min<size_t>(matchCode, 15));
+  if (literalCount >= 15) {
+    writeLength(literalCount - 15, out);
+  }
+
+  out.append(reinterpret_cast<const char*>(literals), literalCount);
+  out += static_cast<char>(offset & 0xff);
+  out += static_cast<char>(offset >> 8);
+  if (matchCode >= 15) {
+    writeLength(matchCode - 15, out);
+  }
+}
+
+void writeLastLiterals(const uint8_t* literals, size_t literalCount, std::string& out) {
+  out += static_cast<char>(std::min<size_t>(literalCount, 15) << 4);
+  if (literalCount >= 15) {
+    writeLength(literalCount - 15, out);
+  }
+
+  out.append(reinterpret_cast<const char*>(literals), literalCount);
+}
+
+bool readLength(const uint8_t*& in, const uint8_t* end, size_t& length) {
+  uint8_t b;
+  do {
+    if (in == end) {
+      return false;
+    }
+
+    b = *in++;
+    length += b;
+  } while (b == 255);
+
+  return true;
+}
+
+}
+
+void lz4Compress(const void* data, size_t size, const std::string& dictionary, std::string& compressed) {
+  size_t dictionarySize = std::min(dictionary.size(), MAX_OFFSET);
+  std::vector<uint8_t> buffer(dictionarySize + size);
+  memcpy(buffer.data(), dictionary.data() + dictionary.size() - dictionarySize, dictionarySize);
+  if (size != 0) {
+    memcpy(buffer.data() + dictionarySize, data, size);
+  }
+
+  const uint8_t* base = buffer.data();
+  size_t end = buffer.size();
+  size_t anchor = dictionarySize;
+  compressed.clear();
+  compressed.reserve(size + size / 255 + 16);
+
+  if (size > MATCH_START_LIMIT) {
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, NO_POSITION);
+    for (size_t p = 0; p + MIN_MATCH <= dictionarySize; ++p) {
+      table[hash32(read32(base + p))] = static_cast<uint32_t>(p);
+    }
+
+    size_t matchStartLimit = end - MATCH_START_LIMIT;
+    size_t matchEndLimit = end - LAST_LITERALS;
+    size_t ip = dictionarySize;
+    while (ip < matchStartLimit) {
+      uint32_t sequence = read32(base + ip);
+      uint32_t& slot = table[hash32(sequence)];
+      size_t ref = slot;
+      slot = static_cast<uint32_t>(ip);
+      if (ref == NO_POSITION || ip - ref > MAX_OFFSET || read32(base + ref) != sequence) {
+        ++ip;
+        continue;
+      }
+
+      while (ip > anchor && ref > 0 && base[ip - 1] == base[ref - 1]) {
+        --ip;
+        --ref;
+      }
+
+      size_t length = MIN_MATCH;
+      while (ip + length < matchEndLimit && base[ref + length] == base[ip + length]) {
+        ++length;
+      }
+
+      writeSequence(base + anchor, ip - anchor, ip - ref, length, compressed);
+      ip += length;
+      anchor = ip;
+      if (ip < matchStartLimit) {
+        table[hash32(read32(base + ip - 2))] = static_cast<uint32_t>(ip - 2);
+      }
+    }
+  }
+
+  writeLastLiterals(base + anchor, end - anchor, compressed);
+}
+
+bool lz4Decompress(const void* data, size_t size, size_t originalSize, const std::string& dictionary, std::string& decompressed) {
+  size_t dictionarySize = std::min(dictionary.size(), MAX_OFFSET);
+  std::string buffer;
+  buffer.resize(dictionarySize + originalSize);
+  memcpy(&buffer[0], dictionary.data() + dictionary.size() - dictionarySize, dictionarySize);
+
+  const uint8_t* in = static_cast<const uint8_t*>(data);
+  const uint8_t* inEnd = in + size;
+  char* out = &buffer[0] + dictionarySize;
+  char* outEnd = out + originalSize;
+  for (;;) {
+    if (in == inEnd) {
+      return false;
+    }
+
+    uint8_t token = *in++;
+    size_t literalCount = token >> 4;
+    if (literalCount == 15 && !readLength(in, inEnd, literalCount)) {
+      return false;
+    }
+
+    if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > static_cast<size_t>(outEnd - out)) {
+      return false;
+    }
+
+    memcpy(out, in, literalCount);
+    in += literalCount;
+    out += literalCount;
+    if (in == inEnd) {
+      break;
+    }
+
+    if (inEnd - in < 2) {
+      return false;
+    }
+
+    size_t offset = in[0] | (static_cast<size_t>(in[1]) << 8);
+    in += 2;
+    size_t length = token & 15;
+    if (length == 15 && !readLength(in, inEnd, length)) {
+      return false;
+    }
+
+    length += MIN_MATCH;
+    if (offset == 0 || offset > static_cast<size_t>(out - &buffer[0]) || length > static_cast<size_t>(outEnd - out)) {
+      return false;
+    }
+
+    // The source may overlap the destination, which repeats the last `offset` bytes
+    const char* match = out - offset;
+    if (offset >= length) {
+      memcpy(out, match, length);
+      out += length;
+    } else {
+      for (size_t i = 0; i < length; ++i) {
+        *out++ = *match++;
+      }
+    }
+  }
+
+  if (out != outEnd) {
+    return false;
+  }
+
+  decompressed.assign(buffer, dictionarySize, std::string::npos);
+  return true;
+}
+
+}
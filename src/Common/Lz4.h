@@ -0,0 +1,21 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace Common {
+
+// Compression in the LZ4 block format. Matches may refer back into the dictionary, which acts as data that precedes
+// the input, so both sides must use the same dictionary. Only its last 64 KiB are used
+void lz4Compress(const void* data, size_t size, const std::string& dictionary, std::string& compressed);
+
+// Fails on malformed input or if the block doesn't decompress to exactly originalSize bytes
+bool lz4Decompress(const void* data, size_t size, size_t originalSize, const std::string& dictionary, std::string& decompressed);
+
+}
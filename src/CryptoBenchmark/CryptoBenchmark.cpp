@@ -0,0 +1,323 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+
+#include "Common/CommandLine.h"
+#include "Common/JsonValue.h"
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+#include "version.h"
+
+namespace po = boost::program_options;
+
+using Common::JsonValue;
+
+namespace {
+
+const command_line::arg_descriptor<uint32_t>    arg_min_time    = {"min-time", "Milliseconds every repetition of a benchmark runs at least", 200};
+const command_line::arg_descriptor<uint32_t>    arg_repetitions = {"repetitions", "Repetitions of every benchmark, the median is reported", 5};
+const command_line::arg_descriptor<std::string> arg_filter      = {"filter", "Run only the benchmarks with this in their name", ""};
+const command_line::arg_descriptor<std::string> arg_output_file = {"output-file", "Write the results to this file instead of the standard output", ""};
+
+const size_t MAX_MIXIN = 16;
+
+struct Benchmark {
+  std::string name;
+  std::function<void()> operation;
+};
+
+// Inputs derived from fixed seeds, so every run and every build measures the same keys, data and signatures
+class Inputs {
+public:
+  Inputs() : seed(0) {
+  }
+
+  Crypto::Hash hash() {
+    uint64_t value = seed++;
+    return Crypto::cn_fast_hash(&value, sizeof(value));
+  }
+
+  void keys(Crypto::PublicKey& publicKey, Crypto::SecretKey& secretKey) {
+    Crypto::Hash value = hash();
+    Crypto::SecretKey keySeed = reinterpret_cast<const Crypto::SecretKey&>(value);
+    Crypto::generate_keys_from_seed(publicKey, secretKey, keySeed);
+  }
+
+  std::vector<uint8_t> data(size_t size) {
+    std::vector<uint8_t> result(size);
+    for (size_t i = 0; i < size; i += sizeof(Crypto::Hash)) {
+      Crypto::Hash value = hash();
+      std::copy(value.data, value.data + std::min(sizeof(value), size - i), result.begin() + i);
+    }
+
+    return result;
+  }
+
+private:
+  uint64_t seed;
+};
+
+void check(bool result, const std::string& what) {
+  if (!result) {
+    throw std::runtime_error(what + " failed on the benchmark inputs");
+  }
+}
+
+std::vector<Benchmark> createBenchmarks(Inputs& inputs, Crypto::cn_context& context) {
+  std::vector<Benchmark> benchmarks;
+  for (size_t size : { 32, 76, 1024, 16384 }) {
+    auto data = std::make_shared<std::vector<uint8_t>>(inputs.data(size));
+    benchmarks.push_back({ "cn_fast_hash/" + std::to_string(size), [data] {
+      Crypto::Hash hash;
+      Crypto::cn_fast_hash(data->data(), data->size(), hash);
+    } });
+  }
+
+  // Every cryptonight_algo, each reached through its public function, on a block hashing blob
+  typedef void (*SlowHash)(Crypto::cn_context&, const void*, size_t, Crypto::Hash&);
+  std::vector<std::pair<std::string, SlowHash>> slowHashes = {
+    { "CRYPTONIGHT", &Crypto::cn_slow_hash },
+    { "CRYPTONIGHT_FAST_V8", &Crypto::cn_fast_slow_hash_v1 },
+    { "CRYPTONIGHT_CONCEAL", &Crypto::cn_conceal_slow_hash_v0 },
+    { "CRYPTONIGHT_CACHE_HASH", &Crypto::cn_moonbank_slow_hash_v0 } };
+  auto blob = std::make_shared<std::vector<uint8_t>>(inputs.data(76));
+  for (auto& slowHash : slowHashes) {
+    SlowHash function = slowHash.second;
+    benchmarks.push_back({ "cryptonight/" + slowHash.first, [&context, blob, function] {
+      Crypto::Hash hash;
+      function(context, blob->data(), blob->size(), hash);
+    } });
+  }
+
+  Crypto::PublicKey txPublicKey;
+  Crypto::SecretKey txSecretKey;
+  inputs.keys(txPublicKey, txSecretKey);
+  Crypto::PublicKey viewPublicKey;
+  Crypto::SecretKey viewSecretKey;
+  inputs.keys(viewPublicKey, viewSecretKey);
+  Crypto::PublicKey spendPublicKey;
+  Crypto::SecretKey spendSecretKey;
+  inputs.keys(spendPublicKey, spendSecretKey);
+  Crypto::KeyDerivation derivation;
+  check(Crypto::generate_key_derivation(txPublicKey, viewSecretKey, derivation), "generate_key_derivation");
+  Crypto::PublicKey outputKey;
+  check(Crypto::derive_public_key(derivation, 1, spendPublicKey, outputKey), "derive_public_key");
+  benchmarks.push_back({ "generate_key_derivation", [=] {
+    Crypto::KeyDerivation result;
+    Crypto::generate_key_derivation(txPublicKey, viewSecretKey, result);
+  } });
+  benchmarks.push_back({ "derive_public_key", [=] {
+    Crypto::PublicKey result;
+    Crypto::derive_public_key(derivation, 1, spendPublicKey, result);
+  } });
+  benchmarks.push_back({ "underive_public_key", [=] {
+    Crypto::PublicKey result;
+    Crypto::underive_public_key(derivation, 1, outputKey, result);
+  } });
+
+  Crypto::Hash prefixHash = inputs.hash();
+  Crypto::Signature signature;
+  Crypto::generate_signature(prefixHash, spendPublicKey, spendSecretKey, signature);
+  check(Crypto::check_signature(prefixHash, spendPublicKey, signature), "check_signature");
+  benchmarks.push_back({ "check_signature", [=] {
+    Crypto::check_signature(prefixHash, spendPublicKey, signature);
+  } });
+  benchmarks.push_back({ "generate_key_image", [=] {
+    Crypto::KeyImage result;
+    Crypto::generate_key_image(spendPublicKey, spendSecretKey, result);
+  } });
+
+  Crypto::KeyImage keyImage;
+  Crypto::generate_key_image(spendPublicKey, spendSecretKey, keyImage);
+  auto ring = std::make_shared<std::vector<Crypto::PublicKey>>();
+  // The rings point into it, so it must not grow into new memory
+  ring->reserve(MAX_MIXIN + 1);
+  ring->push_back(spendPublicKey);
+  for (size_t mixin = 0; mixin <= MAX_MIXIN; ++mixin) {
+    if (mixin != 0) {
+      Crypto::PublicKey decoy;
+      Crypto::SecretKey decoySecret;
+      inputs.keys(decoy, decoySecret);
+      ring->push_back(decoy);
+    }
+
+    // The real key is in the middle of the ring, as wallets don't put it at a fixed position
+    auto keys = std::make_shared<std::vector<const Crypto::PublicKey*>>();
+    size_t realIndex = mixin / 2;
+    for (size_t i = 0; i <= mixin; ++i) {
+      keys->push_back(&(*ring)[i == realIndex ? 0 : (i < realIndex ? i + 1 : i)]);
+    }
+
+    auto signatures = std::make_shared<std::vector<Crypto::Signature>>(keys->size());
+    Crypto::generate_ring_signature(prefixHash, keyImage, *keys, spendSecretKey, realIndex, signatures->data());
+    check(Crypto::check_ring_signature(prefixHash, keyImage, *keys, signatures->data()), "check_ring_signature");
+    benchmarks.push_back({ "check_ring_signature/mixin:" + std::to_string(mixin), [prefixHash, keyImage, ring, keys,
+      signatures] {
+      Crypto::check_ring_signature(prefixHash, keyImage, *keys, signatures->data());
+    } });
+  }
+
+  for (size_t count : { 1, 2, 16, 256, 4096 }) {
+    auto hashes = std::make_shared<std::vector<Crypto::Hash>>();
+    for (size_t i = 0; i < count; ++i) {
+      hashes->push_back(inputs.hash());
+    }
+
+    benchmarks.push_back({ "tree_hash/" + std::to_string(count), [hashes] {
+      Crypto::Hash root;
+      Crypto::tree_hash(hashes->data(), hashes->size(), root);
+    } });
+  }
+
+  return benchmarks;
+}
+
+double runBatch(const Benchmark& benchmark, uint64_t iterations) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint64_t i = 0; i < iterations; ++i) {
+    benchmark.operation();
+  }
+
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Runs the operation in batches long enough for the clock not to matter, first once unmeasured to warm the caches
+JsonValue run(const Benchmark& benchmark, double minTime, uint32_t repetitions) {
+  uint64_t batch = 1;
+  while (runBatch(benchmark, batch) < minTime / 100) {
+    batch *= 2;
+  }
+
+  std::vector<double> samples;
+  uint64_t totalIterations = 0;
+  for (uint32_t i = 0; i < repetitions; ++i) {
+    uint64_t iterations = 0;
+    double seconds = 0;
+    while (seconds < minTime) {
+      seconds += runBatch(benchmark, batch);
+      iterations += batch;
+    }
+
+    samples.push_back(seconds * 1000000000 / iterations);
+    totalIterations += iterations;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double median = samples.size() % 2 != 0 ? samples[samples.size() / 2] :
+    (samples[samples.size() / 2 - 1] + samples[samples.size() / 2]) / 2;
+  JsonValue result(JsonValue::OBJECT);
+  result.insert("name", benchmark.name);
+  result.insert("iterations", static_cast<JsonValue::Integer>(totalIterations));
+  result.insert("repetitions", static_cast<JsonValue::Integer>(repetitions));
+  result.insert("ns_per_op", median);
+  result.insert("min_ns_per_op", samples.front());
+  result.insert("max_ns_per_op", samples.back());
+  result.insert("ops_per_second", 1000000000 / median);
+  return result;
+}
+
+const char* pageTypeName(Crypto::cn_context::page_type pages) {
+  switch (pages) {
+  case Crypto::cn_context::page_type::huge:
+    return "huge";
+  case Crypto::cn_context::page_type::transparent_huge:
+    return "transparent_huge";
+  default:
+    return "normal";
+  }
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  po::options_description desc_general("General options");
+  command_line::add_arg(desc_general, command_line::arg_help);
+  po::options_description desc_params("Benchmark options");
+  command_line::add_arg(desc_params, arg_min_time);
+  command_line::add_arg(desc_params, arg_repetitions);
+  command_line::add_arg(desc_params, arg_filter);
+  command_line::add_arg(desc_params, arg_output_file);
+
+  po::options_description desc_all;
+  desc_all.add(desc_general).add(desc_params);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_all, [&]() {
+    po::store(po::parse_command_line(argc, argv, desc_all), vm);
+    if (command_line::get_arg(vm, command_line::arg_help)) {
+      std::cout << "Measures the hash, key and signature functions of the crypto library, results are written as JSON" <<
+        std::endl;
+      std::cout << desc_all << std::endl;
+      return false;
+    }
+
+    po::notify(vm);
+    return true;
+  });
+
+  if (!r) {
+    return 1;
+  }
+
+  try {
+    double minTime = std::max<uint32_t>(command_line::get_arg(vm, arg_min_time), 1) / 1000.0;
+    uint32_t repetitions = std::max<uint32_t>(command_line::get_arg(vm, arg_repetitions), 1);
+    std::string filter = command_line::get_arg(vm, arg_filter);
+    Crypto::cn_context context(true);
+    Inputs inputs;
+    JsonValue results(JsonValue::ARRAY);
+    for (const Benchmark& benchmark : createBenchmarks(inputs, context)) {
+      if (benchmark.name.find(filter) != std::string::npos) {
+        std::cerr << benchmark.name << std::endl;
+        results.pushBack(run(benchmark, minTime, repetitions));
+      }
+    }
+
+    JsonValue build(JsonValue::OBJECT);
+    build.insert("version", std::string(PROJECT_VERSION) + " (" + PROJECT_VERSION_BUILD_NO + ")");
+#if defined(__VERSION__)
+    build.insert("compiler", std::string(__VERSION__));
+#endif
+#if defined(NDEBUG)
+    build.insert("assertions", JsonValue(false));
+#else
+    build.insert("assertions", JsonValue(true));
+#endif
+    build.insert("scratchpad_pages", std::string(pageTypeName(context.scratchpad_pages())));
+    JsonValue report(JsonValue::OBJECT);
+    report.insert("build", std::move(build));
+    report.insert("benchmarks", std::move(results));
+
+    std::string outputFile = command_line::get_arg(vm, arg_output_file);
+    if (outputFile.empty()) {
+      std::cout << report << std::endl;
+    } else {
+      std::ofstream file(outputFile);
+      file << report << std::endl;
+      if (!file) {
+        throw std::runtime_error("failed to write " + outputFile);
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << "Benchmark failed: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
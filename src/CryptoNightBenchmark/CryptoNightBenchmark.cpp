@@ -0,0 +1,198 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <boost/program_options.hpp>
+
+#include "Common/CommandLine.h"
+#include "Common/CpuAffinity.h"
+#include "crypto/hash.h"
+
+namespace po = boost::program_options;
+
+namespace {
+
+const command_line::arg_descriptor<uint32_t> arg_threads      = {"threads", "Hashing threads, all hardware threads when 0", 0};
+const command_line::arg_descriptor<uint32_t> arg_seconds      = {"seconds", "Duration of every measurement", 20};
+const command_line::arg_descriptor<bool>     arg_cpu_affinity = {"cpu-affinity", "Pin every thread to its own CPU, Linux only"};
+const command_line::arg_descriptor<int32_t>  arg_numa_node    = {"numa-node", "Run the threads on this NUMA node, Linux only", -1};
+
+// Size of a block hashing blob
+const size_t BLOB_SIZE = 76;
+
+struct ThreadResult {
+  int cpu;
+  Crypto::cn_context::page_type pages;
+  uint64_t hashes;
+  double seconds;
+};
+
+const char* pageTypeName(Crypto::cn_context::page_type pages) {
+  switch (pages) {
+  case Crypto::cn_context::page_type::huge:
+    return "huge pages";
+  case Crypto::cn_context::page_type::transparent_huge:
+    return "transparent huge pages";
+  default:
+    return "normal pages";
+  }
+}
+
+// Every thread hashes with its own context, as the miner threads do, for the same time after all of them are ready
+std::vector<ThreadResult> measure(uint32_t threadCount, const std::vector<unsigned>& cpus, bool cpuAffinity,
+  bool hugePages, uint32_t seconds) {
+  std::vector<ThreadResult> results(threadCount);
+  std::atomic<uint32_t> ready(0);
+  std::atomic<bool> started(false);
+  std::vector<std::thread> threads;
+  for (uint32_t i = 0; i < threadCount; ++i) {
+    threads.emplace_back([&, i] {
+      ThreadResult& result = results[i];
+      result.cpu = -1;
+      if (!cpus.empty()) {
+        std::vector<unsigned> threadCpus = cpus;
+        if (cpuAffinity) {
+          threadCpus.assign(1, cpus[i % cpus.size()]);
+          result.cpu = static_cast<int>(threadCpus[0]);
+        }
+
+        Common::setThreadAffinity(threadCpus);
+      }
+
+      Crypto::cn_context context(hugePages);
+      result.pages = context.scratchpad_pages();
+      uint8_t blob[BLOB_SIZE];
+      for (size_t j = 0; j < BLOB_SIZE; ++j) {
+        blob[j] = static_cast<uint8_t>(j * 31 + i);
+      }
+
+      ++ready;
+      while (!started) {
+        std::this_thread::yield();
+      }
+
+      auto start = std::chrono::steady_clock::now();
+      auto end = start + std::chrono::seconds(seconds);
+      uint64_t hashes = 0;
+      Crypto::Hash hash;
+      do {
+        uint32_t nonce = static_cast<uint32_t>(hashes);
+        memcpy(blob + 39, &nonce, sizeof(nonce));
+        Crypto::cn_moonbank_slow_hash_v0(context, blob, BLOB_SIZE, hash);
+        ++hashes;
+      } while (std::chrono::steady_clock::now() < end);
+
+      result.hashes = hashes;
+      result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
+  }
+
+  while (ready != threadCount) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  started = true;
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  return results;
+}
+
+double report(const std::vector<ThreadResult>& results) {
+  double total = 0;
+  for (size_t i = 0; i < results.size(); ++i) {
+    const ThreadResult& result = results[i];
+    double rate = result.hashes / result.seconds;
+    total += rate;
+    std::string name = "thread " + std::to_string(i);
+    if (result.cpu >= 0) {
+      name += ", cpu " + std::to_string(result.cpu);
+    }
+
+    std::cout << "  " << std::setw(20) << std::left << name << std::right << std::fixed << std::setprecision(1) <<
+      std::setw(10) << rate << " H/s  " << pageTypeName(result.pages) << std::endl;
+  }
+
+  std::cout << "  " << std::setw(20) << std::left << "total" << std::right << std::fixed << std::setprecision(1) <<
+    std::setw(10) << total << " H/s" << std::endl;
+  return total;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  po::options_description desc_general("General options");
+  command_line::add_arg(desc_general, command_line::arg_help);
+  po::options_description desc_params("Benchmark options");
+  command_line::add_arg(desc_params, arg_threads);
+  command_line::add_arg(desc_params, arg_seconds);
+  command_line::add_arg(desc_params, arg_cpu_affinity);
+  command_line::add_arg(desc_params, arg_numa_node);
+
+  po::options_description desc_all;
+  desc_all.add(desc_general).add(desc_params);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_all, [&]() {
+    po::store(po::parse_command_line(argc, argv, desc_all), vm);
+    if (command_line::get_arg(vm, command_line::arg_help)) {
+      std::cout << "Measures the CryptoNight hash rate of every thread with scratchpads on normal and huge pages" <<
+        std::endl;
+      std::cout << desc_all << std::endl;
+      return false;
+    }
+
+    po::notify(vm);
+    return true;
+  });
+
+  if (!r) {
+    return 1;
+  }
+
+  try {
+    uint32_t threadCount = command_line::get_arg(vm, arg_threads);
+    if (threadCount == 0) {
+      threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    uint32_t seconds = std::max<uint32_t>(command_line::get_arg(vm, arg_seconds), 1);
+    bool cpuAffinity = command_line::get_arg(vm, arg_cpu_affinity);
+    int32_t numaNode = command_line::get_arg(vm, arg_numa_node);
+    std::vector<unsigned> cpus;
+    if (cpuAffinity || numaNode >= 0) {
+      cpus = Common::getAvailableCpus(numaNode);
+      if (cpus.empty()) {
+        throw std::runtime_error(Common::getAvailableCpus().empty() ? "thread affinity isn't supported on this platform" :
+          "NUMA node " + std::to_string(numaNode) + " has no CPUs the threads may run on");
+      }
+    }
+
+    std::cout << "Normal pages:" << std::endl;
+    double normalRate = report(measure(threadCount, cpus, cpuAffinity, false, seconds));
+    std::cout << "Huge pages:" << std::endl;
+    double hugeRate = report(measure(threadCount, cpus, cpuAffinity, true, seconds));
+    std::cout << "Huge pages speedup: " << std::fixed << std::setprecision(2) << hugeRate / normalRate << "x" << std::endl;
+  } catch (std::exception& e) {
+    std::cerr << "Benchmark failed: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <CryptoNote.h>
+#include "CryptoNoteCore/Difficulty.h"
+
+namespace CryptoNote {
+
+// Everything the explorer RPC methods report about a block besides its transactions. The values of a main chain
+// block only depend on that block and its ancestors, so they never change until the block is popped
+struct BlockSummary {
+  Crypto::Hash hash;
+  Crypto::Hash previousBlockHash;
+  uint32_t height;
+  uint8_t majorVersion;
+  uint8_t minorVersion;
+  uint64_t timestamp;
+  uint32_t nonce;
+  difficulty_type difficulty;
+  // Sum of the base transaction outputs
+  uint64_t reward;
+  // Size of the block blob and all of its transactions
+  size_t blockSize;
+  // Size of all the transactions including the base transaction, as used for the reward penalty
+  size_t transactionsCumulativeSize;
+  // Includes the base transaction
+  size_t transactionCount;
+  // Median of transactionsCumulativeSize over the REWARD_BLOCKS_WINDOW blocks up to this one
+  size_t sizeMedian;
+  uint64_t alreadyGeneratedCoins;
+  uint64_t depositAmount;
+};
+
+}
@@ -45,6 +45,19 @@ namespace
     return result;
   }
 
+  const size_t MAX_CACHED_BLOCK_SUMMARIES = 20000;
+  // Blocks read from the blocks file at once when going through all of them
+  const uint32_t BLOCKS_READ_BATCH = 128;
+
+  // Size of the output indexes stored after each transaction of a block
+  size_t getOutputIndexesBinarySize(const std::vector<uint32_t> &indexes)
+  {
+    Common::CountingOutputStream stream;
+    CryptoNote::BinaryOutputStreamSerializer serializer(stream);
+    serializer(const_cast<std::vector<uint32_t> &>(indexes), "indexes");
+    return stream.getSize();
+  }
+
 } // namespace
 
 namespace std
@@ -60,7 +73,7 @@ namespace std
   }
 } // namespace std
 
-#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 4
+#define CURRENT_BLOCKCACHE_STORAGE_ARCHIVE_VER 5
 #define CURRENT_BLOCKCHAININDICES_STORAGE_ARCHIVE_VER 1
 
 namespace CryptoNote
@@ -249,6 +262,10 @@ namespace CryptoNote
       logger(INFO, BRIGHT_MAGENTA) << operation << "Deposit Index";
       s(m_bs.m_depositIndex, "deposit_index");
 
+      logger(INFO, BRIGHT_MAGENTA) << operation << "Transaction Blob Locations";
+      serializeAsBinary(m_bs.m_transactionBlobLocations, "transaction_blob_locations", s);
+      serializeAsBinary(m_bs.m_firstTransactionBlobLocations, "first_transaction_blob_locations", s);
+
       auto dur = std::chrono::steady_clock::now() - start;
 
       logger(INFO, BRIGHT_GREEN) << "Serialization time took: " << std::chrono::duration_cast<std::chrono::milliseconds>(dur).count() << "ms";
@@ -368,7 +385,8 @@ namespace CryptoNote
                                                                                                                               m_current_block_cumul_sz_limit(0),
                                                                                                                               m_checkpoints(logger),
                                                                                                                               m_blockchainIndexesEnabled(blockchainIndexesEnabled),
-                                                                                                                              m_upgradeDetectorV2(currency, m_blocks, BLOCK_MAJOR_VERSION_2, logger)
+                                                                                                                              m_upgradeDetectorV2(currency, m_blocks, BLOCK_MAJOR_VERSION_2, logger),
+                                                                                                                              m_blockPushTimes()
 
   {
   }
@@ -491,7 +509,7 @@ namespace CryptoNote
     if (load_existing && !m_blocks.empty())
     {
       logger(INFO, BRIGHT_WHITE) << "Loading Blockchain...";
-      BlockMoonBankSerializer loader(*this, get_block_hash(m_blocks.back().bl), logger.getLogger());
+      BlockMoonBankSerializer loader(*this, m_blocks.back().getHash(), logger.getLogger());
       loader.load(appendPath(config_folder, m_currency.blocksMoonBankFileName()));
 
       if (!loader.loaded())
@@ -531,7 +549,7 @@ namespace CryptoNote
     }
     else
     {
-      Crypto::Hash firstBlockHash = get_block_hash(m_blocks[0].bl);
+      Crypto::Hash firstBlockHash = m_blocks[0].getHash();
       if (!(firstBlockHash == m_currency.genesisBlockHash()))
       {
         logger(ERROR, BRIGHT_RED) << "Failed to init: genesis block mismatch. "
@@ -606,21 +624,33 @@ namespace CryptoNote
     m_spent_keys.clear();
     m_outputs.clear();
     m_multisignatureOutputs.clear();
+    m_transactionBlobLocations.clear();
+    m_firstTransactionBlobLocations.clear();
+    // The blocks are read in batches, the next one in the background while this one is indexed
+    std::vector<std::shared_ptr<const BlockEntry>> batch;
+    m_blocks.setReadAhead(BLOCKS_READ_BATCH);
     for (uint32_t b = 0; b < m_blocks.size(); ++b) {
       if (b % 1000 == 0) {
         logger(INFO, BRIGHT_MAGENTA) << "Rebuilding MoonBank for Height " << b << " of " << m_blocks.size();
       }
 
-      const BlockEntry &block = m_blocks[b];
-      Crypto::Hash blockHash = get_block_hash(block.bl);
+      if (b % BLOCKS_READ_BATCH == 0) {
+        batch = m_blocks.getRange(b, std::min<uint64_t>(BLOCKS_READ_BATCH, m_blocks.size() - b));
+      }
+
+      const BlockEntry &block = *batch[b % BLOCKS_READ_BATCH];
+      Crypto::Hash blockHash = block.getHash();
       m_blockIndex.push(blockHash);
       uint64_t interest = 0;
+      std::vector<size_t> transactionSizes(block.transactions.size());
       for (uint16_t t = 0; t < block.transactions.size(); ++t)
       {
         const TransactionEntry &transaction = block.transactions[t];
-        Crypto::Hash transactionHash = getObjectHash(transaction.tx);
+        // Only the miner transaction has to be hashed, the block already lists the hashes of the others
+        Crypto::Hash transactionHash = t == 0 ? transaction.getHash() : block.bl.transactionHashes[t - 1];
         TransactionIndex transactionIndex = {b, t};
         m_transactionMap.insert(std::make_pair(transactionHash, transactionIndex));
+        transactionSizes[t] = getObjectBinarySize(transaction.tx);
 
         // process inputs
         for (auto &i : transaction.tx.inputs)
@@ -655,8 +685,10 @@ namespace CryptoNote
       }
 
       pushToDepositIndex(block, interest);
+      pushTransactionBlobLocations(block, transactionSizes);
     }
 
+    m_blocks.setReadAhead(0);
     std::chrono::duration<double> duration = std::chrono::steady_clock::now() - timePoint;
     logger(INFO, BRIGHT_GREEN) << "Rebuilding internal structures took: " << duration.count() << "seconds";
   }
@@ -702,6 +734,9 @@ namespace CryptoNote
     m_timestampIndex.clear();
     m_generatedTransactionsIndex.clear();
     m_orthanBlocksIndex.clear();
+    m_blockSummaries.clear();
+    m_transactionBlobLocations.clear();
+    m_firstTransactionBlobLocations.clear();
 
     block_verification_context bvc = boost::value_initialized<block_verification_context>();
     addNewBlock(b, bvc);
@@ -854,21 +889,20 @@ namespace CryptoNote
   uint64_t Blockchain::coinsEmittedAtHeight(uint64_t height)
   {
     std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-    const auto &block = m_blocks[height];
-    return block.already_generated_coins;
+    return m_blocks.get(height)->already_generated_coins;
   }
 
   difficulty_type Blockchain::difficultyAtHeight(uint64_t height)
   {
     std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-    const auto &current = m_blocks[height];
+    std::shared_ptr<const BlockEntry> current = m_blocks.get(height);
     if (height < 1)
     {
-      return current.cumulative_difficulty;
+      return current->cumulative_difficulty;
     }
 
-    const auto &previous = m_blocks[height - 1];
-    return current.cumulative_difficulty - previous.cumulative_difficulty;
+    std::shared_ptr<const BlockEntry> previous = m_blocks.get(height - 1);
+    return current->cumulative_difficulty - previous->cumulative_difficulty;
   }
 
   uint8_t Blockchain::get_block_major_version_for_height(uint64_t height) const
@@ -889,7 +923,7 @@ namespace CryptoNote
     // remove failed subchain
     for (size_t i = m_blocks.size() - 1; i >= rollback_height; i--)
     {
-      popBlock(get_block_hash(m_blocks.back().bl));
+      popBlock(m_blocks.back().getHash());
     }
 
     uint32_t height = static_cast<uint32_t>(rollback_height - 1);
@@ -975,13 +1009,13 @@ namespace CryptoNote
     {
       auto ch_ent = *alt_ch_iter;
       block_verification_context bvc = boost::value_initialized<block_verification_context>();
-      bool r = pushBlock(ch_ent->second.bl, get_block_hash(ch_ent->second.bl), bvc, ++height);
+      bool r = pushBlock(ch_ent->second.bl, ch_ent->second.getHash(), bvc, ++height);
       if (!r || !bvc.m_added_to_main_chain)
       {
         logger(INFO, BRIGHT_WHITE) << "Failed to switch to alternative blockchain";
         rollback_blockchain_switching(disconnected_chain, split_height);
-        //add_block_as_invalid(ch_ent->second, get_block_hash(ch_ent->second.bl));
-        logger(INFO, BRIGHT_WHITE) << "The block was inserted as invalid while connecting new alternative chain,  block_id: " << get_block_hash(ch_ent->second.bl);
+        //add_block_as_invalid(ch_ent->second, ch_ent->second.getHash());
+        logger(INFO, BRIGHT_WHITE) << "The block was inserted as invalid while connecting new alternative chain,  block_id: " << ch_ent->second.getHash();
         m_orthanBlocksIndex.remove(ch_ent->second.bl);
         m_alternative_chains.erase(ch_ent);
 
@@ -1020,7 +1054,7 @@ namespace CryptoNote
     //removing all_chain entries from alternative chain
     for (auto ch_ent : alt_chain)
     {
-      blocksFromCommonRoot.push_back(get_block_hash(ch_ent->second.bl));
+      blocksFromCommonRoot.push_back(ch_ent->second.getHash());
       m_orthanBlocksIndex.remove(ch_ent->second.bl);
       m_alternative_chains.erase(ch_ent);
     }
@@ -1310,7 +1344,7 @@ namespace CryptoNote
         }
 
         Crypto::Hash h = NULL_HASH;
-        get_block_hash(m_blocks[alt_chain.front()->second.height - 1].bl, h);
+        h = m_blocks[alt_chain.front()->second.height - 1].getHash();
         if (!(h == alt_chain.front()->second.bl.previousBlockHash))
         {
           logger(ERROR, BRIGHT_RED) << "alternative chain have wrong connection to main chain";
@@ -1479,15 +1513,13 @@ namespace CryptoNote
       return false;
     }
 
-    for (size_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++)
+    // The transactions of a block are stored with it, in the order of its transaction hashes
+    for (const auto &entry : m_blocks.getRange(start_offset, std::min<uint64_t>(count, m_blocks.size() - start_offset)))
     {
-      blocks.push_back(m_blocks[i].bl);
-      std::list<Crypto::Hash> missed_ids;
-      getTransactions(m_blocks[i].bl.transactionHashes, txs, missed_ids);
-      if (!(!missed_ids.size()))
+      blocks.push_back(entry->bl);
+      for (size_t i = 1; i < entry->transactions.size(); ++i)
       {
-        logger(ERROR, BRIGHT_RED) << "have missed transactions in own block in main blockchain";
-        return false;
+        txs.push_back(entry->transactions[i].tx);
       }
     }
 
@@ -1502,9 +1534,9 @@ namespace CryptoNote
       return false;
     }
 
-    for (uint32_t i = start_offset; i < start_offset + count && i < m_blocks.size(); i++)
+    for (const auto &entry : m_blocks.getRange(start_offset, std::min<uint64_t>(count, m_blocks.size() - start_offset)))
     {
-      blocks.push_back(m_blocks[i].bl);
+      blocks.push_back(entry->bl);
     }
 
     return true;
@@ -1570,7 +1602,8 @@ namespace CryptoNote
   bool Blockchain::add_out_to_get_random_outs(std::vector<std::pair<TransactionIndex, uint16_t>> &amount_outs, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::outs_for_amount &result_outs, uint64_t amount, size_t i)
   {
     std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
-    const Transaction &tx = transactionByIndex(amount_outs[i].first).tx;
+    std::shared_ptr<const TransactionEntry> transaction = transactionByIndex(amount_outs[i].first);
+    const Transaction &tx = transaction->tx;
     if (!(tx.outputs.size() > amount_outs[i].second))
     {
       logger(ERROR, BRIGHT_RED) << "internal error: in global outs index, transaction out index="
@@ -1690,7 +1723,7 @@ namespace CryptoNote
     for (size_t i = start_index; i != m_blocks.size() && i != end_index; i++)
     {
       ss << "height " << i << ", timestamp " << m_blocks[i].bl.timestamp << ", cumul_dif " << m_blocks[i].cumulative_difficulty << ", cumul_size " << m_blocks[i].block_cumulative_size
-         << "\nid\t\t" << get_block_hash(m_blocks[i].bl)
+         << "\nid\t\t" << m_blocks[i].getHash()
          << "\ndifficulty\t\t" << blockDifficulty(i) << ", nonce " << m_blocks[i].bl.nonce << ", tx_count " << m_blocks[i].bl.transactionHashes.size() << ENDL;
     }
     logger(DEBUGGING) << "Current blockchain:" << ENDL << ss.str();
@@ -1724,7 +1757,7 @@ namespace CryptoNote
         ss << "amount: " << v.first << ENDL;
         for (size_t i = 0; i != vals.size(); i++)
         {
-          ss << "\t" << getObjectHash(transactionByIndex(vals[i].first).tx) << ": " << vals[i].second << ENDL;
+          ss << "\t" << transactionByIndex(vals[i].first)->getHash() << ": " << vals[i].second << ENDL;
         }
       }
     }
@@ -1781,7 +1814,8 @@ namespace CryptoNote
       return false;
     }
 
-    const TransactionEntry &tx = transactionByIndex(it->second);
+    std::shared_ptr<const TransactionEntry> transaction = transactionByIndex(it->second);
+    const TransactionEntry &tx = *transaction;
     if (!(tx.m_global_output_indexes.size()))
     {
       logger(ERROR, BRIGHT_RED) << "internal error: global indexes for transaction " << tx_id << " is empty";
@@ -1811,7 +1845,8 @@ namespace CryptoNote
     }
 
     auto msigUsage = it->second[gindex];
-    auto &targetOut = transactionByIndex(msigUsage.transactionIndex).tx.outputs[msigUsage.outputIndex].target;
+    std::shared_ptr<const TransactionEntry> transaction = transactionByIndex(msigUsage.transactionIndex);
+    auto &targetOut = transaction->tx.outputs[msigUsage.outputIndex].target;
     if (targetOut.type() != typeid(MultisignatureOutput))
     {
       return false;
@@ -1836,7 +1871,7 @@ namespace CryptoNote
       logger(ERROR, BRIGHT_RED) << "internal error: max used block index=" << max_used_block_height << " is not less then blockchain size = " << m_blocks.size();
       return false;
     }
-    get_block_hash(m_blocks[max_used_block_height].bl, max_used_block_id);
+    max_used_block_id = m_blocks[max_used_block_height].getHash();
     return true;
   }
 
@@ -1859,10 +1894,10 @@ namespace CryptoNote
   bool Blockchain::checkTransactionInputs(const Transaction &tx, uint32_t *pmax_used_block_height)
   {
     Crypto::Hash tx_prefix_hash = getObjectHash(*static_cast<const TransactionPrefix *>(&tx));
-    return checkTransactionInputs(tx, tx_prefix_hash, pmax_used_block_height);
+    return checkTransactionInputs(tx, getObjectHash(tx), tx_prefix_hash, pmax_used_block_height);
   }
 
-  bool Blockchain::checkTransactionInputs(const Transaction &tx, const Crypto::Hash &tx_prefix_hash, uint32_t *pmax_used_block_height)
+  bool Blockchain::checkTransactionInputs(const Transaction &tx, const Crypto::Hash &transactionHash, const Crypto::Hash &tx_prefix_hash, uint32_t *pmax_used_block_height)
   {
     size_t inputIndex = 0;
     if (pmax_used_block_height)
@@ -1870,7 +1905,6 @@ namespace CryptoNote
       *pmax_used_block_height = 0;
     }
 
-    Crypto::Hash transactionHash = getObjectHash(tx);
     for (const auto &txin : tx.inputs)
     {
       assert(inputIndex < tx.signatures.size());
@@ -2210,9 +2244,46 @@ namespace CryptoNote
     return add_result;
   }
 
-  const Blockchain::TransactionEntry &Blockchain::transactionByIndex(TransactionIndex index)
+  std::shared_ptr<const Blockchain::TransactionEntry> Blockchain::transactionByIndex(TransactionIndex index)
   {
-    return m_blocks[index.block].transactions[index.transaction];
+    std::shared_ptr<const BlockEntry> block = m_blocks.get(index.block);
+    return std::shared_ptr<const TransactionEntry>(block, &block->transactions[index.transaction]);
+  }
+
+  void Blockchain::pushTransactionBlobLocations(const BlockEntry &block, const std::vector<size_t> &transactionSizes)
+  {
+    assert(transactionSizes.size() == block.transactions.size());
+    m_firstTransactionBlobLocations.push_back(static_cast<uint32_t>(m_transactionBlobLocations.size()));
+
+    // A block is stored field by field with its transactions last, each one followed by its output indexes
+    uint64_t transactionsSize = 0;
+    for (size_t i = 0; i < block.transactions.size(); ++i)
+    {
+      TransactionBlobLocation location;
+      location.offset = static_cast<uint32_t>(transactionsSize);
+      location.size = static_cast<uint32_t>(transactionSizes[i]);
+      m_transactionBlobLocations.push_back(location);
+      transactionsSize += transactionSizes[i] + getOutputIndexesBinarySize(block.transactions[i].m_global_output_indexes);
+    }
+
+    uint64_t transactionsOffset = m_blocks.itemSize(m_blocks.size() - 1) - transactionsSize;
+    for (size_t i = m_firstTransactionBlobLocations.back(); i < m_transactionBlobLocations.size(); ++i)
+    {
+      m_transactionBlobLocations[i].offset += static_cast<uint32_t>(transactionsOffset);
+    }
+  }
+
+  void Blockchain::popTransactionBlobLocations()
+  {
+    m_transactionBlobLocations.resize(m_firstTransactionBlobLocations.back());
+    m_firstTransactionBlobLocations.pop_back();
+  }
+
+  void Blockchain::readTransactionBlob(TransactionIndex index, BinaryArray &blob)
+  {
+    const TransactionBlobLocation &location = m_transactionBlobLocations[m_firstTransactionBlobLocations[index.block] + index.transaction];
+    blob.resize(location.size);
+    m_blocks.readItemBytes(index.block, location.offset, blob.data(), location.size);
   }
 
   bool Blockchain::pushBlock(const Block &blockData, const Crypto::Hash &id, block_verification_context &bvc, uint32_t height)
@@ -2285,7 +2356,8 @@ namespace CryptoNote
 
     auto targetTimeStart = std::chrono::steady_clock::now();
     difficulty_type currentDifficulty = getDifficultyForNextBlock();
-    auto target_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - targetTimeStart).count();
+    auto targetTime = std::chrono::steady_clock::now() - targetTimeStart;
+    auto target_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(targetTime).count();
 
     if (!(currentDifficulty))
     {
@@ -2311,7 +2383,8 @@ namespace CryptoNote
       }
     }
 
-    auto longhash_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - longhashTimeStart).count();
+    auto longhashTime = std::chrono::steady_clock::now() - longhashTimeStart;
+    auto longhash_calculating_time = std::chrono::duration_cast<std::chrono::milliseconds>(longhashTime).count();
 
     if (!prevalidate_miner_transaction(blockData, static_cast<uint32_t>(m_blocks.size())))
     {
@@ -2327,11 +2400,17 @@ namespace CryptoNote
     block.height = static_cast<uint32_t>(m_blocks.size());
     block.transactions.resize(1);
     block.transactions[0].tx = blockData.baseTransaction;
+    block.transactions[0].setHash(minerTransactionHash);
+    block.setHash(blockHash);
     TransactionIndex transactionIndex = {block.height, static_cast<uint16_t>(0)};
+    auto indexTimeStart = std::chrono::steady_clock::now();
     pushTransaction(block, minerTransactionHash, transactionIndex);
+    auto indexTime = std::chrono::steady_clock::now() - indexTimeStart;
+    std::chrono::steady_clock::duration validationTime(0);
 
     size_t coinbase_blob_size = getObjectBinarySize(blockData.baseTransaction);
     size_t cumulative_block_size = coinbase_blob_size;
+    std::vector<size_t> transactionSizes(1, coinbase_blob_size);
     uint64_t fee_summary = 0;
     uint64_t interestSummary = 0;
 
@@ -2340,8 +2419,10 @@ namespace CryptoNote
       const Crypto::Hash &tx_id = blockData.transactionHashes[i];
       block.transactions.resize(block.transactions.size() + 1);
       block.transactions.back().tx = transactions[i];
-      size_t blob_size = toBinaryArray(transactions[i]).size();
+      block.transactions.back().setHash(tx_id);
+      size_t blob_size = getObjectBinarySize(transactions[i]);
 
+      auto validationTimeStart = std::chrono::steady_clock::now();
       uint64_t in_amount = m_currency.getTransactionAllInputsAmount(transactions[i], block.height);
       uint64_t out_amount = getOutputAmount(transactions[i]);
       uint64_t fee = in_amount < out_amount ? CryptoNote::parameters::MINIMUM_FEE : in_amount - out_amount;
@@ -2353,7 +2434,7 @@ namespace CryptoNote
         logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " can't contain transaction " << tx_id << " because it has invalid version " << transactions[i].version;
       }
 
-      if (!checkTransactionInputs(transactions[i]))
+      if (!checkTransactionInputs(transactions[i], tx_id, getObjectHash(*static_cast<const TransactionPrefix *>(&transactions[i]))))
       {
         isTransactionValid = false;
         logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " has at least one transaction with wrong inputs: " << tx_id;
@@ -2365,6 +2446,9 @@ namespace CryptoNote
         logger(INFO, BRIGHT_WHITE) << "Transaction " << tx_id << " has at least one invalid output";
       }
 
+      indexTimeStart = std::chrono::steady_clock::now();
+      validationTime += indexTimeStart - validationTimeStart;
+
       if (!isTransactionValid)
       {
         logger(INFO, BRIGHT_WHITE) << "Block " << blockHash << " has at least one invalid transaction: " << tx_id;
@@ -2377,8 +2461,10 @@ namespace CryptoNote
 
       ++transactionIndex.transaction;
       pushTransaction(block, tx_id, transactionIndex);
+      indexTime += std::chrono::steady_clock::now() - indexTimeStart;
 
       cumulative_block_size += blob_size;
+      transactionSizes.push_back(blob_size);
       fee_summary += fee;
       interestSummary += m_currency.calculateTotalTransactionInterest(transactions[i]);
     }
@@ -2409,10 +2495,26 @@ namespace CryptoNote
       block.cumulative_difficulty += m_blocks.back().cumulative_difficulty;
     }
 
-    pushBlock(block);
+    indexTimeStart = std::chrono::steady_clock::now();
+    pushBlock(block, transactionSizes);
     pushToDepositIndex(block, interestSummary);
 
-    auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - blockProcessingStart).count();
+    BlockSummary summary;
+    if (makeBlockSummary(block, blockHash, summary))
+    {
+      cacheBlockSummary(block.height, summary);
+    }
+
+    auto blockProcessingEnd = std::chrono::steady_clock::now();
+    indexTime += blockProcessingEnd - indexTimeStart;
+    auto block_processing_time = std::chrono::duration_cast<std::chrono::milliseconds>(blockProcessingEnd - blockProcessingStart).count();
+    ++m_blockPushTimes.blocks;
+    m_blockPushTimes.transactions += transactions.size();
+    m_blockPushTimes.targetCalculating += targetTime;
+    m_blockPushTimes.longhashCalculating += longhashTime;
+    m_blockPushTimes.transactionValidation += validationTime;
+    m_blockPushTimes.indexUpdate += indexTime;
+    m_blockPushTimes.total += blockProcessingEnd - blockProcessingStart;
 
     logger(DEBUGGING) << "+++++ Block added" << ENDL << "id:\t" << blockHash
                       << ENDL << "PoW:\t" << proof_of_work
@@ -2429,6 +2531,12 @@ namespace CryptoNote
     return true;
   }
 
+  Blockchain::BlockPushTimes Blockchain::getBlockPushTimes() const
+  {
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    return m_blockPushTimes;
+  }
+
   uint64_t Blockchain::fullDepositAmount() const
   {
     std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
@@ -2478,12 +2586,13 @@ namespace CryptoNote
     m_depositIndex.pushBlock(deposit, interest);
   }
 
-  bool Blockchain::pushBlock(BlockEntry &block)
+  bool Blockchain::pushBlock(BlockEntry &block, const std::vector<size_t> &transactionSizes)
   {
-    Crypto::Hash blockHash = get_block_hash(block.bl);
+    Crypto::Hash blockHash = block.getHash();
 
     m_blocks.push_back(block);
     m_blockIndex.push(blockHash);
+    pushTransactionBlobLocations(block, transactionSizes);
 
     m_timestampIndex.add(block.bl.timestamp, blockHash);
     m_generatedTransactionsIndex.add(block.bl);
@@ -2511,12 +2620,14 @@ namespace CryptoNote
     uint32_t height = m_blocks.size(); //height of popped block should be same as number of blocks
     saveTransactions(transactions, height);
 
-    popTransactions(m_blocks.back(), getObjectHash(m_blocks.back().bl.baseTransaction));
+    popTransactions(m_blocks.back(), m_blocks.back().transactions[0].getHash());
 
     m_timestampIndex.remove(m_blocks.back().bl.timestamp, blockHash);
     m_generatedTransactionsIndex.remove(m_blocks.back().bl);
 
     m_depositIndex.popBlock();
+    m_blockSummaries.erase(static_cast<uint32_t>(m_blocks.size() - 1));
+    popTransactionBlobLocations();
     m_blocks.pop_back();
     m_blockIndex.pop();
 
@@ -2755,7 +2866,8 @@ namespace CryptoNote
       return false;
     }
 
-    const Transaction &outputTransaction = m_blocks[outputIndex.transactionIndex.block].transactions[outputIndex.transactionIndex.transaction].tx;
+    std::shared_ptr<const TransactionEntry> outputTransactionEntry = transactionByIndex(outputIndex.transactionIndex);
+    const Transaction &outputTransaction = outputTransactionEntry->tx;
     if (!is_tx_spendtime_unlocked(outputTransaction.unlockTime))
     {
       logger(DEBUGGING) << "Transaction << " << transactionHash << " contains multisignature input which points to a locked transaction.";
@@ -2827,12 +2939,14 @@ namespace CryptoNote
     }
 
     logger(DEBUGGING) << "Removing last block with height " << m_blocks.back().height;
-    popTransactions(m_blocks.back(), getObjectHash(m_blocks.back().bl.baseTransaction));
+    popTransactions(m_blocks.back(), m_blocks.back().transactions[0].getHash());
 
     Crypto::Hash blockHash = getBlockIdByHeight(m_blocks.back().height);
     m_timestampIndex.remove(m_blocks.back().bl.timestamp, blockHash);
     m_generatedTransactionsIndex.remove(m_blocks.back().bl);
 
+    m_blockSummaries.erase(static_cast<uint32_t>(m_blocks.size() - 1));
+    popTransactionBlobLocations();
     m_blocks.pop_back();
     m_blockIndex.pop();
 
@@ -2928,6 +3042,120 @@ namespace CryptoNote
     return false;
   }
 
+  bool Blockchain::getBlockSummary(const Crypto::Hash &hash, BlockSummary &summary)
+  {
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+
+    uint32_t height = 0;
+    if (m_blockIndex.getBlockHeight(hash, height))
+    {
+      return getMainChainBlockSummary(height, summary);
+    }
+
+    // alternative blocks may still be switched to, so their summaries are not cached
+    auto blockByHashIterator = m_alternative_chains.find(hash);
+    if (blockByHashIterator != m_alternative_chains.end())
+    {
+      return makeBlockSummary(blockByHashIterator->second, hash, summary);
+    }
+
+    logger(DEBUGGING) << "Can't find block with hash " << hash << " to get block summary.";
+    return false;
+  }
+
+  bool Blockchain::getBlockSummaries(uint32_t startHeight, uint32_t count, std::vector<BlockSummary> &summaries)
+  {
+    std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
+    if (startHeight >= m_blocks.size() || count > m_blocks.size() - startHeight)
+    {
+      logger(DEBUGGING) << "Can't get " << count << " block summaries from height " << startHeight << ", blockchain height = " << m_blocks.size();
+      return false;
+    }
+
+    summaries.reserve(summaries.size() + count);
+    for (uint32_t height = startHeight; height < startHeight + count; ++height)
+    {
+      BlockSummary summary;
+      if (!getMainChainBlockSummary(height, summary))
+      {
+        return false;
+      }
+
+      summaries.push_back(std::move(summary));
+    }
+
+    return true;
+  }
+
+  bool Blockchain::makeBlockSummary(const BlockEntry &block, const Crypto::Hash &blockHash, BlockSummary &summary)
+  {
+    std::vector<size_t> blocksSizes;
+    if (!getBackwardBlocksSize(block.height, blocksSizes, parameters::REWARD_BLOCKS_WINDOW))
+    {
+      return false;
+    }
+
+    summary.hash = blockHash;
+    summary.previousBlockHash = block.bl.previousBlockHash;
+    summary.height = block.height;
+    summary.majorVersion = block.bl.majorVersion;
+    summary.minorVersion = block.bl.minorVersion;
+    summary.timestamp = block.bl.timestamp;
+    summary.nonce = block.bl.nonce;
+    summary.difficulty = blockDifficulty(block.height);
+    summary.reward = get_outs_money_amount(block.bl.baseTransaction);
+    summary.blockSize = getObjectBinarySize(block.bl) + block.block_cumulative_size - getObjectBinarySize(block.bl.baseTransaction);
+    summary.transactionsCumulativeSize = block.block_cumulative_size;
+    summary.transactionCount = block.bl.transactionHashes.size() + 1;
+    summary.sizeMedian = Common::medianValue(blocksSizes);
+    summary.alreadyGeneratedCoins = block.already_generated_coins;
+    summary.depositAmount = m_depositIndex.depositAmountAtHeight(static_cast<DepositIndex::DepositHeight>(block.height));
+    return true;
+  }
+
+  bool Blockchain::getMainChainBlockSummary(uint32_t height, BlockSummary &summary)
+  {
+    auto it = m_blockSummaries.find(height);
+    if (it != m_blockSummaries.end())
+    {
+      summary = it->second;
+      return true;
+    }
+
+    std::shared_ptr<const BlockEntry> block = m_blocks.get(height);
+    if (!makeBlockSummary(*block, block->getHash(), summary))
+    {
+      logger(ERROR, BRIGHT_RED) << "Internal error: can't make summary of block at height " << height;
+      return false;
+    }
+
+    cacheBlockSummary(height, summary);
+    return true;
+  }
+
+  void Blockchain::cacheBlockSummary(uint32_t height, const BlockSummary &summary)
+  {
+    m_blockSummaries[height] = summary;
+    if (m_blockSummaries.size() <= MAX_CACHED_BLOCK_SUMMARIES)
+    {
+      return;
+    }
+
+    // Keep the top of the chain, which the explorer asks for most, and drop the older half
+    uint32_t oldestKeptHeight = static_cast<uint32_t>(m_blocks.size() - std::min<size_t>(m_blocks.size(), MAX_CACHED_BLOCK_SUMMARIES / 2));
+    for (auto it = m_blockSummaries.begin(); it != m_blockSummaries.end();)
+    {
+      if (it->first < oldestKeptHeight && it->first != height)
+      {
+        m_blockSummaries.erase(it++);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+  }
+
   bool Blockchain::getMultisigOutputReference(const MultisignatureInput &txInMultisig, std::pair<Crypto::Hash, size_t> &outputReference)
   {
     std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
@@ -2943,8 +3171,7 @@ namespace CryptoNote
       return false;
     }
     const MultisignatureOutputUsage &outputIndex = amountIter->second[txInMultisig.outputIndex];
-    const Transaction &outputTransaction = m_blocks[outputIndex.transactionIndex.block].transactions[outputIndex.transactionIndex.transaction].tx;
-    outputReference.first = getObjectHash(outputTransaction);
+    outputReference.first = transactionByIndex(outputIndex.transactionIndex)->getHash();
     outputReference.second = outputIndex.outputIndex;
     return true;
   }
@@ -2970,7 +3197,7 @@ namespace CryptoNote
     std::lock_guard<decltype(m_blockchain_lock)> lk(m_blockchain_lock);
 
     logger(INFO, BRIGHT_WHITE) << "Loading blockchain indices for BlockchainExplorer";
-    BlockchainIndicesSerializer loader(*this, get_block_hash(m_blocks.back().bl), logger.getLogger());
+    BlockchainIndicesSerializer loader(*this, m_blocks.back().getHash(), logger.getLogger());
 
     loadFromBinaryFile(loader, appendPath(m_config_folder, m_currency.blockchinIndicesFileName()));
 
@@ -2989,12 +3216,12 @@ namespace CryptoNote
         {
           logger(INFO, BRIGHT_WHITE) << "Rebuilding Indices for Height " << b << " of " << m_blocks.size();
         }
-        const BlockEntry &block = m_blocks[b];
-        m_timestampIndex.add(block.bl.timestamp, get_block_hash(block.bl));
-        m_generatedTransactionsIndex.add(block.bl);
-        for (uint16_t t = 0; t < block.transactions.size(); ++t)
+        std::shared_ptr<const BlockEntry> block = m_blocks.get(b);
+        m_timestampIndex.add(block->bl.timestamp, block->getHash());
+        m_generatedTransactionsIndex.add(block->bl);
+        for (uint16_t t = 0; t < block->transactions.size(); ++t)
         {
-          const TransactionEntry &transaction = block.transactions[t];
+          const TransactionEntry &transaction = block->transactions[t];
           m_paymentIdIndex.add(transaction.tx);
         }
       }
@@ -10,6 +10,7 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 
 #include "google/sparse_hash_set"
 #include "google/sparse_hash_map"
@@ -18,6 +19,7 @@
 #include "Common/ObserverManager.h"
 #include "Common/Util.h"
 #include "CryptoNoteCore/BlockIndex.h"
+#include "CryptoNoteCore/BlockSummary.h"
 #include "CryptoNoteCore/Checkpoints.h"
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/DepositIndex.h"
@@ -25,6 +27,7 @@
 #include "CryptoNoteCore/ITransactionValidator.h"
 #include "CryptoNoteCore/SwappedVector.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/TransactionPool.h"
 #include "CryptoNoteCore/BlockchainIndices.h"
 #include "CryptoNoteCore/UpgradeDetector.h"
@@ -111,6 +114,8 @@ namespace CryptoNote
     bool getBlockContainingTransaction(const Crypto::Hash &txId, Crypto::Hash &blockId, uint32_t &blockHeight);
     bool getAlreadyGeneratedCoins(const Crypto::Hash &hash, uint64_t &generatedCoins);
     bool getBlockSize(const Crypto::Hash &hash, size_t &size);
+    bool getBlockSummary(const Crypto::Hash &hash, BlockSummary &summary);
+    bool getBlockSummaries(uint32_t startHeight, uint32_t count, std::vector<BlockSummary> &summaries);
     bool getMultisigOutputReference(const MultisignatureInput &txInMultisig, std::pair<Crypto::Hash, size_t> &outputReference);
     bool getGeneratedTransactionsNumber(uint32_t height, uint64_t &generatedTransactions);
     bool getOrphanBlockIdsByHeight(uint32_t height, std::vector<Crypto::Hash> &blockHashes);
@@ -174,7 +179,7 @@ namespace CryptoNote
         }
         else
         {
-          txs.push_back(transactionByIndex(it->second).tx);
+          txs.push_back(transactionByIndex(it->second)->tx);
         }
       }
     }
@@ -198,6 +203,31 @@ namespace CryptoNote
       }
     }
 
+    // Copies the stored blobs of the transactions without deserializing them or the blocks they belong to
+    template <class t_ids_container, class t_blob_container, class t_missed_container>
+    void getTransactionBlobs(const t_ids_container &txs_ids, t_blob_container &blobs, t_missed_container &missed_txs, bool checkTxPool = false)
+    {
+      if (checkTxPool)
+      {
+        std::lock_guard<decltype(m_tx_pool)> txLock(m_tx_pool);
+
+        getBlockchainTransactionBlobs(txs_ids, blobs, missed_txs);
+
+        auto poolTxIds = std::move(missed_txs);
+        missed_txs.clear();
+        std::list<Transaction> poolTxs;
+        m_tx_pool.getTransactions(poolTxIds, poolTxs, missed_txs);
+        for (const auto &tx : poolTxs)
+        {
+          blobs.push_back(toBinaryArray(tx));
+        }
+      }
+      else
+      {
+        getBlockchainTransactionBlobs(txs_ids, blobs, missed_txs);
+      }
+    }
+
     //debug functions
     void print_blockchain(uint64_t start_index, uint64_t end_index);
     void print_blockchain_index();
@@ -215,34 +245,45 @@ namespace CryptoNote
       }
     };
 
-    bool rollbackBlockchainTo(uint32_t height);
-    bool have_tx_keyimg_as_spent(const Crypto::KeyImage &key_im);
-
-  private:
-    struct MultisignatureOutputUsage
+    // Stored items of the main chain, a BlockEntry with its transactions for every block of the blocks file
+    struct TransactionEntry
     {
-      TransactionIndex transactionIndex;
-      uint16_t outputIndex;
-      bool isUsed;
+      Transaction tx;
+      std::vector<uint32_t> m_global_output_indexes;
 
-      void serialize(ISerializer &s)
+      TransactionEntry() : m_hashCached(false) {}
+
+      // The hash is not stored on disk: it is set when the entry is pushed and when it is deserialized, so the entries
+      // shared by the readers of the blocks file are never written. Only entries of a single thread compute it here
+      Crypto::Hash getHash() const
       {
-        s(transactionIndex, "txindex");
-        s(outputIndex, "outindex");
-        s(isUsed, "used");
+        if (!m_hashCached)
+        {
+          setHash(getObjectHash(tx));
+        }
+
+        return m_hash;
       }
-    };
 
-    struct TransactionEntry
-    {
-      Transaction tx;
-      std::vector<uint32_t> m_global_output_indexes;
+      void setHash(const Crypto::Hash &hash) const
+      {
+        m_hash = hash;
+        m_hashCached = true;
+      }
 
       void serialize(ISerializer &s)
       {
         s(tx, "tx");
         s(m_global_output_indexes, "indexes");
+        if (s.type() == ISerializer::INPUT)
+        {
+          setHash(getObjectHash(tx));
+        }
       }
+
+    private:
+      mutable Crypto::Hash m_hash;
+      mutable bool m_hashCached;
     };
 
     struct BlockEntry
@@ -254,6 +295,25 @@ namespace CryptoNote
       uint64_t already_generated_coins;
       std::vector<TransactionEntry> transactions;
 
+      BlockEntry() : m_hashCached(false) {}
+
+      // Set and computed like the hash of a TransactionEntry
+      Crypto::Hash getHash() const
+      {
+        if (!m_hashCached)
+        {
+          setHash(get_block_hash(bl));
+        }
+
+        return m_hash;
+      }
+
+      void setHash(const Crypto::Hash &hash) const
+      {
+        m_hash = hash;
+        m_hashCached = true;
+      }
+
       void serialize(ISerializer &s)
       {
         s(bl, "block");
@@ -262,9 +322,57 @@ namespace CryptoNote
         s(cumulative_difficulty, "cumulative_difficulty");
         s(already_generated_coins, "already_generated_coins");
         s(transactions, "transactions");
+        if (s.type() == ISerializer::INPUT)
+        {
+          setHash(get_block_hash(bl));
+        }
+      }
+
+    private:
+      mutable Crypto::Hash m_hash;
+      mutable bool m_hashCached;
+    };
+
+    // Time pushBlock spent in the phases of adding blocks to the main chain, summed over all blocks it added
+    struct BlockPushTimes
+    {
+      uint64_t blocks;
+      uint64_t transactions;
+      std::chrono::steady_clock::duration targetCalculating;
+      std::chrono::steady_clock::duration longhashCalculating;
+      std::chrono::steady_clock::duration transactionValidation;
+      // Spent outputs and key images, transaction and block indexes and the write of the block to the blocks file
+      std::chrono::steady_clock::duration indexUpdate;
+      std::chrono::steady_clock::duration total;
+    };
+
+    BlockPushTimes getBlockPushTimes() const;
+
+    bool rollbackBlockchainTo(uint32_t height);
+    bool have_tx_keyimg_as_spent(const Crypto::KeyImage &key_im);
+
+  private:
+    struct MultisignatureOutputUsage
+    {
+      TransactionIndex transactionIndex;
+      uint16_t outputIndex;
+      bool isUsed;
+
+      void serialize(ISerializer &s)
+      {
+        s(transactionIndex, "txindex");
+        s(outputIndex, "outindex");
+        s(isUsed, "used");
       }
     };
 
+    // Where a transaction blob lies inside the stored item of its block
+    struct TransactionBlobLocation
+    {
+      uint32_t offset;
+      uint32_t size;
+    };
+
     typedef parallel_flat_hash_map<Crypto::KeyImage, uint32_t> key_images_container;
     typedef parallel_flat_hash_map<Crypto::Hash, BlockEntry> blocks_ext_by_hash;
     typedef parallel_flat_hash_map<uint64_t, std::vector<std::pair<TransactionIndex, uint16_t>>> outputs_container; //Crypto::Hash - tx hash, size_t - index of out in transaction
@@ -289,6 +397,7 @@ namespace CryptoNote
     typedef parallel_flat_hash_map<Crypto::Hash, uint32_t> BlockMap;
     typedef parallel_flat_hash_map<Crypto::Hash, TransactionIndex> TransactionMap;
     typedef BasicUpgradeDetector<Blocks> UpgradeDetector;
+    typedef parallel_flat_hash_map<uint32_t, BlockSummary> BlockSummaryMap;
 
     friend class BlockMoonBankSerializer;
     friend class BlockchainIndicesSerializer;
@@ -306,6 +415,14 @@ namespace CryptoNote
     GeneratedTransactionsIndex m_generatedTransactionsIndex;
     OrphanBlocksIndex m_orthanBlocksIndex;
 
+    // Main chain block summaries by height: filled when a block is pushed or first requested, erased when it is popped
+    BlockSummaryMap m_blockSummaries;
+    // Transaction blob locations of the main chain blocks, block after block, and the position of the first one of each
+    // block: appended when a block is pushed or the moonbank is rebuilt, saved with the moonbank, dropped when it is popped
+    std::vector<TransactionBlobLocation> m_transactionBlobLocations;
+    std::vector<uint32_t> m_firstTransactionBlobLocations;
+    BlockPushTimes m_blockPushTimes;
+
     IntrusiveLinkedList<MessageQueue<BlockchainMessage>> m_messageQueueList;
 
     Logging::LoggerRef logger;
@@ -331,14 +448,42 @@ namespace CryptoNote
     bool getBlockCumulativeSize(const Block &block, size_t &cumulativeSize);
     bool update_next_comulative_size_limit();
     bool check_tx_input(const KeyInput &txin, const Crypto::Hash &tx_prefix_hash, const std::vector<Crypto::Signature> &sig, uint32_t *pmax_related_block_height = NULL);
-    bool checkTransactionInputs(const Transaction &tx, const Crypto::Hash &tx_prefix_hash, uint32_t *pmax_used_block_height = NULL);
+    bool checkTransactionInputs(const Transaction &tx, const Crypto::Hash &transactionHash, const Crypto::Hash &tx_prefix_hash, uint32_t *pmax_used_block_height = NULL);
     bool checkTransactionInputs(const Transaction &tx, uint32_t *pmax_used_block_height = NULL);
     bool check_tx_outputs(const Transaction &tx) const;
 
-    const TransactionEntry &transactionByIndex(TransactionIndex index);
+    // Shares the ownership of the block entry, which the cache of m_blocks may drop any time
+    std::shared_ptr<const TransactionEntry> transactionByIndex(TransactionIndex index);
+    // Appends the locations of the transactions of the block last pushed to m_blocks, given the sizes of their blobs
+    void pushTransactionBlobLocations(const BlockEntry &block, const std::vector<size_t> &transactionSizes);
+    void popTransactionBlobLocations();
+    void readTransactionBlob(TransactionIndex index, BinaryArray &blob);
+
+    template <class t_ids_container, class t_blob_container, class t_missed_container>
+    void getBlockchainTransactionBlobs(const t_ids_container &txs_ids, t_blob_container &blobs, t_missed_container &missed_txs)
+    {
+      std::lock_guard<decltype(m_blockchain_lock)> bcLock(m_blockchain_lock);
+
+      for (const auto &tx_id : txs_ids)
+      {
+        auto it = m_transactionMap.find(tx_id);
+        if (it == m_transactionMap.end())
+        {
+          missed_txs.push_back(tx_id);
+        }
+        else
+        {
+          blobs.emplace_back();
+          readTransactionBlob(it->second, blobs.back());
+        }
+      }
+    }
     bool pushBlock(const Block &blockData, const Crypto::Hash &id, block_verification_context &bvc, uint32_t height);
     bool pushBlock(const Block &blockData, const std::vector<Transaction> &transactions, const Crypto::Hash &id, block_verification_context &bvc);
-    bool pushBlock(BlockEntry &block);
+    bool pushBlock(BlockEntry &block, const std::vector<size_t> &transactionSizes);
+    bool makeBlockSummary(const BlockEntry &block, const Crypto::Hash &blockHash, BlockSummary &summary);
+    bool getMainChainBlockSummary(uint32_t height, BlockSummary &summary);
+    void cacheBlockSummary(uint32_t height, const BlockSummary &summary);
     void popBlock(const Crypto::Hash &blockHash);
     bool pushTransaction(BlockEntry &block, const Crypto::Hash &transactionHash, TransactionIndex transactionIndex);
     void popTransaction(const Transaction &transaction, const Crypto::Hash &transactionHash);
@@ -395,7 +540,8 @@ namespace CryptoNote
       //auto tx_it = m_transactionMap.find(amount_outs_vec[i].first);
       //if (!(tx_it != m_transactionMap.end())) { logger(ERROR, BRIGHT_RED) << "Wrong transaction id in output indexes: " << Common::podToHex(amount_outs_vec[i].first); return false; }
 
-      const TransactionEntry &tx = transactionByIndex(amount_outs_vec[i].first);
+      std::shared_ptr<const TransactionEntry> transaction = transactionByIndex(amount_outs_vec[i].first);
+      const TransactionEntry &tx = *transaction;
 
       if (!(amount_outs_vec[i].second < tx.tx.outputs.size()))
       {
@@ -133,6 +133,10 @@ void core::getTransactions(const std::vector<Crypto::Hash>& txs_ids, std::list<T
   m_blockchain.getTransactions(txs_ids, txs, missed_txs, checkTxPool);
 }
 
+void core::getTransactionBlobs(const std::vector<Crypto::Hash>& txs_ids, std::vector<BinaryArray>& txs, std::vector<Crypto::Hash>& missed_txs, bool checkTxPool) {
+  m_blockchain.getTransactionBlobs(txs_ids, txs, missed_txs, checkTxPool);
+}
+
 bool core::get_alternative_blocks(std::list<Block>& blocks) {
   return m_blockchain.getAlternativeBlocks(blocks);
 }
@@ -916,6 +920,14 @@ bool core::getBlockDifficulty(uint32_t height, difficulty_type& difficulty) {
   return true;
 }
 
+bool core::getBlockSummary(const Crypto::Hash& hash, BlockSummary& summary) {
+  return m_blockchain.getBlockSummary(hash, summary);
+}
+
+bool core::getBlockSummaries(uint32_t startHeight, uint32_t count, std::vector<BlockSummary>& summaries) {
+  return m_blockchain.getBlockSummaries(startHeight, count, summaries);
+}
+
 bool core::getBlockContainingTx(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight) {
   return m_blockchain.getBlockContainingTransaction(txId, blockId, blockHeight);
 }
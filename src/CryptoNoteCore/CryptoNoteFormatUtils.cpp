@@ -488,14 +488,16 @@ bool get_block_longhash(cn_context &context, const Block& b, Hash& res) {
     return false;
   }
 
-  if (b.majorVersion >= 2) {
-    cn_moonbank_slow_hash_v0(context, bd.data(), bd.size(), res);
+  get_block_longhash(context, b.majorVersion, bd, res);
+  return true;
+}
+
+void get_block_longhash(cn_context &context, uint8_t majorVersion, const BinaryArray& hashingBlob, Hash& res) {
+  if (majorVersion >= 2) {
+    cn_moonbank_slow_hash_v0(context, hashingBlob.data(), hashingBlob.size(), res);
   } else {
-    cn_slow_hash(context, bd.data(), bd.size(), res);
+    cn_slow_hash(context, hashingBlob.data(), hashingBlob.size(), res);
   }
-  
-
-  return true;
 }
 
 std::vector<uint32_t> relative_output_offsets_to_absolute(const std::vector<uint32_t>& off) {
@@ -9,9 +9,8 @@
 
 namespace CryptoNote {
 template<>
-bool toBinaryArray(const BinaryArray& object, BinaryArray& binaryArray) {
+bool toBinaryStream(const BinaryArray& object, Common::IOutputStream& stream) {
   try {
-    Common::VectorOutputStream stream(binaryArray);
     BinaryOutputStreamSerializer serializer(stream);
     std::string oldBlob = Common::asString(object);
     serializer(oldBlob, "");
@@ -22,6 +21,12 @@ bool toBinaryArray(const BinaryArray& object, BinaryArray& binaryArray) {
   return true;
 }
 
+template<>
+bool toBinaryArray(const BinaryArray& object, BinaryArray& binaryArray) {
+  Common::VectorOutputStream stream(binaryArray);
+  return toBinaryStream(object, stream);
+}
+
 void getBinaryArrayHash(const BinaryArray& binaryArray, Crypto::Hash& hash) {
   cn_fast_hash(binaryArray.data(), binaryArray.size(), hash);
 }
@@ -7,12 +7,14 @@
 #pragma once
 
 #include <limits>
+#include "Common/CountingOutputStream.h"
 #include "Common/MemoryInputStream.h"
 #include "Common/StringTools.h"
 #include "Common/VectorOutputStream.h"
 #include "Serialization/BinaryOutputStreamSerializer.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
 #include "CryptoNoteSerialization.h"
+#include "KeccakOutputStream.h"
 
 namespace CryptoNote {
 
@@ -20,9 +22,8 @@ void getBinaryArrayHash(const BinaryArray& binaryArray, Crypto::Hash& hash);
 Crypto::Hash getBinaryArrayHash(const BinaryArray& binaryArray);
 
 template<class T>
-bool toBinaryArray(const T& object, BinaryArray& binaryArray) {
+bool toBinaryStream(const T& object, ::Common::IOutputStream& stream) {
   try {
-    ::Common::VectorOutputStream stream(binaryArray);
     BinaryOutputStreamSerializer serializer(stream);
     serialize(const_cast<T&>(object), serializer);
   } catch (std::exception&) {
@@ -32,6 +33,15 @@ bool toBinaryArray(const T& object, BinaryArray& binaryArray) {
   return true;
 }
 
+template<>
+bool toBinaryStream(const BinaryArray& object, ::Common::IOutputStream& stream);
+
+template<class T>
+bool toBinaryArray(const T& object, BinaryArray& binaryArray) {
+  ::Common::VectorOutputStream stream(binaryArray);
+  return toBinaryStream(object, stream);
+}
+
 template<>
 bool toBinaryArray(const BinaryArray& object, BinaryArray& binaryArray); 
 
@@ -57,15 +67,16 @@ bool fromBinaryArray(T& object, const BinaryArray& binaryArray) {
   return result;
 }
 
+// Size and hash are taken while serializing, without building the blob
 template<class T>
 bool getObjectBinarySize(const T& object, size_t& size) {
-  BinaryArray ba;
-  if (!toBinaryArray(object, ba)) {
+  ::Common::CountingOutputStream stream;
+  if (!toBinaryStream(object, stream)) {
     size = (std::numeric_limits<size_t>::max)();
     return false;
   }
 
-  size = ba.size();
+  size = stream.getSize();
   return true;
 }
 
@@ -78,27 +89,27 @@ size_t getObjectBinarySize(const T& object) {
 
 template<class T>
 bool getObjectHash(const T& object, Crypto::Hash& hash) {
-  BinaryArray ba;
-  if (!toBinaryArray(object, ba)) {
+  KeccakOutputStream stream;
+  if (!toBinaryStream(object, stream)) {
     hash = NULL_HASH;
     return false;
   }
 
-  hash = getBinaryArrayHash(ba);
+  hash = stream.getHash();
   return true;
 }
 
 template<class T>
 bool getObjectHash(const T& object, Crypto::Hash& hash, size_t& size) {
-  BinaryArray ba;
-  if (!toBinaryArray(object, ba)) {
+  KeccakOutputStream stream;
+  if (!toBinaryStream(object, stream)) {
     hash = NULL_HASH;
     size = (std::numeric_limits<size_t>::max)();
     return false;
   }
 
-  size = ba.size();
-  hash = getBinaryArrayHash(ba);
+  size = stream.getSize();
+  hash = stream.getHash();
   return true;
 }
 
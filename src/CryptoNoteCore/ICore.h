@@ -35,6 +35,7 @@ struct Block;
 struct block_verification_context;
 struct BlockFullInfo;
 struct BlockShortInfo;
+struct BlockSummary;
 struct core_stat_info;
 struct i_cryptonote_protocol;
 struct Transaction;
@@ -89,6 +90,7 @@ public:
   virtual bool getBlockByHash(const Crypto::Hash &h, Block &blk) = 0;
   virtual bool getBlockHeight(const Crypto::Hash& blockId, uint32_t& blockHeight) = 0;
   virtual void getTransactions(const std::vector<Crypto::Hash>& txs_ids, std::list<Transaction>& txs, std::list<Crypto::Hash>& missed_txs, bool checkTxPool = false) = 0;
+  virtual void getTransactionBlobs(const std::vector<Crypto::Hash>& txs_ids, std::vector<BinaryArray>& txs, std::vector<Crypto::Hash>& missed_txs, bool checkTxPool = false) = 0;
   virtual bool getBackwardBlocksSizes(uint32_t fromHeight, std::vector<size_t>& sizes, size_t count) = 0;
   virtual bool getBlockSize(const Crypto::Hash& hash, size_t& size) = 0;
   virtual bool getAlreadyGeneratedCoins(const Crypto::Hash& hash, uint64_t& generatedCoins) = 0;
@@ -96,6 +98,8 @@ public:
                               uint64_t& reward, int64_t& emissionChange) = 0;
   virtual bool scanOutputkeysForIndices(const KeyInput& txInToKey, std::list<std::pair<Crypto::Hash, size_t>>& outputReferences) = 0;
   virtual bool getBlockDifficulty(uint32_t height, difficulty_type& difficulty) = 0;
+  virtual bool getBlockSummary(const Crypto::Hash& hash, BlockSummary& summary) = 0;
+  virtual bool getBlockSummaries(uint32_t startHeight, uint32_t count, std::vector<BlockSummary>& summaries) = 0;
   virtual bool getBlockContainingTx(const Crypto::Hash& txId, Crypto::Hash& blockId, uint32_t& blockHeight) = 0;
   virtual bool getMultisigOutputReference(const MultisignatureInput& txInMultisig, std::pair<Crypto::Hash, size_t>& outputReference) = 0;
 
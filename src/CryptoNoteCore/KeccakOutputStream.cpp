@@ -0,0 +1,31 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "KeccakOutputStream.h"
+
+namespace CryptoNote {
+
+KeccakOutputStream::KeccakOutputStream() : size(0) {
+  keccak1600_init(&context);
+}
+
+size_t KeccakOutputStream::writeSome(const void* data, size_t size) {
+  keccak1600_update(&context, static_cast<const uint8_t*>(data), size);
+  this->size += size;
+  return size;
+}
+
+Crypto::Hash KeccakOutputStream::getHash() const {
+  Crypto::Hash hash;
+  keccak1600_final(&context, reinterpret_cast<uint8_t*>(&hash), sizeof(hash));
+  return hash;
+}
+
+size_t KeccakOutputStream::getSize() const {
+  return size;
+}
+
+}
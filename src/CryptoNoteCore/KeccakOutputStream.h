@@ -0,0 +1,32 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include "Common/IOutputStream.h"
+#include "crypto/hash.h"
+
+extern "C" {
+#include "crypto/keccak.h"
+}
+
+namespace CryptoNote {
+
+// Feeds written data into a Keccak state, so that getHash() equals cn_fast_hash of everything written so far
+class KeccakOutputStream : public Common::IOutputStream {
+public:
+  KeccakOutputStream();
+  size_t writeSome(const void* data, size_t size) override;
+
+  Crypto::Hash getHash() const;
+  size_t getSize() const;
+
+private:
+  keccak1600_ctx context;
+  size_t size;
+};
+
+}
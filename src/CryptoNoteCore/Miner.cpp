@@ -20,11 +20,13 @@
 
 #include "crypto/crypto.h"
 #include "Common/CommandLine.h"
+#include "Common/CpuAffinity.h"
 #include "Common/StringTools.h"
 #include "Logging/FileLog.h"
 #include "Serialization/SerializationTools.h"
 
 #include "CryptoNoteFormatUtils.h"
+#include "MiningJob.h"
 #include "TransactionExtra.h"
 
 using namespace Logging;
@@ -42,6 +44,7 @@ namespace CryptoNote
     m_handler(handler),
     m_pausers_count(0),
     m_threads_total(0),
+    m_cpu_affinity(false),
     m_starter_nonce(0),
     m_last_hr_merge_time(0),
     m_hashes(0),
@@ -170,6 +173,19 @@ namespace CryptoNote
       logger(INFO) << "Loaded " << m_extra_messages.size() << " extra messages, current index " << m_config.current_extra_message_index;
     }
 
+    if (config.miningCpuAffinity || config.miningNumaNode >= 0) {
+      m_cpu_affinity = config.miningCpuAffinity;
+      m_mining_cpus = Common::getAvailableCpus(config.miningNumaNode);
+      if (m_mining_cpus.empty()) {
+        if (Common::getAvailableCpus().empty()) {
+          logger(WARNING) << "Mining thread affinity isn't supported on this platform, the threads run on any CPU";
+        } else {
+          logger(ERROR) << "NUMA node " << config.miningNumaNode << " has no CPUs the miner may run on";
+          return false;
+        }
+      }
+    }
+
     if(!config.startMining.empty()) {
       if (!m_currency.parseAccountAddressString(config.startMining, m_mine_address)) {
         logger(ERROR) << "Target account address " << config.startMining << " has wrong format, starting daemon canceled";
@@ -267,17 +283,17 @@ namespace CryptoNote
 
       for (unsigned i = 0; i < nthreads; ++i) {
         threads[i] = std::async(std::launch::async, [&, i]() {
-          Crypto::cn_context localctx;
+          Crypto::cn_context localctx(true);
           Crypto::Hash h;
 
-          Block lb(bl); // copy to local block
+          MiningJob job;
+          if (!job.setBlock(bl)) {
+            return;
+          }
 
           for (uint32_t nonce = startNonce + i; !found; nonce += nthreads) {
-            lb.nonce = nonce;
-
-            if (!get_block_longhash(localctx, lb, h)) {
-              return;
-            }
+            job.setNonce(nonce);
+            job.getLongHash(localctx, h);
 
             if (check_hash(h, diffic)) {
               foundNonce = nonce;
@@ -298,11 +314,15 @@ namespace CryptoNote
 
       return found;
     } else {
+      MiningJob job;
+      if (!job.setBlock(bl)) {
+        return false;
+      }
+
       for (; bl.nonce != std::numeric_limits<uint32_t>::max(); bl.nonce++) {
         Crypto::Hash h;
-        if (!get_block_longhash(context, bl, h)) {
-          return false;
-        }
+        job.setNonce(bl.nonce);
+        job.getLongHash(context, h);
 
         if (check_hash(h, diffic)) {
           return true;
@@ -347,8 +367,25 @@ namespace CryptoNote
     uint32_t nonce = m_starter_nonce + th_local_index;
     difficulty_type local_diff = 0;
     uint32_t local_template_ver = 0;
-    Crypto::cn_context context;
+    if (!m_mining_cpus.empty()) {
+      std::vector<unsigned> cpus = m_mining_cpus;
+      if (m_cpu_affinity) {
+        cpus.assign(1, m_mining_cpus[th_local_index % m_mining_cpus.size()]);
+      }
+
+      if (!Common::setThreadAffinity(cpus)) {
+        logger(WARNING) << "Failed to set the CPU affinity of miner thread [" << th_local_index << "]";
+      }
+    }
+
+    // Created after the thread is pinned, so the scratchpad is on the NUMA node of the CPUs the thread runs on
+    Crypto::cn_context context(true);
+    if (th_local_index == 0 && context.scratchpad_pages() == Crypto::cn_context::page_type::normal) {
+      logger(INFO) << "Huge pages are unavailable, mining scratchpads use normal pages. Reserve huge pages with "
+        "vm.nr_hugepages for a higher hash rate";
+    }
     Block b;
+    MiningJob job;
 
     while(!m_stop)
     {
@@ -366,6 +403,12 @@ namespace CryptoNote
 
         local_template_ver = m_template_no;
         nonce = m_starter_nonce + th_local_index;
+
+        if (local_template_ver && !job.setBlock(b)) {
+          logger(ERROR) << "Failed to get block hashing blob";
+          m_stop = true;
+          continue;
+        }
       }
 
       if(!local_template_ver)//no any set_block_template call
@@ -375,16 +418,14 @@ namespace CryptoNote
         continue;
       }
 
-      b.nonce = nonce;
       Crypto::Hash h;
-      if (!m_stop && !get_block_longhash(context, b, h)) {
-        logger(ERROR) << "Failed to get block long hash";
-        m_stop = true;
-      }
+      job.setNonce(nonce);
+      job.getLongHash(context, h);
 
       if (!m_stop && check_hash(h, local_diff))
       {
         //we lucky!
+        b.nonce = nonce;
         ++m_config.current_extra_message_index;
 
         logger(INFO, GREEN) << "Found block for difficulty: " << local_diff;
@@ -10,6 +10,7 @@
 #include <list>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "CryptoNoteCore/CryptoNoteBasic.h"
 #include "CryptoNoteCore/Currency.h"
@@ -68,6 +69,9 @@ namespace CryptoNote {
     difficulty_type m_diffic;
 
     std::atomic<uint32_t> m_threads_total;
+    // CPUs the mining threads run on, each on its own one with m_cpu_affinity. Empty when they may run on any CPU
+    std::vector<unsigned> m_mining_cpus;
+    bool m_cpu_affinity;
     std::atomic<int32_t> m_pausers_count;
     std::mutex m_miners_count_lock;
 
@@ -14,16 +14,22 @@ namespace {
 const command_line::arg_descriptor<std::string> arg_extra_messages =  {"extra-messages-file", "Specify file for extra messages to include into coinbase transactions", "", true};
 const command_line::arg_descriptor<std::string> arg_start_mining =    {"start-mining", "Specify wallet address to mining for", "", true};
 const command_line::arg_descriptor<uint32_t>    arg_mining_threads =  {"mining-threads", "Specify mining threads count", 0, true};
+const command_line::arg_descriptor<bool>        arg_mining_cpu_affinity = {"mining-cpu-affinity", "Pin every mining thread to its own CPU, Linux only"};
+const command_line::arg_descriptor<int32_t>     arg_mining_numa_node = {"mining-numa-node", "Run mining threads and their scratchpads on this NUMA node, Linux only", -1};
 }
 
 MinerConfig::MinerConfig() {
   miningThreads = 0;
+  miningCpuAffinity = false;
+  miningNumaNode = -1;
 }
 
 void MinerConfig::initOptions(boost::program_options::options_description& desc) {
   command_line::add_arg(desc, arg_extra_messages);
   command_line::add_arg(desc, arg_start_mining);
   command_line::add_arg(desc, arg_mining_threads);
+  command_line::add_arg(desc, arg_mining_cpu_affinity);
+  command_line::add_arg(desc, arg_mining_numa_node);
 }
 
 void MinerConfig::init(const boost::program_options::variables_map& options) {
@@ -38,6 +44,9 @@ void MinerConfig::init(const boost::program_options::variables_map& options) {
   if (command_line::has_arg(options, arg_mining_threads)) {
     miningThreads = command_line::get_arg(options, arg_mining_threads);
   }
+
+  miningCpuAffinity = command_line::get_arg(options, arg_mining_cpu_affinity);
+  miningNumaNode = command_line::get_arg(options, arg_mining_numa_node);
 }
 
 } //namespace CryptoNote
@@ -23,6 +23,9 @@ public:
   std::string extraMessages;
   std::string startMining;
   uint32_t miningThreads;
+  bool miningCpuAffinity;
+  // Negative when the threads may run on any node
+  int32_t miningNumaNode;
 };
 
 } //namespace CryptoNote
@@ -0,0 +1,46 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "MiningJob.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "CryptoNoteFormatUtils.h"
+#include "CryptoNoteSerialization.h"
+#include "CryptoNoteTools.h"
+
+namespace CryptoNote {
+
+MiningJob::MiningJob() : nonceOffset(0), majorVersion(0) {
+}
+
+bool MiningJob::setBlock(const Block& block) {
+  size_t headerSize;
+  if (!getObjectBinarySize(static_cast<const BlockHeader&>(block), headerSize) || !get_block_hashing_blob(block, blob)) {
+    return false;
+  }
+
+  // The blob starts with the serialized header, whose last field is the nonce written as its raw 4 bytes
+  assert(headerSize >= sizeof(block.nonce) && headerSize <= blob.size());
+  nonceOffset = headerSize - sizeof(block.nonce);
+  assert(memcmp(blob.data() + nonceOffset, &block.nonce, sizeof(block.nonce)) == 0);
+  majorVersion = block.majorVersion;
+  return true;
+}
+
+void MiningJob::setNonce(uint32_t nonce) {
+  assert(nonceOffset + sizeof(nonce) <= blob.size());
+  memcpy(blob.data() + nonceOffset, &nonce, sizeof(nonce));
+}
+
+void MiningJob::getLongHash(Crypto::cn_context& context, Crypto::Hash& hash) const {
+  get_block_longhash(context, majorVersion, blob, hash);
+}
+
+}
@@ -0,0 +1,36 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "CryptoNote.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Hashing blob of a block template, serialized and with its transaction tree hash computed once. Trying a nonce only
+// writes its 4 bytes into the blob instead of building the blob again from the block
+class MiningJob {
+public:
+  MiningJob();
+
+  // False if the hashing blob of the block can't be built
+  bool setBlock(const Block& block);
+  void setNonce(uint32_t nonce);
+  void getLongHash(Crypto::cn_context& context, Crypto::Hash& hash) const;
+
+private:
+  BinaryArray blob;
+  size_t nonceOffset;
+  uint8_t majorVersion;
+};
+
+}
@@ -6,6 +6,136 @@
 
 #include "SwappedVector.h"
 
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 namespace {
-char suppressMSVCWarningLNK4221;
+
+// Limit of a single system call, which Windows takes as a 32 bit count and some systems fail above 2 GB
+const size_t MAX_CALL_SIZE = 1 << 30;
+
+}
+
+SwappedVectorFile::SwappedVectorFile() :
+#ifdef _WIN32
+  m_handle(INVALID_HANDLE_VALUE) {
+#else
+  m_descriptor(-1) {
+#endif
+}
+
+SwappedVectorFile::~SwappedVectorFile() {
+  close();
+}
+
+bool SwappedVectorFile::open(const std::string& fileName, bool create) {
+  close();
+#ifdef _WIN32
+  HANDLE handle = ::CreateFileA(fileName.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL,
+    create ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (handle == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  m_handle = handle;
+#else
+  int descriptor = ::open(fileName.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+  if (descriptor == -1) {
+    return false;
+  }
+
+  m_descriptor = descriptor;
+#endif
+  return true;
+}
+
+void SwappedVectorFile::close() {
+#ifdef _WIN32
+  if (m_handle != INVALID_HANDLE_VALUE) {
+    ::CloseHandle(m_handle);
+    m_handle = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (m_descriptor != -1) {
+    ::close(m_descriptor);
+    m_descriptor = -1;
+  }
+#endif
+}
+
+bool SwappedVectorFile::isOpen() const {
+#ifdef _WIN32
+  return m_handle != INVALID_HANDLE_VALUE;
+#else
+  return m_descriptor != -1;
+#endif
+}
+
+bool SwappedVectorFile::read(uint64_t offset, void* data, size_t size) const {
+  char* position = static_cast<char*>(data);
+  while (size != 0) {
+    size_t chunk = std::min(size, MAX_CALL_SIZE);
+#ifdef _WIN32
+    // The offset of an overlapped structure makes the read positional, the file pointer isn't shared between threads
+    OVERLAPPED overlapped = OVERLAPPED();
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD transferred;
+    if (!::ReadFile(m_handle, position, static_cast<DWORD>(chunk), &transferred, &overlapped) || transferred == 0) {
+      return false;
+    }
+#else
+    ssize_t transferred = ::pread(m_descriptor, position, chunk, static_cast<off_t>(offset));
+    if (transferred == -1 && errno == EINTR) {
+      continue;
+    }
+
+    if (transferred <= 0) {
+      return false;
+    }
+#endif
+    position += transferred;
+    offset += transferred;
+    size -= transferred;
+  }
+
+  return true;
+}
+
+bool SwappedVectorFile::write(uint64_t offset, const void* data, size_t size) {
+  const char* position = static_cast<const char*>(data);
+  while (size != 0) {
+    size_t chunk = std::min(size, MAX_CALL_SIZE);
+#ifdef _WIN32
+    OVERLAPPED overlapped = OVERLAPPED();
+    overlapped.Offset = static_cast<DWORD>(offset);
+    overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+    DWORD transferred;
+    if (!::WriteFile(m_handle, position, static_cast<DWORD>(chunk), &transferred, &overlapped) || transferred == 0) {
+      return false;
+    }
+#else
+    ssize_t transferred = ::pwrite(m_descriptor, position, chunk, static_cast<off_t>(offset));
+    if (transferred == -1 && errno == EINTR) {
+      continue;
+    }
+
+    if (transferred <= 0) {
+      return false;
+    }
+#endif
+    position += transferred;
+    offset += transferred;
+    size -= transferred;
+  }
+
+  return true;
 }
@@ -6,21 +6,50 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
 #include <cstddef>
-#include <fstream>
-#include <iomanip>
-#include <iostream>
-#include <list>
-#include <map>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
-#include <cstdio>
-#include "Common/StdInputStream.h"
-#include "Common/StdOutputStream.h"
+#include "Common/MemoryInputStream.h"
+#include "Common/VectorOutputStream.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
 #include "Serialization/BinaryOutputStreamSerializer.h"
 
+// A file read and written at given offsets, so reads of several threads don't share a file position
+class SwappedVectorFile {
+public:
+  SwappedVectorFile();
+  SwappedVectorFile(const SwappedVectorFile&) = delete;
+  ~SwappedVectorFile();
+  SwappedVectorFile& operator=(const SwappedVectorFile&) = delete;
+
+  // Opens an existing file, or creates an empty one in place of any existing one when create is set
+  bool open(const std::string& fileName, bool create);
+  void close();
+  bool isOpen() const;
+  bool read(uint64_t offset, void* data, size_t size) const;
+  bool write(uint64_t offset, const void* data, size_t size);
+
+private:
+#ifdef _WIN32
+  void* m_handle;
+#else
+  int m_descriptor;
+#endif
+};
+
+// Items stored in a file, of which a number are cached deserialized. The reading methods may be called from any number
+// of threads at once, also while a single thread changes the vector with clear, pop_back and push_back. The threads
+// share the cached items, so their const methods must not change them, e.g. by caching values computed lazily.
 template<class T> class SwappedVector {
 public:
   typedef T value_type;
@@ -36,7 +65,7 @@ public:
     const_iterator() {
     }
 
-    const_iterator(SwappedVector* swappedVector, size_t index) : m_swappedVector(swappedVector), m_index(index) {
+    const_iterator(const SwappedVector* swappedVector, size_t index) : m_swappedVector(swappedVector), m_index(index) {
     }
 
     bool operator!=(const const_iterator& other) const {
@@ -107,7 +136,7 @@ public:
       return m_index - other.m_index;
     }
 
-    const_iterator& operator-(difference_type n) const {
+    const_iterator operator-(difference_type n) const {
       return const_iterator(m_swappedVector, m_index - n);
     }
 
@@ -128,7 +157,7 @@ public:
     }
 
   private:
-    SwappedVector* m_swappedVector;
+    const SwappedVector* m_swappedVector;
     size_t m_index;
   };
 
@@ -142,44 +171,78 @@ public:
 
   bool empty() const;
   uint64_t size() const;
-  const_iterator begin();
-  const_iterator end();
-  const T& operator[](uint64_t index);
-  const T& front();
-  const T& back();
+  const_iterator begin() const;
+  const_iterator end() const;
+  // The item stays valid while it is cached and at least for the next few operator[] calls of the thread on any
+  // SwappedVector<T>; a reference kept across other reads should come from get
+  const T& operator[](uint64_t index) const;
+  const T& front() const;
+  const T& back() const;
   void clear();
   void pop_back();
   void push_back(const T& item);
 
-private:
-  struct ItemEntry;
-  struct MoonBankEntry;
+  // The item stays valid as long as the pointer is held
+  std::shared_ptr<const T> get(uint64_t index) const;
+  // Items [first, first + count), those not cached are read with one read per contiguous run and cached
+  std::vector<std::shared_ptr<const T>> getRange(uint64_t first, uint64_t count) const;
+  // Number of items following every getRange range to load in the background, none when 0
+  void setReadAhead(uint64_t count);
 
-  struct ItemEntry {
-  public:
-    T item;
-    typename std::list<MoonBankEntry>::iterator moonbankIter;
+  // Stored size of an item and direct access to its bytes, e.g. to copy out a part of it without deserializing it
+  uint64_t itemSize(uint64_t index) const;
+  void readItemBytes(uint64_t index, uint64_t offset, void* data, uint64_t size) const;
+
+private:
+  static const size_t CACHE_SHARDS = 8;
+  static const size_t PINNED_ITEMS = 16;
+  static const uint64_t MAX_READ_SIZE = 16 * 1024 * 1024;
+
+  struct CacheSlot {
+    uint64_t index;
+    std::shared_ptr<const T> item;
+    bool referenced;
   };
 
-  struct MoonBankEntry {
-  public:
-    typename std::map<uint64_t, ItemEntry>::iterator itemIter;
+  // A part of the cache, which evicts with the CLOCK algorithm: a hit only marks the slot referenced, a miss takes the
+  // first unreferenced slot the hand reaches, unmarking the ones it passes
+  struct CacheShard {
+    std::mutex mutex;
+    std::vector<CacheSlot> slots;
+    std::unordered_map<uint64_t, size_t> positions;
+    size_t capacity;
+    size_t hand;
   };
 
-  std::fstream m_itemsFile;
-  std::fstream m_indexesFile;
+  SwappedVectorFile m_itemsFile;
+  SwappedVectorFile m_indexesFile;
   size_t m_poolSize;
+  mutable std::mutex m_offsetsMutex;
   std::vector<uint64_t> m_offsets;
   uint64_t m_itemsFileSize;
-  std::map<uint64_t, ItemEntry> m_items;
-  std::list<MoonBankEntry> m_moonbank;
-  uint64_t m_moonbankHits;
-  uint64_t m_moonbankMisses;
-
-  T* prepare(uint64_t index);
+  // Changed by every removal, so items read before it aren't cached after it
+  std::atomic<uint64_t> m_generation;
+  std::unique_ptr<CacheShard[]> m_cache;
+  size_t m_cacheShards;
+
+  mutable std::mutex m_readAheadMutex;
+  mutable std::condition_variable m_readAheadCondition;
+  std::thread m_readAheadThread;
+  uint64_t m_readAheadCount;
+  mutable uint64_t m_readAheadFirst;
+  mutable uint64_t m_readAheadEnd;
+  bool m_readAheadStop;
+
+  std::shared_ptr<const T> findCached(uint64_t index) const;
+  void cache(uint64_t index, const std::shared_ptr<const T>& item, uint64_t generation) const;
+  void uncache(uint64_t index);
+  void load(uint64_t first, std::vector<std::shared_ptr<const T>>& items) const;
+  void readAhead();
+  void stopReadAhead();
 };
 
-template<class T> SwappedVector<T>::SwappedVector() {
+template<class T> SwappedVector<T>::SwappedVector() : m_poolSize(0), m_itemsFileSize(0), m_generation(0), m_cacheShards(0),
+  m_readAheadCount(0), m_readAheadFirst(0), m_readAheadEnd(0), m_readAheadStop(false) {
 }
 
 template<class T> SwappedVector<T>::~SwappedVector() {
@@ -187,211 +250,407 @@ template<class T> SwappedVector<T>::~SwappedVector() {
 }
 
 template<class T> bool SwappedVector<T>::open(const std::string& itemFileName, const std::string& indexFileName, size_t poolSize) {
+  close();
   if (poolSize == 0) {
     return false;
   }
 
-  m_itemsFile.open(itemFileName, std::ios::in | std::ios::out | std::ios::binary);
-  m_indexesFile.open(indexFileName, std::ios::in | std::ios::out | std::ios::binary);
-  if (m_itemsFile && m_indexesFile) {
+  std::vector<uint64_t> offsets;
+  uint64_t itemsFileSize = 0;
+  if (m_itemsFile.open(itemFileName, false) && m_indexesFile.open(indexFileName, false)) {
     uint64_t count;
-    m_indexesFile.read(reinterpret_cast<char*>(&count), sizeof count);
-    if (!m_indexesFile) {
+    if (!m_indexesFile.read(0, &count, sizeof count) || count > UINT32_MAX) {
       return false;
     }
 
-    std::vector<uint64_t> offsets;
-    uint64_t itemsFileSize = 0;
-    for (uint64_t i = 0; i < count; ++i) {
-      uint32_t itemSize;
-      m_indexesFile.read(reinterpret_cast<char*>(&itemSize), sizeof itemSize);
-      if (!m_indexesFile) {
-        return false;
-      }
+    std::vector<uint32_t> itemSizes(static_cast<size_t>(count));
+    if (count != 0 && !m_indexesFile.read(sizeof count, itemSizes.data(), itemSizes.size() * sizeof(uint32_t))) {
+      return false;
+    }
 
+    offsets.reserve(itemSizes.size());
+    for (uint32_t itemSize : itemSizes) {
       offsets.emplace_back(itemsFileSize);
       itemsFileSize += itemSize;
     }
-
-    m_offsets.swap(offsets);
-    m_itemsFileSize = itemsFileSize;
   } else {
-    m_itemsFile.open(itemFileName, std::ios::out | std::ios::binary);
-    m_itemsFile.close();
-    m_itemsFile.open(itemFileName, std::ios::in | std::ios::out | std::ios::binary);
-    m_indexesFile.open(indexFileName, std::ios::out | std::ios::binary);
-    uint64_t count = 0;
-    m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
-    if (!m_indexesFile) {
+    if (!m_itemsFile.open(itemFileName, true) || !m_indexesFile.open(indexFileName, true)) {
       return false;
     }
 
-    m_indexesFile.close();
-    m_indexesFile.open(indexFileName, std::ios::in | std::ios::out | std::ios::binary);
-    m_offsets.clear();
-    m_itemsFileSize = 0;
+    uint64_t count = 0;
+    if (!m_indexesFile.write(0, &count, sizeof count)) {
+      return false;
+    }
   }
 
+  m_offsets.swap(offsets);
+  m_itemsFileSize = itemsFileSize;
   m_poolSize = poolSize;
-  m_items.clear();
-  m_moonbank.clear();
-  m_moonbankHits = 0;
-  m_moonbankMisses = 0;
+  m_cacheShards = std::min(poolSize, static_cast<size_t>(CACHE_SHARDS));
+  m_cache.reset(new CacheShard[m_cacheShards]);
+  for (size_t i = 0; i < m_cacheShards; ++i) {
+    m_cache[i].capacity = poolSize / m_cacheShards + (i < poolSize % m_cacheShards ? 1 : 0);
+    m_cache[i].slots.reserve(m_cache[i].capacity);
+    m_cache[i].hand = 0;
+  }
+
   return true;
 }
 
 template<class T> void SwappedVector<T>::close() {
+  stopReadAhead();
+  m_itemsFile.close();
+  m_indexesFile.close();
 }
 
 template<class T> bool SwappedVector<T>::empty() const {
-  return m_offsets.empty();
+  return size() == 0;
 }
 
 template<class T> uint64_t SwappedVector<T>::size() const {
+  std::lock_guard<std::mutex> lock(m_offsetsMutex);
   return m_offsets.size();
 }
 
-template<class T> typename SwappedVector<T>::const_iterator SwappedVector<T>::begin() {
+template<class T> typename SwappedVector<T>::const_iterator SwappedVector<T>::begin() const {
   return const_iterator(this, 0);
 }
 
-template<class T> typename SwappedVector<T>::const_iterator SwappedVector<T>::end() {
-  return const_iterator(this, m_offsets.size());
+template<class T> typename SwappedVector<T>::const_iterator SwappedVector<T>::end() const {
+  return const_iterator(this, size());
 }
 
-template<class T> const T& SwappedVector<T>::operator[](uint64_t index) {
-  auto itemIter = m_items.find(index);
-  if (itemIter != m_items.end()) {
-    if (itemIter->second.moonbankIter != --m_moonbank.end()) {
-      m_moonbank.splice(m_moonbank.end(), m_moonbank, itemIter->second.moonbankIter);
-    }
+template<class T> const T& SwappedVector<T>::operator[](uint64_t index) const {
+  // Reads of other threads may evict the item any time, so the last ones returned on this thread are held here
+  static thread_local std::shared_ptr<const T> pinned[PINNED_ITEMS];
+  static thread_local size_t nextPinned = 0;
+  std::shared_ptr<const T> item = get(index);
+  pinned[nextPinned] = item;
+  nextPinned = (nextPinned + 1) % PINNED_ITEMS;
+  return *item;
+}
+
+template<class T> const T& SwappedVector<T>::front() const {
+  return operator[](0);
+}
+
+template<class T> const T& SwappedVector<T>::back() const {
+  return operator[](size() - 1);
+}
 
-    ++m_moonbankHits;
-    return itemIter->second.item;
+template<class T> void SwappedVector<T>::clear() {
+  uint64_t count = 0;
+  if (!m_indexesFile.write(0, &count, sizeof count)) {
+    throw std::runtime_error("SwappedVector::clear");
   }
 
-  if (index >= m_offsets.size()) {
-    throw std::runtime_error("SwappedVector::operator[]");
+  {
+    std::lock_guard<std::mutex> lock(m_offsetsMutex);
+    m_offsets.clear();
+    m_itemsFileSize = 0;
+    ++m_generation;
   }
 
-  if (!m_itemsFile) {
-    throw std::runtime_error("SwappedVector::operator[]");
+  for (size_t i = 0; i < m_cacheShards; ++i) {
+    CacheShard& shard = m_cache[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.slots.clear();
+    shard.positions.clear();
+    shard.hand = 0;
   }
+}
 
-  m_itemsFile.seekg(m_offsets[index]);
-  T tempItem;
-  
-  Common::StdInputStream stream(m_itemsFile);
-  CryptoNote::BinaryInputStreamSerializer archive(stream);
-  serialize(tempItem, archive);
+template<class T> void SwappedVector<T>::pop_back() {
+  uint64_t count = m_offsets.size() - 1;
+  if (!m_indexesFile.write(0, &count, sizeof count)) {
+    throw std::runtime_error("SwappedVector::pop_back");
+  }
 
-  T* item = prepare(index);
-  std::swap(tempItem, *item);
-  ++m_moonbankMisses;
-  return *item;
-}
+  {
+    std::lock_guard<std::mutex> lock(m_offsetsMutex);
+    m_itemsFileSize = m_offsets.back();
+    m_offsets.pop_back();
+    ++m_generation;
+  }
 
-template<class T> const T& SwappedVector<T>::front() {
-  return operator[](0);
+  uncache(count);
 }
 
-template<class T> const T& SwappedVector<T>::back() {
-  return operator[](m_offsets.size() - 1);
+template<class T> void SwappedVector<T>::push_back(const T& item) {
+  std::vector<uint8_t> data;
+  {
+    Common::VectorOutputStream stream(data);
+    CryptoNote::BinaryOutputStreamSerializer archive(stream);
+    serialize(const_cast<T&>(item), archive);
+  }
+
+  if (!m_itemsFile.write(m_itemsFileSize, data.data(), data.size())) {
+    throw std::runtime_error("SwappedVector::push_back");
+  }
+
+  uint64_t index = m_offsets.size();
+  uint32_t itemSize = static_cast<uint32_t>(data.size());
+  if (!m_indexesFile.write(sizeof(uint64_t) + sizeof(uint32_t) * index, &itemSize, sizeof itemSize)) {
+    throw std::runtime_error("SwappedVector::push_back");
+  }
+
+  uint64_t count = index + 1;
+  if (!m_indexesFile.write(0, &count, sizeof count)) {
+    throw std::runtime_error("SwappedVector::push_back");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_offsetsMutex);
+    m_offsets.push_back(m_itemsFileSize);
+    m_itemsFileSize += data.size();
+  }
+
+  cache(index, std::make_shared<T>(item), m_generation);
 }
 
-template<class T> void SwappedVector<T>::clear() {
-  if (!m_indexesFile) {
-    throw std::runtime_error("SwappedVector::clear");
+template<class T> std::shared_ptr<const T> SwappedVector<T>::get(uint64_t index) const {
+  if (index >= size()) {
+    throw std::runtime_error("SwappedVector::get");
   }
 
-  m_indexesFile.seekp(0);
-  uint64_t count = 0;
-  m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
-  if (!m_indexesFile) {
-    throw std::runtime_error("SwappedVector::clear");
+  std::shared_ptr<const T> item = findCached(index);
+  if (!item) {
+    std::vector<std::shared_ptr<const T>> items(1);
+    load(index, items);
+    item = std::move(items[0]);
   }
 
-  m_offsets.clear();
-  m_itemsFileSize = 0;
-  m_items.clear();
-  m_moonbank.clear();
+  return item;
 }
 
-template<class T> void SwappedVector<T>::pop_back() {
-  if (!m_indexesFile) {
-    throw std::runtime_error("SwappedVector::pop_back");
+template<class T> std::vector<std::shared_ptr<const T>> SwappedVector<T>::getRange(uint64_t first, uint64_t count) const {
+  if (first > size() || count > size() - first) {
+    throw std::runtime_error("SwappedVector::getRange");
   }
 
-  m_indexesFile.seekp(0);
-  uint64_t count = m_offsets.size() - 1;
-  m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
-  if (!m_indexesFile) {
-    throw std::runtime_error("SwappedVector::pop_back");
+  std::vector<std::shared_ptr<const T>> items(static_cast<size_t>(count));
+  for (size_t i = 0; i < items.size(); ++i) {
+    items[i] = findCached(first + i);
   }
 
-  m_itemsFileSize = m_offsets.back();
-  m_offsets.pop_back();
-  auto itemIter = m_items.find(m_offsets.size());
-  if (itemIter != m_items.end()) {
-    m_moonbank.erase(itemIter->second.moonbankIter);
-    m_items.erase(itemIter);
+  load(first, items);
+
+  std::lock_guard<std::mutex> lock(m_readAheadMutex);
+  if (m_readAheadCount != 0) {
+    m_readAheadFirst = first + count;
+    m_readAheadEnd = first + count + m_readAheadCount;
+    m_readAheadCondition.notify_one();
   }
+
+  return items;
 }
 
-template<class T> void SwappedVector<T>::push_back(const T& item) {
-  uint64_t itemsFileSize;
+template<class T> void SwappedVector<T>::setReadAhead(uint64_t count) {
+  // More would evict the items read ahead before they are used
+  count = std::min<uint64_t>(count, m_poolSize / 2);
+  if (count == 0) {
+    stopReadAhead();
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_readAheadMutex);
+  m_readAheadCount = count;
+  if (!m_readAheadThread.joinable()) {
+    m_readAheadStop = false;
+    m_readAheadFirst = 0;
+    m_readAheadEnd = 0;
+    m_readAheadThread = std::thread(&SwappedVector::readAhead, this);
+  }
+}
+
+template<class T> uint64_t SwappedVector<T>::itemSize(uint64_t index) const {
+  std::lock_guard<std::mutex> lock(m_offsetsMutex);
+  if (index >= m_offsets.size()) {
+    throw std::runtime_error("SwappedVector::itemSize");
+  }
+
+  uint64_t end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_itemsFileSize;
+  return end - m_offsets[index];
+}
 
+template<class T> void SwappedVector<T>::readItemBytes(uint64_t index, uint64_t offset, void* data, uint64_t size) const {
+  uint64_t itemOffset;
   {
-    if (!m_itemsFile) {
-      throw std::runtime_error("SwappedVector::push_back");
+    std::lock_guard<std::mutex> lock(m_offsetsMutex);
+    if (index >= m_offsets.size()) {
+      throw std::runtime_error("SwappedVector::readItemBytes");
+    }
+
+    uint64_t end = index + 1 < m_offsets.size() ? m_offsets[index + 1] : m_itemsFileSize;
+    if (offset > end - m_offsets[index] || size > end - m_offsets[index] - offset) {
+      throw std::runtime_error("SwappedVector::readItemBytes");
     }
 
-    m_itemsFile.seekp(m_itemsFileSize);
+    itemOffset = m_offsets[index];
+  }
 
-    Common::StdOutputStream stream(m_itemsFile);
-    CryptoNote::BinaryOutputStreamSerializer archive(stream);
-    serialize(const_cast<T&>(item), archive);
+  if (!m_itemsFile.read(itemOffset + offset, data, static_cast<size_t>(size))) {
+    throw std::runtime_error("SwappedVector::readItemBytes");
+  }
+}
+
+template<class T> std::shared_ptr<const T> SwappedVector<T>::findCached(uint64_t index) const {
+  CacheShard& shard = m_cache[index % m_cacheShards];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto position = shard.positions.find(index);
+  if (position == shard.positions.end()) {
+    return nullptr;
+  }
 
-    itemsFileSize = m_itemsFile.tellp();
+  CacheSlot& slot = shard.slots[position->second];
+  slot.referenced = true;
+  return slot.item;
+}
+
+template<class T> void SwappedVector<T>::cache(uint64_t index, const std::shared_ptr<const T>& item, uint64_t generation) const {
+  CacheShard& shard = m_cache[index % m_cacheShards];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  if (generation != m_generation) {
+    // An item was removed after this one was read, which might have been it
+    return;
+  }
+
+  auto position = shard.positions.find(index);
+  if (position != shard.positions.end()) {
+    CacheSlot& slot = shard.slots[position->second];
+    slot.item = item;
+    slot.referenced = true;
+    return;
+  }
+
+  if (shard.slots.size() < shard.capacity) {
+    shard.positions.emplace(index, shard.slots.size());
+    shard.slots.push_back(CacheSlot{index, item, true});
+    return;
+  }
+
+  while (shard.slots[shard.hand].referenced) {
+    shard.slots[shard.hand].referenced = false;
+    shard.hand = (shard.hand + 1) % shard.slots.size();
+  }
+
+  CacheSlot& slot = shard.slots[shard.hand];
+  shard.positions.erase(slot.index);
+  shard.positions.emplace(index, shard.hand);
+  slot.index = index;
+  slot.item = item;
+  slot.referenced = true;
+  shard.hand = (shard.hand + 1) % shard.slots.size();
+}
+
+template<class T> void SwappedVector<T>::uncache(uint64_t index) {
+  CacheShard& shard = m_cache[index % m_cacheShards];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto position = shard.positions.find(index);
+  if (position == shard.positions.end()) {
+    return;
+  }
+
+  // The last slot takes the place of the removed one
+  size_t removed = position->second;
+  shard.positions.erase(position);
+  if (removed + 1 != shard.slots.size()) {
+    shard.slots[removed] = std::move(shard.slots.back());
+    shard.positions[shard.slots[removed].index] = removed;
+  }
+
+  shard.slots.pop_back();
+  if (shard.hand >= shard.slots.size()) {
+    shard.hand = 0;
   }
+}
 
+// Reads the items of the null pointers, items[i] being item first + i
+template<class T> void SwappedVector<T>::load(uint64_t first, std::vector<std::shared_ptr<const T>>& items) const {
+  std::vector<uint64_t> offsets;
+  uint64_t generation;
   {
-    if (!m_indexesFile) {
-      throw std::runtime_error("SwappedVector::push_back");
+    std::lock_guard<std::mutex> lock(m_offsetsMutex);
+    if (first > m_offsets.size() || items.size() > m_offsets.size() - first) {
+      throw std::runtime_error("SwappedVector::load");
+    }
+
+    uint64_t end = first + items.size();
+    offsets.assign(m_offsets.begin() + first, m_offsets.begin() + end);
+    offsets.push_back(end < m_offsets.size() ? m_offsets[end] : m_itemsFileSize);
+    generation = m_generation;
+  }
+
+  std::vector<uint8_t> buffer;
+  size_t i = 0;
+  while (i < items.size()) {
+    if (items[i]) {
+      ++i;
+      continue;
+    }
+
+    size_t runEnd = i + 1;
+    while (runEnd < items.size() && !items[runEnd] && offsets[runEnd + 1] - offsets[i] <= MAX_READ_SIZE) {
+      ++runEnd;
     }
 
-    m_indexesFile.seekp(sizeof(uint64_t) + sizeof(uint32_t) * m_offsets.size());
-    uint32_t itemSize = static_cast<uint32_t>(itemsFileSize - m_itemsFileSize);
-    m_indexesFile.write(reinterpret_cast<char*>(&itemSize), sizeof itemSize);
-    if (!m_indexesFile) {
-      throw std::runtime_error("SwappedVector::push_back");
+    buffer.resize(static_cast<size_t>(offsets[runEnd] - offsets[i]));
+    if (!m_itemsFile.read(offsets[i], buffer.data(), buffer.size())) {
+      throw std::runtime_error("SwappedVector::load");
     }
 
-    m_indexesFile.seekp(0);
-    uint64_t count = m_offsets.size() + 1;
-    m_indexesFile.write(reinterpret_cast<char*>(&count), sizeof count);
-    if (!m_indexesFile) {
-      throw std::runtime_error("SwappedVector::push_back");
+    uint64_t runOffset = offsets[i];
+    for (; i < runEnd; ++i) {
+      Common::MemoryInputStream stream(buffer.data() + (offsets[i] - runOffset), static_cast<size_t>(offsets[i + 1] - offsets[i]));
+      CryptoNote::BinaryInputStreamSerializer archive(stream);
+      std::shared_ptr<T> item = std::make_shared<T>();
+      serialize(*item, archive);
+      items[i] = std::move(item);
+      cache(first + i, items[i], generation);
     }
   }
+}
 
-  m_offsets.push_back(m_itemsFileSize);
-  m_itemsFileSize = itemsFileSize;
+template<class T> void SwappedVector<T>::readAhead() {
+  std::unique_lock<std::mutex> lock(m_readAheadMutex);
+  for (;;) {
+    m_readAheadCondition.wait(lock, [this] { return m_readAheadStop || m_readAheadFirst < m_readAheadEnd; });
+    if (m_readAheadStop) {
+      return;
+    }
+
+    uint64_t first = m_readAheadFirst;
+    uint64_t end = m_readAheadEnd;
+    m_readAheadFirst = m_readAheadEnd;
+    lock.unlock();
+    try {
+      end = std::min(end, size());
+      if (first < end) {
+        std::vector<std::shared_ptr<const T>> items(static_cast<size_t>(end - first));
+        for (size_t i = 0; i < items.size(); ++i) {
+          items[i] = findCached(first + i);
+        }
+
+        load(first, items);
+      }
+    } catch (std::exception&) {
+      // Reading ahead is only a hint, the reader of the items gets any error itself
+    }
 
-  T* newItem = prepare(m_offsets.size() - 1);
-  *newItem = item;
+    lock.lock();
+  }
 }
 
-template<class T> T* SwappedVector<T>::prepare(uint64_t index) {
-  if (m_items.size() == m_poolSize) {
-    auto moonbankIter = m_moonbank.begin();
-    m_items.erase(moonbankIter->itemIter);
-    m_moonbank.erase(moonbankIter);
+template<class T> void SwappedVector<T>::stopReadAhead() {
+  {
+    std::lock_guard<std::mutex> lock(m_readAheadMutex);
+    m_readAheadCount = 0;
+    m_readAheadStop = true;
+    m_readAheadCondition.notify_one();
   }
 
-  auto itemIter = m_items.insert(std::make_pair(index, ItemEntry()));
-  MoonBankEntry moonbankEntry = { itemIter.first };
-  auto moonbankIter = m_moonbank.insert(m_moonbank.end(), moonbankEntry);
-  itemIter.first->second.moonbankIter = moonbankIter;
-  return &itemIter.first->second.item;
+  if (m_readAheadThread.joinable()) {
+    m_readAheadThread.join();
+  }
 }
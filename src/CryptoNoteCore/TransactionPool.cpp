@@ -478,11 +478,11 @@ namespace CryptoNote
       {
         total_size += txd.blobSize;
         fee += txd.fee;
-        logger(DEBUGGING) << "Transaction " << txd.id << " included in the block template";
+        LAZY_LOG(logger, DEBUGGING) << "Transaction " << txd.id << " included in the block template";
       }
       else
       {
-        logger(DEBUGGING) << "Transaction " << txd.id << " was not included in the block template";
+        LAZY_LOG(logger, DEBUGGING) << "Transaction " << txd.id << " was not included in the block template";
       }
     }
 
@@ -0,0 +1,502 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "ViewKeyScanner.h"
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+
+#include "Common/StringTools.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/TransactionUtils.h"
+
+using namespace Logging;
+
+namespace CryptoNote {
+
+namespace {
+
+const uint32_t BLOCKS_PER_BATCH = 200;
+// A wallet whose last scanned block left the main chain rescans this many blocks. Matches of a reorganization deeper
+// than that are kept
+const uint32_t FORK_RESCAN_DEPTH = 100;
+
+// Takes the same time wherever the keys differ, so the RPC response time doesn't reveal a stored key byte by byte
+bool secretKeysEqual(const Crypto::SecretKey& first, const Crypto::SecretKey& second) {
+  volatile uint8_t difference = 0;
+  for (size_t i = 0; i < sizeof(first.data); ++i) {
+    difference |= first.data[i] ^ second.data[i];
+  }
+
+  return difference == 0;
+}
+
+}
+
+ViewKeyScanner::ViewKeyScanner(core& core, Logging::ILogger& logger, size_t threadCount, size_t maxWalletCount,
+  std::chrono::seconds idleTimeout, size_t maxRegistrationsPerMinute) :
+  m_core(core), logger(logger, "ViewKeyScanner"), m_threadCount(std::max<size_t>(threadCount, 1)),
+  m_maxWalletCount(maxWalletCount), m_idleTimeout(idleTimeout), m_maxRegistrationsPerMinute(maxRegistrationsPerMinute),
+  m_stop(false) {
+}
+
+ViewKeyScanner::~ViewKeyScanner() {
+  stop();
+}
+
+void ViewKeyScanner::start() {
+  m_stop = false;
+  m_poolStop = false;
+  for (size_t i = 1; i < m_threadCount; ++i) {
+    m_poolThreads.emplace_back(&ViewKeyScanner::poolLoop, this, i);
+  }
+
+  m_core.addObserver(this);
+  m_scanThread = std::thread(&ViewKeyScanner::scanLoop, this);
+}
+
+void ViewKeyScanner::stop() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+
+  m_workAvailable.notify_all();
+  if (m_scanThread.joinable()) {
+    m_scanThread.join();
+    m_core.removeObserver(this);
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    m_poolStop = true;
+  }
+
+  m_poolWorkAvailable.notify_all();
+  for (std::thread& thread : m_poolThreads) {
+    thread.join();
+  }
+
+  m_poolThreads.clear();
+}
+
+bool ViewKeyScanner::addWallet(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& viewSecretKey,
+  uint32_t startHeight, std::string& error) {
+  Crypto::PublicKey viewPublicKey;
+  if (!Crypto::secret_key_to_public_key(viewSecretKey, viewPublicKey)) {
+    error = "Invalid view secret key";
+    return false;
+  }
+
+  if (!Crypto::check_key(spendPublicKey)) {
+    error = "Invalid spend public key";
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto now = std::chrono::steady_clock::now();
+    auto it = findWallet(spendPublicKey, viewSecretKey);
+    if (it != m_wallets.end()) {
+      it->lastAccess = now;
+      return true;
+    }
+
+    while (!m_registrationTimes.empty() && now - m_registrationTimes.front() >= std::chrono::minutes(1)) {
+      m_registrationTimes.pop_front();
+    }
+
+    if (m_maxRegistrationsPerMinute != 0 && m_registrationTimes.size() >= m_maxRegistrationsPerMinute) {
+      error = "Too many registrations, try again later";
+      return false;
+    }
+
+    removeIdleWallets();
+    if (m_wallets.size() >= m_maxWalletCount) {
+      error = "Too many registered wallets";
+      return false;
+    }
+
+    Wallet wallet;
+    wallet.address.spendPublicKey = spendPublicKey;
+    wallet.address.viewPublicKey = viewPublicKey;
+    wallet.viewSecretKey = viewSecretKey;
+    wallet.startHeight = startHeight;
+    wallet.scannedHeight = startHeight;
+    wallet.lastBlockHash = NULL_HASH;
+    wallet.lastAccess = now;
+    m_wallets.push_back(std::move(wallet));
+    m_registrationTimes.push_back(now);
+    m_workPending = true;
+  }
+
+  m_workAvailable.notify_all();
+  logger(DEBUGGING) << "Registered wallet " << Common::podToHex(spendPublicKey) << " from height " << startHeight;
+  return true;
+}
+
+bool ViewKeyScanner::removeWallet(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& viewSecretKey) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = findWallet(spendPublicKey, viewSecretKey);
+  if (it == m_wallets.end()) {
+    return false;
+  }
+
+  m_wallets.erase(it);
+  logger(DEBUGGING) << "Unregistered wallet " << Common::podToHex(spendPublicKey);
+  return true;
+}
+
+bool ViewKeyScanner::getMatches(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& viewSecretKey,
+  uint32_t startHeight, size_t maxCount, std::vector<Match>& matches, uint32_t& nextHeight) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = findWallet(spendPublicKey, viewSecretKey);
+  if (it == m_wallets.end()) {
+    return false;
+  }
+
+  it->lastAccess = std::chrono::steady_clock::now();
+  const std::vector<Match>& found = it->matches;
+  auto match = std::lower_bound(found.begin(), found.end(), startHeight,
+    [](const Match& m, uint32_t height) { return m.blockHeight < height; });
+
+  for (; match != found.end(); ++match) {
+    if (!matches.empty() && matches.size() >= maxCount && match->blockHeight != matches.back().blockHeight) {
+      nextHeight = match->blockHeight;
+      return true;
+    }
+
+    matches.push_back(*match);
+  }
+
+  nextHeight = std::max(startHeight, it->scannedHeight);
+  return true;
+}
+
+void ViewKeyScanner::blockchainUpdated() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_workPending = true;
+  }
+
+  m_workAvailable.notify_all();
+}
+
+void ViewKeyScanner::scanLoop() {
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_workAvailable.wait(lock, [this] { return m_stop || m_workPending; });
+      if (m_stop) {
+        return;
+      }
+
+      m_workPending = false;
+      removeIdleWallets();
+    }
+
+    try {
+      while (!m_stop && scanNextBatch()) {
+      }
+    } catch (std::exception& e) {
+      logger(ERROR, BRIGHT_RED) << "Failed to scan blocks: " << e.what();
+    }
+  }
+}
+
+// The core is never called with m_mutex held, since it may notify blockchainUpdated with its own lock held. Only this
+// thread changes the scanned heights, so they stay valid between the locked sections
+bool ViewKeyScanner::scanNextBatch() {
+  uint32_t chainHeight = m_core.get_current_blockchain_height();
+  rollBackForks(chainHeight);
+
+  std::vector<Wallet> wallets;
+  uint32_t batchStart = chainHeight;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const Wallet& wallet : m_wallets) {
+      if (wallet.scannedHeight < chainHeight) {
+        Wallet copy;
+        copy.address = wallet.address;
+        copy.viewSecretKey = wallet.viewSecretKey;
+        copy.startHeight = wallet.startHeight;
+        copy.scannedHeight = wallet.scannedHeight;
+        copy.lastBlockHash = wallet.lastBlockHash;
+        wallets.push_back(std::move(copy));
+        batchStart = std::min(batchStart, wallet.scannedHeight);
+      }
+    }
+  }
+
+  if (wallets.empty()) {
+    return false;
+  }
+
+  uint32_t batchEnd = std::min(chainHeight, batchStart + BLOCKS_PER_BATCH);
+  std::list<Block> blocks;
+  std::list<Transaction> transactions;
+  if (!m_core.get_blocks(batchStart, batchEnd - batchStart, blocks, transactions) || blocks.empty()) {
+    // The chain got shorter since its height was read
+    return true;
+  }
+
+  batchEnd = batchStart + static_cast<uint32_t>(blocks.size());
+  std::vector<ScannedTransaction> scanned;
+  std::vector<Crypto::Hash> blockHashes;
+  auto transaction = transactions.begin();
+  uint32_t height = batchStart;
+  for (const Block& block : blocks) {
+    Crypto::Hash blockHash = get_block_hash(block);
+    blockHashes.push_back(blockHash);
+    scanned.push_back({ getObjectHash(block.baseTransaction), &block.baseTransaction, blockHash, height });
+    for (const Crypto::Hash& transactionHash : block.transactionHashes) {
+      if (transaction == transactions.end()) {
+        logger(ERROR, BRIGHT_RED) << "Transactions of block " << height << " are missing";
+        return false;
+      }
+
+      scanned.push_back({ transactionHash, &*transaction, blockHash, height });
+      ++transaction;
+    }
+
+    ++height;
+  }
+
+  std::vector<std::vector<Match>> matches;
+  findMatches(scanned, wallets, matches);
+
+  std::unordered_map<Crypto::Hash, std::vector<uint32_t>> globalIndexes;
+  for (std::vector<Match>& walletMatches : matches) {
+    for (Match& match : walletMatches) {
+      auto it = globalIndexes.find(match.transactionHash);
+      if (it == globalIndexes.end()) {
+        std::vector<uint32_t> indexes;
+        if (!m_core.get_tx_outputs_gindexs(match.transactionHash, indexes)) {
+          // Popped since the batch was read, the next pass rolls the wallets back
+          return true;
+        }
+
+        it = globalIndexes.emplace(match.transactionHash, std::move(indexes)).first;
+      }
+
+      for (uint32_t outputIndex : match.outputIndexes) {
+        if (outputIndex >= it->second.size()) {
+          logger(ERROR, BRIGHT_RED) << "No global index for output " << outputIndex << " of transaction " <<
+            Common::podToHex(match.transactionHash);
+          return false;
+        }
+
+        match.globalOutputIndexes.push_back(it->second[outputIndex]);
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (size_t i = 0; i < wallets.size(); ++i) {
+    const Wallet& scannedWallet = wallets[i];
+    auto it = findWallet(scannedWallet.address.spendPublicKey, scannedWallet.viewSecretKey);
+    if (it == m_wallets.end() || it->scannedHeight != scannedWallet.scannedHeight) {
+      continue;
+    }
+
+    // Skip wallets whose last block was replaced after the fork check, they are rolled back on the next pass
+    uint32_t offset = scannedWallet.scannedHeight - batchStart;
+    const Crypto::Hash& previousHash = offset == 0 ? blocks.front().previousBlockHash : blockHashes[offset - 1];
+    if (scannedWallet.lastBlockHash != NULL_HASH && scannedWallet.lastBlockHash != previousHash) {
+      continue;
+    }
+
+    std::move(matches[i].begin(), matches[i].end(), std::back_inserter(it->matches));
+    it->scannedHeight = batchEnd;
+    it->lastBlockHash = blockHashes.back();
+  }
+
+  logger(DEBUGGING) << "Scanned blocks " << batchStart << " - " << batchEnd - 1 << " for " << wallets.size() << " wallets";
+  return true;
+}
+
+void ViewKeyScanner::rollBackForks(uint32_t chainHeight) {
+  std::vector<std::pair<size_t, Crypto::Hash>> lastBlocks;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (size_t i = 0; i < m_wallets.size(); ++i) {
+      if (m_wallets[i].lastBlockHash != NULL_HASH) {
+        lastBlocks.emplace_back(i, m_wallets[i].lastBlockHash);
+      }
+    }
+  }
+
+  std::vector<Crypto::Hash> forkedBlocks;
+  std::unordered_map<uint32_t, Crypto::Hash> chainBlocks;
+  for (const auto& lastBlock : lastBlocks) {
+    uint32_t height;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (lastBlock.first >= m_wallets.size() || m_wallets[lastBlock.first].lastBlockHash != lastBlock.second) {
+        continue;
+      }
+
+      height = m_wallets[lastBlock.first].scannedHeight - 1;
+    }
+
+    auto chainBlock = chainBlocks.find(height);
+    if (chainBlock == chainBlocks.end()) {
+      chainBlock = chainBlocks.emplace(height, m_core.getBlockIdByHeight(height)).first;
+    }
+
+    if (chainBlock->second != lastBlock.second) {
+      forkedBlocks.push_back(lastBlock.second);
+    }
+  }
+
+  if (forkedBlocks.empty()) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (Wallet& wallet : m_wallets) {
+    if (std::find(forkedBlocks.begin(), forkedBlocks.end(), wallet.lastBlockHash) == forkedBlocks.end()) {
+      continue;
+    }
+
+    uint32_t height = wallet.scannedHeight > FORK_RESCAN_DEPTH ? wallet.scannedHeight - FORK_RESCAN_DEPTH : 0;
+    height = std::max(std::min(height, chainHeight), wallet.startHeight);
+    auto firstDropped = std::lower_bound(wallet.matches.begin(), wallet.matches.end(), height,
+      [](const Match& m, uint32_t h) { return m.blockHeight < h; });
+    wallet.matches.erase(firstDropped, wallet.matches.end());
+    logger(DEBUGGING) << "Block " << wallet.scannedHeight - 1 << " of wallet " << Common::podToHex(wallet.address.spendPublicKey) <<
+      " left the main chain, rescanning from " << height;
+    wallet.scannedHeight = height;
+    wallet.lastBlockHash = NULL_HASH;
+  }
+}
+
+void ViewKeyScanner::findMatches(const std::vector<ScannedTransaction>& transactions, const std::vector<Wallet>& wallets,
+  std::vector<std::vector<Match>>& matches) {
+  size_t threadCount = std::max<size_t>(std::min(m_threadCount, transactions.size()), 1);
+  std::vector<std::vector<std::vector<Match>>> found(threadCount, std::vector<std::vector<Match>>(wallets.size()));
+
+  // Every thread takes a contiguous range, so concatenating their results keeps the chain order
+  auto scanRange = [&](size_t thread) {
+    size_t begin = transactions.size() * thread / threadCount;
+    size_t end = transactions.size() * (thread + 1) / threadCount;
+    for (size_t i = begin; i < end; ++i) {
+      const ScannedTransaction& transaction = transactions[i];
+      if (getTransactionPublicKeyFromExtra(transaction.prefix->extra) == NULL_PUBLIC_KEY) {
+        continue;
+      }
+
+      for (size_t w = 0; w < wallets.size(); ++w) {
+        if (transaction.blockHeight < wallets[w].scannedHeight) {
+          continue;
+        }
+
+        std::vector<uint32_t> outputIndexes;
+        uint64_t amount = 0;
+        findOutputsToAccount(*transaction.prefix, wallets[w].address, wallets[w].viewSecretKey, outputIndexes, amount);
+        if (!outputIndexes.empty()) {
+          found[thread][w].push_back({ transaction.hash, transaction.blockHash, transaction.blockHeight,
+            std::move(outputIndexes), std::vector<uint32_t>(), amount });
+        }
+      }
+    }
+  };
+
+  runOnPool([&](size_t thread) {
+    if (thread < threadCount) {
+      scanRange(thread);
+    }
+  });
+
+  matches.assign(wallets.size(), std::vector<Match>());
+  for (size_t thread = 0; thread < threadCount; ++thread) {
+    for (size_t w = 0; w < wallets.size(); ++w) {
+      std::move(found[thread][w].begin(), found[thread][w].end(), std::back_inserter(matches[w]));
+    }
+  }
+}
+
+void ViewKeyScanner::runOnPool(const std::function<void(size_t)>& task) {
+  {
+    std::lock_guard<std::mutex> lock(m_poolMutex);
+    m_poolTask = &task;
+    m_poolPending = m_poolThreads.size();
+    ++m_poolGeneration;
+  }
+
+  m_poolWorkAvailable.notify_all();
+
+  // The pool threads use the task until they are done with it, so they are waited for even if this part fails
+  std::exception_ptr error;
+  try {
+    task(0);
+  } catch (...) {
+    error = std::current_exception();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(m_poolMutex);
+    m_poolWorkDone.wait(lock, [this] { return m_poolPending == 0; });
+    m_poolTask = nullptr;
+  }
+
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void ViewKeyScanner::poolLoop(size_t index) {
+  uint64_t generation = 0;
+  std::unique_lock<std::mutex> lock(m_poolMutex);
+  for (;;) {
+    m_poolWorkAvailable.wait(lock, [this, generation] { return m_poolStop || m_poolGeneration != generation; });
+    if (m_poolStop) {
+      return;
+    }
+
+    generation = m_poolGeneration;
+    const std::function<void(size_t)>& task = *m_poolTask;
+    lock.unlock();
+    try {
+      task(index);
+    } catch (std::exception& e) {
+      logger(ERROR, BRIGHT_RED) << "Failed to scan blocks: " << e.what();
+    }
+
+    lock.lock();
+    if (--m_poolPending == 0) {
+      m_poolWorkDone.notify_one();
+    }
+  }
+}
+
+// Called with m_mutex held
+void ViewKeyScanner::removeIdleWallets() {
+  auto now = std::chrono::steady_clock::now();
+  auto idle = std::remove_if(m_wallets.begin(), m_wallets.end(), [&](const Wallet& wallet) {
+    return now - wallet.lastAccess >= m_idleTimeout;
+  });
+
+  if (idle != m_wallets.end()) {
+    logger(DEBUGGING) << "Dropping " << std::distance(idle, m_wallets.end()) << " idle wallets";
+    m_wallets.erase(idle, m_wallets.end());
+  }
+}
+
+std::vector<ViewKeyScanner::Wallet>::iterator ViewKeyScanner::findWallet(const Crypto::PublicKey& spendPublicKey,
+  const Crypto::SecretKey& viewSecretKey) {
+  return std::find_if(m_wallets.begin(), m_wallets.end(), [&](const Wallet& wallet) {
+    return wallet.address.spendPublicKey == spendPublicKey && secretKeysEqual(wallet.viewSecretKey, viewSecretKey);
+  });
+}
+
+}
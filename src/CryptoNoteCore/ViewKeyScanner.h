@@ -0,0 +1,126 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CryptoNoteCore/ICoreObserver.h"
+#include "CryptoNote.h"
+#include "Logging/LoggerRef.h"
+
+namespace CryptoNote {
+
+class core;
+
+// Scans the main chain once on behalf of registered wallets, so they can fetch the transactions that pay them instead
+// of downloading and scanning every block. A wallet is identified by its spend public key and view secret key, which
+// is all findOutputsToAccount needs; spends can't be detected without the spend secret key.
+//
+// One background thread walks the chain in batches starting from the lowest height any wallet still needs, and every
+// batch is checked against all the wallets that need it by a pool of threads. Registrations are kept in memory only,
+// are dropped when they haven't been queried for the idle timeout and new ones are limited per minute
+class ViewKeyScanner : public ICoreObserver {
+public:
+  struct Match {
+    Crypto::Hash transactionHash;
+    Crypto::Hash blockHash;
+    uint32_t blockHeight;
+    // Indexes of the outputs within the transaction and the matching global indexes
+    std::vector<uint32_t> outputIndexes;
+    std::vector<uint32_t> globalOutputIndexes;
+    uint64_t amount;
+  };
+
+  // maxRegistrationsPerMinute of 0 doesn't limit the registrations
+  ViewKeyScanner(core& core, Logging::ILogger& logger, size_t threadCount, size_t maxWalletCount,
+    std::chrono::seconds idleTimeout, size_t maxRegistrationsPerMinute);
+  virtual ~ViewKeyScanner();
+
+  void start();
+  void stop();
+
+  // Registering an already registered wallet succeeds and leaves it as it is
+  bool addWallet(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& viewSecretKey, uint32_t startHeight, std::string& error);
+  bool removeWallet(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& viewSecretKey);
+  // Returns the matches of whole blocks from startHeight on, at most maxCount unless a single block has more, so at least
+  // the first block with matches is returned.
+  // nextHeight is where the next call should start; it never passes the height the wallet has been scanned to
+  bool getMatches(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& viewSecretKey, uint32_t startHeight,
+    size_t maxCount, std::vector<Match>& matches, uint32_t& nextHeight);
+
+  virtual void blockchainUpdated() override;
+
+private:
+  struct Wallet {
+    AccountPublicAddress address;
+    Crypto::SecretKey viewSecretKey;
+    uint32_t startHeight;
+    // Blocks below this height have been scanned
+    uint32_t scannedHeight;
+    // Id of the block at scannedHeight - 1 when it was scanned, NULL_HASH if not known
+    Crypto::Hash lastBlockHash;
+    std::vector<Match> matches;
+    // Last registration or query of the wallet
+    std::chrono::steady_clock::time_point lastAccess;
+  };
+
+  struct ScannedTransaction {
+    Crypto::Hash hash;
+    const TransactionPrefix* prefix;
+    Crypto::Hash blockHash;
+    uint32_t blockHeight;
+  };
+
+  void scanLoop();
+  bool scanNextBatch();
+  void rollBackForks(uint32_t chainHeight);
+  void findMatches(const std::vector<ScannedTransaction>& transactions, const std::vector<Wallet>& wallets,
+    std::vector<std::vector<Match>>& matches);
+  std::vector<Wallet>::iterator findWallet(const Crypto::PublicKey& spendPublicKey, const Crypto::SecretKey& viewSecretKey);
+  void removeIdleWallets();
+  // Runs the task with the indexes of all the threads of the pool, 0 on this one, and waits for it
+  void runOnPool(const std::function<void(size_t)>& task);
+  void poolLoop(size_t index);
+
+  core& m_core;
+  Logging::LoggerRef logger;
+  const size_t m_threadCount;
+  const size_t m_maxWalletCount;
+  const std::chrono::seconds m_idleTimeout;
+  const size_t m_maxRegistrationsPerMinute;
+
+  std::mutex m_mutex;
+  std::condition_variable m_workAvailable;
+  std::atomic<bool> m_stop;
+  bool m_workPending = false;
+  std::vector<Wallet> m_wallets;
+  // Times of the registrations of the last minute
+  std::deque<std::chrono::steady_clock::time_point> m_registrationTimes;
+  std::thread m_scanThread;
+
+  std::mutex m_poolMutex;
+  std::condition_variable m_poolWorkAvailable;
+  std::condition_variable m_poolWorkDone;
+  const std::function<void(size_t)>* m_poolTask = nullptr;
+  uint64_t m_poolGeneration = 0;
+  size_t m_poolPending = 0;
+  bool m_poolStop = false;
+  std::vector<std::thread> m_poolThreads;
+};
+
+}
@@ -22,6 +22,7 @@
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/MinerConfig.h"
+#include "CryptoNoteCore/ViewKeyScanner.h"
 #include "CryptoNoteProtocol/CryptoNoteProtocolHandler.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolQuery.h"
 #include "P2p/NetNode.h"
@@ -57,6 +58,15 @@ namespace
   const command_line::arg_descriptor<int>         arg_set_fee_amount  = { "fee-amount", "Sets the convenience charge amount for remote wallets that use this node.", 0 };
   const command_line::arg_descriptor<std::string> arg_set_view_key    = { "view-key", "Set secret view-key for remote node fee confirmation", "" };
 
+  const command_line::arg_descriptor<bool>     arg_enable_view_key_scanning = { "enable-view-key-scanning", "Scan blocks for light wallets that register their view keys through the RPC server" };
+  const command_line::arg_descriptor<uint32_t> arg_view_key_scanning_threads = { "view-key-scanning-threads", "Number of threads that scan blocks for registered view keys", 2 };
+  const command_line::arg_descriptor<uint32_t> arg_view_key_scanning_max_wallets = { "view-key-scanning-max-wallets", "Maximum number of registered view keys", 1000 };
+  const command_line::arg_descriptor<uint32_t> arg_view_key_scanning_idle_timeout = { "view-key-scanning-idle-timeout", "Seconds after which a registered view key that is not queried is dropped", 86400 };
+  const command_line::arg_descriptor<uint32_t> arg_view_key_scanning_registrations = { "view-key-scanning-registrations-per-minute", "Maximum number of new view key registrations per minute, 0 for no limit", 10 };
+#if defined(__linux__)
+  const command_line::arg_descriptor<std::string> arg_io_backend = { "io-backend", "Socket I/O of the P2P and RPC servers, epoll or io_uring. io_uring falls back to epoll if the kernel doesn't support it", "epoll" };
+#endif
+
   /* to be deleted eventually */
   const command_line::arg_descriptor<bool> arg_testnet_on = {"testnet", "Used to deploy a private testnet. Use it with --data-dir flag. \"moonbank-wallet\" must be launched with --testnet flag.", false};
   const command_line::arg_descriptor<bool> arg_print_hash = { "print-hash", "Creates an example and exits" };
@@ -82,6 +92,7 @@ JsonValue buildLoggerConfiguration(Level level, const std::string& logfile) {
   fileLogger.insert("type", "file");
   fileLogger.insert("filename", logfile);
   fileLogger.insert("level", static_cast<int64_t>(TRACE));
+  fileLogger.insert("async", JsonValue(true));
 
   JsonValue& consoleLogger = cfgLoggers.pushBack(JsonValue::OBJECT);
   consoleLogger.insert("type", "console");
@@ -121,6 +132,14 @@ int main(int argc, char* argv[])
     command_line::add_arg(desc_cmd_sett, arg_load_checkpoints);
     command_line::add_arg(desc_cmd_sett, arg_set_fee_address);
     command_line::add_arg(desc_cmd_sett, arg_set_fee_amount);
+    command_line::add_arg(desc_cmd_sett, arg_enable_view_key_scanning);
+    command_line::add_arg(desc_cmd_sett, arg_view_key_scanning_threads);
+    command_line::add_arg(desc_cmd_sett, arg_view_key_scanning_max_wallets);
+    command_line::add_arg(desc_cmd_sett, arg_view_key_scanning_idle_timeout);
+    command_line::add_arg(desc_cmd_sett, arg_view_key_scanning_registrations);
+#if defined(__linux__)
+    command_line::add_arg(desc_cmd_sett, arg_io_backend);
+#endif
 
     RpcServerConfig::initOptions(desc_cmd_sett);
     CoreConfig::initOptions(desc_cmd_sett);
@@ -238,10 +257,29 @@ int main(int argc, char* argv[])
       }
     }
 
+#if defined(__linux__)
+    std::string ioBackend = command_line::get_arg(vm, arg_io_backend);
+    if (ioBackend == "io_uring") {
+      System::Dispatcher::setDefaultIoBackend(System::IoBackend::IO_URING);
+    } else if (ioBackend != "epoll") {
+      logger(ERROR, BRIGHT_RED) << "Unknown I/O backend " << ioBackend << ", use epoll or io_uring";
+      return 1;
+    }
+#endif
+
     System::Dispatcher dispatcher;
+#if defined(__linux__)
+    if (ioBackend == "io_uring" && dispatcher.getIoBackend() != System::IoBackend::IO_URING) {
+      logger(WARNING, BRIGHT_YELLOW) << "io_uring is not supported by the kernel, using epoll";
+    }
+#endif
+
     CryptoNote::CryptoNoteProtocolHandler cprotocol(currency, dispatcher, ccore, nullptr, logManager);
     CryptoNote::NodeServer p2psrv(dispatcher, cprotocol, logManager);
     CryptoNote::RpcServer rpcServer(dispatcher, logManager, ccore, p2psrv, cprotocol);
+    CryptoNote::ViewKeyScanner viewKeyScanner(ccore, logManager, command_line::get_arg(vm, arg_view_key_scanning_threads),
+      command_line::get_arg(vm, arg_view_key_scanning_max_wallets), std::chrono::seconds(command_line::get_arg(vm, arg_view_key_scanning_idle_timeout)),
+      command_line::get_arg(vm, arg_view_key_scanning_registrations));
 
     cprotocol.set_p2p_endpoint(&p2psrv);
     ccore.set_cryptonote_protocol(&cprotocol);
@@ -266,6 +304,12 @@ int main(int argc, char* argv[])
     }
     logger(INFO, BRIGHT_GREEN) << "Core has been initialized!";
 
+    if (command_line::get_arg(vm, arg_enable_view_key_scanning)) {
+      viewKeyScanner.start();
+      rpcServer.setViewKeyScanner(&viewKeyScanner);
+      logger(INFO) << "View key scanning enabled for up to " << command_line::get_arg(vm, arg_view_key_scanning_max_wallets) << " wallets";
+    }
+
     // start components
     if (!command_line::has_arg(vm, arg_console)) {
       dch.start_handling();
@@ -336,6 +380,7 @@ int main(int argc, char* argv[])
     //stop components
     logger(INFO) << "Stopping core RPC server...";
     rpcServer.stop();
+    viewKeyScanner.stop();
 
     //deinitialize components
     logger(INFO) << "Deinitializing core...";
@@ -25,6 +25,19 @@ namespace {
     std::cout << CryptoNote::storeToJson(obj) << ENDL;
     return true;
   }
+
+#if defined(__linux__)
+  void print_dispatcher_statistics(const std::string& title, System::Dispatcher& dispatcher) {
+    System::DispatcherStatistics statistics = dispatcher.getStatistics();
+    uint64_t polls = std::max<uint64_t>(statistics.pollCount, 1);
+    std::cout << title << ENDL <<
+      "Backend: " << (dispatcher.getIoBackend() == System::IoBackend::IO_URING ? "io_uring" : "epoll") << ENDL <<
+      "Polls: " << statistics.pollCount << ENDL <<
+      "Events: " << statistics.eventCount << ", " << statistics.eventCount / static_cast<double>(polls) << " per poll, at most " <<
+      statistics.maxEventsPerPoll << ENDL <<
+      "Run time between polls: " << statistics.totalRunTime / polls << " us average, " << statistics.maxRunTime << " us max" << ENDL;
+  }
+#endif
 }
 
 DaemonCommandsHandler::DaemonCommandsHandler(CryptoNote::core& core, CryptoNote::NodeServer& srv, Logging::LoggerManager& log, const CryptoNote::ICryptoNoteProtocolQuery& protocol, CryptoNote::RpcServer* prpc_server) :
@@ -47,6 +60,9 @@ DaemonCommandsHandler::DaemonCommandsHandler(CryptoNote::core& core, CryptoNote:
   m_consoleHandler.setHandler("hide_hr", boost::bind(&DaemonCommandsHandler::hide_hr, this, _1), "Stop showing hash rate");
   m_consoleHandler.setHandler("set_log", boost::bind(&DaemonCommandsHandler::set_log, this, _1), "set_log <level> - Change current log level, <level> is a number 0-4");
   m_consoleHandler.setHandler("print_ban", boost::bind(&DaemonCommandsHandler::print_ban, this, _1), "Print banned nodes");
+#if defined(__linux__)
+  m_consoleHandler.setHandler("print_dispatcher", boost::bind(&DaemonCommandsHandler::print_dispatcher, this, _1), "Print event loop statistics of the P2P and RPC dispatchers");
+#endif
   m_consoleHandler.setHandler("ban", boost::bind(&DaemonCommandsHandler::ban, this, _1), "Ban a given <IP> for a given amount of <seconds>, ban <IP> [<seconds>]");
   m_consoleHandler.setHandler("unban", boost::bind(&DaemonCommandsHandler::unban, this, _1), "Unban a given <IP>, unban <IP>");
 }
@@ -432,6 +448,18 @@ bool DaemonCommandsHandler::print_ban(const std::vector<std::string>& args) {
   return true;
 }
 
+#if defined(__linux__)
+bool DaemonCommandsHandler::print_dispatcher(const std::vector<std::string>& args) {
+  print_dispatcher_statistics("Node", m_srv.getDispatcher());
+  std::vector<System::Dispatcher*> workers = m_srv.getWorkerDispatchers();
+  for (size_t i = 0; i < workers.size(); ++i) {
+    print_dispatcher_statistics("P2p thread " + std::to_string(i + 1), *workers[i]);
+  }
+
+  return true;
+}
+#endif
+
 bool DaemonCommandsHandler::ban(const std::vector<std::string>& args)
 {
   if (args.size() != 1 && args.size() != 2) return false;
@@ -79,4 +79,7 @@ private:
   bool print_ban(const std::vector<std::string>& args);
   bool ban(const std::vector<std::string>& args);
   bool unban(const std::vector<std::string>& args);
+#if defined(__linux__)
+  bool print_dispatcher(const std::vector<std::string>& args);
+#endif
 };
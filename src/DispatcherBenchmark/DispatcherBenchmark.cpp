@@ -0,0 +1,423 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+
+#include "Common/CommandLine.h"
+#include <System/ContextGroup.h>
+#include <System/ContextGroupTimeout.h>
+#include <System/Dispatcher.h>
+#include <System/Event.h>
+#include <System/Ipv4Address.h>
+#include <System/TcpConnection.h>
+#include <System/TcpConnector.h>
+#include <System/TcpListener.h>
+#include <System/Timer.h>
+
+#if defined(__linux__)
+#include <ucontext.h>
+#include <System/ContextSwitch.h>
+#endif
+
+namespace po = boost::program_options;
+
+namespace {
+
+const command_line::arg_descriptor<uint32_t> arg_switches = {"switches", "Context switches in every switch measurement", 2000000};
+const command_line::arg_descriptor<uint32_t> arg_spawns   = {"spawns", "Contexts spawned in the spawn measurement", 200000};
+const command_line::arg_descriptor<uint32_t> arg_connections = {"connections", "Loopback connections in the socket wakeup measurement", 256};
+const command_line::arg_descriptor<uint32_t> arg_wakeups  = {"wakeups", "Socket reads woken in the socket wakeup measurement", 500000};
+const command_line::arg_descriptor<uint32_t> arg_megabytes = {"megabytes", "Data sent over all connections in the socket throughput measurement", 512};
+const command_line::arg_descriptor<uint16_t> arg_port     = {"port", "Loopback port of the socket measurements", 32348};
+const command_line::arg_descriptor<uint32_t> arg_timeouts = {"timeouts", "Timeouts armed and cancelled in the timeout measurement", 200000};
+const command_line::arg_descriptor<uint32_t> arg_sleepers = {"sleepers", "Contexts sleeping at once in the timer expiry measurement", 4096};
+
+const size_t STACK_SIZE = 512 * 1024;
+
+template <typename F>
+double measure(F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const std::string& name, uint32_t count, double seconds) {
+  std::cout << "  " << std::setw(28) << std::left << name << std::right << std::fixed << std::setprecision(1) <<
+    std::setw(10) << count / seconds / 1000000 << " M/s" << std::setw(10) << seconds * 1000000000 / count << " ns" <<
+    std::endl;
+}
+
+#if defined(__linux__)
+
+// A coroutine that switches back to the caller for every switch to it, as the dispatcher did before
+struct SwapcontextPingPong {
+  ucontext_t caller;
+  ucontext_t coroutine;
+  uint32_t rounds;
+
+  static void procedure(unsigned int high, unsigned int low) {
+    auto self = reinterpret_cast<SwapcontextPingPong*>((static_cast<uintptr_t>(high) << 16 << 16) | low);
+    for (uint32_t i = 0; i < self->rounds; ++i) {
+      swapcontext(&self->coroutine, &self->caller);
+    }
+
+    setcontext(&self->caller);
+  }
+};
+
+double benchmarkSwapcontext(uint32_t switches) {
+  std::unique_ptr<SwapcontextPingPong> pingPong(new SwapcontextPingPong);
+  std::unique_ptr<uint8_t[]> stack(new uint8_t[STACK_SIZE]);
+  pingPong->rounds = switches / 2;
+  if (getcontext(&pingPong->coroutine) == -1) {
+    throw std::runtime_error("getcontext failed");
+  }
+
+  uintptr_t pointer = reinterpret_cast<uintptr_t>(pingPong.get());
+  pingPong->coroutine.uc_stack.ss_sp = stack.get();
+  pingPong->coroutine.uc_stack.ss_size = STACK_SIZE;
+  pingPong->coroutine.uc_link = nullptr;
+  makecontext(&pingPong->coroutine, reinterpret_cast<void(*)()>(&SwapcontextPingPong::procedure), 2,
+    static_cast<unsigned int>(pointer >> 16 >> 16), static_cast<unsigned int>(pointer));
+
+  return measure([&] {
+    for (uint32_t i = 0; i <= pingPong->rounds; ++i) {
+      swapcontext(&pingPong->caller, &pingPong->coroutine);
+    }
+  });
+}
+
+struct SwitchContextPingPong {
+  System::ContextState caller;
+  System::ContextState coroutine;
+  uint32_t rounds;
+
+  static void procedure(void* argument) {
+    auto self = static_cast<SwitchContextPingPong*>(argument);
+    for (;;) {
+      System::switchContext(self->coroutine, self->caller);
+    }
+  }
+};
+
+double benchmarkSwitchContext(uint32_t switches) {
+  SwitchContextPingPong pingPong;
+  pingPong.rounds = switches / 2;
+  void* stack = System::allocateStack(STACK_SIZE);
+  System::makeContext(pingPong.coroutine, stack, STACK_SIZE, &SwitchContextPingPong::procedure, &pingPong);
+  double seconds = measure([&] {
+    for (uint32_t i = 0; i < pingPong.rounds; ++i) {
+      System::switchContext(pingPong.caller, pingPong.coroutine);
+    }
+  });
+
+  // The coroutine never finishes, it is abandoned with its stack
+  System::releaseStack(stack, STACK_SIZE);
+  return seconds;
+}
+
+#endif
+
+// Two contexts handing control to each other through events, the path every network wakeup takes
+double benchmarkDispatcherSwitches(uint32_t switches) {
+  System::Dispatcher dispatcher;
+  System::Event ping(dispatcher);
+  System::Event pong(dispatcher);
+  uint32_t rounds = switches / 2;
+  double seconds = measure([&] {
+    System::ContextGroup group(dispatcher);
+    group.spawn([&] {
+      for (uint32_t i = 0; i < rounds; ++i) {
+        ping.wait();
+        ping.clear();
+        pong.set();
+      }
+    });
+
+    for (uint32_t i = 0; i < rounds; ++i) {
+      ping.set();
+      pong.wait();
+      pong.clear();
+    }
+
+    group.wait();
+  });
+
+  return seconds;
+}
+
+double benchmarkSpawns(uint32_t spawns) {
+  System::Dispatcher dispatcher;
+  uint32_t finished = 0;
+  double seconds = measure([&] {
+    System::ContextGroup group(dispatcher);
+    for (uint32_t i = 0; i < spawns; ++i) {
+      group.spawn([&] { ++finished; });
+      if (i % 64 == 63) {
+        group.wait();
+      }
+    }
+
+    group.wait();
+  });
+
+  if (finished != spawns) {
+    throw std::runtime_error("Not every spawned context finished");
+  }
+
+  return seconds;
+}
+
+void connectLoopback(System::Dispatcher& dispatcher, uint32_t connectionCount, uint16_t port,
+  std::vector<System::TcpConnection>& servers, std::vector<System::TcpConnection>& clients) {
+  System::TcpListener listener(dispatcher, System::Ipv4Address("127.0.0.1"), port);
+  System::ContextGroup acceptGroup(dispatcher);
+  acceptGroup.spawn([&] {
+    for (uint32_t i = 0; i < connectionCount; ++i) {
+      servers.push_back(listener.accept());
+    }
+  });
+
+  System::TcpConnector connector(dispatcher);
+  for (uint32_t i = 0; i < connectionCount; ++i) {
+    clients.push_back(connector.connect(System::Ipv4Address("127.0.0.1"), port));
+  }
+
+  acceptGroup.wait();
+}
+
+// Every round writes a byte to each connection and waits until all the readers got theirs, the pattern of a node
+// relaying a message to its peers
+double benchmarkSocketWakeups(uint32_t connectionCount, uint32_t wakeups, uint16_t port) {
+  System::Dispatcher dispatcher;
+  std::vector<System::TcpConnection> servers;
+  std::vector<System::TcpConnection> clients;
+  connectLoopback(dispatcher, connectionCount, port, servers, clients);
+  uint32_t rounds = std::max<uint32_t>(wakeups / connectionCount, 1);
+  uint32_t pending = 0;
+  System::Event roundDone(dispatcher);
+#if defined(__linux__)
+  System::DispatcherStatistics before = dispatcher.getStatistics();
+#endif
+  double seconds = measure([&] {
+    System::ContextGroup readers(dispatcher);
+    for (System::TcpConnection& server : servers) {
+      System::TcpConnection* connection = &server;
+      readers.spawn([&, connection] {
+        uint8_t byte;
+        for (uint32_t i = 0; i < rounds; ++i) {
+          connection->read(&byte, 1);
+          if (--pending == 0) {
+            roundDone.set();
+          }
+        }
+      });
+    }
+
+    uint8_t byte = 0;
+    for (uint32_t i = 0; i < rounds; ++i) {
+      pending = connectionCount;
+      roundDone.clear();
+      for (System::TcpConnection& client : clients) {
+        client.write(&byte, 1);
+      }
+
+      roundDone.wait();
+    }
+
+    readers.wait();
+  });
+
+#if defined(__linux__)
+  System::DispatcherStatistics after = dispatcher.getStatistics();
+  uint64_t polls = std::max<uint64_t>(after.pollCount - before.pollCount, 1);
+  std::cout << "  " << std::setw(28) << std::left << "events per poll" << std::right << std::setw(10) <<
+    static_cast<double>(after.eventCount - before.eventCount) / polls << std::setw(12) << "max " <<
+    after.maxEventsPerPoll << std::endl;
+  std::cout << "  " << std::setw(28) << std::left << "run time between polls" << std::right << std::setw(10) <<
+    static_cast<double>(after.totalRunTime - before.totalRunTime) / polls << " us" << std::setw(8) << "max " <<
+    after.maxRunTime << " us" << std::endl;
+#endif
+
+  return seconds;
+}
+
+// Every connection streams its share of the data in blocks the size of a large protocol message
+double benchmarkSocketThroughput(uint32_t connectionCount, uint64_t bytes, uint16_t port) {
+  const size_t BLOCK_SIZE = 64 * 1024;
+  System::Dispatcher dispatcher;
+  std::vector<System::TcpConnection> servers;
+  std::vector<System::TcpConnection> clients;
+  connectLoopback(dispatcher, connectionCount, port, servers, clients);
+  uint64_t share = bytes / connectionCount;
+  uint64_t received = 0;
+  double seconds = measure([&] {
+    System::ContextGroup group(dispatcher);
+    for (uint32_t i = 0; i < connectionCount; ++i) {
+      System::TcpConnection* client = &clients[i];
+      System::TcpConnection* server = &servers[i];
+      group.spawn([&, client] {
+        std::vector<uint8_t> block(BLOCK_SIZE, 1);
+        for (uint64_t sent = 0; sent < share;) {
+          size_t size = static_cast<size_t>(std::min<uint64_t>(share - sent, BLOCK_SIZE));
+          sent += client->write(block.data(), size);
+        }
+      });
+
+      group.spawn([&, server] {
+        std::vector<uint8_t> block(BLOCK_SIZE);
+        for (uint64_t read = 0; read < share;) {
+          size_t size = server->read(block.data(), block.size());
+          if (size == 0) {
+            throw std::runtime_error("Connection closed before all the data arrived");
+          }
+
+          read += size;
+          received += size;
+        }
+      });
+    }
+
+    group.wait();
+  });
+
+  if (received != share * connectionCount) {
+    throw std::runtime_error("Not all the data arrived");
+  }
+
+  return seconds;
+}
+
+// A timeout that is cancelled before it expires, as around every request to a peer
+double benchmarkTimeouts(uint32_t timeouts) {
+  System::Dispatcher dispatcher;
+  System::ContextGroup group(dispatcher);
+  return measure([&] {
+    for (uint32_t i = 0; i < timeouts; ++i) {
+      System::ContextGroupTimeout timeout(dispatcher, group, std::chrono::seconds(10));
+      // Lets the timeout context start sleeping
+      dispatcher.yield();
+    }
+  });
+}
+
+// Many contexts sleeping a millisecond at a time, so expirations are spread over the ticks of the timer
+double benchmarkTimerExpirations(uint32_t sleepers, uint32_t rounds) {
+  System::Dispatcher dispatcher;
+  return measure([&] {
+    System::ContextGroup group(dispatcher);
+    for (uint32_t i = 0; i < sleepers; ++i) {
+      group.spawn([&] {
+        System::Timer timer(dispatcher);
+        for (uint32_t j = 0; j < rounds; ++j) {
+          timer.sleep(std::chrono::milliseconds(1));
+        }
+      });
+    }
+
+    group.wait();
+  });
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  po::options_description desc_general("General options");
+  command_line::add_arg(desc_general, command_line::arg_help);
+  po::options_description desc_params("Benchmark options");
+  command_line::add_arg(desc_params, arg_switches);
+  command_line::add_arg(desc_params, arg_spawns);
+  command_line::add_arg(desc_params, arg_connections);
+  command_line::add_arg(desc_params, arg_wakeups);
+  command_line::add_arg(desc_params, arg_megabytes);
+  command_line::add_arg(desc_params, arg_port);
+  command_line::add_arg(desc_params, arg_timeouts);
+  command_line::add_arg(desc_params, arg_sleepers);
+
+  po::options_description desc_all;
+  desc_all.add(desc_general).add(desc_params);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_all, [&]() {
+    po::store(po::parse_command_line(argc, argv, desc_all), vm);
+    if (command_line::get_arg(vm, command_line::arg_help)) {
+      std::cout << "Measures coroutine context switches, spawns, sockets and timers of System::Dispatcher" << std::endl;
+      std::cout << desc_all << std::endl;
+      return false;
+    }
+
+    po::notify(vm);
+    return true;
+  });
+
+  if (!r) {
+    return 1;
+  }
+
+  try {
+    uint32_t switches = std::max<uint32_t>(command_line::get_arg(vm, arg_switches), 2);
+    uint32_t spawns = std::max<uint32_t>(command_line::get_arg(vm, arg_spawns), 1);
+    std::cout << "Context switches:" << std::endl;
+#if defined(__linux__)
+    report("swapcontext", switches, benchmarkSwapcontext(switches));
+    report("switchContext", switches, benchmarkSwitchContext(switches));
+#endif
+    report("Dispatcher, event ping-pong", switches, benchmarkDispatcherSwitches(switches));
+    std::cout << "Spawned contexts:" << std::endl;
+    report("ContextGroup::spawn", spawns, benchmarkSpawns(spawns));
+    uint32_t connections = std::max<uint32_t>(command_line::get_arg(vm, arg_connections), 1);
+    uint32_t wakeups = std::max<uint32_t>(command_line::get_arg(vm, arg_wakeups), connections);
+    uint64_t bytes = std::max<uint64_t>(uint64_t(command_line::get_arg(vm, arg_megabytes)) << 20, connections);
+    uint16_t port = command_line::get_arg(vm, arg_port);
+#if defined(__linux__)
+    std::vector<std::pair<std::string, System::IoBackend>> backends = { { "epoll", System::IoBackend::EPOLL },
+      { "io_uring", System::IoBackend::IO_URING } };
+#else
+    std::vector<std::string> backends = { "native" };
+#endif
+    for (auto& backend : backends) {
+#if defined(__linux__)
+      System::Dispatcher::setDefaultIoBackend(backend.second);
+      if (System::Dispatcher().getIoBackend() != backend.second) {
+        std::cout << "Sockets, " << backend.first << ": not supported by the kernel" << std::endl;
+        continue;
+      }
+
+      std::cout << "Sockets, " << backend.first << ", " << connections << " loopback connections:" << std::endl;
+#else
+      std::cout << "Sockets, " << connections << " loopback connections:" << std::endl;
+#endif
+      double seconds = benchmarkSocketWakeups(connections, wakeups, port);
+      report("TcpConnection::read", wakeups / connections * connections, seconds);
+      seconds = benchmarkSocketThroughput(connections, bytes, port);
+      std::cout << "  " << std::setw(28) << std::left << "throughput" << std::right << std::setw(10) <<
+        bytes / connections * connections / seconds / (1 << 20) << " MiB/s" << std::endl;
+    }
+
+    uint32_t timeouts = std::max<uint32_t>(command_line::get_arg(vm, arg_timeouts), 1);
+    uint32_t sleepers = std::max<uint32_t>(command_line::get_arg(vm, arg_sleepers), 1);
+    const uint32_t SLEEP_ROUNDS = 16;
+    std::cout << "Timers:" << std::endl;
+    report("ContextGroupTimeout, cancel", timeouts, benchmarkTimeouts(timeouts));
+    report("Timer::sleep, 1 ms", sleepers * SLEEP_ROUNDS, benchmarkTimerExpirations(sleepers, SLEEP_ROUNDS));
+  } catch (std::exception& e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
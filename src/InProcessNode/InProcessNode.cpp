@@ -835,13 +835,18 @@ void InProcessNode::getTransactionsAsync(const std::vector<Crypto::Hash>& transa
 
 std::error_code InProcessNode::doGetTransactions(const std::vector<Crypto::Hash>& transactionHashes, std::vector<TransactionDetails>& transactions) {
   try {
-    std::list<Transaction> txs;
-    std::list<Crypto::Hash> missed_txs;
-    core.getTransactions(transactionHashes, txs, missed_txs, true);
+    std::vector<BinaryArray> txs;
+    std::vector<Crypto::Hash> missed_txs;
+    core.getTransactionBlobs(transactionHashes, txs, missed_txs, true);
     if (missed_txs.size() > 0) {
       return make_error_code(CryptoNote::error::REQUEST_ERROR);
     }
-    for (const Transaction& tx : txs) {
+    for (const BinaryArray& txBlob : txs) {
+      Transaction tx;
+      if (!fromBinaryArray(tx, txBlob)) {
+        return make_error_code(CryptoNote::error::INTERNAL_NODE_ERROR);
+      }
+
       TransactionDetails transactionDetails;
       if (!blockchainExplorerDataBuilder.fillTransactionDetails(tx, transactionDetails)) {
         return make_error_code(CryptoNote::error::INTERNAL_NODE_ERROR);
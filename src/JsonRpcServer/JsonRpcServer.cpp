@@ -20,12 +20,22 @@
 #include "HTTP/HttpParser.h"
 #include "HTTP/HttpResponse.h"
 
-#include "Common/JsonValue.h"
-#include "Serialization/JsonInputValueSerializer.h"
-#include "Serialization/JsonOutputStreamSerializer.h"
+#include "Serialization/JsonTextInputSerializer.h"
+#include "Serialization/JsonTextOutputSerializer.h"
 
 namespace CryptoNote {
 
+namespace {
+
+std::string makeError(int64_t code, std::string message) {
+  JsonTextOutputSerializer error;
+  error(code, "code");
+  error(message, "message");
+  return error.takeText();
+}
+
+}
+
 JsonRpcServer::JsonRpcServer(System::Dispatcher& sys, System::Event& stopEvent, Logging::ILogger& loggerGroup) :
   HttpServer(sys, loggerGroup), 
   system(sys),
@@ -45,27 +55,24 @@ void JsonRpcServer::processRequest(const CryptoNote::HttpRequest& req, CryptoNot
     logger(Logging::TRACE) << "HTTP request came: \n" << req;
 
     if (req.getUrl() == "/json_rpc") {
-      std::istringstream jsonInputStream(req.getBody());
-      Common::JsonValue jsonRpcRequest;
-      Common::JsonValue jsonRpcResponse(Common::JsonValue::OBJECT);
+      const std::string& body = req.getBody();
+      std::unique_ptr<JsonTextInputSerializer> jsonRpcRequest;
+      Response jsonRpcResponse;
 
       try {
-        jsonInputStream >> jsonRpcRequest;
+        jsonRpcRequest.reset(new JsonTextInputSerializer(body.data(), body.size()));
       } catch (std::runtime_error&) {
-        logger(Logging::DEBUGGING) << "Couldn't parse request: \"" << req.getBody() << "\"";
+        logger(Logging::DEBUGGING) << "Couldn't parse request: \"" << body << "\"";
         makeJsonParsingErrorResponse(jsonRpcResponse);
         resp.setStatus(CryptoNote::HttpResponse::STATUS_200);
-        resp.setBody(jsonRpcResponse.toString());
+        resp.setBody(makeBody(jsonRpcResponse));
         return;
       }
 
-      processJsonRpcRequest(jsonRpcRequest, jsonRpcResponse);
-
-      std::ostringstream jsonOutputStream;
-      jsonOutputStream << jsonRpcResponse;
+      processJsonRpcRequest(*jsonRpcRequest, jsonRpcResponse);
 
       resp.setStatus(CryptoNote::HttpResponse::STATUS_200);
-      resp.setBody(jsonOutputStream.str());
+      resp.setBody(makeBody(jsonRpcResponse));
 
     } else {
       logger(Logging::WARNING) << "Requested url \"" << req.getUrl() << "\" is not found";
@@ -78,102 +85,57 @@ void JsonRpcServer::processRequest(const CryptoNote::HttpRequest& req, CryptoNot
   }
 }
 
-void JsonRpcServer::prepareJsonResponse(const Common::JsonValue& req, Common::JsonValue& resp) {
-  using Common::JsonValue;
-
-  if (req.contains("id")) {
-    resp.insert("id", req("id"));
+std::string JsonRpcServer::makeBody(const Response& resp) {
+  JsonTextOutputSerializer body;
+  if (!resp.id.empty()) {
+    body.rawValue(resp.id, "id");
   }
-  
-  resp.insert("jsonrpc", "2.0");
-}
-
-void JsonRpcServer::makeErrorResponse(const std::error_code& ec, Common::JsonValue& resp) {
-  using Common::JsonValue;
-
-  JsonValue error(JsonValue::OBJECT);
-
-  JsonValue code;
-  code = static_cast<int64_t>(-32000); //Application specific error code
-
-  JsonValue message;
-  message = ec.message();
-
-  JsonValue data(JsonValue::OBJECT);
-  JsonValue appCode;
-  appCode = static_cast<int64_t>(ec.value());
-  data.insert("application_code", appCode);
-
-  error.insert("code", code);
-  error.insert("message", message);
-  error.insert("data", data);
-
-  resp.insert("error", error);
-}
-
-void JsonRpcServer::makeGenericErrorReponse(Common::JsonValue& resp, const char* what, int errorCode) {
-  using Common::JsonValue;
-
-  JsonValue error(JsonValue::OBJECT);
-
-  JsonValue code;
-  code = static_cast<int64_t>(errorCode);
 
-  std::string msg;
-  if (what) {
-    msg = what;
-  } else {
-    msg = "Unknown application error";
+  std::string version("2.0");
+  body(version, "jsonrpc");
+  if (!resp.error.empty()) {
+    body.rawValue(resp.error, "error");
+  } else if (!resp.result.empty()) {
+    body.rawValue(resp.result, "result");
   }
 
-  JsonValue message;
-  message = msg;
-
-  error.insert("code", code);
-  error.insert("message", message);
-
-  resp.insert("error", error);
-
+  return body.takeText();
 }
 
-void JsonRpcServer::makeMethodNotFoundResponse(Common::JsonValue& resp) {
-  using Common::JsonValue;
-
-  JsonValue error(JsonValue::OBJECT);
-
-  JsonValue code;
-  code = static_cast<int64_t>(-32601); //ambigous declaration of JsonValue::operator= (between int and JsonValue)
+void JsonRpcServer::prepareJsonResponse(JsonTextInputSerializer& req, Response& resp) {
+  req.getRawValue("id", resp.id);
+}
 
-  JsonValue message;
-  message = "Method not found";
+void JsonRpcServer::makeErrorResponse(const std::error_code& ec, Response& resp) {
+  JsonTextOutputSerializer error;
+  int64_t code = -32000; //Application specific error code
+  std::string message = ec.message();
+  error(code, "code");
+  error(message, "message");
 
-  error.insert("code", code);
-  error.insert("message", message);
+  error.beginObject("data");
+  int64_t appCode = ec.value();
+  error(appCode, "application_code");
+  error.endObject();
 
-  resp.insert("error", error);
+  resp.error = error.takeText();
 }
 
-void JsonRpcServer::fillJsonResponse(const Common::JsonValue& v, Common::JsonValue& resp) {
-  resp.insert("result", v);
+void JsonRpcServer::makeGenericErrorReponse(Response& resp, const char* what, int errorCode) {
+  resp.error = makeError(errorCode, what ? what : "Unknown application error");
 }
 
-void JsonRpcServer::makeJsonParsingErrorResponse(Common::JsonValue& resp) {
-  using Common::JsonValue;
-
-  resp = JsonValue(JsonValue::OBJECT);
-  resp.insert("jsonrpc", "2.0");
-  resp.insert("id", nullptr);
-
-  JsonValue error(JsonValue::OBJECT);
-  JsonValue code;
-  code = static_cast<int64_t>(-32700); //ambigous declaration of JsonValue::operator= (between int and JsonValue)
-
-  JsonValue message = "Parse error";
+void JsonRpcServer::makeMethodNotFoundResponse(Response& resp) {
+  resp.error = makeError(-32601, "Method not found");
+}
 
-  error.insert("code", code);
-  error.insert("message", message);
+void JsonRpcServer::fillJsonResponse(std::string&& result, Response& resp) {
+  resp.result = std::move(result);
+}
 
-  resp.insert("error", error);
+void JsonRpcServer::makeJsonParsingErrorResponse(Response& resp) {
+  resp.id = "null";
+  resp.error = makeError(-32700, "Parse error");
 }
 
 }
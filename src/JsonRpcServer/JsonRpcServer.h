@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <string>
 #include <system_error>
 
 #include <System/Dispatcher.h>
@@ -18,10 +19,7 @@
 namespace CryptoNote {
 class HttpResponse;
 class HttpRequest;
-}
-
-namespace Common {
-class JsonValue;
+class JsonTextInputSerializer;
 }
 
 namespace System {
@@ -38,19 +36,28 @@ public:
   void start(const std::string& bindAddress, uint16_t bindPort, const std::string& user = "", const std::string& password = "");
 
 protected:
-  static void makeErrorResponse(const std::error_code& ec, Common::JsonValue& resp);
-  static void makeMethodNotFoundResponse(Common::JsonValue& resp);
-  static void makeGenericErrorReponse(Common::JsonValue& resp, const char* what, int errorCode = -32001);
-  static void fillJsonResponse(const Common::JsonValue& v, Common::JsonValue& resp);
-  static void prepareJsonResponse(const Common::JsonValue& req, Common::JsonValue& resp);
-  static void makeJsonParsingErrorResponse(Common::JsonValue& resp);
+  // Members of a response body, each already rendered as JSON text
+  struct Response {
+    std::string id;
+    std::string result;
+    std::string error;
+  };
 
-  virtual void processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp) = 0;
+  static void makeErrorResponse(const std::error_code& ec, Response& resp);
+  static void makeMethodNotFoundResponse(Response& resp);
+  static void makeGenericErrorReponse(Response& resp, const char* what, int errorCode = -32001);
+  static void fillJsonResponse(std::string&& result, Response& resp);
+  static void prepareJsonResponse(JsonTextInputSerializer& req, Response& resp);
+  static void makeJsonParsingErrorResponse(Response& resp);
+
+  virtual void processJsonRpcRequest(JsonTextInputSerializer& req, Response& resp) = 0;
 
 private:
   // HttpServer
   virtual void processRequest(const CryptoNote::HttpRequest& request, CryptoNote::HttpResponse& response) override;
 
+  static std::string makeBody(const Response& resp);
+
   System::Dispatcher& system;
   System::Event& stopEvent;
   Logging::LoggerRef logger;
@@ -0,0 +1,142 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "AsyncLogger.h"
+
+namespace Logging {
+
+const size_t AsyncLogger::DEFAULT_QUEUE_SIZE;
+
+AsyncLogger::AsyncLogger(ILogger& logger, size_t queueSize)
+  : logger(logger)
+  , enqueuePosition(0)
+  , dequeuePosition(0)
+  , droppedCount(0)
+  , stopped(false)
+  , writerWaiting(false) {
+  size_t capacity = 2;
+  while (capacity < queueSize) {
+    capacity <<= 1;
+  }
+
+  slots.reset(new Slot[capacity]);
+  mask = capacity - 1;
+  for (size_t i = 0; i < capacity; ++i) {
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  writer = std::thread(&AsyncLogger::writerLoop, this);
+}
+
+AsyncLogger::~AsyncLogger() {
+  {
+    std::lock_guard<std::mutex> lock(wakeupMutex);
+    stopped = true;
+    wakeup.notify_one();
+  }
+
+  writer.join();
+}
+
+void AsyncLogger::operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
+  if (level > logger.getMaxLevel()) {
+    return;
+  }
+
+  if (!tryPush(category, level, time, body)) {
+    droppedCount.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  // Pairs with the fence in writerLoop: either the writer sees the new record or we see that it is waiting
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (writerWaiting.load(std::memory_order_relaxed)) {
+    std::lock_guard<std::mutex> lock(wakeupMutex);
+    wakeup.notify_one();
+  }
+}
+
+Level AsyncLogger::getMaxLevel() const {
+  return logger.getMaxLevel();
+}
+
+uint64_t AsyncLogger::getDroppedCount() const {
+  return droppedCount.load(std::memory_order_relaxed);
+}
+
+bool AsyncLogger::tryPush(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
+  size_t position = enqueuePosition.load(std::memory_order_relaxed);
+  Slot* slot;
+  for (;;) {
+    slot = &slots[position & mask];
+    size_t sequence = slot->sequence.load(std::memory_order_acquire);
+    if (sequence == position) {
+      if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (sequence < position) {
+      // The slot still holds a record from the previous lap
+      return false;
+    } else {
+      position = enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->record.category = category;
+  slot->record.level = level;
+  slot->record.time = time;
+  slot->record.body = body;
+  slot->sequence.store(position + 1, std::memory_order_release);
+  return true;
+}
+
+bool AsyncLogger::tryPop(Record& record) {
+  Slot& slot = slots[dequeuePosition & mask];
+  if (slot.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) {
+    return false;
+  }
+
+  record.category.swap(slot.record.category);
+  record.level = slot.record.level;
+  record.time = slot.record.time;
+  record.body.swap(slot.record.body);
+  slot.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+  ++dequeuePosition;
+  return true;
+}
+
+bool AsyncLogger::hasRecords() const {
+  return slots[dequeuePosition & mask].sequence.load(std::memory_order_acquire) == dequeuePosition + 1;
+}
+
+void AsyncLogger::writerLoop() {
+  uint64_t reportedDrops = 0;
+  Record record;
+  for (;;) {
+    while (tryPop(record)) {
+      logger(record.category, record.level, record.time, record.body);
+    }
+
+    uint64_t drops = droppedCount.load(std::memory_order_relaxed);
+    if (drops != reportedDrops) {
+      logger("AsyncLogger", WARNING, boost::posix_time::microsec_clock::local_time(),
+        YELLOW + std::to_string(drops - reportedDrops) + " log messages were dropped, logging queue is full\n");
+      reportedDrops = drops;
+    }
+
+    std::unique_lock<std::mutex> lock(wakeupMutex);
+    if (stopped && !hasRecords()) {
+      break;
+    }
+
+    writerWaiting.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    wakeup.wait(lock, [this] { return stopped || hasRecords(); });
+    writerWaiting.store(false, std::memory_order_relaxed);
+  }
+}
+
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include "ILogger.h"
+
+namespace Logging {
+
+// Moves writing of another logger to a background thread. Records are passed through a bounded lock-free
+// queue; when it is full the record is dropped and counted, and the writer reports the losses once it catches up
+class AsyncLogger : public ILogger {
+public:
+  static const size_t DEFAULT_QUEUE_SIZE = 8192;
+
+  AsyncLogger(ILogger& logger, size_t queueSize = DEFAULT_QUEUE_SIZE);
+  ~AsyncLogger();
+  AsyncLogger(const AsyncLogger&) = delete;
+  AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+  virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) override;
+  virtual Level getMaxLevel() const override;
+
+  uint64_t getDroppedCount() const;
+
+private:
+  struct Record {
+    std::string category;
+    Level level;
+    boost::posix_time::ptime time;
+    std::string body;
+  };
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    Record record;
+  };
+
+  bool tryPush(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body);
+  bool tryPop(Record& record);
+  bool hasRecords() const;
+  void writerLoop();
+
+  ILogger& logger;
+  std::unique_ptr<Slot[]> slots;
+  size_t mask;
+  std::atomic<size_t> enqueuePosition;
+  size_t dequeuePosition;
+  std::atomic<uint64_t> droppedCount;
+
+  std::atomic<bool> stopped;
+  std::atomic<bool> writerWaiting;
+  std::mutex wakeupMutex;
+  std::condition_variable wakeup;
+  std::thread writer;
+};
+
+}
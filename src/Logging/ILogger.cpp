@@ -35,4 +35,8 @@ const std::array<std::string, 6> ILogger::LEVEL_NAMES = {
   "TRACE"}
 };
 
+Level ILogger::getMaxLevel() const {
+  return TRACE;
+}
+
 }
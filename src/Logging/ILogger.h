@@ -46,6 +46,9 @@ public:
   const static std::array<std::string, 6> LEVEL_NAMES;
 
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) = 0;
+
+  // Most verbose level that can still be written, used to drop messages before they are formatted
+  virtual Level getMaxLevel() const;
 };
 
 #ifndef ENDL
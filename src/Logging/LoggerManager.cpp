@@ -13,7 +13,25 @@ namespace Logging {
 
 using Common::JsonValue;
 
-LoggerManager::LoggerManager() {
+LoggerManager::LoggerManager() : maxLevel(LoggerGroup::getMaxLevel()) {
+}
+
+void LoggerManager::addLogger(ILogger& logger) {
+  std::unique_lock<std::mutex> lock(reconfigureLock);
+  LoggerGroup::addLogger(logger);
+  updateMaxLevel();
+}
+
+void LoggerManager::removeLogger(ILogger& logger) {
+  std::unique_lock<std::mutex> lock(reconfigureLock);
+  LoggerGroup::removeLogger(logger);
+  updateMaxLevel();
+}
+
+void LoggerManager::setMaxLevel(Level level) {
+  std::unique_lock<std::mutex> lock(reconfigureLock);
+  LoggerGroup::setMaxLevel(level);
+  updateMaxLevel();
 }
 
 void LoggerManager::operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) {
@@ -21,8 +39,18 @@ void LoggerManager::operator()(const std::string& category, Level level, boost::
   LoggerGroup::operator()(category, level, time, body);
 }
 
+Level LoggerManager::getMaxLevel() const {
+  return maxLevel.load(std::memory_order_relaxed);
+}
+
+// Called with reconfigureLock held
+void LoggerManager::updateMaxLevel() {
+  maxLevel.store(LoggerGroup::getMaxLevel(), std::memory_order_relaxed);
+}
+
 void LoggerManager::configure(const JsonValue& val) {
   std::unique_lock<std::mutex> lock(reconfigureLock);
+  asyncLoggers.clear();
   loggers.clear();
   LoggerGroup::loggers.clear();
   Level globalLevel;
@@ -99,7 +127,18 @@ void LoggerManager::configure(const JsonValue& val) {
         }
 
         loggers.emplace_back(std::move(logger));
-        addLogger(*loggers.back());
+
+        if (loggerConfiguration.contains("async") && loggerConfiguration("async").getBool()) {
+          size_t queueSize = AsyncLogger::DEFAULT_QUEUE_SIZE;
+          if (loggerConfiguration.contains("asyncQueueSize")) {
+            queueSize = static_cast<size_t>(loggerConfiguration("asyncQueueSize").getInteger());
+          }
+
+          asyncLoggers.emplace_back(new AsyncLogger(*loggers.back(), queueSize));
+          LoggerGroup::addLogger(*asyncLoggers.back());
+        } else {
+          LoggerGroup::addLogger(*loggers.back());
+        }
       }
     } else {
       throw std::runtime_error("loggers parameter has wrong type");
@@ -107,10 +146,12 @@ void LoggerManager::configure(const JsonValue& val) {
   } else {
     throw std::runtime_error("loggers parameter missing");
   }
-  setMaxLevel(globalLevel);
+  LoggerGroup::setMaxLevel(globalLevel);
   for (const auto& category : globalDisabledCategories) {
     disableCategory(category);
   }
+
+  updateMaxLevel();
 }
 
 }
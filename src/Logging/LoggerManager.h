@@ -6,10 +6,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <list>
 #include <memory>
 #include <mutex>
 #include "../Common/JsonValue.h"
+#include "AsyncLogger.h"
 #include "LoggerGroup.h"
 
 namespace Logging {
@@ -18,11 +20,21 @@ class LoggerManager : public LoggerGroup {
 public:
   LoggerManager();
   void configure(const Common::JsonValue& val);
+  virtual void addLogger(ILogger& logger) override;
+  virtual void removeLogger(ILogger& logger) override;
+  virtual void setMaxLevel(Level level) override;
   virtual void operator()(const std::string& category, Level level, boost::posix_time::ptime time, const std::string& body) override;
+  // Read without the lock. A member logger whose level changes after it is added is seen at the next change of the manager
+  virtual Level getMaxLevel() const override;
 
 private:
   std::vector<std::unique_ptr<CommonLogger>> loggers;
-  std::mutex reconfigureLock;
+  // Declared after loggers so that writer threads are stopped before the loggers they write to are destroyed
+  std::vector<std::unique_ptr<AsyncLogger>> asyncLoggers;
+  mutable std::mutex reconfigureLock;
+  std::atomic<Level> maxLevel;
+
+  void updateMaxLevel();
 };
 
 }
@@ -16,7 +16,18 @@ LoggerMessage::LoggerMessage(ILogger& logger, const std::string& category, Level
   , logLevel(level)
   , message(color)
   , timestamp(boost::posix_time::microsec_clock::local_time())
-  , gotText(false) {
+  , gotText(false)
+  , enabled(true) {
+}
+
+LoggerMessage::LoggerMessage(ILogger& logger, Level level)
+  : std::ostream(this)
+  , std::streambuf()
+  , logger(logger)
+  , logLevel(level)
+  , gotText(false)
+  , enabled(false) {
+  setstate(std::ios_base::badbit);
 }
 
 LoggerMessage::~LoggerMessage() {
@@ -33,8 +44,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
   , logLevel(other.logLevel)
   , logger(other.logger)
   , message(other.message)
-  , timestamp(boost::posix_time::microsec_clock::local_time())
-  , gotText(false) {
+  , timestamp(other.timestamp)
+  , gotText(false)
+  , enabled(other.enabled) {
   this->set_rdbuf(this);
 }
 #else
@@ -45,8 +57,9 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
   , logLevel(other.logLevel)
   , logger(other.logger)
   , message(other.message)
-  , timestamp(boost::posix_time::microsec_clock::local_time())
-  , gotText(false) {
+  , timestamp(other.timestamp)
+  , gotText(false)
+  , enabled(other.enabled) {
   if (this != &other) {
     _M_tie = nullptr;
     _M_streambuf = nullptr;
@@ -87,6 +100,10 @@ LoggerMessage::LoggerMessage(LoggerMessage&& other)
 #endif
 
 int LoggerMessage::sync() {
+  if (!enabled) {
+    return 0;
+  }
+
   logger(category, logLevel, timestamp, message);
   gotText = false;
   message = DEFAULT;
@@ -94,6 +111,10 @@ int LoggerMessage::sync() {
 }
 
 int LoggerMessage::overflow(int c) {
+  if (!enabled) {
+    return std::streambuf::traits_type::eof();
+  }
+
   gotText = true;
   message += static_cast<char>(c);
   return 0;
@@ -14,6 +14,8 @@ namespace Logging {
 class LoggerMessage : public std::ostream, std::streambuf {
 public:
   LoggerMessage(ILogger& logger, const std::string& category, Level level, const std::string& color);
+  // Discarding message: the stream is put into a failed state, so formatting stops at the first operator<<
+  LoggerMessage(ILogger& logger, Level level);
   ~LoggerMessage();
   LoggerMessage(const LoggerMessage&) = delete;
   LoggerMessage& operator=(const LoggerMessage&) = delete;
@@ -29,6 +31,7 @@ private:
   ILogger& logger;
   boost::posix_time::ptime timestamp;
   bool gotText;
+  bool enabled;
 };
 
 }
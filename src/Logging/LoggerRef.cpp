@@ -12,6 +12,10 @@ LoggerRef::LoggerRef(ILogger& logger, const std::string& category) : logger(&log
 }
 
 LoggerMessage LoggerRef::operator()(Level level, const std::string& color) const {
+  if (!isEnabled(level)) {
+    return LoggerMessage(*logger, level);
+  }
+
   return LoggerMessage(*logger, category, level, color);
 }
 
@@ -19,4 +23,8 @@ ILogger& LoggerRef::getLogger() const {
   return *logger;
 }
 
+bool LoggerRef::isEnabled(Level level) const {
+  return level <= logger->getMaxLevel();
+}
+
 }
@@ -16,6 +16,11 @@ public:
   LoggerRef(ILogger& logger, const std::string& category);
   LoggerMessage operator()(Level level = INFO, const std::string& color = DEFAULT) const;
   ILogger& getLogger() const;
+  bool isEnabled(Level level) const;
+
+  static Level messageLevel(Level level = INFO, const std::string& color = DEFAULT) {
+    return level;
+  }
 
 private:
   ILogger* logger;
@@ -23,3 +28,8 @@ private:
 };
 
 }
+
+// Same as logger(level, color) << ..., but the streamed operands are not evaluated when the level is filtered out.
+// Meant for per-transaction and per-block messages on hot paths
+#define LAZY_LOG(logger, ...) \
+  if (!(logger).isEnabled(Logging::LoggerRef::messageLevel(__VA_ARGS__))) {} else (logger)(__VA_ARGS__)
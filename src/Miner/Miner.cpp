@@ -10,6 +10,7 @@
 
 #include "crypto/crypto.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
+#include "CryptoNoteCore/MiningJob.h"
 
 #include <System/InterruptedException.h>
 
@@ -88,16 +89,20 @@ void Miner::runWorkers(BlockMiningParameters blockMiningParameters, size_t threa
 void Miner::workerFunc(const Block& blockTemplate, difficulty_type difficulty, uint32_t nonceStep) {
   try {
     Block block = blockTemplate;
-    Crypto::cn_context cryptoContext;
+    Crypto::cn_context cryptoContext(true);
+
+    MiningJob job;
+    if (!job.setBlock(block)) {
+      //error occured
+      m_logger(Logging::DEBUGGING) << "calculating long hash error occured";
+      m_state = MiningState::MINING_STOPPED;
+      return;
+    }
 
     while (m_state == MiningState::MINING_IN_PROGRESS) {
       Crypto::Hash hash;
-      if (!get_block_longhash(cryptoContext, block, hash)) {
-        //error occured
-        m_logger(Logging::DEBUGGING) << "calculating long hash error occured";
-        m_state = MiningState::MINING_STOPPED;
-        return;
-      }
+      job.setNonce(block.nonce);
+      job.getLongHash(cryptoContext, hash);
 
       if (check_hash(hash, difficulty)) {
         m_logger(Logging::INFO) << "Found block for difficulty " << difficulty;
@@ -9,6 +9,7 @@
 #include "NodeRpcProxy.h"
 #include "NodeErrors.h"
 
+#include <algorithm>
 #include <atomic>
 #include <system_error>
 #include <thread>
@@ -17,8 +18,6 @@
 #include <HTTP/HttpResponse.h>
 #include <System/ContextGroup.h>
 #include <System/Dispatcher.h>
-#include <System/Event.h>
-#include <System/EventLock.h>
 #include <System/Timer.h>
 #include <CryptoNoteCore/TransactionApi.h>
 
@@ -27,6 +26,7 @@
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "Rpc/CoreRpcServerCommandsDefinitions.h"
 #include "Rpc/HttpClient.h"
+#include "Rpc/HttpClientPool.h"
 #include "Rpc/JsonRpc.h"
 
 #ifndef AUTO_VAL_INIT
@@ -41,6 +41,15 @@ namespace CryptoNote {
 
 namespace {
 
+// Wallet sync keeps at most two requests in flight and leaves the last connection to sends and other short calls
+const size_t HTTP_CONNECTION_COUNT = 3;
+const size_t HTTP_RESERVED_CONNECTION_COUNT = 1;
+
+// Requests whose responses grow with the number of blocks or pool transactions behind the wallet
+bool isBulkRequest(const std::string& url) {
+  return url == "/queryblockslite.bin" || url == "/getblocks.bin" || url == "/get_pool_changes_lite.bin";
+}
+
 std::error_code interpretResponseStatus(const std::string& status) {
   if (CORE_RPC_STATUS_BUSY == status) {
     return make_error_code(error::NODE_BUSY);
@@ -125,11 +134,8 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
     m_dispatcher = &dispatcher;
     ContextGroup contextGroup(dispatcher);
     m_context_group = &contextGroup;
-    HttpClient httpClient(dispatcher, m_nodeHost, m_nodePort);
-    m_httpClient = &httpClient;
-    Event httpEvent(dispatcher);
-    m_httpEvent = &httpEvent;
-    m_httpEvent->set();
+    HttpClientPool httpClientPool(dispatcher, m_nodeHost, m_nodePort, HTTP_CONNECTION_COUNT, HTTP_RESERVED_CONNECTION_COUNT);
+    m_httpClientPool = &httpClientPool;
 
     {
       std::lock_guard<std::mutex> lock(m_mutex);
@@ -160,8 +166,7 @@ void NodeRpcProxy::workerThread(const INode::Callback& initialized_callback) {
 
   m_dispatcher = nullptr;
   m_context_group = nullptr;
-  m_httpClient = nullptr;
-  m_httpEvent = nullptr;
+  m_httpClientPool = nullptr;
   m_connected = false;
   m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::connectionStatusUpdated, m_connected);
 }
@@ -235,8 +240,8 @@ void NodeRpcProxy::updateBlockchainStatus() {
     updatePeerCount(getInfoResp.incoming_connections_count + getInfoResp.outgoing_connections_count);
   }
 
-  if (m_connected != m_httpClient->isConnected()) {
-    m_connected = m_httpClient->isConnected();
+  if (m_connected != m_httpClientPool->isConnected()) {
+    m_connected = m_httpClientPool->isConnected();
     m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::connectionStatusUpdated, m_connected);
   }
 }
@@ -303,6 +308,11 @@ uint64_t NodeRpcProxy::getLastLocalBlockTimestamp() const {
   return m_lastLocalBlockTimestamp;
 }
 
+std::map<std::string, NodeRpcProxyRequestStats> NodeRpcProxy::getRequestStats() const {
+  std::lock_guard<std::mutex> lock(m_requestStatsMutex);
+  return m_requestStats;
+}
+
 void NodeRpcProxy::relayTransaction(const CryptoNote::Transaction& transaction, const Callback& callback) {
   std::lock_guard<std::mutex> lock(m_mutex);
   if (m_state != STATE_INITIALIZED) {
@@ -632,8 +642,8 @@ void NodeRpcProxy::scheduleRequest(std::function<std::error_code()>&& procedure,
           callback(std::make_error_code(std::errc::operation_canceled));
         } else {
           std::error_code ec = procedure();
-          if (m_connected != m_httpClient->isConnected()) {
-            m_connected = m_httpClient->isConnected();
+          if (m_connected != m_httpClientPool->isConnected()) {
+            m_connected = m_httpClientPool->isConnected();
             m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::connectionStatusUpdated, m_connected);
           }
           callback(m_stop ? std::make_error_code(std::errc::operation_canceled) : ec);
@@ -645,10 +655,13 @@ void NodeRpcProxy::scheduleRequest(std::function<std::error_code()>&& procedure,
 template <typename Request, typename Response>
 std::error_code NodeRpcProxy::binaryCommand(const std::string& url, const Request& req, Response& res) {
   std::error_code ec;
+  auto start = std::chrono::steady_clock::now();
+  auto acquired = start;
 
   try {
-    EventLock eventLock(*m_httpEvent);
-    invokeBinaryCommand(*m_httpClient, url, req, res);
+    HttpClientPool::Lease lease = m_httpClientPool->acquire(isBulkRequest(url));
+    acquired = std::chrono::steady_clock::now();
+    invokeBinaryCommand(lease.client(), url, req, res);
     ec = interpretResponseStatus(res.status);
   } catch (const ConnectException&) {
     ec = make_error_code(error::CONNECT_ERROR);
@@ -656,16 +669,20 @@ std::error_code NodeRpcProxy::binaryCommand(const std::string& url, const Reques
     ec = make_error_code(error::NETWORK_ERROR);
   }
 
+  updateRequestStats(url, start, acquired, ec);
   return ec;
 }
 
 template <typename Request, typename Response>
 std::error_code NodeRpcProxy::jsonCommand(const std::string& url, const Request& req, Response& res) {
   std::error_code ec;
+  auto start = std::chrono::steady_clock::now();
+  auto acquired = start;
 
   try {
-    EventLock eventLock(*m_httpEvent);
-    invokeJsonCommand(*m_httpClient, url, req, res);
+    HttpClientPool::Lease lease = m_httpClientPool->acquire(isBulkRequest(url));
+    acquired = std::chrono::steady_clock::now();
+    invokeJsonCommand(lease.client(), url, req, res);
     ec = interpretResponseStatus(res.status);
   } catch (const ConnectException&) {
     ec = make_error_code(error::CONNECT_ERROR);
@@ -673,15 +690,19 @@ std::error_code NodeRpcProxy::jsonCommand(const std::string& url, const Request&
     ec = make_error_code(error::NETWORK_ERROR);
   }
 
+  updateRequestStats(url, start, acquired, ec);
   return ec;
 }
 
 template <typename Request, typename Response>
 std::error_code NodeRpcProxy::jsonRpcCommand(const std::string& method, const Request& req, Response& res) {
   std::error_code ec = make_error_code(error::INTERNAL_NODE_ERROR);
+  auto start = std::chrono::steady_clock::now();
+  auto acquired = start;
 
   try {
-    EventLock eventLock(*m_httpEvent);
+    HttpClientPool::Lease lease = m_httpClientPool->acquire(false);
+    acquired = std::chrono::steady_clock::now();
 
     JsonRpc::JsonRpcRequest jsReq;
 
@@ -694,7 +715,7 @@ std::error_code NodeRpcProxy::jsonRpcCommand(const std::string& method, const Re
     httpReq.setUrl("/json_rpc");
     httpReq.setBody(jsReq.getBody());
 
-    m_httpClient->request(httpReq, httpRes);
+    lease.client().request(httpReq, httpRes);
 
     JsonRpc::JsonRpcResponse jsRes;
 
@@ -710,9 +731,35 @@ std::error_code NodeRpcProxy::jsonRpcCommand(const std::string& method, const Re
     ec = make_error_code(error::NETWORK_ERROR);
   }
 
+  updateRequestStats(method, start, acquired, ec);
   return ec;
 }
 
+void NodeRpcProxy::updateRequestStats(const std::string& request, std::chrono::steady_clock::time_point start,
+  std::chrono::steady_clock::time_point acquired, const std::error_code& ec) {
+  auto now = std::chrono::steady_clock::now();
+  uint64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(now - start).count();
+  uint64_t waitTime = std::chrono::duration_cast<std::chrono::microseconds>(acquired - start).count();
+
+  NodeRpcProxyRequestStats stats;
+  {
+    std::lock_guard<std::mutex> lock(m_requestStatsMutex);
+    NodeRpcProxyRequestStats& entry = m_requestStats[request];
+    ++entry.count;
+    if (ec) {
+      ++entry.failedCount;
+    }
+
+    entry.totalLatency += latency;
+    entry.maxLatency = std::max(entry.maxLatency, latency);
+    entry.lastLatency = latency;
+    entry.totalWaitTime += waitTime;
+    stats = entry;
+  }
+
+  m_rpcProxyObserverManager.notify(&INodeRpcProxyObserver::requestCompleted, request, stats);
+}
+
 std::error_code NodeRpcProxy::doGetTransactionHashesByPaymentId(const Crypto::Hash& paymentId, std::vector<Crypto::Hash>& transactionHashes) {
   COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID::request req = AUTO_VAL_INIT(req);
   COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID::response resp = AUTO_VAL_INIT(resp);
@@ -9,7 +9,9 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <map>
 #include <mutex>
 #include <string>
 #include <thread>
@@ -21,17 +23,28 @@
 namespace System {
   class ContextGroup;
   class Dispatcher;
-  class Event;
 }
 
 namespace CryptoNote {
 
-class HttpClient;
+class HttpClientPool;
+
+// Latency counters of one RPC method or URL, in microseconds. The latency includes the time spent waiting for a
+// free connection, which is also counted separately
+struct NodeRpcProxyRequestStats {
+  uint64_t count = 0;
+  uint64_t failedCount = 0;
+  uint64_t totalLatency = 0;
+  uint64_t maxLatency = 0;
+  uint64_t lastLatency = 0;
+  uint64_t totalWaitTime = 0;
+};
 
 class INodeRpcProxyObserver {
 public:
   virtual ~INodeRpcProxyObserver() {}
   virtual void connectionStatusUpdated(bool connected) {}
+  virtual void requestCompleted(const std::string& request, const NodeRpcProxyRequestStats& stats) {}
 };
 
 class NodeRpcProxy : public CryptoNote::INode {
@@ -75,6 +88,8 @@ public:
   unsigned int rpcTimeout() const { return m_rpcTimeout; }
   void rpcTimeout(unsigned int val) { m_rpcTimeout = val; }
 
+  std::map<std::string, NodeRpcProxyRequestStats> getRequestStats() const;
+
 private:
   void resetInternalState();
   void workerThread(const Callback& initialized_callback);
@@ -106,6 +121,8 @@ private:
   std::error_code jsonCommand(const std::string& url, const Request& req, Response& res);
   template <typename Request, typename Response>
   std::error_code jsonRpcCommand(const std::string& method, const Request& req, Response& res);
+  void updateRequestStats(const std::string& request, std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point acquired, const std::error_code& ec);
 
   enum State {
     STATE_NOT_INITIALIZED,
@@ -126,8 +143,9 @@ private:
   const std::string m_nodeHost;
   const unsigned short m_nodePort;
   unsigned int m_rpcTimeout;
-  HttpClient* m_httpClient = nullptr;
-  System::Event* m_httpEvent = nullptr;
+  HttpClientPool* m_httpClientPool = nullptr;
+  mutable std::mutex m_requestStatsMutex;
+  std::map<std::string, NodeRpcProxyRequestStats> m_requestStats;
 
   uint64_t m_pullInterval;
 
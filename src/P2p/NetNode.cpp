@@ -100,6 +100,25 @@ bool parse_peer_from_string(NetworkAddress& pe, const std::string& node_addr) {
   return Common::parseIpAddressAndPort(pe.ip, pe.port, node_addr);
 }
 
+System::TcpListener openListener(System::Dispatcher& dispatcher, const std::string& ip, uint16_t port, bool shared) {
+#ifdef __linux__
+  return System::TcpListener(dispatcher, System::Ipv4Address(ip), port, shared);
+#else
+  assert(!shared);
+  return System::TcpListener(dispatcher, System::Ipv4Address(ip), port);
+#endif
+}
+
+System::TcpListener takeListener(System::Dispatcher& dispatcher, System::TcpListener& listener) {
+#ifdef __linux__
+  return System::TcpListener(dispatcher, std::move(listener));
+#else
+  // There are no workers on the other platforms
+  assert(false);
+  throw std::runtime_error("Listeners can't be taken over on this platform");
+#endif
+}
+
 }
 
 
@@ -147,48 +166,95 @@ namespace CryptoNote
   //-----------------------------------------------------------------------------------
 
   bool P2pConnectionContext::pushMessage(P2pMessage&& msg) {
-    writeQueueSize += msg.size();
+    bool overflow;
+    bool wakeWriter = false;
+    {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      writeQueueSize += msg.size();
+      overflow = writeQueueSize > P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE;
+      if (!overflow) {
+        // The writer takes the whole queue at once, so it only has to be woken for the first message
+        wakeWriter = writeQueue.empty();
+        writeQueue.push_back(std::move(msg));
+      }
+    }
 
-    if (writeQueueSize > P2P_CONNECTION_MAX_WRITE_BUFFER_SIZE) {
+    if (overflow) {
       logger(DEBUGGING) << *this << "Write queue overflows. Interrupt connection";
       interrupt();
       return false;
     }
 
-    writeQueue.push_back(std::move(msg));
-    queueEvent.set();
+    if (wakeWriter) {
+      onOwner([](P2pConnectionContext& ctx) {
+        ctx.queueEvent.set();
+      });
+    }
+
     return true;
   }
 
   std::vector<P2pMessage> P2pConnectionContext::popBuffer() {
+    std::unique_lock<std::mutex> lock(queueMutex);
     writeOperationStartTime = TimePoint();
 
     while (writeQueue.empty() && !stopped) {
+      lock.unlock();
       queueEvent.wait();
+      // A wakeup posted by another thread can come after the messages it was for are taken, so the queue is checked
+      // again after every one
+      queueEvent.clear();
+      lock.lock();
     }
 
     std::vector<P2pMessage> msgs(std::move(writeQueue));
     writeQueue.clear();
     writeQueueSize = 0;
     writeOperationStartTime = Clock::now();
-    queueEvent.clear();
     return msgs;
   }
 
   uint64_t P2pConnectionContext::writeDuration(TimePoint now) const { // in milliseconds
+    std::lock_guard<std::mutex> lock(queueMutex);
     return writeOperationStartTime == TimePoint() ? 0 : std::chrono::duration_cast<std::chrono::milliseconds>(now - writeOperationStartTime).count();
   }
 
+  void P2pConnectionContext::updateStateAction() {
+    stateActionRequired.store(m_state == CryptoNoteConnectionContext::state_shutdown ||
+      m_state == CryptoNoteConnectionContext::state_sync_required ||
+      m_state == CryptoNoteConnectionContext::state_pool_sync_required, std::memory_order_release);
+  }
+
   void P2pConnectionContext::interrupt() {
-    logger(DEBUGGING) << *this << "Interrupt connection";
-    assert(context != nullptr);
-    stopped = true;
-    queueEvent.set();
-    context->interrupt();
+    onOwner([](P2pConnectionContext& ctx) {
+      ctx.logger(DEBUGGING) << ctx << "Interrupt connection";
+      assert(ctx.context != nullptr);
+      ctx.stopped = true;
+      ctx.queueEvent.set();
+      ctx.context->interrupt();
+    });
   }
 
-  template <typename Command, typename Handler>
-  int invokeAdaptor(const BinaryArray& reqBuf, BinaryArray& resBuf, P2pConnectionContext& ctx, Handler handler) {
+  void P2pConnectionContext::onOwner(std::function<void(P2pConnectionContext&)>&& procedure) {
+    if (worker == nullptr || worker->threadId == std::this_thread::get_id()) {
+      procedure(*this);
+      return;
+    }
+
+    // The connection can be closed before the worker gets to the procedure, so it is looked up again there
+    P2pWorker* owner = worker;
+    boost::uuids::uuid connectionId = m_connection_id;
+    owner->dispatcher->remoteSpawn([owner, connectionId, procedure] {
+      auto it = owner->connections.find(connectionId);
+      if (it != owner->connections.end()) {
+        procedure(*it->second);
+      }
+    });
+  }
+
+  // Decoding and encoding are done on the dispatcher of the connection, the handler by the runner
+  template <typename Command, typename Handler, typename Runner>
+  int invokeAdaptor(const BinaryArray& reqBuf, BinaryArray& resBuf, P2pConnectionContext& ctx, Handler handler, Runner runner) {
     typedef typename Command::request Request;
     typedef typename Command::response Response;
     int command = Command::ID;
@@ -200,7 +266,11 @@ namespace CryptoNote
     }
 
     Response res = boost::value_initialized<Response>();
-    int ret = handler(command, req, res, ctx);
+    int ret = 0;
+    runner([&] {
+      ret = handler(command, req, res, ctx);
+    });
+
     resBuf = LevinProtocol::encode(res);
     return ret;
   }
@@ -218,6 +288,7 @@ namespace CryptoNote
     m_timedSyncTimer(m_dispatcher),
     m_timeoutTimer(m_dispatcher),
     m_stop(false),
+    m_threadCount(0),
     // intervals
     // m_peer_handshake_idle_maker_interval(CryptoNote::P2P_DEFAULT_HANDSHAKE_INTERVAL),
     m_connections_maker_interval(1),
@@ -236,32 +307,54 @@ namespace CryptoNote
     s(m_config.m_peer_id, "peer_id");
   }
 
-#define INVOKE_HANDLER(CMD, Handler) case CMD::ID: { ret = invokeAdaptor<CMD>(cmd.buf, out, ctx,  boost::bind(Handler, this, _1, _2, _3, _4)); break; }
+#define INVOKE_HANDLER(CMD, Handler, Runner) case CMD::ID: { ret = invokeAdaptor<CMD>(cmd.buf, out, ctx,  boost::bind(Handler, this, _1, _2, _3, _4), Runner); break; }
 
   int NodeServer::handleCommand(const LevinProtocol::Command& cmd, BinaryArray& out, P2pConnectionContext& ctx, bool& handled) {
     int ret = 0;
     handled = true;
 
+#ifdef ALLOW_DEBUG_COMMANDS
+    auto onNodeDispatcher = [this, &ctx](std::function<void()>&& procedure) { onNode(ctx, std::move(procedure)); };
+#endif
+    auto onConnectionDispatcher = [](std::function<void()>&& procedure) { procedure(); };
+
     if (cmd.isResponse && cmd.command == COMMAND_TIMED_SYNC::ID) {
-      if (!handleTimedSyncResponse(cmd.buf, ctx)) {
-        // invalid response, close connection
-        ctx.m_state = CryptoNoteConnectionContext::state_shutdown;
+      // Decoded and checked here, the node server only merges the peerlist and hands the sync data to the core
+      auto rsp = std::make_shared<COMMAND_TIMED_SYNC::response>();
+      int64_t delta = 0;
+      if (!LevinProtocol::decode<COMMAND_TIMED_SYNC::response>(cmd.buf, *rsp) ||
+          !fix_time_delta(rsp->local_peerlist, rsp->local_time, delta)) {
+        logger(Logging::DEBUGGING) << ctx << "COMMAND_TIMED_SYNC: invalid response, closing connection.";
+        onNodeAsync(ctx, [](P2pConnectionContext& ctx) {
+          ctx.m_state = CryptoNoteConnectionContext::state_shutdown;
+        });
+        return 0;
       }
+
+      logger(Logging::TRACE) << ctx << "REMOTE PEERLIST: TIME_DELTA: " << delta << ", remote peerlist size=" << rsp->local_peerlist.size();
+      onNodeAsync(ctx, [this, rsp](P2pConnectionContext& ctx) {
+        if (!handleTimedSyncResponse(*rsp, ctx)) {
+          // invalid response, close connection
+          ctx.m_state = CryptoNoteConnectionContext::state_shutdown;
+        }
+      });
       return 0;
     }
 
     switch (cmd.command) {
-      INVOKE_HANDLER(COMMAND_HANDSHAKE, &NodeServer::handle_handshake)
-      INVOKE_HANDLER(COMMAND_TIMED_SYNC, &NodeServer::handle_timed_sync)
-      INVOKE_HANDLER(COMMAND_PING, &NodeServer::handle_ping)
+      INVOKE_HANDLER(COMMAND_HANDSHAKE, &NodeServer::handle_handshake, onConnectionDispatcher)
+      INVOKE_HANDLER(COMMAND_TIMED_SYNC, &NodeServer::handle_timed_sync, onConnectionDispatcher)
+      INVOKE_HANDLER(COMMAND_PING, &NodeServer::handle_ping, onConnectionDispatcher)
 #ifdef ALLOW_DEBUG_COMMANDS
-      INVOKE_HANDLER(COMMAND_REQUEST_STAT_INFO, &NodeServer::handle_get_stat_info)
-      INVOKE_HANDLER(COMMAND_REQUEST_NETWORK_STATE, &NodeServer::handle_get_network_state)
-      INVOKE_HANDLER(COMMAND_REQUEST_PEER_ID, &NodeServer::handle_get_peer_id)
+      INVOKE_HANDLER(COMMAND_REQUEST_STAT_INFO, &NodeServer::handle_get_stat_info, onNodeDispatcher)
+      INVOKE_HANDLER(COMMAND_REQUEST_NETWORK_STATE, &NodeServer::handle_get_network_state, onNodeDispatcher)
+      INVOKE_HANDLER(COMMAND_REQUEST_PEER_ID, &NodeServer::handle_get_peer_id, onConnectionDispatcher)
 #endif
     default: {
         handled = false;
-        ret = m_payload_handler.handleCommand(cmd.isNotify, cmd.command, cmd.buf, out, ctx, handled);
+        onNode(ctx, [&] {
+          ret = m_payload_handler.handleCommand(cmd.isNotify, cmd.command, cmd.buf, out, ctx, handled);
+        });
       }
     }
 
@@ -506,6 +599,7 @@ namespace CryptoNote
     std::copy(seedNodes.begin(), seedNodes.end(), std::back_inserter(m_seed_nodes));
 
     m_hide_my_port = config.getHideMyPort();
+    m_threadCount = config.getThreadCount();
     return true;
   }
 
@@ -582,7 +676,15 @@ namespace CryptoNote
     logger(INFO) <<  "Binding on " << m_bind_ip << ":" << m_port;
     m_listeningPort = Common::fromString<uint16_t>(m_port);
 
-    m_listener = System::TcpListener(m_dispatcher, System::Ipv4Address(m_bind_ip), static_cast<uint16_t>(m_listeningPort));
+#ifndef __linux__
+    if (m_threadCount != 0) {
+      logger(WARNING) << "P2P threads are only supported on Linux, the connections stay on the main thread";
+      m_threadCount = 0;
+    }
+#endif
+
+    // With workers the first one takes this listener over, the others bind listeners of their own to the port
+    m_listener = openListener(m_dispatcher, m_bind_ip, static_cast<uint16_t>(m_listeningPort), m_threadCount != 0);
 
     logger(INFO, BRIGHT_GREEN) << "Net service bound on " << m_bind_ip << ":" << m_listeningPort;
 
@@ -605,7 +707,11 @@ namespace CryptoNote
   bool NodeServer::run() {
     logger(INFO) <<  "Starting node server";
 
-    m_workingContextGroup.spawn(std::bind(&NodeServer::acceptLoop, this));
+    startWorkers();
+    if (m_workers.empty()) {
+      m_workingContextGroup.spawn(std::bind(&NodeServer::acceptLoop, this, std::ref(m_listener), nullptr));
+    }
+
     m_workingContextGroup.spawn(std::bind(&NodeServer::onIdle, this));
     m_workingContextGroup.spawn(std::bind(&NodeServer::timedSyncLoop, this));
     m_workingContextGroup.spawn(std::bind(&NodeServer::timeoutLoop, this));
@@ -614,6 +720,7 @@ namespace CryptoNote
 
     logger(INFO) <<  "Stopping NodeServer and it's, " << m_connections.size() << " connections...";
     m_workingContextGroup.interrupt();
+    stopWorkers();
     m_workingContextGroup.wait();
 
     logger(INFO) <<  "NodeServer loop stopped";
@@ -743,14 +850,10 @@ namespace CryptoNote
     return true;
   }
 
-  bool NodeServer::handleTimedSyncResponse(const BinaryArray& in, P2pConnectionContext& context) {
-    COMMAND_TIMED_SYNC::response rsp;
-    if (!LevinProtocol::decode<COMMAND_TIMED_SYNC::response>(in, rsp)) {
-      return false;
-    }
-
-    if (!handle_remote_peerlist(rsp.local_peerlist, rsp.local_time, context)) {
-      logger(Logging::DEBUGGING) << context << "COMMAND_TIMED_SYNC: failed to handle_remote_peerlist(...), closing connection.";
+  // The times in the peerlist of the response are already fixed by the connection
+  bool NodeServer::handleTimedSyncResponse(const COMMAND_TIMED_SYNC::response& rsp, P2pConnectionContext& context) {
+    if (!m_peerlist.merge_peerlist(rsp.local_peerlist)) {
+      logger(Logging::DEBUGGING) << context << "COMMAND_TIMED_SYNC: failed to merge the remote peerlist, closing connection.";
       return false;
     }
 
@@ -1272,18 +1375,19 @@ namespace CryptoNote
     auto ip = Common::ipAddressToString(actual_ip);
     auto port = node_data.my_port;
     auto peerId = node_data.peer_id;
+    System::Dispatcher& dispatcher = context.worker != nullptr ? *context.worker->dispatcher : m_dispatcher;
 
     try {
       COMMAND_PING::request req;
       COMMAND_PING::response rsp;
-      System::Context<> pingContext(m_dispatcher, [&] {
-        System::TcpConnector connector(m_dispatcher);
+      System::Context<> pingContext(dispatcher, [&] {
+        System::TcpConnector connector(dispatcher);
         auto connection = connector.connect(System::Ipv4Address(ip), static_cast<uint16_t>(port));
         LevinProtocol(connection).invoke(COMMAND_PING::ID, req, rsp);
       });
 
-      System::Context<> timeoutContext(m_dispatcher, [&] {
-        System::Timer(m_dispatcher).sleep(std::chrono::milliseconds(m_config.m_net_config.connection_timeout * 2));
+      System::Context<> timeoutContext(dispatcher, [&] {
+        System::Timer(dispatcher).sleep(std::chrono::milliseconds(m_config.m_net_config.connection_timeout * 2));
         logger(DEBUGGING) << context << "Back ping timed out" << ip << ":" << port;
         safeInterrupt(pingContext);
       });
@@ -1304,68 +1408,88 @@ namespace CryptoNote
   }
 
   //-----------------------------------------------------------------------------------
+  // Runs on the dispatcher of the connection, only the core and the peerlist are used on the one of the node server
   int NodeServer::handle_timed_sync(int command, COMMAND_TIMED_SYNC::request& arg, COMMAND_TIMED_SYNC::response& rsp, P2pConnectionContext& context)
   {
-    if(!m_payload_handler.process_payload_sync_data(arg.payload_data, context, false)) {
-      logger(Logging::DEBUGGING) << context << "Failed to process_payload_sync_data(), dropping connection";
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
-    }
+    onNode(context, [&] {
+      if(!m_payload_handler.process_payload_sync_data(arg.payload_data, context, false)) {
+        logger(Logging::DEBUGGING) << context << "Failed to process_payload_sync_data(), dropping connection";
+        context.m_state = CryptoNoteConnectionContext::state_shutdown;
+        return;
+      }
+
+      //fill response
+      m_peerlist.get_peerlist_head(rsp.local_peerlist);
+      m_payload_handler.get_payload_sync_data(rsp.payload_data);
+    });
 
-    //fill response
     rsp.local_time = time(NULL);
-    m_peerlist.get_peerlist_head(rsp.local_peerlist);
-    m_payload_handler.get_payload_sync_data(rsp.payload_data);
     logger(Logging::TRACE) << context << "COMMAND_TIMED_SYNC";
     return 1;
   }
   //-----------------------------------------------------------------------------------
 
+  // Runs on the dispatcher of the connection, only the core and the peerlist are used on the one of the node server
   int NodeServer::handle_handshake(int command, COMMAND_HANDSHAKE::request& arg, COMMAND_HANDSHAKE::response& rsp, P2pConnectionContext& context)
   {
-    context.version = arg.node_data.version;
-    
+    auto drop = [&](bool addFail) {
+      onNode(context, [&] {
+        drop_connection(context, addFail);
+      });
+      return 1;
+    };
+
     if (!is_remote_host_allowed(context.m_remote_ip)) {
       logger(Logging::DEBUGGING) << context << "Banned node connected " << Common::ipAddressToString(context.m_remote_ip) << ", dropping connection.";
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
+      return drop(false);
     }
 
     if (arg.node_data.network_id != m_network_id) {
-      add_host_fail(context.m_remote_ip);
       logger(Logging::INFO) << context << "WRONG NETWORK AGENT CONNECTED! id=" << arg.node_data.network_id;
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
+      return drop(true);
     }
 
     if (arg.node_data.version < CryptoNote::P2P_MINIMUM_VERSION) {
       logger(Logging::DEBUGGING) << context << "UNSUPPORTED NETWORK AGENT VERSION CONNECTED! version=" << std::to_string(arg.node_data.version);
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
+      return drop(false);
     } else if (arg.node_data.version > CryptoNote::P2P_CURRENT_VERSION) {
       logger(Logging::WARNING) << context << "Warning, your software may be out of date. Please upgrare to the latest version.";
     }
 
     if(!context.m_is_income) {
-      add_host_fail(context.m_remote_ip);
       logger(Logging::DEBUGGING) << context << "COMMAND_HANDSHAKE came not from incoming connection";
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
+      return drop(true);
     }
 
+    // peerId is only set below, by this connection
     if(context.peerId) {
       logger(Logging::DEBUGGING) << context << "COMMAND_HANDSHAKE came, but seems that connection already have associated peer_id (double COMMAND_HANDSHAKE?)";
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
-      return 1;
+      return drop(false);
     }
 
-    if(!m_payload_handler.process_payload_sync_data(arg.payload_data, context, true))  {
-      logger(Logging::DEBUGGING) << context << "COMMAND_HANDSHAKE came, but process_payload_sync_data returned false, dropping connection.";
-      context.m_state = CryptoNoteConnectionContext::state_shutdown;
+    bool accepted = false;
+    onNode(context, [&] {
+      context.version = arg.node_data.version;
+      if(!m_payload_handler.process_payload_sync_data(arg.payload_data, context, true))  {
+        logger(Logging::DEBUGGING) << context << "COMMAND_HANDSHAKE came, but process_payload_sync_data returned false, dropping connection.";
+        context.m_state = CryptoNoteConnectionContext::state_shutdown;
+        return;
+      }
+
+      //associate peer_id with this connection
+      context.peerId = arg.node_data.peer_id;
+      accepted = true;
+
+      //fill response
+      m_peerlist.get_peerlist_head(rsp.local_peerlist);
+      m_payload_handler.get_payload_sync_data(rsp.payload_data);
+    });
+
+    if (!accepted) {
       return 1;
     }
-    //associate peer_id with this connection
-    context.peerId = arg.node_data.peer_id;
+
+    get_local_node_data(rsp.node_data);
 
     if(arg.node_data.peer_id != m_config.m_peer_id && arg.node_data.my_port) {
       PeerIdType peer_id_l = arg.node_data.peer_id;
@@ -1378,17 +1502,14 @@ namespace CryptoNote
           pe.adr.port = port_l;
           pe.last_seen = time(nullptr);
           pe.id = peer_id_l;
-          m_peerlist.append_with_peer_white(pe);
+          onNodeAsync(context, [this, pe](P2pConnectionContext&) {
+            m_peerlist.append_with_peer_white(pe);
+          });
 
           logger(Logging::TRACE) << context << "BACK PING SUCCESS, " << Common::ipAddressToString(context.m_remote_ip) << ":" << port_l << " added to whitelist";
       }
     }
 
-    //fill response
-    m_peerlist.get_peerlist_head(rsp.local_peerlist);
-    get_local_node_data(rsp.node_data);
-    m_payload_handler.get_payload_sync_data(rsp.payload_data);
-
     logger(Logging::DEBUGGING, Logging::BRIGHT_GREEN) << "COMMAND_HANDSHAKE";
     return 1;
   }
@@ -1497,23 +1618,38 @@ namespace CryptoNote
     return true;
   }
 
-  void NodeServer::acceptLoop() {
+  void NodeServer::acceptLoop(System::TcpListener& listener, P2pWorker* worker) {
+    System::Dispatcher& dispatcher = worker != nullptr ? *worker->dispatcher : m_dispatcher;
+    System::ContextGroup& contextGroup = worker != nullptr ? *worker->contextGroup : m_workingContextGroup;
+
     for (;;) {
       try {
-        P2pConnectionContext ctx(m_dispatcher, logger.getLogger(), m_listener.accept());
+        P2pConnectionContext ctx(dispatcher, logger.getLogger(), listener.accept());
         ctx.m_connection_id = boost::uuids::random_generator()();
         ctx.m_is_income = true;
         ctx.m_started = time(nullptr);
+        ctx.worker = worker;
 
         auto addressAndPort = ctx.connection.getPeerAddressAndPort();
         ctx.m_remote_ip = hostToNetwork(addressAndPort.first.getValue());
         ctx.m_remote_port = addressAndPort.second;
 
-        auto iter = m_connections.emplace(ctx.m_connection_id, std::move(ctx)).first;
-        const boost::uuids::uuid& connectionId = iter->first;
-        P2pConnectionContext& connection = iter->second;
+        // The connections are only added and removed on the dispatcher of the node server
+        const boost::uuids::uuid* connectionId = nullptr;
+        P2pConnectionContext* connection = nullptr;
+        onNode(ctx, [&] {
+          if (!m_stop) {
+            auto iter = m_connections.emplace(ctx.m_connection_id, std::move(ctx)).first;
+            connectionId = &iter->first;
+            connection = &iter->second;
+          }
+        });
+
+        if (connection == nullptr) {
+          continue;
+        }
 
-        m_workingContextGroup.spawn(std::bind(&NodeServer::connectionHandler, this, std::cref(connectionId), std::ref(connection)));
+        contextGroup.spawn(std::bind(&NodeServer::connectionHandler, this, std::cref(*connectionId), std::ref(*connection)));
       } catch (System::InterruptedException&) {
         logger(DEBUGGING) << "acceptLoop() is interrupted";
         break;
@@ -1525,6 +1661,183 @@ namespace CryptoNote
     logger(DEBUGGING) << "acceptLoop finished";
   }
 
+  void NodeServer::startWorkers() {
+    for (uint32_t i = 0; i < m_threadCount; ++i) {
+      std::unique_ptr<P2pWorker> worker(new P2pWorker(m_dispatcher));
+      // The first worker accepts the connections already queued on the listener of the node server
+      if (m_workers.empty()) {
+        worker->takenListener = &m_listener;
+      }
+
+      std::promise<void> started;
+      std::future<void> startResult = started.get_future();
+      worker->thread = std::thread(&NodeServer::workerThread, this, std::ref(*worker), std::move(started));
+
+      try {
+        startResult.get();
+      } catch (const std::exception& e) {
+        logger(ERROR, BRIGHT_RED) << "Failed to start p2p thread: " << e.what();
+        worker->thread.join();
+        break;
+      }
+
+      m_workers.push_back(std::move(worker));
+    }
+
+    if (!m_workers.empty()) {
+      logger(INFO) << "Incoming p2p connections are handled by " << m_workers.size() << " threads";
+    }
+  }
+
+  std::vector<System::Dispatcher*> NodeServer::getWorkerDispatchers() {
+    std::vector<System::Dispatcher*> dispatchers;
+    for (auto& worker : m_workers) {
+      dispatchers.push_back(worker->dispatcher);
+    }
+
+    return dispatchers;
+  }
+
+  void NodeServer::stopWorkers() {
+    for (auto& worker : m_workers) {
+      System::Event* stopEvent = worker->stopEvent;
+      worker->dispatcher->remoteSpawn([stopEvent] {
+        stopEvent->set();
+      });
+    }
+
+    // Closing their connections needs this dispatcher, so the workers are waited for without blocking it
+    for (auto& worker : m_workers) {
+      worker->finished.wait();
+      worker->thread.join();
+    }
+
+    m_workers.clear();
+  }
+
+  void NodeServer::workerThread(P2pWorker& worker, std::promise<void> started) {
+    bool running = false;
+    try {
+      System::Dispatcher dispatcher;
+      System::ContextGroup contextGroup(dispatcher);
+      System::Event stopEvent(dispatcher);
+      System::TcpListener listener = worker.takenListener != nullptr ? takeListener(dispatcher, *worker.takenListener) :
+        openListener(dispatcher, m_bind_ip, static_cast<uint16_t>(m_listeningPort), true);
+
+      worker.dispatcher = &dispatcher;
+      worker.contextGroup = &contextGroup;
+      worker.stopEvent = &stopEvent;
+      worker.threadId = std::this_thread::get_id();
+      started.set_value();
+      running = true;
+
+      contextGroup.spawn(std::bind(&NodeServer::acceptLoop, this, std::ref(listener), &worker));
+      stopEvent.wait();
+      contextGroup.interrupt();
+      contextGroup.wait();
+    } catch (const std::exception&) {
+      if (!running) {
+        started.set_exception(std::current_exception());
+        return;
+      }
+
+      logger(ERROR, BRIGHT_RED) << "Exception in p2p thread";
+    }
+
+    m_dispatcher.remoteSpawn([&worker] {
+      worker.finished.set();
+    });
+  }
+
+  void NodeServer::onNode(P2pConnectionContext& ctx, std::function<void()>&& procedure) {
+    if (ctx.worker == nullptr) {
+      procedure();
+      return;
+    }
+
+    System::Dispatcher* dispatcher = ctx.worker->dispatcher;
+    System::Event done(*dispatcher);
+    std::exception_ptr error;
+    boost::uuids::uuid connectionId = ctx.m_connection_id;
+    m_dispatcher.remoteSpawn([this, dispatcher, connectionId, &done, &error, &procedure] {
+      try {
+        procedure();
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      // The procedure can add or remove the connection, so it is looked up
+      auto it = m_connections.find(connectionId);
+      if (it != m_connections.end()) {
+        it->second.updateStateAction();
+      }
+
+      // make a local copy; done is gone as soon as it is set
+      System::Event* localDone = &done;
+      dispatcher->remoteSpawn([localDone] {
+        localDone->set();
+      });
+    });
+
+    // As in RemoteContext, the procedure refers to this frame, so an interrupt can't end the wait
+    bool interrupted = false;
+    while (!done.get()) {
+      try {
+        done.wait();
+      } catch (System::InterruptedException&) {
+        interrupted = true;
+      }
+    }
+
+    if (interrupted) {
+      dispatcher->interrupt();
+    }
+
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+
+  void NodeServer::onNodeAsync(P2pConnectionContext& ctx, std::function<void(P2pConnectionContext&)>&& procedure) {
+    if (ctx.worker == nullptr) {
+      procedure(ctx);
+      return;
+    }
+
+    // The connection can be closed before the node server gets to the procedure, so it is looked up again there
+    boost::uuids::uuid connectionId = ctx.m_connection_id;
+    m_dispatcher.remoteSpawn([this, connectionId, procedure] {
+      auto it = m_connections.find(connectionId);
+      if (it == m_connections.end()) {
+        return;
+      }
+
+      P2pConnectionContext& connection = it->second;
+      procedure(connection);
+      connection.updateStateAction();
+      if (connection.m_state == CryptoNoteConnectionContext::state_shutdown) {
+        // The worker may be waiting for the next command, so it is not left to notice the state by itself
+        safeInterrupt(connection);
+      }
+    });
+  }
+
+  bool NodeServer::processConnectionState(P2pConnectionContext& ctx) {
+    if (ctx.m_state == CryptoNoteConnectionContext::state_shutdown) {
+      return false;
+    }
+
+    if (ctx.m_state == CryptoNoteConnectionContext::state_sync_required) {
+      ctx.m_state = CryptoNoteConnectionContext::state_synchronizing;
+      m_payload_handler.start_sync(ctx);
+    } else if (ctx.m_state == CryptoNoteConnectionContext::state_pool_sync_required) {
+      ctx.m_state = CryptoNoteConnectionContext::state_normal;
+      m_payload_handler.requestMissingPoolTransactions(ctx);
+    }
+
+    return true;
+  }
+
   void NodeServer::onIdle() {
     logger(DEBUGGING) << "onIdle started";
 
@@ -1532,6 +1845,12 @@ namespace CryptoNote
       while (!m_stop) {
         idle_worker();
         m_payload_handler.on_idle();
+
+        // The states of the connections are also changed by other connections and by the idle handlers
+        for (auto& kv : m_connections) {
+          kv.second.updateStateAction();
+        }
+
         m_idleTimer.sleep(std::chrono::seconds(1));
       }
     } catch (System::InterruptedException&) {
@@ -1580,26 +1899,35 @@ namespace CryptoNote
   }
 
   void NodeServer::connectionHandler(const boost::uuids::uuid& connectionId, P2pConnectionContext& ctx) {
+    System::Dispatcher& dispatcher = ctx.worker != nullptr ? *ctx.worker->dispatcher : m_dispatcher;
+
     // This inner context is necessary in order to stop connection handler at any moment
-    System::Context<> context(m_dispatcher, [this, &connectionId, &ctx] {
-      System::Context<> writeContext(m_dispatcher, std::bind(&NodeServer::writeHandler, this, std::ref(ctx)));
+    System::Context<> context(dispatcher, [this, &dispatcher, &connectionId, &ctx] {
+      if (ctx.worker != nullptr) {
+        ctx.worker->connections.emplace(connectionId, &ctx);
+      }
+
+      System::Context<> writeContext(dispatcher, std::bind(&NodeServer::writeHandler, this, std::ref(ctx)));
 
       try {
-        on_connection_new(ctx);
+        onNode(ctx, [this, &ctx] {
+          on_connection_new(ctx);
+        });
 
         LevinProtocol proto(ctx.connection);
         LevinProtocol::Command cmd;
 
         for (;;) {
-          if (ctx.m_state == CryptoNoteConnectionContext::state_sync_required) {
-            ctx.m_state = CryptoNoteConnectionContext::state_synchronizing;
-            m_payload_handler.start_sync(ctx);
-          } else if (ctx.m_state == CryptoNoteConnectionContext::state_pool_sync_required) {
-            ctx.m_state = CryptoNoteConnectionContext::state_normal;
-            m_payload_handler.requestMissingPoolTransactions(ctx);
+          bool running = true;
+          if (ctx.worker == nullptr) {
+            running = processConnectionState(ctx);
+          } else if (ctx.stateActionRequired.load(std::memory_order_acquire)) {
+            onNode(ctx, [this, &ctx, &running] {
+              running = processConnectionState(ctx);
+            });
           }
 
-          if (!proto.readCommand(cmd)) {
+          if (!running || !proto.readCommand(cmd)) {
             break;
           }
 
@@ -1616,10 +1944,6 @@ namespace CryptoNote
 
             ctx.pushMessage(P2pMessage(P2pMessage::REPLY, cmd.command, std::move(response), retcode));
           }
-
-          if (ctx.m_state == CryptoNoteConnectionContext::state_shutdown) {
-            break;
-          }
         }
       } catch (System::InterruptedException&) {
         logger(DEBUGGING) << ctx << "connectionHandler() inner context is interrupted";
@@ -1631,8 +1955,16 @@ namespace CryptoNote
       safeInterrupt(writeContext);
       writeContext.wait();
 
-      on_connection_close(ctx);
-      m_connections.erase(connectionId);
+      if (ctx.worker != nullptr) {
+        ctx.worker->connections.erase(connectionId);
+        // The socket belongs to the dispatcher of the worker, the context itself is destroyed by the node server
+        ctx.connection = System::TcpConnection();
+      }
+
+      onNode(ctx, [this, &connectionId, &ctx] {
+        on_connection_close(ctx);
+        m_connections.erase(connectionId);
+      });
     });
 
     ctx.context = &context;
@@ -9,7 +9,12 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 #include <boost/functional/hash.hpp>
@@ -43,6 +48,7 @@ namespace CryptoNote
 {
   class LevinProtocol;
   class ISerializer;
+  struct P2pWorker;
 
   struct P2pMessage {
     enum Type {
@@ -77,11 +83,17 @@ namespace CryptoNote
     System::Context<void>* context;
     PeerIdType peerId;
     System::TcpConnection connection;
+    // Worker doing the I/O of the connection, nullptr if it is done on the dispatcher of the node server
+    P2pWorker* worker;
+    // Set by the node server when m_state needs handling there, so the worker checks the state without a round trip
+    std::atomic<bool> stateActionRequired;
 
     P2pConnectionContext(System::Dispatcher& dispatcher, Logging::ILogger& log, System::TcpConnection&& conn) :
       context(nullptr),
       peerId(0),
       connection(std::move(conn)),
+      worker(nullptr),
+      stateActionRequired(false),
       logger(log, "node_server"),
       queueEvent(dispatcher),
       stopped(false) {
@@ -92,19 +104,28 @@ namespace CryptoNote
       context(ctx.context),
       peerId(ctx.peerId),
       connection(std::move(ctx.connection)),
+      worker(ctx.worker),
+      stateActionRequired(ctx.stateActionRequired.load()),
       logger(ctx.logger.getLogger(), "node_server"),
       queueEvent(std::move(ctx.queueEvent)),
       stopped(std::move(ctx.stopped)) {
     }
 
+    // pushMessage, interrupt and writeDuration can be called from the thread of the node server for a connection
+    // of a worker, the rest only from the thread doing its I/O
     bool pushMessage(P2pMessage&& msg);
     std::vector<P2pMessage> popBuffer();
     void interrupt();
 
     uint64_t writeDuration(TimePoint now) const;
+    // Only on the thread of the node server
+    void updateStateAction();
 
   private:
+    void onOwner(std::function<void(P2pConnectionContext&)>&& procedure);
+
     Logging::LoggerRef logger;
+    mutable std::mutex queueMutex;
     TimePoint writeOperationStartTime;
     System::Event queueEvent;
     std::vector<P2pMessage> writeQueue;
@@ -112,6 +133,29 @@ namespace CryptoNote
     bool stopped;
   };
 
+  // Thread with a dispatcher of its own, accepting incoming connections on a listener shared with the other workers.
+  // It does the Levin framing and the socket I/O of its connections, everything touching the node state or the core
+  // is handed to the dispatcher of the node server
+  struct P2pWorker {
+    explicit P2pWorker(System::Dispatcher& nodeDispatcher) : dispatcher(nullptr), contextGroup(nullptr), stopEvent(nullptr),
+      takenListener(nullptr), finished(nodeDispatcher) {
+    }
+
+    // Set by the worker thread before it accepts anything and valid until finished is set
+    System::Dispatcher* dispatcher;
+    System::ContextGroup* contextGroup;
+    System::Event* stopEvent;
+    std::thread::id threadId;
+
+    // Listener of the node server the worker takes over instead of opening one, so no queued connection is lost
+    System::TcpListener* takenListener;
+    // Connections the worker does the I/O of, only used on the worker thread
+    std::unordered_map<boost::uuids::uuid, P2pConnectionContext*, boost::hash<boost::uuids::uuid>> connections;
+
+    System::Event finished;
+    std::thread thread;
+  };
+
   class NodeServer :  public IP2pEndpoint
   {
   public:
@@ -137,6 +181,9 @@ namespace CryptoNote
     size_t get_outgoing_connections_count();
 
     CryptoNote::PeerlistManager& getPeerlistManager() { return m_peerlist; }
+    System::Dispatcher& getDispatcher() { return m_dispatcher; }
+    // Dispatchers of the p2p threads, valid while the server runs
+    std::vector<System::Dispatcher*> getWorkerDispatchers();
     bool ban_host(const uint32_t address_ip, time_t seconds = P2P_IP_BLOCKTIME);
     bool unban_host(const uint32_t address_ip);
     std::map<uint32_t, time_t> get_blocked_hosts() { return m_blocked_hosts; };
@@ -169,7 +216,7 @@ namespace CryptoNote
 
     bool handshake(CryptoNote::LevinProtocol& proto, P2pConnectionContext& context, bool just_take_peerlist = false);
     bool timedSync();
-    bool handleTimedSyncResponse(const BinaryArray& in, P2pConnectionContext& context);
+    bool handleTimedSyncResponse(const COMMAND_TIMED_SYNC::response& rsp, P2pConnectionContext& context);
     void forEachConnection(std::function<void(P2pConnectionContext&)> action);
 
     void on_connection_new(P2pConnectionContext& context);
@@ -221,7 +268,15 @@ namespace CryptoNote
     typedef ConnectionContainer::iterator ConnectionIterator;
     ConnectionContainer m_connections;
 
-    void acceptLoop();
+    void acceptLoop(System::TcpListener& listener, P2pWorker* worker);
+    void startWorkers();
+    void stopWorkers();
+    void workerThread(P2pWorker& worker, std::promise<void> started);
+    // Runs the procedure on the dispatcher of the node server and waits for it on the one of the connection
+    void onNode(P2pConnectionContext& ctx, std::function<void()>&& procedure);
+    // Runs the procedure on the dispatcher of the node server without waiting, if the connection is still there
+    void onNodeAsync(P2pConnectionContext& ctx, std::function<void(P2pConnectionContext&)>&& procedure);
+    bool processConnectionState(P2pConnectionContext& ctx);
     void connectionHandler(const boost::uuids::uuid& connectionId, P2pConnectionContext& connection);
     void writeHandler(P2pConnectionContext& ctx);
     void onIdle();
@@ -262,6 +317,8 @@ namespace CryptoNote
     System::TcpListener m_listener;
     Logging::LoggerRef logger;
     std::atomic<bool> m_stop;
+    uint32_t m_threadCount;
+    std::vector<std::unique_ptr<P2pWorker>> m_workers;
 
     CryptoNoteProtocolHandler& m_payload_handler;
     PeerlistManager m_peerlist;
@@ -28,6 +28,7 @@ const command_line::arg_descriptor<std::vector<std::string> > arg_p2p_add_exclus
       " If this option is given the options add-priority-node and seed-node are ignored"};
 const command_line::arg_descriptor<std::vector<std::string> > arg_p2p_seed_node   = {"seed-node", "Connect to a node to retrieve peer addresses, and disconnect"};
 const command_line::arg_descriptor<bool> arg_p2p_hide_my_port   =    {"hide-my-port", "Do not announce yourself as peerlist candidate", false, true};
+const command_line::arg_descriptor<uint32_t> arg_p2p_threads = {"p2p-threads", "Threads accepting incoming p2p connections and doing their network I/O, 0 keeps them on the main thread (Linux only)", 0};
 
 bool parsePeerFromString(NetworkAddress& pe, const std::string& node_addr) {
   return Common::parseIpAddressAndPort(pe.ip, pe.port, node_addr);
@@ -61,6 +62,7 @@ void NetNodeConfig::initOptions(boost::program_options::options_description& des
   command_line::add_arg(desc, arg_p2p_add_exclusive_node);
   command_line::add_arg(desc, arg_p2p_seed_node);
   command_line::add_arg(desc, arg_p2p_hide_my_port);
+  command_line::add_arg(desc, arg_p2p_threads);
 }
 
 NetNodeConfig::NetNodeConfig() {
@@ -69,6 +71,7 @@ NetNodeConfig::NetNodeConfig() {
   externalPort = 0;
   allowLocalIp = false;
   hideMyPort = false;
+  threadCount = 0;
   configFolder = Tools::getDefaultDataDirectory();
   testnet = false;
 }
@@ -91,6 +94,10 @@ bool NetNodeConfig::init(const boost::program_options::variables_map& vm)
     allowLocalIp = command_line::get_arg(vm, arg_p2p_allow_local_ip);
   }
 
+  if (vm.count(arg_p2p_threads.name) != 0 && (!vm[arg_p2p_threads.name].defaulted() || threadCount == 0)) {
+    threadCount = command_line::get_arg(vm, arg_p2p_threads);
+  }
+
   if (vm.count(command_line::arg_data_dir.name) != 0 && (!vm[command_line::arg_data_dir.name].defaulted() || configFolder == Tools::getDefaultDataDirectory())) {
     configFolder = command_line::get_arg(vm, command_line::arg_data_dir);
   }
@@ -184,6 +191,10 @@ bool NetNodeConfig::getHideMyPort() const {
   return hideMyPort;
 }
 
+uint32_t NetNodeConfig::getThreadCount() const {
+  return threadCount;
+}
+
 std::string NetNodeConfig::getConfigFolder() const {
   return configFolder;
 }
@@ -228,6 +239,10 @@ void NetNodeConfig::setHideMyPort(bool hide) {
   hideMyPort = hide;
 }
 
+void NetNodeConfig::setThreadCount(uint32_t count) {
+  threadCount = count;
+}
+
 void NetNodeConfig::setConfigFolder(const std::string& folder) {
   configFolder = folder;
 }
@@ -32,6 +32,7 @@ public:
   std::vector<NetworkAddress> getExclusiveNodes() const;
   std::vector<NetworkAddress> getSeedNodes() const;
   bool getHideMyPort() const;
+  uint32_t getThreadCount() const;
   std::string getConfigFolder() const;
 
   void setP2pStateFilename(const std::string& filename);
@@ -45,6 +46,7 @@ public:
   void setExclusiveNodes(const std::vector<NetworkAddress>& addresses);
   void setSeedNodes(const std::vector<NetworkAddress>& addresses);
   void setHideMyPort(bool hide);
+  void setThreadCount(uint32_t count);
   void setConfigFolder(const std::string& folder);
 
 private:
@@ -57,6 +59,7 @@ private:
   std::vector<NetworkAddress> exclusiveNodes;
   std::vector<NetworkAddress> seedNodes;
   bool hideMyPort;
+  uint32_t threadCount;
   std::string configFolder;
   std::string p2pStateFilename;
   bool testnet;
@@ -68,24 +68,26 @@ PaymentServiceJsonRpcServer::PaymentServiceJsonRpcServer(System::Dispatcher& sys
   handlers.emplace("sendFusionTransaction", jsonHandler<SendFusionTransaction::Request, SendFusionTransaction::Response>(std::bind(&PaymentServiceJsonRpcServer::handleSendFusionTransaction, this, std::placeholders::_1, std::placeholders::_2)));
 }
 
-void PaymentServiceJsonRpcServer::processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp) {
+void PaymentServiceJsonRpcServer::processJsonRpcRequest(CryptoNote::JsonTextInputSerializer& req, Response& resp) {
   try {
     prepareJsonResponse(req, resp);
 
-    if (!req.contains("method")) {
-      logger(Logging::WARNING) << "Field \"method\" is not found in json request: " << req;
+    std::string method;
+    bool hasMethod;
+    try {
+      hasMethod = req(method, "method");
+    } catch (std::runtime_error&) {
+      logger(Logging::WARNING) << "Field \"method\" is not a string type";
       makeGenericErrorReponse(resp, "Invalid Request", -3600);
       return;
     }
 
-    if (!req("method").isString()) {
-      logger(Logging::WARNING) << "Field \"method\" is not a string type: " << req;
+    if (!hasMethod) {
+      logger(Logging::WARNING) << "Field \"method\" is not found in json request";
       makeGenericErrorReponse(resp, "Invalid Request", -3600);
       return;
     }
 
-    std::string method = req("method").getString();
-
     auto it = handlers.find(method);
     if (it == handlers.end()) {
       logger(Logging::WARNING) << "Requested method not found: " << method;
@@ -95,12 +97,7 @@ void PaymentServiceJsonRpcServer::processJsonRpcRequest(const Common::JsonValue&
 
     logger(Logging::DEBUGGING) << method << " request came";
 
-    Common::JsonValue params(Common::JsonValue::OBJECT);
-    if (req.contains("params")) {
-      params = req("params");
-    }
-
-    it->second(params, resp);
+    it->second(req, resp);
   } catch (std::exception& e) {
     logger(Logging::WARNING) << "Error occurred while processing JsonRpc request: " << e.what();
     makeGenericErrorReponse(resp, e.what());
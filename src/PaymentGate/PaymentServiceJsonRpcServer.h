@@ -8,11 +8,10 @@
 
 #include <unordered_map>
 
-#include "Common/JsonValue.h"
 #include "JsonRpcServer/JsonRpcServer.h"
 #include "PaymentServiceJsonRpcMessages.h"
-#include "Serialization/JsonInputValueSerializer.h"
-#include "Serialization/JsonOutputStreamSerializer.h"
+#include "Serialization/JsonTextInputSerializer.h"
+#include "Serialization/JsonTextOutputSerializer.h"
 
 namespace PaymentService {
 
@@ -24,23 +23,22 @@ public:
   PaymentServiceJsonRpcServer(const PaymentServiceJsonRpcServer&) = delete;
 
 protected:
-  virtual void processJsonRpcRequest(const Common::JsonValue& req, Common::JsonValue& resp) override;
+  virtual void processJsonRpcRequest(CryptoNote::JsonTextInputSerializer& req, Response& resp) override;
 
 private:
   WalletService& service;
   Logging::LoggerRef logger;
 
-  typedef std::function<void (const Common::JsonValue& jsonRpcParams, Common::JsonValue& jsonResponse)> HandlerFunction;
+  typedef std::function<void (CryptoNote::JsonTextInputSerializer& jsonRpcRequest, Response& jsonResponse)> HandlerFunction;
 
   template <typename RequestType, typename ResponseType, typename RequestHandler>
   HandlerFunction jsonHandler(RequestHandler handler) {
-    return [handler] (const Common::JsonValue& jsonRpcParams, Common::JsonValue& jsonResponse) mutable {
+    return [handler] (CryptoNote::JsonTextInputSerializer& jsonRpcRequest, Response& jsonResponse) mutable {
       RequestType request;
       ResponseType response;
 
       try {
-        CryptoNote::JsonInputValueSerializer inputSerializer(const_cast<Common::JsonValue&>(jsonRpcParams));
-        serialize(request, inputSerializer);
+        jsonRpcRequest(request, "params");
       } catch (std::exception&) {
         makeGenericErrorReponse(jsonResponse, "Invalid Request", -32600);
         return;
@@ -52,9 +50,10 @@ private:
         return;
       }
 
-      CryptoNote::JsonOutputStreamSerializer outputSerializer;
+      // Responses such as getTransactions can be large, they are written straight into the response text
+      CryptoNote::JsonTextOutputSerializer outputSerializer;
       serialize(response, outputSerializer);
-      fillJsonResponse(outputSerializer.getValue(), jsonResponse);
+      fillJsonResponse(outputSerializer.takeText(), jsonResponse);
     };
   }
 
@@ -1569,7 +1569,8 @@ namespace PaymentService
 
       validateAddresses(addresses, currency, logger);
 
-      std::vector<CryptoNote::WalletTransactionWithTransfers> transactions = wallet.getUnconfirmedTransactions();
+      std::vector<CryptoNote::WalletTransactionWithTransfers> transactions =
+          addresses.empty() ? wallet.getUnconfirmedTransactions() : wallet.getUnconfirmedTransactions(addresses);
 
       TransactionsInBlockInfoFilter transactionFilter(addresses, "");
 
@@ -1971,60 +1972,80 @@ namespace PaymentService
       return std::error_code();
     }
 
-    std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash &blockHash, size_t blockCount) const
+    // Results are sparse, so an empty one no longer means that the starting block is unknown. The hash is checked
+    // with a single-block dense query and the index against the wallet's block count
+    std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash &blockHash, size_t blockCount, const TransactionsInBlockInfoFilter &filter) const
     {
-      std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(blockHash, blockCount);
-      if (result.empty())
+      if (wallet.getTransactions(blockHash, 1).empty())
       {
         throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
       }
 
-      return result;
+      if (filter.havePaymentId)
+      {
+        return wallet.getTransactionsByPaymentId(filter.paymentId, blockHash, blockCount);
+      }
+
+      if (!filter.addresses.empty())
+      {
+        std::vector<std::string> addresses(filter.addresses.begin(), filter.addresses.end());
+        return wallet.getTransactionsByAddresses(addresses, blockHash, blockCount);
+      }
+
+      return wallet.getTransactions(blockHash, blockCount, true);
     }
 
-    std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount) const
+    std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter &filter) const
     {
-      std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(firstBlockIndex, blockCount);
-      if (result.empty())
+      if (firstBlockIndex >= wallet.getBlockCount())
       {
         throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
       }
 
-      return result;
+      if (filter.havePaymentId)
+      {
+        return wallet.getTransactionsByPaymentId(filter.paymentId, firstBlockIndex, blockCount);
+      }
+
+      if (!filter.addresses.empty())
+      {
+        std::vector<std::string> addresses(filter.addresses.begin(), filter.addresses.end());
+        return wallet.getTransactionsByAddresses(addresses, firstBlockIndex, blockCount);
+      }
+
+      return wallet.getTransactions(firstBlockIndex, blockCount, true);
     }
 
     std::vector<CryptoNote::DepositsInBlockInfo> WalletService::getDeposits(const Crypto::Hash &blockHash, size_t blockCount) const
     {
-      std::vector<CryptoNote::DepositsInBlockInfo> result = wallet.getDeposits(blockHash, blockCount);
-      if (result.empty())
+      if (wallet.getDeposits(blockHash, 1).empty())
       {
         throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
       }
 
-      return result;
+      return wallet.getDeposits(blockHash, blockCount, true);
     }
 
     std::vector<CryptoNote::DepositsInBlockInfo> WalletService::getDeposits(uint32_t firstBlockIndex, size_t blockCount) const
     {
-      std::vector<CryptoNote::DepositsInBlockInfo> result = wallet.getDeposits(firstBlockIndex, blockCount);
-      if (result.empty())
+      if (firstBlockIndex >= wallet.getBlockCount())
       {
         throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
       }
 
-      return result;
+      return wallet.getDeposits(firstBlockIndex, blockCount, true);
     }
 
     std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(const Crypto::Hash &blockHash, size_t blockCount, const TransactionsInBlockInfoFilter &filter) const
     {
-      std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
+      std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount, filter);
       std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
       return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
     }
 
     std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter &filter) const
     {
-      std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
+      std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount, filter);
       std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
       return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
     }
@@ -2032,7 +2053,7 @@ namespace PaymentService
     std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(const Crypto::Hash &blockHash, size_t blockCount, const TransactionsInBlockInfoFilter &filter) const
     {
       uint32_t knownBlockCount = node.getKnownBlockCount();
-      std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
+      std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount, filter);
       std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
       return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions, knownBlockCount);
     }
@@ -2040,7 +2061,7 @@ namespace PaymentService
     std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter &filter) const
     {
       uint32_t knownBlockCount = node.getKnownBlockCount();
-      std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
+      std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount, filter);
       std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
       return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions, knownBlockCount);
     }
@@ -0,0 +1,217 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "ContextSwitch.h"
+
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include "ErrorMessage.h"
+
+#if defined(__x86_64__)
+
+// Only the registers the System V ABI makes callee-saved survive a call, so they, the SSE control and status
+// register and the x87 control word are all a switch has to keep. They are pushed on the stack of the suspended
+// coroutine, and its stack pointer is all that is left to store
+asm(
+  ".pushsection .text\n"
+  ".globl moonbankSwitchContext\n"
+  ".hidden moonbankSwitchContext\n"
+  ".type moonbankSwitchContext, @function\n"
+  ".p2align 4\n"
+  "moonbankSwitchContext:\n"
+  "  pushq %rbp\n"
+  "  pushq %rbx\n"
+  "  pushq %r12\n"
+  "  pushq %r13\n"
+  "  pushq %r14\n"
+  "  pushq %r15\n"
+  "  subq $8, %rsp\n"
+  "  stmxcsr (%rsp)\n"
+  "  fnstcw 4(%rsp)\n"
+  "  movq %rsp, (%rdi)\n"
+  "  movq %rsi, %rsp\n"
+  "  ldmxcsr (%rsp)\n"
+  "  fldcw 4(%rsp)\n"
+  "  addq $8, %rsp\n"
+  "  popq %r15\n"
+  "  popq %r14\n"
+  "  popq %r13\n"
+  "  popq %r12\n"
+  "  popq %rbx\n"
+  "  popq %rbp\n"
+  "  ret\n"
+  ".size moonbankSwitchContext, .-moonbankSwitchContext\n"
+  "\n"
+  // The first switch to a new coroutine returns here with the procedure in r12 and its argument in r13
+  ".globl moonbankStartContext\n"
+  ".hidden moonbankStartContext\n"
+  ".type moonbankStartContext, @function\n"
+  ".p2align 4\n"
+  "moonbankStartContext:\n"
+  "  .cfi_startproc\n"
+  "  .cfi_undefined rip\n"
+  "  movq %r13, %rdi\n"
+  "  callq *%r12\n"
+  "  ud2\n"
+  "  .cfi_endproc\n"
+  ".size moonbankStartContext, .-moonbankStartContext\n"
+  ".popsection\n"
+);
+
+extern "C" {
+void moonbankSwitchContext(void** currentStackPointer, void* nextStackPointer);
+void moonbankStartContext();
+}
+
+#endif
+
+namespace System {
+
+namespace {
+
+// Enough for the dispatchers of a busy process to spawn and finish contexts without touching mmap
+const size_t MAX_CACHED_STACKS = 64;
+
+struct StackCache {
+  std::mutex mutex;
+  std::vector<std::pair<void*, size_t>> stacks;
+};
+
+// Never destroyed, so dispatchers that outlive static destruction can still release their stacks
+StackCache& stackCache() {
+  static StackCache* cache = new StackCache;
+  return *cache;
+}
+
+size_t pageSize() {
+  static const size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  return size;
+}
+
+size_t mappedSize(size_t size) {
+  return (size + pageSize() - 1) / pageSize() * pageSize() + pageSize();
+}
+
+#if !defined(__x86_64__)
+struct StartData {
+  void (*procedure)(void*);
+  void* argument;
+};
+
+// makecontext only passes int arguments, so the pointer to the start data is split in two
+void startContext(unsigned int high, unsigned int low) {
+  auto data = reinterpret_cast<StartData*>((static_cast<uintptr_t>(high) << 16 << 16) | low);
+  data->procedure(data->argument);
+}
+#endif
+
+}
+
+#if defined(__x86_64__)
+
+void makeContext(ContextState& state, void* stack, size_t stackSize, void (*procedure)(void*), void* argument) {
+  // A new coroutine starts with the floating point modes of the thread that creates it, as with getcontext
+  uint32_t mxcsr;
+  asm volatile("stmxcsr %0" : "=m"(mxcsr));
+  uint16_t x87ControlWord;
+  asm volatile("fnstcw %0" : "=m"(x87ControlWord));
+
+  uintptr_t top = (reinterpret_cast<uintptr_t>(stack) + stackSize) & ~static_cast<uintptr_t>(15);
+  void** frame = reinterpret_cast<void**>(top);
+  // Keeps the stack 16-byte aligned at the call in moonbankStartContext
+  *--frame = nullptr;
+  *--frame = nullptr;
+  *--frame = reinterpret_cast<void*>(&moonbankStartContext);
+  *--frame = nullptr; // rbp, ends frame pointer chains
+  *--frame = nullptr; // rbx
+  *--frame = reinterpret_cast<void*>(procedure); // r12
+  *--frame = argument; // r13
+  *--frame = nullptr; // r14
+  *--frame = nullptr; // r15
+  *--frame = reinterpret_cast<void*>(static_cast<uintptr_t>(mxcsr) | static_cast<uintptr_t>(x87ControlWord) << 32);
+  state.stackPointer = frame;
+}
+
+void switchContext(ContextState& current, ContextState& next) {
+  moonbankSwitchContext(&current.stackPointer, next.stackPointer);
+}
+
+#else
+
+// The start data is read by the first switch to the state, which has to happen before the next makeContext on this thread
+void makeContext(ContextState& state, void* stack, size_t stackSize, void (*procedure)(void*), void* argument) {
+  static thread_local StartData data;
+  if (getcontext(&state.context) == -1) {
+    throw std::runtime_error("makeContext, getcontext failed, " + lastErrorMessage());
+  }
+
+  data = { procedure, argument };
+  uintptr_t pointer = reinterpret_cast<uintptr_t>(&data);
+  state.context.uc_stack.ss_sp = stack;
+  state.context.uc_stack.ss_size = stackSize;
+  state.context.uc_link = nullptr;
+  makecontext(&state.context, reinterpret_cast<void(*)()>(startContext), 2, static_cast<unsigned int>(pointer >> 16 >> 16),
+    static_cast<unsigned int>(pointer));
+}
+
+void switchContext(ContextState& current, ContextState& next) {
+  if (swapcontext(&current.context, &next.context) == -1) {
+    throw std::runtime_error("switchContext, swapcontext failed, " + lastErrorMessage());
+  }
+}
+
+#endif
+
+void* allocateStack(size_t size) {
+  StackCache& cache = stackCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    for (auto it = cache.stacks.begin(); it != cache.stacks.end(); ++it) {
+      if (it->second == size) {
+        void* stack = it->first;
+        cache.stacks.erase(it);
+        return stack;
+      }
+    }
+  }
+
+  size_t mapped = mappedSize(size);
+  void* mapping = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw std::runtime_error("allocateStack, mmap failed, " + lastErrorMessage());
+  }
+
+  if (mprotect(mapping, pageSize(), PROT_NONE) == -1) {
+    std::string message = lastErrorMessage();
+    munmap(mapping, mapped);
+    throw std::runtime_error("allocateStack, mprotect failed, " + message);
+  }
+
+  return static_cast<uint8_t*>(mapping) + pageSize();
+}
+
+void releaseStack(void* stack, size_t size) {
+  StackCache& cache = stackCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    if (cache.stacks.size() < MAX_CACHED_STACKS) {
+      cache.stacks.emplace_back(stack, size);
+      return;
+    }
+  }
+
+  munmap(static_cast<uint8_t*>(stack) - pageSize(), mappedSize(size));
+}
+
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <cstddef>
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+namespace System {
+
+// Execution state of a suspended coroutine. On x86-64 a switch only saves the callee-saved registers on the stack of
+// the suspended coroutine and keeps its stack pointer here, so it needs no system call. Other architectures fall back
+// to swapcontext
+struct ContextState {
+#if defined(__x86_64__)
+  void* stackPointer;
+#else
+  ucontext_t context;
+#endif
+};
+
+// Prepares a state that starts procedure(argument) on the given stack when switched to. The procedure must not return
+void makeContext(ContextState& state, void* stack, size_t stackSize, void (*procedure)(void*), void* argument);
+// Saves the running coroutine to current and resumes next
+void switchContext(ContextState& current, ContextState& next);
+
+// Stacks are mapped with an inaccessible guard page below them, so an overflow faults instead of corrupting memory.
+// Released stacks are kept for reuse by any dispatcher in the process
+void* allocateStack(size_t size);
+void releaseStack(void* stack, size_t size);
+
+}
@@ -16,6 +16,7 @@
 // along with Bytecoin.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "Dispatcher.h"
+#include <algorithm>
 #include <cassert>
 
 #include <sys/epoll.h>
@@ -23,19 +24,15 @@
 #include <sys/timerfd.h>
 #include <fcntl.h>
 #include <string.h>
-#include <ucontext.h>
 #include <unistd.h>
+#include "ContextSwitch.h"
 #include "ErrorMessage.h"
+#include "IoUring.h"
 
 namespace System {
 
 namespace {
 
-struct ContextMakingData {
-  Dispatcher* dispatcher;
-  void* ucontext;
-};
-
 class MutextGuard {
 public:
   MutextGuard(pthread_mutex_t& _mutex) : mutex(_mutex) {
@@ -57,6 +54,14 @@ static_assert(Dispatcher::SIZEOF_PTHREAD_MUTEX_T == sizeof(pthread_mutex_t), "in
 
 //const size_t STACK_SIZE = 64 * 1024;
 const size_t STACK_SIZE = 512 * 1024;
+const int MAX_EVENTS_PER_POLL = 256;
+const size_t MAX_RESUMES_WITHOUT_POLL = 64;
+const unsigned RING_ENTRIES = 256;
+const unsigned RING_COMPLETION_ENTRIES = 4096;
+const size_t RING_BUFFER_COUNT = 64;
+const size_t RING_BUFFER_SIZE = 16 * 1024;
+
+std::atomic<IoBackend> defaultIoBackend(IoBackend::EPOLL);
 
 };
 
@@ -66,45 +71,71 @@ Dispatcher::Dispatcher() {
   if (epoll == -1) {
     message = "epoll_create1 failed, " + lastErrorMessage();
   } else {
-    mainContext.ucontext = new ucontext_t;
-    if (getcontext(reinterpret_cast<ucontext_t*>(mainContext.ucontext)) == -1) {
-      message = "getcontext failed, " + lastErrorMessage();
+    remoteSpawnEvent = eventfd(0, O_NONBLOCK);
+    if(remoteSpawnEvent == -1) {
+      message = "eventfd failed, " + lastErrorMessage();
     } else {
-      remoteSpawnEvent = eventfd(0, O_NONBLOCK);
-      if(remoteSpawnEvent == -1) {
-        message = "eventfd failed, " + lastErrorMessage();
-      } else {
-        remoteSpawnEventContext.writeContext = nullptr;
-        remoteSpawnEventContext.readContext = nullptr;
+      remoteSpawnEventContext.writeContext = nullptr;
+      remoteSpawnEventContext.readContext = nullptr;
 
-        epoll_event remoteSpawnEventEpollEvent;
-        remoteSpawnEventEpollEvent.events = EPOLLIN;
-        remoteSpawnEventEpollEvent.data.ptr = &remoteSpawnEventContext;
+      epoll_event remoteSpawnEventEpollEvent;
+      remoteSpawnEventEpollEvent.events = EPOLLIN;
+      remoteSpawnEventEpollEvent.data.ptr = &remoteSpawnEventContext;
 
-        if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
-          message = "epoll_ctl failed, " + lastErrorMessage();
+      if (epoll_ctl(epoll, EPOLL_CTL_ADD, remoteSpawnEvent, &remoteSpawnEventEpollEvent) == -1) {
+        message = "epoll_ctl failed, " + lastErrorMessage();
+      } else {
+        timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+        if (timer == -1) {
+          message = "timerfd_create failed, " + lastErrorMessage();
         } else {
-          *reinterpret_cast<pthread_mutex_t*>(this->mutex) = pthread_mutex_t(PTHREAD_MUTEX_INITIALIZER);
-
-          mainContext.interrupted = false;
-          mainContext.group = &contextGroup;
-          mainContext.groupPrev = nullptr;
-          mainContext.groupNext = nullptr;
-          mainContext.inExecutionQueue = false;
-          contextGroup.firstContext = nullptr;
-          contextGroup.lastContext = nullptr;
-          contextGroup.firstWaiter = nullptr;
-          contextGroup.lastWaiter = nullptr;
-          currentContext = &mainContext;
-          firstResumingContext = nullptr;
-          firstReusableContext = nullptr;
-          runningContextCount = 0;
-          return;
-        }
+          timerEventContext.writeContext = nullptr;
+          timerEventContext.readContext = nullptr;
+
+          epoll_event timerEpollEvent;
+          timerEpollEvent.events = EPOLLIN;
+          timerEpollEvent.data.ptr = &timerEventContext;
+
+          timespec now;
+          if (epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &timerEpollEvent) == -1) {
+            message = "epoll_ctl failed, " + lastErrorMessage();
+          } else if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+            message = "clock_gettime failed, " + lastErrorMessage();
+          } else {
+            *reinterpret_cast<pthread_mutex_t*>(this->mutex) = pthread_mutex_t(PTHREAD_MUTEX_INITIALIZER);
+
+            // The state of the main context is saved by the first switch away from it
+            mainContext.interrupted = false;
+            mainContext.stackPtr = nullptr;
+            mainContext.group = &contextGroup;
+            mainContext.groupPrev = nullptr;
+            mainContext.groupNext = nullptr;
+            mainContext.inExecutionQueue = false;
+            contextGroup.firstContext = nullptr;
+            contextGroup.lastContext = nullptr;
+            contextGroup.firstWaiter = nullptr;
+            contextGroup.lastWaiter = nullptr;
+            currentContext = &mainContext;
+            firstResumingContext = nullptr;
+            firstReusableContext = nullptr;
+            runningContextCount = 0;
+            resumedSincePoll = 0;
+            timerEpoch = static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+            armedTick = UINT64_MAX;
+            if (defaultIoBackend.load() == IoBackend::IO_URING) {
+              openIoUring();
+            }
+
+            return;
+          }
 
-        auto result = close(remoteSpawnEvent);
-        assert(result == 0);
+          auto result = close(timer);
+          assert(result == 0);
+        }
       }
+
+      auto result = close(remoteSpawnEvent);
+      assert(result == 0);
     }
 
     auto result = close(epoll);
@@ -120,25 +151,38 @@ Dispatcher::~Dispatcher() {
   }
 
   yield();
+  if (ring) {
+    // A cancelled ring operation may complete after the cancellation was submitted
+    while (contextGroup.firstContext != nullptr) {
+      yield();
+    }
+  }
+
   assert(contextGroup.firstContext == nullptr);
   assert(contextGroup.firstWaiter == nullptr);
   assert(firstResumingContext == nullptr);
   assert(runningContextCount == 0);
   while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
+    auto stackPtr = firstReusableContext->stackPtr;
     firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
+    releaseStack(stackPtr, STACK_SIZE);
   }
 
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    assert(result == 0);
-    timers.pop();
+  assert(timerWheel.empty());
+  if (ring) {
+    // Operations without a context, as the accepts of closed listeners, still reference their memory
+    ring->submit();
+    while (ring->getInFlight() != 0) {
+      ring->wait();
+      reapCompletions();
+    }
+
+    ring.reset();
   }
 
-  auto result = close(epoll);
+  auto result = close(timer);
+  assert(result == 0);
+  result = close(epoll);
   assert(result == 0);
   result = close(remoteSpawnEvent);
   assert(result == 0);
@@ -148,20 +192,9 @@ Dispatcher::~Dispatcher() {
 
 void Dispatcher::clear() {
   while (firstReusableContext != nullptr) {
-    auto ucontext = static_cast<ucontext_t*>(firstReusableContext->ucontext);
-    auto stackPtr = static_cast<uint8_t *>(firstReusableContext->stackPtr);
+    auto stackPtr = firstReusableContext->stackPtr;
     firstReusableContext = firstReusableContext->next;
-    delete[] stackPtr;
-    delete ucontext;
-  }
-
-  while (!timers.empty()) {
-    int result = ::close(timers.top());
-    if (result == -1) {
-      throw std::runtime_error("Dispatcher::clear, close failed, "  + lastErrorMessage());
-    }
-
-    timers.pop();
+    releaseStack(stackPtr, STACK_SIZE);
   }
 }
 
@@ -169,58 +202,26 @@ void Dispatcher::dispatch() {
   NativeContext* context;
   for (;;) {
     if (firstResumingContext != nullptr) {
+      // Contexts that keep waking each other would otherwise delay the events of every other source
+      if (resumedSincePoll >= MAX_RESUMES_WITHOUT_POLL) {
+        pollEvents(0);
+      }
+
       context = firstResumingContext;
       firstResumingContext = context->next;
       assert(context->inExecutionQueue);
       context->inExecutionQueue = false;
+      ++resumedSincePoll;
       break;
     }
 
-    epoll_event event;
-    int count = epoll_wait(epoll, &event, 1, -1);
-    if (count == 1) {
-      ContextPair *contextPair = static_cast<ContextPair*>(event.data.ptr);
-      if(((event.events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
-        uint64_t buf;
-        auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
-        if(transferred == -1) {
-            throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
-        }
-
-        MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-        while (!remoteSpawningProcedures.empty()) {
-          spawn(std::move(remoteSpawningProcedures.front()));
-          remoteSpawningProcedures.pop();
-        }
-
-        continue;
-      }
-
-      if ((event.events & EPOLLOUT) != 0) {
-        context = contextPair->writeContext->context;
-        contextPair->writeContext->events = event.events;
-      } else if ((event.events & EPOLLIN) != 0) {
-        context = contextPair->readContext->context;
-        contextPair->readContext->events = event.events;
-      } else {
-        continue;
-      }
-
-      assert(context != nullptr);
-      break;
-    }
-
-    if (errno != EINTR) {
-      throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, "  + lastErrorMessage());
-    }
+    pollEvents(-1);
   }
 
   if (context != currentContext) {
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
+    NativeContext* oldContext = currentContext;
     currentContext = context;
-    if (swapcontext(oldContext, static_cast<ucontext_t *>(context->ucontext)) == -1) {
-      throw std::runtime_error("Dispatcher::dispatch, swapcontext failed, " + lastErrorMessage());
-    }
+    switchContext(oldContext->state, context->state);
   }
 }
 
@@ -302,92 +303,145 @@ void Dispatcher::spawn(std::function<void()>&& procedure) {
 }
 
 void Dispatcher::yield() {
-  for(;;){
-    epoll_event events[16];
-    int count = epoll_wait(epoll, events, 16, 0);
-    if (count == 0) {
-      break;
+  pollEvents(0);
+  if (firstResumingContext != nullptr) {
+    pushContext(currentContext);
+    dispatch();
+  }
+}
+
+DispatcherStatistics Dispatcher::getStatistics() const {
+  DispatcherStatistics statistics;
+  statistics.pollCount = pollCount.load(std::memory_order_relaxed);
+  statistics.eventCount = eventCount.load(std::memory_order_relaxed);
+  statistics.maxEventsPerPoll = maxEventsPerPoll.load(std::memory_order_relaxed);
+  statistics.totalRunTime = totalRunTime.load(std::memory_order_relaxed);
+  statistics.maxRunTime = maxRunTime.load(std::memory_order_relaxed);
+  return statistics;
+}
+
+void Dispatcher::setDefaultIoBackend(IoBackend backend) {
+  defaultIoBackend = backend;
+}
+
+IoBackend Dispatcher::getIoBackend() const {
+  return ring ? IoBackend::IO_URING : IoBackend::EPOLL;
+}
+
+int Dispatcher::getEpoll() const {
+  return epoll;
+}
+
+IoUring* Dispatcher::getIoUring() const {
+  return ring.get();
+}
+
+// Harvests up to MAX_EVENTS_PER_POLL events with one epoll_wait, and every io_uring completion, and queues their
+// contexts behind the ones already runnable, so every source gets its turn before the next poll
+void Dispatcher::pollEvents(int timeout) {
+  auto pollStart = std::chrono::steady_clock::now();
+  if (pollCount.load(std::memory_order_relaxed) != 0) {
+    uint64_t runTime = std::chrono::duration_cast<std::chrono::microseconds>(pollStart - lastPollEnd).count();
+    totalRunTime.store(totalRunTime.load(std::memory_order_relaxed) + runTime, std::memory_order_relaxed);
+    if (runTime > maxRunTime.load(std::memory_order_relaxed)) {
+      maxRunTime.store(runTime, std::memory_order_relaxed);
     }
+  }
 
-    if(count > 0) {
-      for(int i = 0; i < count; ++i) {
-        ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
-        if(((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
-          uint64_t buf;
-          auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
-          if(transferred == -1) {
-            throw std::runtime_error("Dispatcher::dispatch, read(remoteSpawnEvent) failed, " + lastErrorMessage());
-          }
+  unsigned completions = 0;
+  if (ring) {
+    // Everything the contexts prepared since the last poll reaches the kernel with one system call
+    ring->submit();
+    completions = reapCompletions();
+    if (completions != 0) {
+      timeout = 0;
+    }
+  }
 
-          MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
-          while (!remoteSpawningProcedures.empty()) {
-            spawn(std::move(remoteSpawningProcedures.front()));
-            remoteSpawningProcedures.pop();
-          }
+  epoll_event events[MAX_EVENTS_PER_POLL];
+  int count = epoll_wait(epoll, events, MAX_EVENTS_PER_POLL, timeout);
+  lastPollEnd = std::chrono::steady_clock::now();
+  resumedSincePoll = 0;
+  if (count == -1) {
+    if (errno != EINTR) {
+      throw std::runtime_error("Dispatcher::pollEvents, epoll_wait failed, "  + lastErrorMessage());
+    }
 
-          continue;
-        }
+    return;
+  }
 
-        if ((events[i].events & EPOLLOUT) != 0) {
-          if(contextPair->writeContext != nullptr) {
-            if(contextPair->writeContext->context != nullptr) {
-              contextPair->writeContext->context->interruptProcedure = nullptr;
-            }
-          }
-          pushContext(contextPair->writeContext->context);
-          contextPair->writeContext->events = events[i].events;
-        } else if ((events[i].events & EPOLLIN) != 0) {
-          if(contextPair->readContext != nullptr) {
-            if(contextPair->readContext->context != nullptr) {
-              contextPair->readContext->context->interruptProcedure = nullptr;
-            }
-          }
-          pushContext(contextPair->readContext->context);
-          contextPair->readContext->events = events[i].events;
-        } else if ((events[i].events & (EPOLLERR | EPOLLHUP)) != 0) {
-          throw std::runtime_error("Dispatcher::dispatch, events & (EPOLLERR | EPOLLHUP) != 0");
-        } else {
-          continue;
-        }
+  for (int i = 0; i < count; ++i) {
+    ContextPair *contextPair = static_cast<ContextPair*>(events[i].data.ptr);
+    if (contextPair == &timerEventContext) {
+      processTimers();
+      continue;
+    }
+
+    if (contextPair == &ringEventContext) {
+      completions += reapCompletions();
+      continue;
+    }
+
+    if(((events[i].events & (EPOLLIN | EPOLLOUT)) != 0) && contextPair->readContext == nullptr && contextPair->writeContext == nullptr) {
+      uint64_t buf;
+      auto transferred = read(remoteSpawnEvent, &buf, sizeof buf);
+      if(transferred == -1) {
+        throw std::runtime_error("Dispatcher::pollEvents, read(remoteSpawnEvent) failed, " + lastErrorMessage());
       }
-    } else {
-      if (errno != EINTR) {
-        throw std::runtime_error("Dispatcher::dispatch, epoll_wait failed, " + lastErrorMessage());
+
+      MutextGuard guard(*reinterpret_cast<pthread_mutex_t*>(this->mutex));
+      while (!remoteSpawningProcedures.empty()) {
+        spawn(std::move(remoteSpawningProcedures.front()));
+        remoteSpawningProcedures.pop();
       }
+
+      continue;
     }
-  }
 
-  if (firstResumingContext != nullptr) {
-    pushContext(currentContext);
-    dispatch();
+    // An error without readiness is reported to the waiting operation, which checks the events it was woken with
+    OperationContext* operationContext;
+    if ((events[i].events & EPOLLOUT) != 0) {
+      operationContext = contextPair->writeContext;
+    } else if ((events[i].events & EPOLLIN) != 0) {
+      operationContext = contextPair->readContext;
+    } else if ((events[i].events & (EPOLLERR | EPOLLHUP)) != 0) {
+      operationContext = contextPair->writeContext != nullptr ? contextPair->writeContext : contextPair->readContext;
+    } else {
+      continue;
+    }
+
+    if (operationContext == nullptr || operationContext->context == nullptr) {
+      continue;
+    }
+
+    // The operation is complete, interrupting the context now only marks it as interrupted
+    operationContext->context->interruptProcedure = nullptr;
+    operationContext->events = events[i].events;
+    pushContext(operationContext->context);
   }
-}
 
-int Dispatcher::getEpoll() const {
-  return epoll;
+  uint64_t harvested = static_cast<uint64_t>(count) + completions;
+  pollCount.store(pollCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  eventCount.store(eventCount.load(std::memory_order_relaxed) + harvested, std::memory_order_relaxed);
+  if (harvested > maxEventsPerPoll.load(std::memory_order_relaxed)) {
+    maxEventsPerPoll.store(harvested, std::memory_order_relaxed);
+  }
 }
 
 NativeContext& Dispatcher::getReusableContext() {
   if(firstReusableContext == nullptr) {
-    ucontext_t* newlyCreatedContext = new ucontext_t;
-    if (getcontext(newlyCreatedContext) == -1) { //makecontext precondition
-      throw std::runtime_error("Dispatcher::getReusableContext, getcontext failed, " + lastErrorMessage());
-    }
-
-    auto stackPointer = new uint8_t[STACK_SIZE];
-    newlyCreatedContext->uc_stack.ss_sp = stackPointer;
-    newlyCreatedContext->uc_stack.ss_size = STACK_SIZE;
-
-    ContextMakingData makingContextData {this, newlyCreatedContext};
-    makecontext(newlyCreatedContext, (void(*)())contextProcedureStatic, 1, reinterpret_cast<int*>(&makingContextData));
-
-    ucontext_t* oldContext = static_cast<ucontext_t*>(currentContext->ucontext);
-    if (swapcontext(oldContext, newlyCreatedContext) == -1) {
-      throw std::runtime_error("Dispatcher::getReusableContext, swapcontext failed, " + lastErrorMessage());
+    void* stackPointer = allocateStack(STACK_SIZE);
+    ContextState newlyCreatedContext;
+    try {
+      makeContext(newlyCreatedContext, stackPointer, STACK_SIZE, contextProcedureStatic, this);
+    } catch (std::exception&) {
+      releaseStack(stackPointer, STACK_SIZE);
+      throw;
     }
 
+    // The new context pushes itself to the reusable list and switches back
+    switchContext(currentContext->state, newlyCreatedContext);
     assert(firstReusableContext != nullptr);
-    assert(firstReusableContext->ucontext == newlyCreatedContext);
     firstReusableContext->stackPtr = stackPointer;
   };
 
@@ -402,41 +456,109 @@ void Dispatcher::pushReusableContext(NativeContext& context) {
   --runningContextCount;
 }
 
-int Dispatcher::getTimer() {
-  int timer;
-  if (timers.empty()) {
-    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
-    epoll_event timerEvent;
-    timerEvent.events = 0;
-    timerEvent.data.ptr = nullptr;
+void Dispatcher::addTimer(NativeTimer& timer, std::chrono::nanoseconds duration) {
+  uint64_t now = getTimerTime();
+  if (timerWheel.empty()) {
+    timerWheel.advance(now / 1000000);
+  }
 
-    if (epoll_ctl(getEpoll(), EPOLL_CTL_ADD, timer, &timerEvent) == -1) {
-      throw std::runtime_error("Dispatcher::getTimer, epoll_ctl failed, "  + lastErrorMessage());
-    }
-  } else {
-    timer = timers.top();
-    timers.pop();
+  // Rounded up, a timer never expires before its duration has passed
+  uint64_t expiry = now + (duration.count() > 0 ? static_cast<uint64_t>(duration.count()) : 0);
+  timer.expiry = std::max(expiry / 1000000 + (expiry % 1000000 != 0 ? 1 : 0), timerWheel.getCurrentTick() + 1);
+  timerWheel.insert(timer);
+  armTimer();
+}
+
+// The timerfd stays armed, waking up without an expired timer costs less than a timerfd_settime for every removal
+void Dispatcher::removeTimer(NativeTimer& timer) {
+  timerWheel.remove(timer);
+}
+
+uint64_t Dispatcher::getTimerTime() const {
+  timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) == -1) {
+    throw std::runtime_error("Dispatcher::getTimerTime, clock_gettime failed, " + lastErrorMessage());
+  }
+
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000 + now.tv_nsec - timerEpoch;
+}
+
+void Dispatcher::processTimers() {
+  uint64_t expirations;
+  if (read(timer, &expirations, sizeof expirations) == -1 && errno != EAGAIN) {
+    throw std::runtime_error("Dispatcher::processTimers, read failed, " + lastErrorMessage());
+  }
+
+  armedTick = UINT64_MAX;
+  TimerWheel::Entry* entry = timerWheel.advance(getTimerTime() / 1000000);
+  while (entry != nullptr) {
+    NativeTimer* expired = static_cast<NativeTimer*>(entry);
+    entry = entry->next;
+    // The sleep is over, interrupting the context now only marks it as interrupted
+    expired->context->interruptProcedure = nullptr;
+    pushContext(expired->context);
+  }
+
+  armTimer();
+}
+
+// The timerfd is only set when the next tick the wheel needs moves closer, so most timers are added without a system call
+void Dispatcher::armTimer() {
+  uint64_t tick;
+  if (!timerWheel.getNextTick(tick) || tick >= armedTick) {
+    return;
+  }
+
+  uint64_t expiry = timerEpoch + tick * 1000000;
+  itimerspec expires;
+  expires.it_interval.tv_sec = 0;
+  expires.it_interval.tv_nsec = 0;
+  expires.it_value.tv_sec = static_cast<time_t>(expiry / 1000000000);
+  expires.it_value.tv_nsec = static_cast<long>(expiry % 1000000000);
+  if (timerfd_settime(timer, TFD_TIMER_ABSTIME, &expires, nullptr) == -1) {
+    throw std::runtime_error("Dispatcher::armTimer, timerfd_settime failed, " + lastErrorMessage());
+  }
+
+  armedTick = tick;
+}
+
+// Falls back to epoll when the kernel lacks io_uring or any operation the sockets use
+void Dispatcher::openIoUring() {
+  std::unique_ptr<IoUring> newRing(new IoUring);
+  if (!newRing->open(RING_ENTRIES, RING_COMPLETION_ENTRIES)) {
+    return;
+  }
+
+  newRing->registerBuffers(RING_BUFFER_COUNT, RING_BUFFER_SIZE);
+  ringEventContext.writeContext = nullptr;
+  ringEventContext.readContext = nullptr;
+
+  // The ring is readable while it has completions, which wakes a blocked poll
+  epoll_event ringEpollEvent;
+  ringEpollEvent.events = EPOLLIN;
+  ringEpollEvent.data.ptr = &ringEventContext;
+  if (epoll_ctl(epoll, EPOLL_CTL_ADD, newRing->getFd(), &ringEpollEvent) == -1) {
+    return;
   }
 
-  return timer;
+  ring = std::move(newRing);
 }
 
-void Dispatcher::pushTimer(int timer) {
-  timers.push(timer);
+unsigned Dispatcher::reapCompletions() {
+  return ring->reap([this](void* userData, int32_t result, uint32_t flags) {
+    RingOperation* operation = static_cast<RingOperation*>(userData);
+    operation->complete(*this, *operation, result, flags);
+  });
 }
 
-void Dispatcher::contextProcedure(void* ucontext) {
+void Dispatcher::contextProcedure() {
   assert(firstReusableContext == nullptr);
   NativeContext context;
-  context.ucontext = ucontext;
   context.interrupted = false;
   context.next = nullptr;
   context.inExecutionQueue = false;
   firstReusableContext = &context;
-  ucontext_t* oldContext = static_cast<ucontext_t*>(context.ucontext);
-  if (swapcontext(oldContext, static_cast<ucontext_t*>(currentContext->ucontext)) == -1) {
-    throw std::runtime_error("Dispatcher::contextProcedure, swapcontext failed, " + lastErrorMessage());
-  }
+  switchContext(context.state, currentContext->state);
 
   for (;;) {
     ++runningContextCount;
@@ -485,9 +607,8 @@ void Dispatcher::contextProcedure(void* ucontext) {
   }
 };
 
-void Dispatcher::contextProcedureStatic(void *context) {
-  ContextMakingData* makingContextData = reinterpret_cast<ContextMakingData*>(context);
-  makingContextData->dispatcher->contextProcedure(makingContextData->ucontext);
+void Dispatcher::contextProcedureStatic(void* dispatcher) {
+  static_cast<Dispatcher*>(dispatcher)->contextProcedure();
 }
 
 }
@@ -17,20 +17,27 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <queue>
-#include <stack>
+#include "ContextSwitch.h"
+#include "TimerWheel.h"
 #ifndef __GLIBC__
 #include <bits/reg.h>
 #endif
 
 namespace System {
 
+class Dispatcher;
+class IoUring;
 struct NativeContextGroup;
 
 struct NativeContext {
-  void* ucontext;
+  ContextState state;
   void* stackPtr;
   bool interrupted;
   bool inExecutionQueue;
@@ -60,6 +67,32 @@ struct ContextPair {
   OperationContext *writeContext;
 };
 
+// A sleep in progress, kept on the stack of the sleeping context while it is in the timer wheel
+struct NativeTimer : TimerWheel::Entry {
+  NativeContext* context;
+  bool interrupted;
+};
+
+// An operation submitted to the io_uring of a dispatcher, its address is the user data of the submission
+struct RingOperation {
+  // Called for every completion, the last one doesn't have IORING_CQE_F_MORE in flags
+  void (*complete)(Dispatcher& dispatcher, RingOperation& operation, int32_t result, uint32_t flags);
+};
+
+enum class IoBackend {
+  EPOLL,
+  IO_URING
+};
+
+struct DispatcherStatistics {
+  uint64_t pollCount;
+  uint64_t eventCount;
+  uint64_t maxEventsPerPoll;
+  // Time in microseconds contexts ran between two polls, which is how long a ready event may wait to be noticed
+  uint64_t totalRunTime;
+  uint64_t maxRunTime;
+};
+
 class Dispatcher {
 public:
   Dispatcher();
@@ -75,13 +108,22 @@ public:
   void pushContext(NativeContext* context);
   void remoteSpawn(std::function<void()>&& procedure);
   void yield();
+  // Can be called from any thread
+  DispatcherStatistics getStatistics() const;
+  // Backend of the dispatchers created afterwards, IO_URING falls back to EPOLL where the kernel doesn't support it
+  static void setDefaultIoBackend(IoBackend backend);
+  IoBackend getIoBackend() const;
 
   // system-dependent
   int getEpoll() const;
+  // Sockets are read and written through the ring when there is one, nullptr with the epoll backend
+  IoUring* getIoUring() const;
   NativeContext& getReusableContext();
   void pushReusableContext(NativeContext&);
-  int getTimer();
-  void pushTimer(int timer);
+  // Every timer of the dispatcher is multiplexed on a single timerfd with a resolution of a millisecond. The context
+  // of an expired timer is resumed, a removed one is not
+  void addTimer(NativeTimer& timer, std::chrono::nanoseconds duration);
+  void removeTimer(NativeTimer& timer);
 
 #ifdef __x86_64__
 # if __WORDSIZE == 64
@@ -95,12 +137,27 @@ public:
 
 private:
   void spawn(std::function<void()>&& procedure);
+  void pollEvents(int timeout);
+  // Nanoseconds since tick 0 of the timer wheel
+  uint64_t getTimerTime() const;
+  void processTimers();
+  void armTimer();
+  void openIoUring();
+  unsigned reapCompletions();
   int epoll;
   alignas(void*) uint8_t mutex[SIZEOF_PTHREAD_MUTEX_T];
   int remoteSpawnEvent;
   ContextPair remoteSpawnEventContext;
   std::queue<std::function<void()>> remoteSpawningProcedures;
-  std::stack<int> timers;
+  int timer;
+  ContextPair timerEventContext;
+  TimerWheel timerWheel;
+  // CLOCK_MONOTONIC time in nanoseconds of tick 0 of the wheel
+  uint64_t timerEpoch;
+  // Tick the timerfd expires at, UINT64_MAX if it doesn't have to
+  uint64_t armedTick;
+  std::unique_ptr<IoUring> ring;
+  ContextPair ringEventContext;
 
   NativeContext mainContext;
   NativeContextGroup contextGroup;
@@ -109,9 +166,17 @@ private:
   NativeContext* lastResumingContext;
   NativeContext* firstReusableContext;
   size_t runningContextCount;
+  size_t resumedSincePoll;
+
+  std::chrono::steady_clock::time_point lastPollEnd;
+  std::atomic<uint64_t> pollCount{0};
+  std::atomic<uint64_t> eventCount{0};
+  std::atomic<uint64_t> maxEventsPerPoll{0};
+  std::atomic<uint64_t> totalRunTime{0};
+  std::atomic<uint64_t> maxRunTime{0};
 
-  void contextProcedure(void* ucontext);
-  static void contextProcedureStatic(void* context);
+  void contextProcedure();
+  static void contextProcedureStatic(void* dispatcher);
 };
 
 }
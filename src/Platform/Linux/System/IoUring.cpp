@@ -0,0 +1,243 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "IoUring.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "ErrorMessage.h"
+
+namespace System {
+
+namespace {
+
+const uint8_t REQUIRED_OPERATIONS[] = { IORING_OP_ACCEPT, IORING_OP_RECV, IORING_OP_SEND, IORING_OP_READ_FIXED,
+  IORING_OP_ASYNC_CANCEL };
+
+int ioUringSetup(unsigned entries, io_uring_params& parameters) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, &parameters));
+}
+
+int ioUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+  return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int ioUringRegister(int fd, unsigned opcode, void* argument, unsigned count) {
+  return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, argument, count));
+}
+
+template <typename T>
+T* ringField(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+}
+
+IoUring::IoUring() : fd(-1), sqRing(MAP_FAILED), cqRing(MAP_FAILED), sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+  pending(0), inFlight(0), buffers(nullptr), bufferCount(0), bufferSize(0) {
+}
+
+IoUring::~IoUring() {
+  if (buffers != nullptr) {
+    munmap(buffers, bufferCount * bufferSize);
+  }
+
+  if (sqes != MAP_FAILED) {
+    munmap(sqes, sqesSize);
+  }
+
+  if (cqRing != MAP_FAILED && cqRing != sqRing) {
+    munmap(cqRing, cqRingSize);
+  }
+
+  if (sqRing != MAP_FAILED) {
+    munmap(sqRing, sqRingSize);
+  }
+
+  if (fd != -1) {
+    int result = close(fd);
+    assert(result != -1);
+  }
+}
+
+bool IoUring::open(unsigned entries, unsigned completionEntries) {
+  assert(fd == -1);
+  io_uring_params parameters;
+  memset(&parameters, 0, sizeof parameters);
+  parameters.flags = IORING_SETUP_CQSIZE;
+  parameters.cq_entries = completionEntries;
+  fd = ioUringSetup(entries, parameters);
+  if (fd == -1) {
+    return false;
+  }
+
+  // Without these the completions of a busy ring could be lost or the rings would need separate mappings
+  if ((parameters.features & IORING_FEAT_NODROP) == 0 || (parameters.features & IORING_FEAT_SINGLE_MMAP) == 0) {
+    return false;
+  }
+
+  std::vector<uint8_t> probeData(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+  io_uring_probe* probe = reinterpret_cast<io_uring_probe*>(probeData.data());
+  if (ioUringRegister(fd, IORING_REGISTER_PROBE, probe, 256) == -1) {
+    return false;
+  }
+
+  for (uint8_t operation : REQUIRED_OPERATIONS) {
+    if (operation > probe->last_op || (probe->ops[operation].flags & IO_URING_OP_SUPPORTED) == 0) {
+      return false;
+    }
+  }
+
+  sqRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(unsigned);
+  cqRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+  sqRingSize = std::max(sqRingSize, cqRingSize);
+  sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (sqRing == MAP_FAILED) {
+    return false;
+  }
+
+  cqRing = sqRing;
+  sqesSize = parameters.sq_entries * sizeof(io_uring_sqe);
+  sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+    IORING_OFF_SQES));
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+
+  sqHead = ringField<unsigned>(sqRing, parameters.sq_off.head);
+  sqTail = ringField<unsigned>(sqRing, parameters.sq_off.tail);
+  sqFlags = ringField<unsigned>(sqRing, parameters.sq_off.flags);
+  sqArray = ringField<unsigned>(sqRing, parameters.sq_off.array);
+  sqMask = *ringField<unsigned>(sqRing, parameters.sq_off.ring_mask);
+  sqEntries = parameters.sq_entries;
+  cqHead = ringField<unsigned>(cqRing, parameters.cq_off.head);
+  cqTail = ringField<unsigned>(cqRing, parameters.cq_off.tail);
+  cqes = ringField<io_uring_cqe>(cqRing, parameters.cq_off.cqes);
+  cqMask = *ringField<unsigned>(cqRing, parameters.cq_off.ring_mask);
+  return true;
+}
+
+int IoUring::getFd() const {
+  return fd;
+}
+
+io_uring_sqe& IoUring::prepare(void* userData) {
+  if (pending == sqEntries) {
+    submit();
+    if (pending == sqEntries) {
+      throw std::runtime_error("IoUring::prepare, submission queue is full");
+    }
+  }
+
+  unsigned tail = *sqTail;
+  unsigned index = tail & sqMask;
+  io_uring_sqe& sqe = sqes[index];
+  memset(&sqe, 0, sizeof sqe);
+  sqe.user_data = reinterpret_cast<uintptr_t>(userData);
+  sqArray[index] = index;
+  // The kernel doesn't look at the entry before the next submit, so it can still be filled in after the tail moves
+  __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+  ++pending;
+  if (userData != nullptr) {
+    ++inFlight;
+  }
+
+  return sqe;
+}
+
+// Whatever the kernel can't take now, with a completion backlog to reap first, stays queued for the next submit
+void IoUring::submit() {
+  if (pending != 0) {
+    enter(pending, 0, 0);
+  }
+}
+
+void IoUring::wait() {
+  enter(pending, 1, IORING_ENTER_GETEVENTS);
+}
+
+size_t IoUring::getInFlight() const {
+  return inFlight;
+}
+
+bool IoUring::registerBuffers(size_t count, size_t size) {
+  assert(buffers == nullptr);
+  void* mapping = mmap(nullptr, count * size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    return false;
+  }
+
+  std::vector<iovec> vectors(count);
+  for (size_t i = 0; i < count; ++i) {
+    vectors[i].iov_base = static_cast<uint8_t*>(mapping) + i * size;
+    vectors[i].iov_len = size;
+  }
+
+  // Fails when the locked memory limit is too low for the buffers, reads then go to the caller's memory
+  if (ioUringRegister(fd, IORING_REGISTER_BUFFERS, vectors.data(), static_cast<unsigned>(count)) == -1) {
+    munmap(mapping, count * size);
+    return false;
+  }
+
+  buffers = static_cast<uint8_t*>(mapping);
+  bufferCount = count;
+  bufferSize = size;
+  freeBuffers.reserve(count);
+  for (size_t i = count; i > 0; --i) {
+    freeBuffers.push_back(static_cast<int>(i - 1));
+  }
+
+  return true;
+}
+
+int IoUring::acquireBuffer() {
+  if (freeBuffers.empty()) {
+    return -1;
+  }
+
+  int index = freeBuffers.back();
+  freeBuffers.pop_back();
+  return index;
+}
+
+void IoUring::releaseBuffer(int index) {
+  assert(index >= 0 && static_cast<size_t>(index) < bufferCount);
+  freeBuffers.push_back(index);
+}
+
+uint8_t* IoUring::getBuffer(int index) const {
+  return buffers + static_cast<size_t>(index) * bufferSize;
+}
+
+size_t IoUring::getBufferSize() const {
+  return bufferSize;
+}
+
+void IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags) {
+  int result = ioUringEnter(fd, toSubmit, minComplete, flags);
+  if (result == -1) {
+    if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+      return;
+    }
+
+    throw std::runtime_error("IoUring::enter, io_uring_enter failed, " + lastErrorMessage());
+  }
+
+  assert(static_cast<unsigned>(result) <= pending);
+  pending -= static_cast<unsigned>(result);
+}
+
+}
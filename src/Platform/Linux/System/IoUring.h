@@ -0,0 +1,110 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <linux/io_uring.h>
+
+namespace System {
+
+// Submission and completion queues shared with the kernel, driven with the raw system calls. Submissions are only
+// queued by prepare and reach the kernel together at the next submit, which the dispatcher does once per poll
+class IoUring {
+public:
+  IoUring();
+  IoUring(const IoUring&) = delete;
+  ~IoUring();
+  IoUring& operator=(const IoUring&) = delete;
+
+  // False if the kernel doesn't provide io_uring or an operation the dispatcher needs
+  bool open(unsigned entries, unsigned completionEntries);
+  int getFd() const;
+
+  // A cleared submission entry with the given user data, counted in flight until its last completion. A null user
+  // data marks a submission whose completions are ignored, as a cancellation
+  io_uring_sqe& prepare(void* userData);
+  void submit();
+  // Blocks until at least one completion can be reaped
+  void wait();
+  size_t getInFlight() const;
+
+  // Calls complete(userData, result, flags) for every available completion and returns how many there were
+  template <typename F>
+  unsigned reap(F&& complete);
+
+  // Memory registered once with the kernel, so reads into it don't map the pages for every operation
+  bool registerBuffers(size_t count, size_t size);
+  // Index of a free registered buffer, -1 if there is none
+  int acquireBuffer();
+  void releaseBuffer(int index);
+  uint8_t* getBuffer(int index) const;
+  size_t getBufferSize() const;
+
+private:
+  void enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+
+  int fd;
+  void* sqRing;
+  size_t sqRingSize;
+  void* cqRing;
+  size_t cqRingSize;
+  io_uring_sqe* sqes;
+  size_t sqesSize;
+  unsigned* sqHead;
+  unsigned* sqTail;
+  unsigned* sqFlags;
+  unsigned* sqArray;
+  unsigned sqMask;
+  unsigned sqEntries;
+  unsigned* cqHead;
+  unsigned* cqTail;
+  io_uring_cqe* cqes;
+  unsigned cqMask;
+  unsigned pending;
+  size_t inFlight;
+
+  uint8_t* buffers;
+  size_t bufferCount;
+  size_t bufferSize;
+  std::vector<int> freeBuffers;
+};
+
+template <typename F>
+unsigned IoUring::reap(F&& complete) {
+  if ((__atomic_load_n(sqFlags, __ATOMIC_RELAXED) & IORING_SQ_CQ_OVERFLOW) != 0) {
+    // Completions the queue had no room for wait in the kernel until they are asked for
+    enter(0, 0, IORING_ENTER_GETEVENTS);
+  }
+
+  unsigned head = *cqHead;
+  unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+  unsigned count = tail - head;
+  for (; head != tail; ++head) {
+    const io_uring_cqe& cqe = cqes[head & cqMask];
+    void* userData = reinterpret_cast<void*>(static_cast<uintptr_t>(cqe.user_data));
+    int32_t result = cqe.res;
+    uint32_t flags = cqe.flags;
+    // The entry is handed back before the completion runs, which may prepare new submissions
+    __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+    if (userData != nullptr) {
+      if ((flags & IORING_CQE_F_MORE) == 0) {
+        --inFlight;
+      }
+
+      complete(userData, result, flags);
+    }
+  }
+
+  return count;
+}
+
+}
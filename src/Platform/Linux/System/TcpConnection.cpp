@@ -17,17 +17,70 @@
 
 #include "TcpConnection.h"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <cassert>
+#include <cstring>
 #include <sys/epoll.h>
 #include <unistd.h>
 
 #include <System/ErrorMessage.h>
 #include <System/InterruptedException.h>
 #include <System/Ipv4Address.h>
+#include "IoUring.h"
 
 namespace System {
 
+namespace {
+
+struct RingTransfer : RingOperation {
+  NativeContext* context;
+  int32_t result;
+  bool cancelled;
+};
+
+void completeTransfer(Dispatcher& dispatcher, RingOperation& operation, int32_t result, uint32_t) {
+  RingTransfer& transfer = static_cast<RingTransfer&>(operation);
+  transfer.result = result;
+  // The transfer is complete, interrupting the context now only marks it as interrupted
+  transfer.context->interruptProcedure = nullptr;
+  dispatcher.pushContext(transfer.context);
+}
+
+// The context is only resumed by the completion of the transfer, even when interrupted, as the kernel may still use
+// its memory until then
+void waitTransfer(Dispatcher& dispatcher, IoUring& ring, RingTransfer& transfer) {
+  dispatcher.getCurrentContext()->interruptProcedure = [&]() {
+    io_uring_sqe& cancel = ring.prepare(nullptr);
+    cancel.opcode = IORING_OP_ASYNC_CANCEL;
+    cancel.addr = reinterpret_cast<uintptr_t>(&transfer);
+    transfer.cancelled = true;
+  };
+
+  dispatcher.dispatch();
+  dispatcher.getCurrentContext()->interruptProcedure = nullptr;
+  assert(transfer.context == dispatcher.getCurrentContext());
+}
+
+size_t finishTransfer(Dispatcher& dispatcher, const RingTransfer& transfer, const std::string& operation) {
+  if (transfer.cancelled) {
+    if (transfer.result == -ECANCELED || transfer.result == -EINTR) {
+      throw InterruptedException();
+    }
+
+    // Done before the cancellation reached it, the next operation of the context is interrupted instead
+    dispatcher.interrupt();
+  }
+
+  if (transfer.result < 0) {
+    throw std::runtime_error(operation + errorMessage(-transfer.result));
+  }
+
+  return static_cast<size_t>(transfer.result);
+}
+
+}
+
 TcpConnection::TcpConnection() : dispatcher(nullptr) {
 }
 
@@ -81,6 +134,10 @@ size_t TcpConnection::read(uint8_t* data, size_t size) {
   std::string message;
   ssize_t transferred = ::recv(connection, (void *)data, size, 0);
   if (transferred == -1) {
+    if (errno == EAGAIN && dispatcher->getIoUring() != nullptr) {
+      return readRing(*dispatcher->getIoUring(), data, size);
+    }
+
     if (errno != EAGAIN) {
       message = "recv failed, " + lastErrorMessage();
     } else {
@@ -177,6 +234,10 @@ std::size_t TcpConnection::write(const uint8_t* data, size_t size) {
 
   ssize_t transferred = ::send(connection, (void *)data, size, MSG_NOSIGNAL);
   if (transferred == -1) {
+    if (errno == EAGAIN && dispatcher->getIoUring() != nullptr) {
+      return writeRing(*dispatcher->getIoUring(), data, size);
+    }
+
     if (errno != EAGAIN) {
       message = "send failed, " + lastErrorMessage();
     } else {
@@ -269,6 +330,10 @@ std::pair<Ipv4Address, uint16_t> TcpConnection::getPeerAddressAndPort() const {
 TcpConnection::TcpConnection(Dispatcher& dispatcher, int socket) : dispatcher(&dispatcher), connection(socket) {
   contextPair.readContext = nullptr;
   contextPair.writeContext = nullptr;
+  if (dispatcher.getIoUring() != nullptr) {
+    return;
+  }
+
   epoll_event connectionEvent;
   connectionEvent.events = EPOLLONESHOT;
   connectionEvent.data.ptr = nullptr;
@@ -278,4 +343,54 @@ TcpConnection::TcpConnection(Dispatcher& dispatcher, int socket) : dispatcher(&d
   }
 }
 
+// Waits for data the socket didn't have. The read is submitted with the others of this round of the dispatcher and the
+// kernel completes it once data arrives, instead of the epoll_ctl calls and the second recv of the epoll backend. Reads
+// that fit a registered buffer go to one while one is free and are copied out, which is cheaper for the small messages
+// of the protocol than mapping the caller's memory for every read
+size_t TcpConnection::readRing(IoUring& ring, uint8_t* data, size_t size) {
+  RingTransfer transfer;
+  transfer.complete = &completeTransfer;
+  transfer.context = dispatcher->getCurrentContext();
+  transfer.cancelled = false;
+  int buffer = size <= ring.getBufferSize() ? ring.acquireBuffer() : -1;
+  io_uring_sqe& sqe = ring.prepare(&transfer);
+  sqe.fd = connection;
+  if (buffer != -1) {
+    sqe.opcode = IORING_OP_READ_FIXED;
+    sqe.addr = reinterpret_cast<uintptr_t>(ring.getBuffer(buffer));
+    sqe.len = static_cast<uint32_t>(size);
+    sqe.buf_index = static_cast<uint16_t>(buffer);
+  } else {
+    sqe.opcode = IORING_OP_RECV;
+    sqe.addr = reinterpret_cast<uintptr_t>(data);
+    sqe.len = static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX));
+  }
+
+  waitTransfer(*dispatcher, ring, transfer);
+  if (buffer != -1) {
+    if (transfer.result > 0) {
+      memcpy(data, ring.getBuffer(buffer), static_cast<size_t>(transfer.result));
+    }
+
+    ring.releaseBuffer(buffer);
+  }
+
+  return finishTransfer(*dispatcher, transfer, "TcpConnection::read, recv failed, ");
+}
+
+size_t TcpConnection::writeRing(IoUring& ring, const uint8_t* data, size_t size) {
+  RingTransfer transfer;
+  transfer.complete = &completeTransfer;
+  transfer.context = dispatcher->getCurrentContext();
+  transfer.cancelled = false;
+  io_uring_sqe& sqe = ring.prepare(&transfer);
+  sqe.opcode = IORING_OP_SEND;
+  sqe.fd = connection;
+  sqe.addr = reinterpret_cast<uintptr_t>(data);
+  sqe.len = static_cast<uint32_t>(std::min<size_t>(size, UINT32_MAX));
+  sqe.msg_flags = MSG_NOSIGNAL;
+  waitTransfer(*dispatcher, ring, transfer);
+  return finishTransfer(*dispatcher, transfer, "TcpConnection::write, send failed, ");
+}
+
 }
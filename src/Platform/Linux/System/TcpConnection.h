@@ -36,6 +36,8 @@ private:
   ContextPair contextPair;
 
   TcpConnection(Dispatcher& dispatcher, int socket);
+  std::size_t readRing(IoUring& ring, uint8_t* data, std::size_t size);
+  std::size_t writeRing(IoUring& ring, const uint8_t* data, std::size_t size);
 };
 
 }
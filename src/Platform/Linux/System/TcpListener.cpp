@@ -6,6 +6,7 @@
 
 #include "TcpListener.h"
 #include <cassert>
+#include <queue>
 #include <stdexcept>
 
 #include <fcntl.h>
@@ -19,13 +20,73 @@
 #include <System/ErrorMessage.h>
 #include <System/InterruptedException.h>
 #include <System/Ipv4Address.h>
+#include "IoUring.h"
 
 namespace System {
 
+// Accepts of a listener on the io_uring backend. One multishot accept keeps queueing connections between the calls
+// to accept, so it outlives them and is freed by its last completion once the listener is gone
+struct RingAcceptor : RingOperation {
+  bool armed;
+  bool multishot;
+  bool closing;
+  int error;
+  std::queue<int> connections;
+  NativeContext* waiter;
+};
+
+namespace {
+
+void closeConnections(RingAcceptor& acceptor) {
+  while (!acceptor.connections.empty()) {
+    int result = close(acceptor.connections.front());
+    assert(result != -1);
+    acceptor.connections.pop();
+  }
+}
+
+void completeAccept(Dispatcher& dispatcher, RingOperation& operation, int32_t result, uint32_t flags) {
+  RingAcceptor& acceptor = static_cast<RingAcceptor&>(operation);
+  if ((flags & IORING_CQE_F_MORE) == 0) {
+    acceptor.armed = false;
+  }
+
+  if (acceptor.closing) {
+    if (result >= 0) {
+      int closeResult = close(result);
+      assert(closeResult != -1);
+    }
+
+    if (!acceptor.armed) {
+      closeConnections(acceptor);
+      delete &acceptor;
+    }
+
+    return;
+  }
+
+  if (result >= 0) {
+    acceptor.connections.push(result);
+  } else if (result == -EINVAL && acceptor.multishot) {
+    // Kernels before 5.19 don't have multishot accepts, the next ones are single
+    acceptor.multishot = false;
+  } else if (result != -ECANCELED) {
+    acceptor.error = -result;
+  }
+
+  if (acceptor.waiter != nullptr) {
+    acceptor.waiter->interruptProcedure = nullptr;
+    dispatcher.pushContext(acceptor.waiter);
+    acceptor.waiter = nullptr;
+  }
+}
+
+}
+
 TcpListener::TcpListener() : dispatcher(nullptr) {
 }
 
-TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16_t port) : dispatcher(&dispatcher) {
+TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16_t port, bool shared) : dispatcher(&dispatcher) {
   std::string message;
   listener = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
   if (listener == -1) {
@@ -36,7 +97,8 @@ TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16
       message = "fcntl failed, " + lastErrorMessage();
     } else {
       int on = 1;
-      if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) == -1) {
+      if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on) == -1 ||
+        (shared && setsockopt(listener, SOL_SOCKET, SO_REUSEPORT, &on, sizeof on) == -1)) {
         message = "setsockopt failed, " + lastErrorMessage();
       } else {
         sockaddr_in address;
@@ -52,10 +114,13 @@ TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16
           listenEvent.events = 0;
           listenEvent.data.ptr = nullptr;
 
-          if (epoll_ctl(dispatcher.getEpoll(), EPOLL_CTL_ADD, listener, &listenEvent) == -1) {
+          // Accepts on the io_uring backend don't need the listener in the epoll set
+          if (dispatcher.getIoUring() == nullptr &&
+            epoll_ctl(dispatcher.getEpoll(), EPOLL_CTL_ADD, listener, &listenEvent) == -1) {
             message = "epoll_ctl failed, " + lastErrorMessage();
           } else {
             context = nullptr;
+            acceptor = nullptr;
             return;
           }
         }
@@ -69,11 +134,41 @@ TcpListener::TcpListener(Dispatcher& dispatcher, const Ipv4Address& addr, uint16
   throw std::runtime_error("TcpListener::TcpListener, " + message);
 }
 
+TcpListener::TcpListener(Dispatcher& dispatcher, TcpListener&& other) : dispatcher(&dispatcher) {
+  assert(other.dispatcher != nullptr);
+  assert(other.context == nullptr);
+  assert(other.acceptor == nullptr);
+  if (other.dispatcher->getIoUring() == nullptr &&
+    epoll_ctl(other.dispatcher->getEpoll(), EPOLL_CTL_DEL, other.listener, nullptr) == -1) {
+    throw std::runtime_error("TcpListener::TcpListener, epoll_ctl failed, " + lastErrorMessage());
+  }
+
+  epoll_event listenEvent;
+  listenEvent.events = 0;
+  listenEvent.data.ptr = nullptr;
+  if (dispatcher.getIoUring() == nullptr &&
+    epoll_ctl(dispatcher.getEpoll(), EPOLL_CTL_ADD, other.listener, &listenEvent) == -1) {
+    std::string message = "epoll_ctl failed, " + lastErrorMessage();
+    if (other.dispatcher->getIoUring() == nullptr) {
+      // other keeps the socket, so it goes back to the epoll set it was taken out of
+      epoll_ctl(other.dispatcher->getEpoll(), EPOLL_CTL_ADD, other.listener, &listenEvent);
+    }
+
+    throw std::runtime_error("TcpListener::TcpListener, " + message);
+  }
+
+  listener = other.listener;
+  context = nullptr;
+  acceptor = nullptr;
+  other.dispatcher = nullptr;
+}
+
 TcpListener::TcpListener(TcpListener&& other) : dispatcher(other.dispatcher) {
   if (other.dispatcher != nullptr) {
     assert(other.context == nullptr);
     listener = other.listener;
     context = nullptr;
+    acceptor = other.acceptor;
     other.dispatcher = nullptr;
   }
 }
@@ -81,6 +176,7 @@ TcpListener::TcpListener(TcpListener&& other) : dispatcher(other.dispatcher) {
 TcpListener::~TcpListener() {
   if (dispatcher != nullptr) {
     assert(context == nullptr);
+    releaseAcceptor();
     int result = close(listener);
     assert(result != -1);
   }
@@ -89,6 +185,7 @@ TcpListener::~TcpListener() {
 TcpListener& TcpListener::operator=(TcpListener&& other) {
   if (dispatcher != nullptr) {
     assert(context == nullptr);
+    releaseAcceptor();
     if (close(listener) == -1) {
       throw std::runtime_error("TcpListener::operator=, close failed, " + lastErrorMessage());
     }
@@ -99,6 +196,7 @@ TcpListener& TcpListener::operator=(TcpListener&& other) {
     assert(other.context == nullptr);
     listener = other.listener;
     context = nullptr;
+    acceptor = other.acceptor;
     other.dispatcher = nullptr;
   }
 
@@ -112,6 +210,10 @@ TcpConnection TcpListener::accept() {
     throw InterruptedException();
   }
 
+  if (IoUring* ring = dispatcher->getIoUring()) {
+    return acceptRing(*ring);
+  }
+
   ContextPair contextPair;
   OperationContext listenerContext;
   listenerContext.interrupted = false;
@@ -183,4 +285,77 @@ TcpConnection TcpListener::accept() {
   throw std::runtime_error("TcpListener::accept, " + message);
 }
 
+TcpConnection TcpListener::acceptRing(IoUring& ring) {
+  if (acceptor == nullptr) {
+    acceptor = new RingAcceptor;
+    acceptor->complete = &completeAccept;
+    acceptor->armed = false;
+    acceptor->multishot = true;
+    acceptor->closing = false;
+    acceptor->error = 0;
+    acceptor->waiter = nullptr;
+  }
+
+  while (acceptor->connections.empty() && acceptor->error == 0) {
+    if (!acceptor->armed) {
+      io_uring_sqe& sqe = ring.prepare(acceptor);
+      sqe.opcode = IORING_OP_ACCEPT;
+      sqe.fd = listener;
+      sqe.accept_flags = SOCK_NONBLOCK;
+      if (acceptor->multishot) {
+        sqe.ioprio = IORING_ACCEPT_MULTISHOT;
+      }
+
+      acceptor->armed = true;
+    }
+
+    // An interrupted accept leaves the accept armed, the connections it gets wait for the next call
+    bool interrupted = false;
+    NativeContext* current = dispatcher->getCurrentContext();
+    acceptor->waiter = current;
+    context = acceptor;
+    current->interruptProcedure = [&]() {
+      acceptor->waiter = nullptr;
+      interrupted = true;
+      dispatcher->pushContext(current);
+    };
+
+    dispatcher->dispatch();
+    current->interruptProcedure = nullptr;
+    context = nullptr;
+    if (interrupted) {
+      throw InterruptedException();
+    }
+  }
+
+  if (!acceptor->connections.empty()) {
+    int connection = acceptor->connections.front();
+    acceptor->connections.pop();
+    return TcpConnection(*dispatcher, connection);
+  }
+
+  int error = acceptor->error;
+  acceptor->error = 0;
+  throw std::runtime_error("TcpListener::accept, accept failed, " + errorMessage(error));
+}
+
+void TcpListener::releaseAcceptor() {
+  if (acceptor == nullptr) {
+    return;
+  }
+
+  if (acceptor->armed) {
+    // Freed by the completion that ends the accept
+    acceptor->closing = true;
+    io_uring_sqe& cancel = dispatcher->getIoUring()->prepare(nullptr);
+    cancel.opcode = IORING_OP_ASYNC_CANCEL;
+    cancel.addr = reinterpret_cast<uintptr_t>(acceptor);
+  } else {
+    closeConnections(*acceptor);
+    delete acceptor;
+  }
+
+  acceptor = nullptr;
+}
+
 }
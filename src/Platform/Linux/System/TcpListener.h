@@ -13,12 +13,18 @@ namespace System {
 
 class Dispatcher;
 class Ipv4Address;
+class IoUring;
 class TcpConnection;
+struct RingAcceptor;
 
 class TcpListener {
 public:
   TcpListener();
-  TcpListener(Dispatcher& dispatcher, const Ipv4Address& address, uint16_t port);
+  // Shared listeners bound to the same address and port split the incoming connections between them
+  TcpListener(Dispatcher& dispatcher, const Ipv4Address& address, uint16_t port, bool shared = false);
+  // Takes the socket of a listener that has never accepted over to another dispatcher, which can run on another thread.
+  // The connections queued on it stay queued
+  TcpListener(Dispatcher& dispatcher, TcpListener&& other);
   TcpListener(const TcpListener&) = delete;
   TcpListener(TcpListener&& other);
   ~TcpListener();
@@ -30,6 +36,10 @@ private:
   Dispatcher* dispatcher;
   void* context;
   int listener;
+  RingAcceptor* acceptor;
+
+  TcpConnection acceptRing(IoUring& ring);
+  void releaseAcceptor();
 };
 
 }
@@ -0,0 +1,176 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "TimerWheel.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace System {
+
+namespace {
+
+// Offset of the first set bit at or after position start, wrapping around; the mask must not be zero
+unsigned nextSetBit(uint64_t mask, unsigned start) {
+  uint64_t rotated = start == 0 ? mask : (mask >> start) | (mask << (64 - start));
+  return static_cast<unsigned>(__builtin_ctzll(rotated));
+}
+
+}
+
+TimerWheel::TimerWheel() : currentTick(0), count(0) {
+  std::fill(&slots[0][0], &slots[0][0] + LEVEL_COUNT * SLOT_COUNT, nullptr);
+  std::fill(occupied, occupied + LEVEL_COUNT, 0);
+}
+
+bool TimerWheel::empty() const {
+  return count == 0;
+}
+
+uint64_t TimerWheel::getCurrentTick() const {
+  return currentTick;
+}
+
+void TimerWheel::insert(Entry& entry) {
+  assert(entry.expiry >= currentTick);
+  uint64_t delta = entry.expiry - currentTick;
+  for (unsigned level = 0; level < LEVEL_COUNT; ++level) {
+    if (delta < (uint64_t(1) << (LEVEL_BITS * (level + 1)))) {
+      link(entry, level, (entry.expiry >> (LEVEL_BITS * level)) & (SLOT_COUNT - 1));
+      ++count;
+      return;
+    }
+  }
+
+  unsigned top = LEVEL_COUNT - 1;
+  link(entry, top, ((currentTick >> (LEVEL_BITS * top)) + SLOT_COUNT - 1) & (SLOT_COUNT - 1));
+  ++count;
+}
+
+void TimerWheel::remove(Entry& entry) {
+  assert(entry.slot != nullptr);
+  if (entry.prev != nullptr) {
+    entry.prev->next = entry.next;
+  } else {
+    *entry.slot = entry.next;
+    if (entry.next == nullptr) {
+      size_t index = static_cast<size_t>(entry.slot - &slots[0][0]);
+      occupied[index / SLOT_COUNT] &= ~(uint64_t(1) << (index % SLOT_COUNT));
+    }
+  }
+
+  if (entry.next != nullptr) {
+    entry.next->prev = entry.prev;
+  }
+
+  entry.slot = nullptr;
+  --count;
+}
+
+TimerWheel::Entry* TimerWheel::advance(uint64_t tick) {
+  Entry* expired = nullptr;
+  while (currentTick < tick) {
+    if (count == 0) {
+      currentTick = tick;
+      break;
+    }
+
+    if (occupied[0] == 0) {
+      // Nothing can expire before the next cascade
+      uint64_t boundary = (currentTick | (SLOT_COUNT - 1)) + 1;
+      if (boundary > tick) {
+        currentTick = tick;
+        break;
+      }
+
+      currentTick = boundary - 1;
+    }
+
+    ++currentTick;
+    if ((currentTick & (SLOT_COUNT - 1)) == 0) {
+      cascade();
+    }
+
+    size_t slot = currentTick & (SLOT_COUNT - 1);
+    Entry* entry = slots[0][slot];
+    while (entry != nullptr) {
+      Entry* next = entry->next;
+      assert(entry->expiry == currentTick);
+      entry->slot = nullptr;
+      entry->prev = nullptr;
+      entry->next = expired;
+      expired = entry;
+      --count;
+      entry = next;
+    }
+
+    slots[0][slot] = nullptr;
+    occupied[0] &= ~(uint64_t(1) << slot);
+  }
+
+  return expired;
+}
+
+bool TimerWheel::getNextTick(uint64_t& tick) const {
+  if (count == 0) {
+    return false;
+  }
+
+  uint64_t next = UINT64_MAX;
+  if (occupied[0] != 0) {
+    next = currentTick + 1 + nextSetBit(occupied[0], (currentTick + 1) & (SLOT_COUNT - 1));
+  }
+
+  // A higher level slot stands for the first block after the current one with its index
+  for (unsigned level = 1; level < LEVEL_COUNT; ++level) {
+    if (occupied[level] != 0) {
+      uint64_t block = (currentTick >> (LEVEL_BITS * level)) + 1;
+      block += nextSetBit(occupied[level], block & (SLOT_COUNT - 1));
+      next = std::min(next, block << (LEVEL_BITS * level));
+    }
+  }
+
+  tick = next;
+  return true;
+}
+
+void TimerWheel::link(Entry& entry, unsigned level, size_t slot) {
+  Entry*& head = slots[level][slot];
+  entry.prev = nullptr;
+  entry.next = head;
+  if (head != nullptr) {
+    head->prev = &entry;
+  }
+
+  head = &entry;
+  entry.slot = &head;
+  occupied[level] |= uint64_t(1) << slot;
+}
+
+// The current tick starts a new block of level 0, and of the higher levels for which it also is a multiple of their
+// block size. The slots of those blocks are spread over the levels below
+void TimerWheel::cascade() {
+  for (unsigned level = 1; level < LEVEL_COUNT; ++level) {
+    size_t slot = (currentTick >> (LEVEL_BITS * level)) & (SLOT_COUNT - 1);
+    Entry* entry = slots[level][slot];
+    slots[level][slot] = nullptr;
+    occupied[level] &= ~(uint64_t(1) << slot);
+    while (entry != nullptr) {
+      Entry* next = entry->next;
+      --count;
+      insert(*entry);
+      entry = next;
+    }
+
+    if (slot != 0) {
+      break;
+    }
+  }
+}
+
+}
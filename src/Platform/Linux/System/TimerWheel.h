@@ -0,0 +1,58 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace System {
+
+// Hierarchical timing wheel of four levels with 64 slots each. A timer goes to the lowest level whose range covers its
+// expiry and moves down a level every time the wheel reaches the block of ticks its slot stands for, so inserting and
+// removing are O(1). Timers further away than 64^4 ticks wait in the last slot of the top level and are placed again
+// when it is reached
+class TimerWheel {
+public:
+  struct Entry {
+    uint64_t expiry;
+    Entry* prev;
+    Entry* next;
+    // Head of the slot list the entry is in, nullptr when it isn't in the wheel
+    Entry** slot;
+  };
+
+  TimerWheel();
+  TimerWheel(const TimerWheel&) = delete;
+  TimerWheel& operator=(const TimerWheel&) = delete;
+
+  bool empty() const;
+  uint64_t getCurrentTick() const;
+  // The expiry must be after the current tick
+  void insert(Entry& entry);
+  void remove(Entry& entry);
+  // Moves to the given tick and returns the expired entries linked through next, they are no longer in the wheel
+  Entry* advance(uint64_t tick);
+  // Tick at which advance has work to do: an expiry or a cascade of a higher level. False if the wheel is empty
+  bool getNextTick(uint64_t& tick) const;
+
+private:
+  static const unsigned LEVEL_BITS = 6;
+  static const unsigned LEVEL_COUNT = 4;
+  static const size_t SLOT_COUNT = size_t(1) << LEVEL_BITS;
+
+  void link(Entry& entry, unsigned level, size_t slot);
+  void cascade();
+
+  Entry* slots[LEVEL_COUNT][SLOT_COUNT];
+  uint64_t occupied[LEVEL_COUNT];
+  uint64_t currentTick;
+  size_t count;
+};
+
+}
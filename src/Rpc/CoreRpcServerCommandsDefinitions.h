@@ -939,4 +939,82 @@ struct COMMAND_RPC_GET_TRANSACTION_HASHES_BY_PAYMENT_ID {
   };
 };
 
+struct ViewKeyTransactionInfo {
+  Crypto::Hash txHash;
+  Crypto::Hash blockHash;
+  uint32_t blockHeight;
+  TransactionPrefix txPrefix;
+  // Outputs of the transaction that belong to the wallet and their global indexes
+  std::vector<uint32_t> outputIndexes;
+  std::vector<uint32_t> globalIndexes;
+  uint64_t amount;
+
+  void serialize(ISerializer &s) {
+    KV_MEMBER(txHash)
+    KV_MEMBER(blockHash)
+    KV_MEMBER(blockHeight)
+    KV_MEMBER(txPrefix)
+    KV_MEMBER(outputIndexes)
+    KV_MEMBER(globalIndexes)
+    KV_MEMBER(amount)
+  }
+};
+
+struct COMMAND_RPC_REGISTER_VIEW_KEY {
+  struct request {
+    Crypto::SecretKey viewSecretKey;
+    Crypto::PublicKey spendPublicKey;
+    uint32_t startHeight;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(viewSecretKey)
+      KV_MEMBER(spendPublicKey)
+      KV_MEMBER(startHeight)
+    }
+  };
+
+  typedef STATUS_STRUCT response;
+};
+
+struct COMMAND_RPC_UNREGISTER_VIEW_KEY {
+  struct request {
+    Crypto::SecretKey viewSecretKey;
+    Crypto::PublicKey spendPublicKey;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(viewSecretKey)
+      KV_MEMBER(spendPublicKey)
+    }
+  };
+
+  typedef STATUS_STRUCT response;
+};
+
+struct COMMAND_RPC_GET_VIEW_KEY_TRANSACTIONS {
+  struct request {
+    Crypto::SecretKey viewSecretKey;
+    Crypto::PublicKey spendPublicKey;
+    uint32_t startHeight;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(viewSecretKey)
+      KV_MEMBER(spendPublicKey)
+      KV_MEMBER(startHeight)
+    }
+  };
+
+  struct response {
+    std::string status;
+    // Blocks below this height have been reported, it is where the next request should start
+    uint32_t nextHeight;
+    std::vector<ViewKeyTransactionInfo> transactions;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(status)
+      KV_MEMBER(nextHeight)
+      KV_MEMBER(transactions)
+    }
+  };
+};
+
 }
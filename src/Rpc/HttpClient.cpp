@@ -49,6 +49,8 @@ void HttpClient::request(const HttpRequest &req, HttpResponse &res) {
     disconnect();
     throw;
   }
+
+  decompressResponse(res);
 }
 
 void HttpClient::connect() {
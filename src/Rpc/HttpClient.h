@@ -26,6 +26,7 @@
 #include <System/TcpConnection.h>
 #include <System/TcpStream.h>
 #include "JsonRpc.h"
+#include "RpcCompression.h"
 
 #include "Serialization/SerializationTools.h"
 
@@ -125,6 +126,7 @@ void invokeBinaryCommand(HttpClient& client, const std::string& url, const Reque
   if (!user.empty() || !password.empty()) {
     hreq.addHeader("Authorization", "Basic " + Base64::encode(Common::asBinaryArray(user + ":" + password)));
   }
+  acceptCompressedResponse(hreq);
   hreq.setUrl(url);
   hreq.setBody(storeToBinaryKeyValue(req));
   client.request(hreq, hres);
@@ -0,0 +1,65 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "HttpClientPool.h"
+
+#include <cassert>
+
+#include "HttpClient.h"
+
+namespace CryptoNote {
+
+HttpClientPool::Lease::Lease(HttpClientPool& pool, HttpClient& client) : m_pool(&pool), m_client(&client) {
+}
+
+HttpClientPool::Lease::Lease(Lease&& other) : m_pool(other.m_pool), m_client(other.m_client) {
+  other.m_pool = nullptr;
+}
+
+HttpClientPool::Lease::~Lease() {
+  if (m_pool != nullptr) {
+    m_pool->release(*m_client);
+  }
+}
+
+HttpClientPool::HttpClientPool(System::Dispatcher& dispatcher, const std::string& address, uint16_t port, size_t size, size_t reservedCount) :
+  m_reservedCount(reservedCount), m_connected(false), m_released(dispatcher) {
+  assert(size > reservedCount);
+  for (size_t i = 0; i < size; ++i) {
+    m_clients.emplace_back(new HttpClient(dispatcher, address, port));
+    m_idleClients.push_back(m_clients.back().get());
+  }
+
+  m_released.set();
+}
+
+HttpClientPool::~HttpClientPool() {
+  assert(m_idleClients.size() == m_clients.size());
+  m_released.set();
+}
+
+HttpClientPool::Lease HttpClientPool::acquire(bool bulk) {
+  size_t required = bulk ? m_reservedCount + 1 : 1;
+  while (m_idleClients.size() < required) {
+    m_released.clear();
+    m_released.wait();
+  }
+
+  // Prefer the most recently released connection, it is the most likely to still be open
+  HttpClient* client = m_idleClients.back();
+  m_idleClients.pop_back();
+  return Lease(*this, *client);
+}
+
+void HttpClientPool::release(HttpClient& client) {
+  m_connected = client.isConnected();
+  m_idleClients.push_back(&client);
+  m_released.set();
+}
+
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <System/Event.h>
+
+namespace System {
+  class Dispatcher;
+}
+
+namespace CryptoNote {
+
+class HttpClient;
+
+// A fixed set of keep-alive connections to one node, shared by the contexts of a single dispatcher. Each connection
+// carries one request at a time, so up to `size` requests are in flight at once. Bulk requests may only take
+// connections while more than `reservedCount` are idle, which keeps those free for short latency-sensitive calls
+class HttpClientPool {
+public:
+  class Lease {
+  public:
+    Lease(HttpClientPool& pool, HttpClient& client);
+    Lease(Lease&& other);
+    ~Lease();
+    Lease(const Lease&) = delete;
+    Lease& operator=(const Lease&) = delete;
+
+    HttpClient& client() const { return *m_client; }
+
+  private:
+    HttpClientPool* m_pool;
+    HttpClient* m_client;
+  };
+
+  HttpClientPool(System::Dispatcher& dispatcher, const std::string& address, uint16_t port, size_t size, size_t reservedCount);
+  ~HttpClientPool();
+  HttpClientPool(const HttpClientPool&) = delete;
+  HttpClientPool& operator=(const HttpClientPool&) = delete;
+
+  // Blocks the calling context until a connection is available
+  Lease acquire(bool bulk);
+
+  // Whether the connection used by the last completed request is still open
+  bool isConnected() const { return m_connected; }
+
+private:
+  void release(HttpClient& client);
+
+  std::vector<std::unique_ptr<HttpClient>> m_clients;
+  std::vector<HttpClient*> m_idleClients;
+  size_t m_reservedCount;
+  bool m_connected;
+  System::Event m_released;
+};
+
+}
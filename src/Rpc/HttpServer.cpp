@@ -26,6 +26,7 @@
 #include <System/InterruptedException.h>
 #include <System/TcpStream.h>
 #include <System/Ipv4Address.h>
+#include "RpcCompression.h"
 
 using namespace Logging;
 
@@ -110,6 +111,8 @@ void HttpServer::acceptLoop() {
 					fillUnauthorizedResponse(resp);
 				}
 
+      compressResponse(req, resp);
+
       stream << resp;
       stream.flush();
 
@@ -20,6 +20,7 @@
 #include <boost/optional.hpp>
 #include <boost/foreach.hpp>
 #include <functional>
+#include <memory>
 
 #include "CoreRpcServerCommandsDefinitions.h"
 #include <Common/JsonValue.h>
@@ -61,28 +62,28 @@ public:
   std::string message;
 };
 
-typedef boost::optional<Common::JsonValue> OptionalId;
+// Source text of the request id, echoed back in the response as it was received
+typedef boost::optional<std::string> OptionalId;
 
 class JsonRpcRequest {
 public:
   
-  JsonRpcRequest() : psReq(Common::JsonValue::OBJECT) {}
+  JsonRpcRequest() {}
 
   bool parseRequest(const std::string& requestBody) {
     try {
-      psReq = Common::JsonValue::fromString(requestBody);
+      psReq.reset(new JsonTextInputSerializer(requestBody));
     } catch (std::exception&) {
       throw JsonRpcError(errParseError);
     }
 
-    if (!psReq.contains("method")) {
+    if (!(*psReq)(method, "method")) {
       throw JsonRpcError(errInvalidRequest);
     }
 
-    method = psReq("method").getString();
-
-    if (psReq.contains("id")) {
-      id = psReq("id");
+    std::string rawId;
+    if (psReq->getRawValue("id", rawId)) {
+      id = rawId;
     }
 
     return true;
@@ -90,14 +91,24 @@ public:
 
   template <typename T>
   bool loadParams(T& v) const {
-    loadFromJsonValue(v, psReq.contains("params") ? 
-      psReq("params") : Common::JsonValue(Common::JsonValue::NIL));
+    return (*psReq)(v, "params");
+  }
+
+  // Positional parameters have always been accepted both as an array and as an empty object
+  template <typename T>
+  bool loadParams(std::vector<T>& v) const {
+    std::string params;
+    if (!psReq->getRawValue("params", params)) {
+      return false;
+    }
+
+    loadFromJsonValue(v, Common::JsonValue::fromString(params));
     return true;
   }
 
   template <typename T>
   bool setParams(const T& v) {
-    psReq.set("params", storeToJsonValue(v));
+    params = storeToJson(v);
     return true;
   }
 
@@ -114,14 +125,22 @@ public:
   }
 
   std::string getBody() {
-    psReq.set("jsonrpc", std::string("2.0"));
-    psReq.set("method", method);
-    return psReq.toString();
+    JsonTextOutputSerializer s;
+    std::string version("2.0");
+    s(version, "jsonrpc");
+    s(method, "method");
+    if (!params.empty()) {
+      s.rawValue(params, "params");
+    }
+
+    return s.takeText();
   }
 
 private:
 
-  Common::JsonValue psReq;
+  // Parameters are only decoded once the handler asks for them with the right type
+  mutable std::unique_ptr<JsonTextInputSerializer> psReq;
+  std::string params;
   OptionalId id;
   std::string method;
 };
@@ -130,58 +149,63 @@ private:
 class JsonRpcResponse {
 public:
 
-  JsonRpcResponse() : psResp(Common::JsonValue::OBJECT) {}
+  JsonRpcResponse() {}
 
   void parse(const std::string& responseBody) {
     try {
-      psResp = Common::JsonValue::fromString(responseBody);
+      psResp.reset(new JsonTextInputSerializer(responseBody));
     } catch (std::exception&) {
       throw JsonRpcError(errParseError);
     }
   }
 
   void setId(const OptionalId& id) {
-    if (id.is_initialized()) {
-      psResp.insert("id", id.get());
-    }
+    this->id = id;
   }
 
   void setError(const JsonRpcError& err) {
-    psResp.set("error", storeToJsonValue(err));
+    result.clear();
+    error = storeToJson(err);
   }
 
   bool getError(JsonRpcError& err) const {
-    if (!psResp.contains("error")) {
-      return false;
-    }
-
-    loadFromJsonValue(err, psResp("error"));
-    return true;
+    return (*psResp)(err, "error");
   }
 
   std::string getBody() {
-    psResp.set("jsonrpc", std::string("2.0"));
-    return psResp.toString();
+    JsonTextOutputSerializer s;
+    if (id.is_initialized()) {
+      s.rawValue(id.get(), "id");
+    }
+
+    std::string version("2.0");
+    s(version, "jsonrpc");
+    if (!error.empty()) {
+      s.rawValue(error, "error");
+    } else if (!result.empty()) {
+      s.rawValue(result, "result");
+    }
+
+    return s.takeText();
   }
 
+  // The result is rendered right away, so a failure while serializing it cannot leave a half-written body
   template <typename T>
   bool setResult(const T& v) {
-    psResp.set("result", storeToJsonValue(v));
+    result = storeToJson(v);
     return true;
   }
 
   template <typename T>
   bool getResult(T& v) const {
-    if (!psResp.contains("result")) {
-      return false;
-    }
-
-    loadFromJsonValue(v, psResp("result"));
-    return true;
+    return (*psResp)(v, "result");
   }
 
 private:
-  Common::JsonValue psResp;
+  mutable std::unique_ptr<JsonTextInputSerializer> psResp;
+  OptionalId id;
+  std::string result;
+  std::string error;
 };
 
 
@@ -0,0 +1,228 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "RpcCompression.h"
+
+#include <stdexcept>
+
+#include <Common/Lz4.h>
+#include <Common/StringTools.h>
+#include <HTTP/HttpRequest.h>
+#include <HTTP/HttpResponse.h>
+#include "crypto/hash.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "Serialization/SerializationTools.h"
+#include "CoreRpcServerCommandsDefinitions.h"
+
+namespace CryptoNote {
+
+namespace {
+
+// Smaller bodies are dominated by the HTTP headers
+const size_t MIN_COMPRESSED_BODY_SIZE = 512;
+// A body is only sent compressed when that saves at least this share of it, else the client's time is wasted too
+const size_t MIN_COMPRESSION_GAIN_PERCENT = 10;
+const size_t MAX_DECOMPRESSED_BODY_SIZE = 256 * 1024 * 1024;
+const size_t SIZE_PREFIX_SIZE = 4;
+
+Transaction makeSampleBaseTransaction() {
+  Transaction tx;
+  tx.version = 1;
+  tx.unlockTime = 500010;
+  tx.inputs.push_back(BaseInput{ 500000 });
+  for (uint64_t amount : { 7000000ULL, 40000000ULL, 100000000ULL, 2000000000ULL }) {
+    tx.outputs.push_back(TransactionOutput{ amount, KeyOutput() });
+  }
+
+  tx.extra.assign(1 + sizeof(Crypto::PublicKey), 0);
+  tx.extra[0] = 1;
+  return tx;
+}
+
+Transaction makeSampleTransaction() {
+  Transaction tx;
+  tx.version = 1;
+  tx.unlockTime = 0;
+  for (uint64_t amount : { 1000000ULL, 30000000ULL }) {
+    KeyInput input = KeyInput();
+    input.amount = amount;
+    input.outputIndexes = { 1523, 211, 87, 12, 3 };
+    tx.inputs.push_back(input);
+    tx.signatures.push_back(std::vector<Crypto::Signature>(input.outputIndexes.size()));
+  }
+
+  for (uint64_t amount : { 90000ULL, 900000ULL, 20000000ULL }) {
+    tx.outputs.push_back(TransactionOutput{ amount, KeyOutput() });
+  }
+
+  tx.extra.assign(1 + sizeof(Crypto::PublicKey), 0);
+  tx.extra[0] = 1;
+  return tx;
+}
+
+// The field names, type markers and the layout of blocks and transactions repeat in every wallet sync response.
+// Keys, hashes and signatures don't compress, so zeros stand in for them
+std::string makeDictionary() {
+  Block block;
+  block.majorVersion = 1;
+  block.minorVersion = 0;
+  block.nonce = 0;
+  block.timestamp = 1600000000;
+  block.previousBlockHash = NULL_HASH;
+  block.baseTransaction = makeSampleBaseTransaction();
+  Transaction tx = makeSampleTransaction();
+  block.transactionHashes.push_back(getObjectHash(tx));
+
+  COMMAND_RPC_GET_BLOCKS_FAST::response blocks;
+  block_complete_entry blockEntry;
+  blockEntry.block = Common::asString(toBinaryArray(block));
+  blockEntry.txs.push_back(Common::asString(toBinaryArray(tx)));
+  blocks.blocks.push_back(blockEntry);
+  blocks.start_height = 500000;
+  blocks.current_height = 500100;
+  blocks.status = CORE_RPC_STATUS_OK;
+
+  COMMAND_RPC_QUERY_BLOCKS_LITE::response blocksLite;
+  BlockShortInfo blockInfo;
+  blockInfo.blockId = getObjectHash(block);
+  blockInfo.block = blockEntry.block;
+  blockInfo.txPrefixes.push_back(TransactionPrefixInfo{ getObjectHash(tx), tx });
+  blocksLite.items.push_back(blockInfo);
+  blocksLite.status = CORE_RPC_STATUS_OK;
+  blocksLite.startHeight = 500000;
+  blocksLite.currentHeight = 500100;
+  blocksLite.fullOffset = 0;
+
+  // Later bytes are reached with shorter offsets, so the more common response goes last
+  return storeToBinaryKeyValue(blocks) + storeToBinaryKeyValue(blocksLite);
+}
+
+std::string trimSpaces(const std::string& text) {
+  size_t begin = text.find_first_not_of(" \t");
+  if (begin == std::string::npos) {
+    return std::string();
+  }
+
+  return text.substr(begin, text.find_last_not_of(" \t") - begin + 1);
+}
+
+bool acceptsEncoding(const std::string& acceptEncoding, const std::string& encoding) {
+  size_t begin = 0;
+  while (begin < acceptEncoding.size()) {
+    size_t end = acceptEncoding.find(',', begin);
+    if (end == std::string::npos) {
+      end = acceptEncoding.size();
+    }
+
+    std::string coding = acceptEncoding.substr(begin, end - begin);
+    coding = trimSpaces(coding.substr(0, coding.find(';')));
+    if (coding == encoding) {
+      return true;
+    }
+
+    begin = end + 1;
+  }
+
+  return false;
+}
+
+}
+
+const std::string& getRpcCompressionDictionary() {
+  static const std::string dictionary = makeDictionary();
+  return dictionary;
+}
+
+const std::string& getRpcContentEncoding() {
+  static const std::string encoding = [] {
+    const std::string& dictionary = getRpcCompressionDictionary();
+    Crypto::Hash hash = Crypto::cn_fast_hash(dictionary.data(), dictionary.size());
+    return "x-cn-lz4-" + Common::toHex(&hash, 4);
+  }();
+
+  return encoding;
+}
+
+void acceptCompressedResponse(HttpRequest& request) {
+  request.addHeader("Accept-Encoding", getRpcContentEncoding());
+}
+
+void compressResponse(const HttpRequest& request, HttpResponse& response) {
+  if (response.getStatus() != HttpResponse::STATUS_200 || response.getBody().size() < MIN_COMPRESSED_BODY_SIZE) {
+    return;
+  }
+
+  // Full blocks are mostly keys and signatures, which gain about 1% for the time of compressing them
+  if (request.getUrl() == "/getblocks.bin") {
+    return;
+  }
+
+  auto it = request.getHeaders().find("accept-encoding");
+  if (it == request.getHeaders().end() || !acceptsEncoding(it->second, getRpcContentEncoding())) {
+    return;
+  }
+
+  std::string compressed = compressRpcBody(response.getBody());
+  if (compressed.size() * 100 <= response.getBody().size() * (100 - MIN_COMPRESSION_GAIN_PERCENT)) {
+    response.addHeader("Content-Encoding", getRpcContentEncoding());
+    response.setBody(std::move(compressed));
+  }
+}
+
+void decompressResponse(HttpResponse& response) {
+  auto it = response.getHeaders().find("content-encoding");
+  if (it == response.getHeaders().end() || it->second == "identity") {
+    return;
+  }
+
+  if (it->second != getRpcContentEncoding()) {
+    throw std::runtime_error("Unsupported content encoding: " + it->second);
+  }
+
+  std::string body;
+  if (!decompressRpcBody(response.getBody(), body)) {
+    throw std::runtime_error("Failed to decompress response");
+  }
+
+  response.setBody(std::move(body));
+}
+
+// The body is the decompressed size as 4 little-endian bytes followed by an LZ4 block
+std::string compressRpcBody(const std::string& body) {
+  std::string block;
+  Common::lz4Compress(body.data(), body.size(), getRpcCompressionDictionary(), block);
+
+  std::string compressed;
+  compressed.reserve(SIZE_PREFIX_SIZE + block.size());
+  for (size_t i = 0; i < SIZE_PREFIX_SIZE; ++i) {
+    compressed += static_cast<char>(body.size() >> (8 * i));
+  }
+
+  compressed += block;
+  return compressed;
+}
+
+bool decompressRpcBody(const std::string& compressed, std::string& body) {
+  if (compressed.size() < SIZE_PREFIX_SIZE) {
+    return false;
+  }
+
+  size_t size = 0;
+  for (size_t i = 0; i < SIZE_PREFIX_SIZE; ++i) {
+    size |= static_cast<size_t>(static_cast<uint8_t>(compressed[i])) << (8 * i);
+  }
+
+  if (size > MAX_DECOMPRESSED_BODY_SIZE) {
+    return false;
+  }
+
+  return Common::lz4Decompress(compressed.data() + SIZE_PREFIX_SIZE, compressed.size() - SIZE_PREFIX_SIZE, size,
+    getRpcCompressionDictionary(), body);
+}
+
+}
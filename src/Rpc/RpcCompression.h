@@ -0,0 +1,38 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#pragma once
+
+#include <string>
+
+namespace CryptoNote {
+
+class HttpRequest;
+class HttpResponse;
+
+// Negotiated LZ4 compression of RPC response bodies. A client asks for it with an Accept-Encoding header, and the
+// server only compresses when the client named the same content coding. The coding name carries an identifier of the
+// dictionary, so nodes and wallets built with different dictionaries fall back to uncompressed responses
+
+// Content coding name, e.g. "x-cn-lz4-1a2b3c4d"
+const std::string& getRpcContentEncoding();
+// Serialized wallet sync responses with placeholder keys, used to prime the compressor
+const std::string& getRpcCompressionDictionary();
+
+void acceptCompressedResponse(HttpRequest& request);
+// Does nothing unless the request accepts the coding and compression makes the body at least 10% smaller. Responses
+// of /getblocks.bin are never compressed
+void compressResponse(const HttpRequest& request, HttpResponse& response);
+// Throws if the body is encoded with an unknown coding or is malformed
+void decompressResponse(HttpResponse& response);
+
+// The body framing without the HTTP negotiation, for benchmarks
+std::string compressRpcBody(const std::string& body);
+bool decompressRpcBody(const std::string& compressed, std::string& body);
+
+}
@@ -15,6 +15,7 @@
 #include "BlockchainExplorerData.h"
 #include "Common/StringTools.h"
 #include "Common/Base58.h"
+#include "CryptoNoteCore/BlockSummary.h"
 #include "CryptoNoteCore/TransactionUtils.h"
 #include "CryptoNoteCore/CryptoNoteTools.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
@@ -22,6 +23,7 @@
 #include "CryptoNoteCore/IBlock.h"
 #include "CryptoNoteCore/Miner.h"
 #include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/ViewKeyScanner.h"
 #include "CryptoNoteProtocol/ICryptoNoteProtocolQuery.h"
 
 #include "P2p/NetNode.h"
@@ -43,6 +45,9 @@ namespace CryptoNote {
 
 namespace {
 
+// Keeps a response of a wallet that receives a lot of transactions within a few megabytes
+const size_t VIEW_KEY_TRANSACTIONS_LIMIT = 1000;
+
 template <typename Command>
 RpcServer::HandlerFunction binMethod(bool (RpcServer::*handler)(typename Command::request const&, typename Command::response&)) {
   return [handler](RpcServer* obj, const HttpRequest& request, HttpResponse& response) {
@@ -89,6 +94,9 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/getrandom_outs.bin", { binMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false } },
   { "/get_pool_changes.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false } },
   { "/get_pool_changes_lite.bin", { binMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false } },
+  { "/register_view_key.bin", { binMethod<COMMAND_RPC_REGISTER_VIEW_KEY>(&RpcServer::on_register_view_key), false } },
+  { "/unregister_view_key.bin", { binMethod<COMMAND_RPC_UNREGISTER_VIEW_KEY>(&RpcServer::on_unregister_view_key), false } },
+  { "/get_view_key_transactions.bin", { binMethod<COMMAND_RPC_GET_VIEW_KEY_TRANSACTIONS>(&RpcServer::on_get_view_key_transactions), false } },
 
   // json handlers
   { "/getinfo", { jsonMethod<COMMAND_RPC_GET_INFO>(&RpcServer::on_get_info), true } },
@@ -181,8 +189,9 @@ bool RpcServer::processJsonRpcRequest(const HttpRequest& request, HttpResponse&
     jsonResponse.setError(JsonRpcError(JsonRpc::errInternalError, e.what()));
   }
 
-  response.setBody(jsonResponse.getBody());
-  logger(TRACE) << "JSON-RPC response: " << jsonResponse.getBody();
+  std::string body = jsonResponse.getBody();
+  logger(TRACE) << "JSON-RPC response: " << body;
+  response.setBody(std::move(body));
   return true;
 }
 
@@ -577,6 +586,96 @@ bool RpcServer::on_query_blocks_lite(const COMMAND_RPC_QUERY_BLOCKS_LITE::reques
   return true;
 }
 
+bool RpcServer::on_register_view_key(const COMMAND_RPC_REGISTER_VIEW_KEY::request& req, COMMAND_RPC_REGISTER_VIEW_KEY::response& res) {
+  if (m_viewKeyScanner == nullptr) {
+    res.status = "View key scanning is disabled";
+    return false;
+  }
+
+  std::string error;
+  if (!m_viewKeyScanner->addWallet(req.spendPublicKey, req.viewSecretKey, req.startHeight, error)) {
+    res.status = error;
+    return false;
+  }
+
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_unregister_view_key(const COMMAND_RPC_UNREGISTER_VIEW_KEY::request& req, COMMAND_RPC_UNREGISTER_VIEW_KEY::response& res) {
+  if (m_viewKeyScanner == nullptr) {
+    res.status = "View key scanning is disabled";
+    return false;
+  }
+
+  if (!m_viewKeyScanner->removeWallet(req.spendPublicKey, req.viewSecretKey)) {
+    res.status = "Wallet is not registered";
+    return false;
+  }
+
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+bool RpcServer::on_get_view_key_transactions(const COMMAND_RPC_GET_VIEW_KEY_TRANSACTIONS::request& req, COMMAND_RPC_GET_VIEW_KEY_TRANSACTIONS::response& res) {
+  if (m_viewKeyScanner == nullptr) {
+    res.status = "View key scanning is disabled";
+    return false;
+  }
+
+  std::vector<ViewKeyScanner::Match> matches;
+  uint32_t nextHeight;
+  if (!m_viewKeyScanner->getMatches(req.spendPublicKey, req.viewSecretKey, req.startHeight, VIEW_KEY_TRANSACTIONS_LIMIT, matches, nextHeight)) {
+    res.status = "Wallet is not registered";
+    return false;
+  }
+
+  std::vector<Crypto::Hash> transactionHashes;
+  for (const ViewKeyScanner::Match& match : matches) {
+    transactionHashes.push_back(match.transactionHash);
+  }
+
+  std::list<Transaction> transactions;
+  std::list<Crypto::Hash> missedHashes;
+  m_core.getTransactions(transactionHashes, transactions, missedHashes);
+  std::unordered_map<Crypto::Hash, const Transaction*> transactionsByHash;
+  for (const Transaction& transaction : transactions) {
+    transactionsByHash.emplace(getObjectHash(transaction), &transaction);
+  }
+
+  for (const ViewKeyScanner::Match& match : matches) {
+    auto it = transactionsByHash.find(match.transactionHash);
+    if (it == transactionsByHash.end()) {
+      // The block was popped after it was scanned, the scanner rolls the wallet back shortly
+      nextHeight = match.blockHeight;
+      break;
+    }
+
+    ViewKeyTransactionInfo info;
+    info.txHash = match.transactionHash;
+    info.blockHash = match.blockHash;
+    info.blockHeight = match.blockHeight;
+    info.txPrefix = *it->second;
+    info.outputIndexes = match.outputIndexes;
+    info.globalIndexes = match.globalOutputIndexes;
+    info.amount = match.amount;
+    res.transactions.push_back(std::move(info));
+  }
+
+  // Only whole blocks are returned
+  while (!res.transactions.empty() && res.transactions.back().blockHeight >= nextHeight) {
+    res.transactions.pop_back();
+  }
+
+  res.nextHeight = nextHeight;
+  res.status = CORE_RPC_STATUS_OK;
+  return true;
+}
+
+void RpcServer::setViewKeyScanner(ViewKeyScanner* scanner) {
+  m_viewKeyScanner = scanner;
+}
+
 bool RpcServer::setFeeAddress(const std::string fee_address) {
   m_fee_address = fee_address;
   return true;
@@ -729,31 +828,18 @@ bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RP
   res.free_disk_space = m_restricted_rpc ? std::numeric_limits<uint64_t>::max() : m_core.get_free_space();
   res.version = PROJECT_VERSION;
 
-  Block blk;
-  if (!m_core.getBlockByHash(last_block_hash, blk)) {
+  BlockSummary summary;
+  if (!m_core.getBlockSummary(last_block_hash, summary)) {
 	  throw JsonRpc::JsonRpcError{
 		CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
 		"Internal error: can't get last block by hash." };
   }
 
-  if (blk.baseTransaction.inputs.front().type() != typeid(BaseInput)) {
-	  throw JsonRpc::JsonRpcError{
-		CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-		"Internal error: coinbase transaction in the block has the wrong type" };
-  }
-
-  block_header_response block_header;
-  uint32_t last_block_height = boost::get<BaseInput>(blk.baseTransaction.inputs.front()).blockIndex;
-
-  Crypto::Hash tmp_hash = m_core.getBlockIdByHeight(last_block_height);
-  bool is_orphaned = last_block_hash != tmp_hash;
-  fill_block_header_response(blk, is_orphaned, last_block_height, last_block_hash, block_header);
-
-  res.block_major_version = block_header.major_version;
-  res.block_minor_version = block_header.minor_version;
-  res.last_block_timestamp = block_header.timestamp;
-  res.last_block_reward = block_header.reward;
-  m_core.getBlockDifficulty(static_cast<uint32_t>(last_block_height), res.last_block_difficulty);
+  res.block_major_version = summary.majorVersion;
+  res.block_minor_version = summary.minorVersion;
+  res.last_block_timestamp = summary.timestamp;
+  res.last_block_reward = summary.reward;
+  res.last_block_difficulty = summary.difficulty;
 
   res.connections = m_p2p.get_payload_object().all_connections();
   return true;
@@ -780,12 +866,13 @@ bool RpcServer::on_get_transactions(const COMMAND_RPC_GET_TRANSACTIONS::request&
     }
     vh.push_back(*reinterpret_cast<const Hash*>(b.data()));
   }
-  std::list<Hash> missed_txs;
-  std::list<Transaction> txs;
-  m_core.getTransactions(vh, txs, missed_txs);
+  std::vector<Hash> missed_txs;
+  std::vector<BinaryArray> txs;
+  m_core.getTransactionBlobs(vh, txs, missed_txs);
 
-  for (auto& tx : txs) {
-    res.txs_as_hex.push_back(toHex(toBinaryArray(tx)));
+  res.txs_as_hex.reserve(txs.size());
+  for (const auto& tx : txs) {
+    res.txs_as_hex.push_back(toHex(tx));
   }
 
   for (const auto& miss_tx : missed_txs) {
@@ -926,31 +1013,22 @@ bool RpcServer::f_on_blocks_list_json(const F_COMMAND_RPC_GET_BLOCKS_LIST::reque
     last_height = 0;
   }
 
-  for (uint32_t i = req.height; i >= last_height; i--) {
-    Hash block_hash = m_core.getBlockIdByHeight(static_cast<uint32_t>(i));
-    Block blk;
-    if (!m_core.getBlockByHash(block_hash, blk)) {
-      throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-        "Internal error: can't get block by height. Height = " + std::to_string(i) + '.' };
-    }
-
-    size_t tx_cumulative_block_size;
-    m_core.getBlockSize(block_hash, tx_cumulative_block_size);
-    size_t blokBlobSize = getObjectBinarySize(blk);
-    size_t minerTxBlobSize = getObjectBinarySize(blk.baseTransaction);
+  std::vector<BlockSummary> summaries;
+  if (!m_core.getBlockSummaries(last_height, req.height - last_height + 1, summaries)) {
+    throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
+      "Internal error: can't get blocks from height " + std::to_string(last_height) + " to " + std::to_string(req.height) + '.' };
+  }
 
+  for (auto it = summaries.rbegin(); it != summaries.rend(); ++it) {
     f_block_short_response block_short;
-    block_short.cumul_size = blokBlobSize + tx_cumulative_block_size - minerTxBlobSize;
-    block_short.timestamp = blk.timestamp;
-    block_short.height = i;
-    m_core.getBlockDifficulty(static_cast<uint32_t>(block_short.height), block_short.difficulty);
-    block_short.hash = Common::podToHex(block_hash);
-    block_short.tx_count = blk.transactionHashes.size() + 1;
+    block_short.cumul_size = it->blockSize;
+    block_short.timestamp = it->timestamp;
+    block_short.height = it->height;
+    block_short.difficulty = it->difficulty;
+    block_short.hash = Common::podToHex(it->hash);
+    block_short.tx_count = it->transactionCount;
 
     res.blocks.push_back(block_short);
-
-    if (i == 0)
-      break;
   }
 
   res.status = CORE_RPC_STATUS_OK;
@@ -973,48 +1051,25 @@ bool RpcServer::f_on_block_json(const F_COMMAND_RPC_GET_BLOCK_DETAILS::request&
       "Internal error: can't get block by hash. Hash = " + req.hash + '.' };
   }
 
-  if (blk.baseTransaction.inputs.front().type() != typeid(BaseInput)) {
-    throw JsonRpc::JsonRpcError{
-      CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-      "Internal error: coinbase transaction in the block has the wrong type" };
+  BlockSummary summary;
+  if (!m_core.getBlockSummary(hash, summary)) {
+    return false;
   }
 
-  block_header_response block_header;
-  res.block.height = boost::get<BaseInput>(blk.baseTransaction.inputs.front()).blockIndex;
-  fill_block_header_response(blk, false, res.block.height, hash, block_header);
-
-  res.block.major_version = block_header.major_version;
-  res.block.minor_version = block_header.minor_version;
-  res.block.timestamp = block_header.timestamp;
-  res.block.prev_hash = block_header.prev_hash;
-  res.block.nonce = block_header.nonce;
+  res.block.height = summary.height;
+  res.block.major_version = summary.majorVersion;
+  res.block.minor_version = summary.minorVersion;
+  res.block.timestamp = summary.timestamp;
+  res.block.prev_hash = Common::podToHex(summary.previousBlockHash);
+  res.block.nonce = summary.nonce;
   res.block.hash = Common::podToHex(hash);
   res.block.depth = m_core.get_current_blockchain_height() - res.block.height - 1;
-  m_core.getBlockDifficulty(static_cast<uint32_t>(res.block.height), res.block.difficulty);
-
-  res.block.reward = block_header.reward;
-
-  std::vector<size_t> blocksSizes;
-  if (!m_core.getBackwardBlocksSizes(res.block.height, blocksSizes, parameters::REWARD_BLOCKS_WINDOW)) {
-    return false;
-  }
-  res.block.sizeMedian = Common::medianValue(blocksSizes);
-
-  size_t blockSize = 0;
-  if (!m_core.getBlockSize(hash, blockSize)) {
-    return false;
-  }
-  res.block.transactionsCumulativeSize = blockSize;
-
-  size_t blokBlobSize = getObjectBinarySize(blk);
-  size_t minerTxBlobSize = getObjectBinarySize(blk.baseTransaction);
-  res.block.blockSize = blokBlobSize + res.block.transactionsCumulativeSize - minerTxBlobSize;
-
-  uint64_t alreadyGeneratedCoins;
-  if (!m_core.getAlreadyGeneratedCoins(hash, alreadyGeneratedCoins)) {
-    return false;
-  }
-  res.block.alreadyGeneratedCoins = std::to_string(alreadyGeneratedCoins);
+  res.block.difficulty = summary.difficulty;
+  res.block.reward = summary.reward;
+  res.block.sizeMedian = summary.sizeMedian;
+  res.block.transactionsCumulativeSize = summary.transactionsCumulativeSize;
+  res.block.blockSize = summary.blockSize;
+  res.block.alreadyGeneratedCoins = std::to_string(summary.alreadyGeneratedCoins);
 
   if (!m_core.getGeneratedTransactionsNumber(res.block.height, res.block.alreadyGeneratedTransactions)) {
     return false;
@@ -1060,10 +1115,13 @@ bool RpcServer::f_on_block_json(const F_COMMAND_RPC_GET_BLOCK_DETAILS::request&
 
   // Base transaction adding
   f_transaction_short_response transaction_short;
-  transaction_short.hash = Common::podToHex(getObjectHash(blk.baseTransaction));
+  Crypto::Hash baseTransactionHash;
+  size_t blobSize;
+  getObjectHash(blk.baseTransaction, baseTransactionHash, blobSize);
+  transaction_short.size = blobSize;
+  transaction_short.hash = Common::podToHex(baseTransactionHash);
   transaction_short.fee = 0;
   transaction_short.amount_out = get_outs_money_amount(blk.baseTransaction);
-  transaction_short.size = getObjectBinarySize(blk.baseTransaction);
   res.block.transactions.push_back(transaction_short);
 
 
@@ -1079,13 +1137,16 @@ bool RpcServer::f_on_block_json(const F_COMMAND_RPC_GET_BLOCK_DETAILS::request&
     get_inputs_money_amount(tx, amount_in);
     uint64_t amount_out = get_outs_money_amount(tx);
 
-    transaction_short.hash = Common::podToHex(getObjectHash(tx));
+    Crypto::Hash transactionHash;
+    size_t blobSize;
+    getObjectHash(tx, transactionHash, blobSize);
+    transaction_short.size = blobSize;
+    transaction_short.hash = Common::podToHex(transactionHash);
     transaction_short.fee =
 			amount_in < amount_out + parameters::MINIMUM_FEE //account for interest in output, it always has minimum fee
 			? parameters::MINIMUM_FEE
 			: amount_in - amount_out;
     transaction_short.amount_out = amount_out;
-    transaction_short.size = getObjectBinarySize(tx);
     res.block.transactions.push_back(transaction_short);
 
     res.block.totalFeeAmount += transaction_short.fee;
@@ -1107,13 +1168,11 @@ bool RpcServer::f_on_transaction_json(const F_COMMAND_RPC_GET_TRANSACTION_DETAIL
   std::vector<Crypto::Hash> tx_ids;
   tx_ids.push_back(hash);
 
-  std::list<Crypto::Hash> missed_txs;
-  std::list<Transaction> txs;
-  m_core.getTransactions(tx_ids, txs, missed_txs);
+  std::vector<Crypto::Hash> missed_txs;
+  std::vector<BinaryArray> txs;
+  m_core.getTransactionBlobs(tx_ids, txs, missed_txs);
 
-  if (1 == txs.size()) {
-    res.tx = txs.front();
-  } else {
+  if (1 != txs.size() || !fromBinaryArray(res.tx, txs.front())) {
     throw JsonRpc::JsonRpcError{
       CORE_RPC_ERROR_CODE_WRONG_PARAM,
       "transaction wasn't found. Hash = " + req.hash + '.' };
@@ -1122,20 +1181,14 @@ bool RpcServer::f_on_transaction_json(const F_COMMAND_RPC_GET_TRANSACTION_DETAIL
   Crypto::Hash blockHash;
   uint32_t blockHeight;
   if (m_core.getBlockContainingTx(hash, blockHash, blockHeight)) {
-    Block blk;
-    if (m_core.getBlockByHash(blockHash, blk)) {
-      size_t tx_cumulative_block_size;
-      m_core.getBlockSize(blockHash, tx_cumulative_block_size);
-      size_t blokBlobSize = getObjectBinarySize(blk);
-      size_t minerTxBlobSize = getObjectBinarySize(blk.baseTransaction);
+    BlockSummary summary;
+    if (m_core.getBlockSummary(blockHash, summary)) {
       f_block_short_response block_short;
-
-      block_short.cumul_size = blokBlobSize + tx_cumulative_block_size - minerTxBlobSize;
-      block_short.timestamp = blk.timestamp;
+      block_short.cumul_size = summary.blockSize;
+      block_short.timestamp = summary.timestamp;
       block_short.height = blockHeight;
       block_short.hash = Common::podToHex(blockHash);
-      block_short.cumul_size = blokBlobSize + tx_cumulative_block_size - minerTxBlobSize;
-      block_short.tx_count = blk.transactionHashes.size() + 1;
+      block_short.tx_count = summary.transactionCount;
       res.block = block_short;
     }
   }
@@ -1144,7 +1197,8 @@ bool RpcServer::f_on_transaction_json(const F_COMMAND_RPC_GET_TRANSACTION_DETAIL
   get_inputs_money_amount(res.tx, amount_in);
   uint64_t amount_out = get_outs_money_amount(res.tx);
 
-  res.txDetails.hash = Common::podToHex(getObjectHash(res.tx));
+  res.txDetails.size = txs.front().size();
+  res.txDetails.hash = Common::podToHex(getBinaryArrayHash(txs.front()));
   if (amount_in == 0)
     res.txDetails.fee = 0;
   else {
@@ -1154,7 +1208,6 @@ bool RpcServer::f_on_transaction_json(const F_COMMAND_RPC_GET_TRANSACTION_DETAIL
 		: amount_in - amount_out;
   }
   res.txDetails.amount_out = amount_out;
-  res.txDetails.size = getObjectBinarySize(res.tx);
 
   uint64_t mixin;
   if (!f_getMixin(res.tx, mixin)) {
@@ -1194,13 +1247,16 @@ bool RpcServer::f_on_transactions_pool_json(const F_COMMAND_RPC_GET_POOL::reques
         uint64_t amount_in = getInputAmount(tx);
         uint64_t amount_out = getOutputAmount(tx);
 
-        transaction_short.hash = Common::podToHex(getObjectHash(tx));
+        Crypto::Hash transactionHash;
+        size_t blobSize;
+        getObjectHash(tx, transactionHash, blobSize);
+        transaction_short.size = blobSize;
+        transaction_short.hash = Common::podToHex(transactionHash);
         transaction_short.fee =
 			amount_in < amount_out + parameters::MINIMUM_FEE //account for interest in output, it always has minimum fee
 			? parameters::MINIMUM_FEE
 			: amount_in - amount_out;
         transaction_short.amount_out = amount_out;
-        transaction_short.size = getObjectBinarySize(tx);
         res.transactions.push_back(transaction_short);
     }
 
@@ -1325,29 +1381,19 @@ bool RpcServer::on_submitblock(const COMMAND_RPC_SUBMITBLOCK::request& req, COMM
 }
 
 
-namespace {
-  uint64_t get_block_reward(const Block& blk) {
-    uint64_t reward = 0;
-    for (const TransactionOutput& out : blk.baseTransaction.outputs) {
-      reward += out.amount;
-    }
-    return reward;
-  }
-}
-
-void RpcServer::fill_block_header_response(const Block& blk, bool orphan_status, uint64_t height, const Hash& hash, block_header_response& responce) {
-  responce.major_version = blk.majorVersion;
-  responce.minor_version = blk.minorVersion;
-  responce.timestamp = blk.timestamp;
-  responce.prev_hash = Common::podToHex(blk.previousBlockHash);
-  responce.nonce = blk.nonce;
+void RpcServer::fill_block_header_response(const BlockSummary& summary, bool orphan_status, block_header_response& responce) {
+  responce.major_version = summary.majorVersion;
+  responce.minor_version = summary.minorVersion;
+  responce.timestamp = summary.timestamp;
+  responce.prev_hash = Common::podToHex(summary.previousBlockHash);
+  responce.nonce = summary.nonce;
   responce.orphan_status = orphan_status;
-  responce.height = height;
-  responce.deposits = m_core.depositAmountAtHeight(height);
-  responce.depth = m_core.get_current_blockchain_height() - height - 1;
-  responce.hash = Common::podToHex(hash);
-  m_core.getBlockDifficulty(static_cast<uint32_t>(height), responce.difficulty);
-  responce.reward = get_block_reward(blk);
+  responce.height = summary.height;
+  responce.deposits = summary.depositAmount;
+  responce.depth = m_core.get_current_blockchain_height() - summary.height - 1;
+  responce.hash = Common::podToHex(summary.hash);
+  responce.difficulty = summary.difficulty;
+  responce.reward = summary.reward;
 }
 
 bool RpcServer::on_get_last_block_header(const COMMAND_RPC_GET_LAST_BLOCK_HEADER::request& req, COMMAND_RPC_GET_LAST_BLOCK_HEADER::response& res) {
@@ -1356,12 +1402,12 @@ bool RpcServer::on_get_last_block_header(const COMMAND_RPC_GET_LAST_BLOCK_HEADER
 
   m_core.get_blockchain_top(last_block_height, last_block_hash);
 
-  Block last_block;
-  if (!m_core.getBlockByHash(last_block_hash, last_block)) {
+  BlockSummary summary;
+  if (!m_core.getBlockSummary(last_block_hash, summary)) {
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR, "Internal error: can't get last block hash." };
   }
 
-  fill_block_header_response(last_block, false, last_block_height, last_block_hash, res.block_header);
+  fill_block_header_response(summary, false, res.block_header);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -1375,21 +1421,14 @@ bool RpcServer::on_get_block_header_by_hash(const COMMAND_RPC_GET_BLOCK_HEADER_B
       "Failed to parse hex representation of block hash. Hex = " + req.hash + '.' };
   }
 
-  Block blk;
-  if (!m_core.getBlockByHash(block_hash, blk)) {
+  BlockSummary summary;
+  if (!m_core.getBlockSummary(block_hash, summary)) {
     throw JsonRpc::JsonRpcError{
       CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
       "Internal error: can't get block by hash. Hash = " + req.hash + '.' };
   }
 
-  if (blk.baseTransaction.inputs.front().type() != typeid(BaseInput)) {
-    throw JsonRpc::JsonRpcError{
-      CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
-      "Internal error: coinbase transaction in the block has the wrong type" };
-  }
-
-  uint64_t block_height = boost::get<BaseInput>(blk.baseTransaction.inputs.front()).blockIndex;
-  fill_block_header_response(blk, false, block_height, block_hash, res.block_header);
+  fill_block_header_response(summary, false, res.block_header);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -1400,14 +1439,13 @@ bool RpcServer::on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER
       std::string("To big height: ") + std::to_string(req.height) + ", current blockchain height = " + std::to_string(m_core.get_current_blockchain_height()) };
   }
 
-  Hash block_hash = m_core.getBlockIdByHeight(static_cast<uint32_t>(req.height));
-  Block blk;
-  if (!m_core.getBlockByHash(block_hash, blk)) {
+  std::vector<BlockSummary> summaries;
+  if (!m_core.getBlockSummaries(static_cast<uint32_t>(req.height), 1, summaries)) {
     throw JsonRpc::JsonRpcError{ CORE_RPC_ERROR_CODE_INTERNAL_ERROR,
       "Internal error: can't get block by height. Height = " + std::to_string(req.height) + '.' };
   }
 
-  fill_block_header_response(blk, false, req.height, block_hash, res.block_header);
+  fill_block_header_response(summaries.front(), false, res.block_header);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -22,6 +22,8 @@ namespace CryptoNote {
 class core;
 class NodeServer;
 class ICryptoNoteProtocolQuery;
+class ViewKeyScanner;
+struct BlockSummary;
 
 class RpcServer : public HttpServer {
 public:
@@ -36,6 +38,8 @@ public:
   bool enableCors(const std::string domain);  
   bool remotenode_check_incoming_tx(const BinaryArray& tx_blob);
   bool setNodeInfo(const std::string& nodeInfo);
+  // The view-key RPC methods fail unless a scanner is set
+  void setViewKeyScanner(ViewKeyScanner* scanner);
 
 private:
 
@@ -60,6 +64,9 @@ private:
   bool on_get_random_outs(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res);
   bool onGetPoolChanges(const COMMAND_RPC_GET_POOL_CHANGES::request& req, COMMAND_RPC_GET_POOL_CHANGES::response& rsp);
   bool onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::request& req, COMMAND_RPC_GET_POOL_CHANGES_LITE::response& rsp);
+  bool on_register_view_key(const COMMAND_RPC_REGISTER_VIEW_KEY::request& req, COMMAND_RPC_REGISTER_VIEW_KEY::response& res);
+  bool on_unregister_view_key(const COMMAND_RPC_UNREGISTER_VIEW_KEY::request& req, COMMAND_RPC_UNREGISTER_VIEW_KEY::response& res);
+  bool on_get_view_key_transactions(const COMMAND_RPC_GET_VIEW_KEY_TRANSACTIONS::request& req, COMMAND_RPC_GET_VIEW_KEY_TRANSACTIONS::response& res);
 
   // json handlers
   bool on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RPC_GET_INFO::response& res);
@@ -84,7 +91,7 @@ private:
   bool on_get_block_header_by_hash(const COMMAND_RPC_GET_BLOCK_HEADER_BY_HASH::request& req, COMMAND_RPC_GET_BLOCK_HEADER_BY_HASH::response& res);
   bool on_get_block_header_by_height(const COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT::request& req, COMMAND_RPC_GET_BLOCK_HEADER_BY_HEIGHT::response& res);
 
-  void fill_block_header_response(const Block& blk, bool orphan_status, uint64_t height, const Crypto::Hash& hash, block_header_response& responce);
+  void fill_block_header_response(const BlockSummary& summary, bool orphan_status, block_header_response& responce);
 
   bool f_on_blocks_list_json(const F_COMMAND_RPC_GET_BLOCKS_LIST::request& req, F_COMMAND_RPC_GET_BLOCKS_LIST::response& res);
   bool f_on_block_json(const F_COMMAND_RPC_GET_BLOCK_DETAILS::request& req, F_COMMAND_RPC_GET_BLOCK_DETAILS::response& res);
@@ -103,6 +110,7 @@ private:
   Crypto::SecretKey m_view_key = NULL_SECRET_KEY;
   AccountPublicAddress m_fee_acc;
   std::string m_node_info;
+  ViewKeyScanner* m_viewKeyScanner = nullptr;
 };
 
 }
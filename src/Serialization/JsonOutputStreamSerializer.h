@@ -47,6 +47,10 @@ public:
     return root;
   }
 
+  Common::JsonValue& getValue() {
+    return root;
+  }
+
   friend std::ostream& operator<<(std::ostream& out, const JsonOutputStreamSerializer& enumerator);
 
 private:
@@ -0,0 +1,366 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "JsonReader.h"
+
+#include <cctype>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace CryptoNote {
+
+namespace {
+
+bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+uint32_t readHexQuad(const char*& position, const char* end) {
+  if (end - position < 4) {
+    throw std::runtime_error("Unable to parse: truncated escape sequence");
+  }
+
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    char c = *position++;
+    value <<= 4;
+    if (c >= '0' && c <= '9') {
+      value |= static_cast<uint32_t>(c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      value |= static_cast<uint32_t>(c - 'a' + 10);
+    } else if (c >= 'A' && c <= 'F') {
+      value |= static_cast<uint32_t>(c - 'A' + 10);
+    } else {
+      throw std::runtime_error("Unable to parse: invalid escape sequence");
+    }
+  }
+
+  return value;
+}
+
+void appendUtf8(uint32_t codePoint, std::string& result) {
+  if (codePoint < 0x80) {
+    result += static_cast<char>(codePoint);
+  } else if (codePoint < 0x800) {
+    result += static_cast<char>(0xc0 | (codePoint >> 6));
+    result += static_cast<char>(0x80 | (codePoint & 0x3f));
+  } else if (codePoint < 0x10000) {
+    result += static_cast<char>(0xe0 | (codePoint >> 12));
+    result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+    result += static_cast<char>(0x80 | (codePoint & 0x3f));
+  } else {
+    result += static_cast<char>(0xf0 | (codePoint >> 18));
+    result += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3f));
+    result += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3f));
+    result += static_cast<char>(0x80 | (codePoint & 0x3f));
+  }
+}
+
+class Parser {
+public:
+  Parser(const char* data, size_t size, JsonReader::Handler& handler) : data(data), size(size), position(0), handler(handler) {
+  }
+
+  size_t parse() {
+    for (;;) {
+      char c = next();
+      if (c == '{' || c == '[') {
+        if (containers.size() >= JsonReader::MAX_NESTING_DEPTH) {
+          throw std::runtime_error("Unable to parse: nesting is too deep");
+        }
+
+        bool isObject = c == '{';
+        if (isObject) {
+          handler.beginObject(position);
+        } else {
+          handler.beginArray(position);
+        }
+
+        ++position;
+        containers.push_back(isObject);
+        if (next() != (isObject ? '}' : ']')) {
+          if (isObject) {
+            readKey();
+          }
+
+          continue;
+        }
+
+        closeContainer();
+      } else {
+        readScalar(c);
+      }
+
+      // A value is complete: either more members follow or enclosing containers end
+      for (;;) {
+        if (containers.empty()) {
+          return position;
+        }
+
+        c = next();
+        if (c == ',') {
+          ++position;
+          if (containers.back()) {
+            readKey();
+          }
+
+          break;
+        }
+
+        if (c != (containers.back() ? '}' : ']')) {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        closeContainer();
+      }
+    }
+  }
+
+private:
+  char next() {
+    while (position < size && isspace(static_cast<unsigned char>(data[position]))) {
+      ++position;
+    }
+
+    if (position >= size) {
+      throw std::runtime_error("Unable to parse: unexpected end of stream");
+    }
+
+    return data[position];
+  }
+
+  void closeContainer() {
+    ++position;
+    if (containers.back()) {
+      handler.endObject(position);
+    } else {
+      handler.endArray(position);
+    }
+
+    containers.pop_back();
+  }
+
+  // Returns the offset of the closing quote of the string starting at the current position
+  size_t findStringEnd() const {
+    size_t i = position + 1;
+    for (;;) {
+      if (i >= size) {
+        throw std::runtime_error("Unable to parse: unexpected end of stream");
+      }
+
+      char c = data[i];
+      if (c == '"') {
+        return i;
+      }
+
+      i += c == '\\' ? 2 : 1;
+    }
+  }
+
+  void readKey() {
+    if (next() != '"') {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    size_t end = findStringEnd();
+    handler.key(position + 1, end);
+    position = end + 1;
+    if (next() != ':') {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    ++position;
+  }
+
+  void readLiteral(const char* text, size_t length, JsonReader::ScalarType type) {
+    if (size - position < length || memcmp(data + position, text, length) != 0) {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    handler.scalar(type, position, position + length);
+    position += length;
+  }
+
+  void readNumber() {
+    size_t begin = position;
+    bool isInteger = true;
+    if (data[position] == '-') {
+      ++position;
+    }
+
+    size_t digits = skipDigits();
+    if (digits == 0 || (digits > 1 && data[position - digits] == '0')) {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    if (position < size && data[position] == '.') {
+      isInteger = false;
+      ++position;
+      skipDigits();
+    }
+
+    if (position < size && (data[position] == 'e' || data[position] == 'E')) {
+      isInteger = false;
+      ++position;
+      if (position < size && (data[position] == '+' || data[position] == '-')) {
+        ++position;
+      }
+
+      if (skipDigits() == 0) {
+        throw std::runtime_error("Unable to parse");
+      }
+    }
+
+    handler.scalar(isInteger ? JsonReader::INTEGER : JsonReader::REAL, begin, position);
+  }
+
+  size_t skipDigits() {
+    size_t begin = position;
+    while (position < size && isDigit(data[position])) {
+      ++position;
+    }
+
+    return position - begin;
+  }
+
+  void readScalar(char c) {
+    switch (c) {
+    case '"': {
+      size_t end = findStringEnd() + 1;
+      handler.scalar(JsonReader::STRING, position, end);
+      position = end;
+      break;
+    }
+    case 't':
+      readLiteral("true", 4, JsonReader::TRUE_LITERAL);
+      break;
+    case 'f':
+      readLiteral("false", 5, JsonReader::FALSE_LITERAL);
+      break;
+    case 'n':
+      readLiteral("null", 4, JsonReader::NULL_LITERAL);
+      break;
+    default:
+      if (c != '-' && !isDigit(c)) {
+        throw std::runtime_error("Unable to parse");
+      }
+
+      readNumber();
+      break;
+    }
+  }
+
+  const char* data;
+  size_t size;
+  size_t position;
+  JsonReader::Handler& handler;
+  std::vector<bool> containers;
+};
+
+}
+
+const size_t JsonReader::MAX_NESTING_DEPTH;
+
+size_t JsonReader::parse(const char* data, size_t size, Handler& handler) {
+  Parser parser(data, size, handler);
+  return parser.parse();
+}
+
+void JsonReader::unescape(const char* begin, const char* end, std::string& result) {
+  result.clear();
+  result.reserve(end - begin);
+  while (begin != end) {
+    const char* escape = static_cast<const char*>(memchr(begin, '\\', end - begin));
+    if (escape == nullptr) {
+      result.append(begin, end);
+      return;
+    }
+
+    result.append(begin, escape);
+    begin = escape + 1;
+    if (begin == end) {
+      throw std::runtime_error("Unable to parse: truncated escape sequence");
+    }
+
+    switch (*begin++) {
+    case '"': result += '"'; break;
+    case '\\': result += '\\'; break;
+    case '/': result += '/'; break;
+    case 'b': result += '\b'; break;
+    case 'f': result += '\f'; break;
+    case 'n': result += '\n'; break;
+    case 'r': result += '\r'; break;
+    case 't': result += '\t'; break;
+    case 'u': {
+      uint32_t codePoint = readHexQuad(begin, end);
+      if (codePoint >= 0xd800 && codePoint < 0xdc00 && end - begin >= 6 && begin[0] == '\\' && begin[1] == 'u') {
+        const char* lowPosition = begin + 2;
+        uint32_t low = readHexQuad(lowPosition, end);
+        if (low >= 0xdc00 && low < 0xe000) {
+          codePoint = 0x10000 + ((codePoint - 0xd800) << 10) + (low - 0xdc00);
+          begin = lowPosition;
+        }
+      }
+
+      appendUtf8(codePoint, result);
+      break;
+    }
+    default:
+      throw std::runtime_error("Unable to parse: invalid escape sequence");
+    }
+  }
+}
+
+int64_t JsonReader::parseInteger(const char* begin, const char* end) {
+  bool negative = begin != end && *begin == '-';
+  if (negative) {
+    ++begin;
+  }
+
+  if (begin == end) {
+    throw std::runtime_error("Unable to parse integer");
+  }
+
+  uint64_t value = 0;
+  for (; begin != end; ++begin) {
+    if (!isDigit(*begin)) {
+      throw std::runtime_error("Unable to parse integer");
+    }
+
+    uint64_t digit = static_cast<uint64_t>(*begin - '0');
+    if (value > (UINT64_MAX - digit) / 10) {
+      throw std::runtime_error("Integer is out of range");
+    }
+
+    value = value * 10 + digit;
+  }
+
+  if (negative) {
+    if (value > static_cast<uint64_t>(INT64_MAX) + 1) {
+      throw std::runtime_error("Integer is out of range");
+    }
+
+    return static_cast<int64_t>(0 - value);
+  }
+
+  // Values above INT64_MAX keep their unsigned bit pattern, so they still read back into unsigned fields
+  return static_cast<int64_t>(value);
+}
+
+double JsonReader::parseReal(const char* begin, const char* end) {
+  double value;
+  std::istringstream stream(std::string(begin, end));
+  stream >> value;
+  if (stream.fail()) {
+    throw std::runtime_error("Unable to parse real number");
+  }
+
+  return value;
+}
+
+}
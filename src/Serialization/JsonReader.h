@@ -0,0 +1,54 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace CryptoNote {
+
+// Event-driven JSON parser. Values are reported to the handler in document order as offsets into the parsed
+// text, so nothing is copied or allocated per value. Throws std::runtime_error on malformed input
+class JsonReader {
+public:
+  enum ScalarType {
+    NULL_LITERAL,
+    FALSE_LITERAL,
+    TRUE_LITERAL,
+    INTEGER,
+    REAL,
+    STRING
+  };
+
+  class Handler {
+  public:
+    virtual ~Handler() {}
+
+    // 'begin' is the offset of the opening bracket, 'end' is the offset just past the closing one
+    virtual void beginObject(size_t begin) = 0;
+    virtual void endObject(size_t end) = 0;
+    virtual void beginArray(size_t begin) = 0;
+    virtual void endArray(size_t end) = 0;
+
+    // Member names are reported without quotes, strings with them. Escape sequences are left as they are
+    virtual void key(size_t begin, size_t end) = 0;
+    virtual void scalar(ScalarType type, size_t begin, size_t end) = 0;
+  };
+
+  static const size_t MAX_NESTING_DEPTH = 512;
+
+  // Parses the first value of the text and returns the offset just past it
+  static size_t parse(const char* data, size_t size, Handler& handler);
+
+  // Decode a string reported by the parser, 'begin' and 'end' exclude the quotes
+  static void unescape(const char* begin, const char* end, std::string& result);
+  static int64_t parseInteger(const char* begin, const char* end);
+  static double parseReal(const char* begin, const char* end);
+};
+
+}
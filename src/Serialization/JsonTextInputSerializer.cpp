@@ -0,0 +1,307 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "JsonTextInputSerializer.h"
+
+#include <cassert>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+class JsonTextInputSerializer::TokenBuilder : public JsonReader::Handler {
+public:
+  explicit TokenBuilder(std::vector<Token>& tokens) : tokens(tokens) {
+  }
+
+  virtual void beginObject(size_t begin) override {
+    openContainer(OBJECT, begin);
+  }
+
+  virtual void endObject(size_t end) override {
+    closeContainer(end);
+  }
+
+  virtual void beginArray(size_t begin) override {
+    openContainer(ARRAY, begin);
+  }
+
+  virtual void endArray(size_t end) override {
+    closeContainer(end);
+  }
+
+  virtual void key(size_t begin, size_t end) override {
+    tokens.push_back({ KEY, JsonReader::NULL_LITERAL, begin, end, tokens.size() + 1, 0 });
+  }
+
+  virtual void scalar(JsonReader::ScalarType type, size_t begin, size_t end) override {
+    countItem();
+    tokens.push_back({ SCALAR, type, begin, end, tokens.size() + 1, 0 });
+  }
+
+private:
+  void countItem() {
+    if (!containers.empty() && tokens[containers.back()].type == ARRAY) {
+      ++tokens[containers.back()].itemCount;
+    }
+  }
+
+  void openContainer(TokenType type, size_t begin) {
+    countItem();
+    containers.push_back(tokens.size());
+    tokens.push_back({ type, JsonReader::NULL_LITERAL, begin, begin, 0, 0 });
+  }
+
+  void closeContainer(size_t end) {
+    Token& token = tokens[containers.back()];
+    token.end = end;
+    token.next = tokens.size();
+    containers.pop_back();
+  }
+
+  std::vector<Token>& tokens;
+  std::vector<size_t> containers;
+};
+
+JsonTextInputSerializer::JsonTextInputSerializer(std::string text) : m_text(std::move(text)), m_data(m_text.data()), m_size(m_text.size()) {
+  parse();
+}
+
+JsonTextInputSerializer::JsonTextInputSerializer(const char* data, size_t size) : m_data(data), m_size(size) {
+  parse();
+}
+
+ISerializer::SerializerType JsonTextInputSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool JsonTextInputSerializer::beginObject(Common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  if (token->type != OBJECT) {
+    throw std::runtime_error("JSON value type is not OBJECT");
+  }
+
+  size_t index = token - m_tokens.data();
+  m_frames.push_back({ index, index + 1 });
+  return true;
+}
+
+void JsonTextInputSerializer::endObject() {
+  assert(m_frames.size() > 1);
+  m_frames.pop_back();
+}
+
+bool JsonTextInputSerializer::beginArray(size_t& size, Common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    size = 0;
+    return false;
+  }
+
+  if (token->type != ARRAY) {
+    throw std::runtime_error("JSON value type is not ARRAY");
+  }
+
+  size = token->itemCount;
+  size_t index = token - m_tokens.data();
+  m_frames.push_back({ index, index + 1 });
+  return true;
+}
+
+void JsonTextInputSerializer::endArray() {
+  assert(m_frames.size() > 1);
+  m_frames.pop_back();
+}
+
+bool JsonTextInputSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonTextInputSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonTextInputSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonTextInputSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonTextInputSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonTextInputSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonTextInputSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonTextInputSerializer::operator()(double& value, Common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  if (token->type == SCALAR && token->scalarType == JsonReader::INTEGER) {
+    value = static_cast<double>(JsonReader::parseInteger(m_data + token->begin, m_data + token->end));
+  } else if (token->type == SCALAR && token->scalarType == JsonReader::REAL) {
+    value = JsonReader::parseReal(m_data + token->begin, m_data + token->end);
+  } else {
+    throw std::runtime_error("JSON value type is not REAL");
+  }
+
+  return true;
+}
+
+bool JsonTextInputSerializer::operator()(bool& value, Common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  if (token->type != SCALAR || (token->scalarType != JsonReader::TRUE_LITERAL && token->scalarType != JsonReader::FALSE_LITERAL)) {
+    throw std::runtime_error("JSON value type is not BOOL");
+  }
+
+  value = token->scalarType == JsonReader::TRUE_LITERAL;
+  return true;
+}
+
+bool JsonTextInputSerializer::operator()(std::string& value, Common::StringView name) {
+  const Token* token = getString(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  JsonReader::unescape(m_data + token->begin + 1, m_data + token->end - 1, value);
+  return true;
+}
+
+bool JsonTextInputSerializer::binary(void* value, size_t size, Common::StringView name) {
+  const Token* token = getString(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  JsonReader::unescape(m_data + token->begin + 1, m_data + token->end - 1, m_buffer);
+  Common::fromHex(m_buffer, value, size);
+  return true;
+}
+
+bool JsonTextInputSerializer::binary(std::string& value, Common::StringView name) {
+  const Token* token = getString(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  JsonReader::unescape(m_data + token->begin + 1, m_data + token->end - 1, m_buffer);
+  value = Common::asString(Common::fromHex(m_buffer));
+  return true;
+}
+
+bool JsonTextInputSerializer::getRawValue(Common::StringView name, std::string& json) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  json.assign(m_data + token->begin, token->end - token->begin);
+  return true;
+}
+
+void JsonTextInputSerializer::parse() {
+  m_tokens.reserve(m_size / 16);
+  TokenBuilder builder(m_tokens);
+  size_t end = JsonReader::parse(m_data, m_size, builder);
+  while (end < m_size && isspace(static_cast<unsigned char>(m_data[end]))) {
+    ++end;
+  }
+
+  if (end != m_size) {
+    throw std::runtime_error("Unable to parse: unexpected data after the root value");
+  }
+
+  if (m_tokens.front().type != OBJECT) {
+    throw std::runtime_error("Serializer doesn't support this type of serialization: Object expected.");
+  }
+
+  m_frames.push_back({ 0, 1 });
+}
+
+const JsonTextInputSerializer::Token* JsonTextInputSerializer::findMember(Common::StringView name) const {
+  const Token& object = m_tokens[m_frames.back().token];
+  const Token* member = nullptr;
+
+  // Later duplicates replace earlier ones, as they did when requests were parsed into a JsonValue
+  std::string unescapedKey;
+  for (size_t i = m_frames.back().token + 1; i < object.next; i = m_tokens[i + 1].next) {
+    const Token& key = m_tokens[i];
+    const char* keyData = m_data + key.begin;
+    size_t keySize = key.end - key.begin;
+    if (memchr(keyData, '\\', keySize) != nullptr) {
+      JsonReader::unescape(keyData, keyData + keySize, unescapedKey);
+      keyData = unescapedKey.data();
+      keySize = unescapedKey.size();
+    }
+
+    if (keySize == name.getSize() && memcmp(keyData, name.getData(), name.getSize()) == 0) {
+      member = &m_tokens[i + 1];
+    }
+  }
+
+  return member;
+}
+
+const JsonTextInputSerializer::Token* JsonTextInputSerializer::getValue(Common::StringView name) {
+  Frame& frame = m_frames.back();
+  const Token& container = m_tokens[frame.token];
+  if (container.type != ARRAY) {
+    return findMember(name);
+  }
+
+  if (frame.nextItem >= container.next) {
+    throw std::runtime_error("JSON array index is out of range");
+  }
+
+  const Token* item = &m_tokens[frame.nextItem];
+  frame.nextItem = item->next;
+  return item;
+}
+
+const JsonTextInputSerializer::Token* JsonTextInputSerializer::getString(Common::StringView name) {
+  const Token* token = getValue(name);
+  if (token != nullptr && (token->type != SCALAR || token->scalarType != JsonReader::STRING)) {
+    throw std::runtime_error("JSON value type is not STRING");
+  }
+
+  return token;
+}
+
+int64_t JsonTextInputSerializer::getInteger(Common::StringView name, bool& found) {
+  const Token* token = getValue(name);
+  found = token != nullptr;
+  if (!found) {
+    return 0;
+  }
+
+  if (token->type != SCALAR || token->scalarType != JsonReader::INTEGER) {
+    throw std::runtime_error("JSON value type is not INTEGER");
+  }
+
+  return JsonReader::parseInteger(m_data + token->begin, m_data + token->end);
+}
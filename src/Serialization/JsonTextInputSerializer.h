@@ -0,0 +1,103 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "JsonReader.h"
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Reads values straight from JSON text. The text is parsed once into a flat list of tokens that refer back to
+// it, and values are only decoded when they are requested. The root value must be an object
+class JsonTextInputSerializer : public ISerializer {
+public:
+  JsonTextInputSerializer(std::string text);
+  // The text is not copied and must outlive the serializer
+  JsonTextInputSerializer(const char* data, size_t size);
+
+  SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+  // Copies the source text of a member of the current object, e.g. to echo a JSON-RPC id back
+  bool getRawValue(Common::StringView name, std::string& json);
+
+private:
+  enum TokenType : uint8_t {
+    OBJECT,
+    ARRAY,
+    KEY,
+    SCALAR
+  };
+
+  struct Token {
+    TokenType type;
+    JsonReader::ScalarType scalarType;
+    size_t begin;
+    size_t end;
+    // Index of the token that follows this value and all of its children
+    size_t next;
+    size_t itemCount;
+  };
+
+  struct Frame {
+    size_t token;
+    size_t nextItem;
+  };
+
+  class TokenBuilder;
+
+  void parse();
+  const Token* findMember(Common::StringView name) const;
+  const Token* getValue(Common::StringView name);
+  const Token* getString(Common::StringView name);
+  int64_t getInteger(Common::StringView name, bool& found);
+
+  template <typename T>
+  bool getNumber(Common::StringView name, T& value) {
+    bool found;
+    int64_t number = getInteger(name, found);
+    if (found) {
+      value = static_cast<T>(number);
+    }
+
+    return found;
+  }
+
+  std::string m_text;
+  const char* m_data;
+  size_t m_size;
+  std::vector<Token> m_tokens;
+  std::vector<Frame> m_frames;
+  std::string m_buffer;
+};
+
+}
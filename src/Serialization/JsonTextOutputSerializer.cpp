@@ -0,0 +1,209 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "JsonTextOutputSerializer.h"
+
+#include <cassert>
+#include <iomanip>
+#include <sstream>
+
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+bool needsEscape(char c) {
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+}
+
+JsonTextOutputSerializer::JsonTextOutputSerializer() {
+  m_text += '{';
+  m_levels.push_back({ false, true });
+}
+
+ISerializer::SerializerType JsonTextOutputSerializer::type() const {
+  return ISerializer::OUTPUT;
+}
+
+bool JsonTextOutputSerializer::beginObject(Common::StringView name) {
+  writeName(name);
+  m_text += '{';
+  m_levels.push_back({ false, true });
+  return true;
+}
+
+void JsonTextOutputSerializer::endObject() {
+  assert(m_levels.size() > 1 && !m_levels.back().isArray);
+  m_text += '}';
+  m_levels.pop_back();
+}
+
+bool JsonTextOutputSerializer::beginArray(size_t& size, Common::StringView name) {
+  writeName(name);
+  m_text += '[';
+  m_levels.push_back({ true, true });
+  return true;
+}
+
+void JsonTextOutputSerializer::endArray() {
+  assert(m_levels.size() > 1 && m_levels.back().isArray);
+  m_text += ']';
+  m_levels.pop_back();
+}
+
+// Integers are written the way JsonOutputStreamSerializer wrote them, as signed 64-bit values
+bool JsonTextOutputSerializer::operator()(uint8_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(int16_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(uint16_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(int32_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(uint32_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(int64_t& value, Common::StringView name) {
+  writeInteger(value, name);
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(uint64_t& value, Common::StringView name) {
+  writeInteger(static_cast<int64_t>(value), name);
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(double& value, Common::StringView name) {
+  writeName(name);
+
+  std::ostringstream stream;
+  stream << std::fixed << std::setprecision(11) << value;
+  std::string text = stream.str();
+  while (text.size() > 1 && text[text.size() - 2] != '.' && text[text.size() - 1] == '0') {
+    text.resize(text.size() - 1);
+  }
+
+  m_text += text;
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(bool& value, Common::StringView name) {
+  writeName(name);
+  m_text += value ? "true" : "false";
+  return true;
+}
+
+bool JsonTextOutputSerializer::operator()(std::string& value, Common::StringView name) {
+  writeName(name);
+  writeString(value.data(), value.size());
+  return true;
+}
+
+bool JsonTextOutputSerializer::binary(void* value, size_t size, Common::StringView name) {
+  writeName(name);
+  m_text += '"';
+  Common::toHex(value, size, m_text);
+  m_text += '"';
+  return true;
+}
+
+bool JsonTextOutputSerializer::binary(std::string& value, Common::StringView name) {
+  return binary(const_cast<char*>(value.data()), value.size(), name);
+}
+
+void JsonTextOutputSerializer::rawValue(Common::StringView json, Common::StringView name) {
+  writeName(name);
+  m_text.append(json.getData(), json.getSize());
+}
+
+std::string JsonTextOutputSerializer::takeText() {
+  assert(m_levels.size() == 1);
+  m_text += '}';
+  m_levels.clear();
+  return std::move(m_text);
+}
+
+void JsonTextOutputSerializer::writeName(Common::StringView name) {
+  Level& level = m_levels.back();
+  if (!level.isEmpty) {
+    m_text += ',';
+  }
+
+  level.isEmpty = false;
+  if (!level.isArray) {
+    writeString(name.getData(), name.getSize());
+    m_text += ':';
+  }
+}
+
+void JsonTextOutputSerializer::writeInteger(int64_t value, Common::StringView name) {
+  writeName(name);
+
+  char buffer[24];
+  char* end = buffer + sizeof(buffer);
+  char* begin = end;
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  do {
+    *--begin = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (value < 0) {
+    *--begin = '-';
+  }
+
+  m_text.append(begin, end);
+}
+
+void JsonTextOutputSerializer::writeString(const char* data, size_t size) {
+  m_text += '"';
+  const char* end = data + size;
+  const char* run = data;
+  for (const char* c = data; c != end; ++c) {
+    if (!needsEscape(*c)) {
+      continue;
+    }
+
+    m_text.append(run, c);
+    run = c + 1;
+    switch (*c) {
+    case '"': m_text += "\\\""; break;
+    case '\\': m_text += "\\\\"; break;
+    case '\b': m_text += "\\b"; break;
+    case '\f': m_text += "\\f"; break;
+    case '\n': m_text += "\\n"; break;
+    case '\r': m_text += "\\r"; break;
+    case '\t': m_text += "\\t"; break;
+    default:
+      m_text += "\\u00";
+      m_text += HEX_DIGITS[static_cast<unsigned char>(*c) >> 4];
+      m_text += HEX_DIGITS[static_cast<unsigned char>(*c) & 0xf];
+      break;
+    }
+  }
+
+  m_text.append(run, end);
+  m_text += '"';
+}
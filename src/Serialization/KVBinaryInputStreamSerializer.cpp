@@ -10,7 +10,6 @@
 #include <cassert>
 #include <cstring>
 #include <stdexcept>
-#include <Common/StreamTools.h>
 #include "KVBinaryCommon.h"
 
 using namespace Common;
@@ -18,182 +17,458 @@ using namespace CryptoNote;
 
 namespace {
 
-template <typename T>
-T readPod(Common::IInputStream& s) {
-  T v;
-  read(s, &v, sizeof(T));
-  return v;
+const size_t MAX_STRING_SIZE = 100 * 1024 * 1024;
+const size_t MAX_NESTING_DEPTH = 100;
+
+size_t fixedValueSize(uint8_t type) {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:
+  case BIN_KV_SERIALIZE_TYPE_UINT64:
+  case BIN_KV_SERIALIZE_TYPE_DOUBLE:
+    return 8;
+  case BIN_KV_SERIALIZE_TYPE_INT32:
+  case BIN_KV_SERIALIZE_TYPE_UINT32:
+    return 4;
+  case BIN_KV_SERIALIZE_TYPE_INT16:
+  case BIN_KV_SERIALIZE_TYPE_UINT16:
+    return 2;
+  case BIN_KV_SERIALIZE_TYPE_INT8:
+  case BIN_KV_SERIALIZE_TYPE_UINT8:
+  case BIN_KV_SERIALIZE_TYPE_BOOL:
+    return 1;
+  default:
+    return 0;
+  }
 }
 
-template <typename T, typename JsonT = T>
-JsonValue readPodJson(Common::IInputStream& s) {
-  JsonValue jv;
-  jv = static_cast<JsonT>(readPod<T>(s));
-  return jv;
 }
 
-template <typename T>
-JsonValue readIntegerJson(Common::IInputStream& s) {
-  return readPodJson<T, int64_t>(s);
+KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(Common::IInputStream& strm) {
+  uint8_t chunk[64 * 1024];
+  for (;;) {
+    size_t size = strm.readSome(chunk, sizeof(chunk));
+    if (size == 0) {
+      break;
+    }
+
+    m_storage.insert(m_storage.end(), chunk, chunk + size);
+  }
+
+  m_data = m_storage.data();
+  m_size = m_storage.size();
+  parseHeader();
 }
 
-size_t readVarint(Common::IInputStream& s) {
-  uint8_t b = read<uint8_t>(s);
-  uint8_t size_mask = b & PORTABLE_RAW_SIZE_MARK_MASK;
-  size_t bytesLeft = 0;
+KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(const void* data, size_t size) :
+  m_data(static_cast<const uint8_t*>(data)), m_size(size) {
+  parseHeader();
+}
 
-  switch (size_mask){
-  case PORTABLE_RAW_SIZE_MARK_BYTE:
-    bytesLeft = 0;
-    break;
-  case PORTABLE_RAW_SIZE_MARK_WORD:
-    bytesLeft = 1;
-    break;
-  case PORTABLE_RAW_SIZE_MARK_DWORD:
-    bytesLeft = 3;
-    break;
-  case PORTABLE_RAW_SIZE_MARK_INT64:
-    bytesLeft = 7;
-    break;
+void KVBinaryInputStreamSerializer::parseHeader() {
+  KVBinaryStorageBlockHeader hdr;
+  checkAvailable(0, sizeof(hdr));
+  memcpy(&hdr, m_data, sizeof(hdr));
+
+  if (
+    hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA ||
+    hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
+    throw std::runtime_error("Invalid binary storage signature");
   }
 
-  size_t value = b;
+  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
+    throw std::runtime_error("Unknown binary storage format version");
+  }
 
-  for (size_t i = 1; i <= bytesLeft; ++i) {
-    size_t n = read<uint8_t>(s);
-    value |= n << (i * 8);
+  pushSection(sizeof(hdr));
+}
+
+ISerializer::SerializerType KVBinaryInputStreamSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool KVBinaryInputStreamSerializer::beginObject(Common::StringView name) {
+  Frame& parent = m_frames.back();
+  if (parent.isArray) {
+    if (parent.itemType != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+      throw std::runtime_error("Array item is not an object");
+    }
+
+    if (parent.nextItem == parent.itemCount) {
+      throw std::runtime_error("Array index is out of range");
+    }
+
+    ++parent.nextItem;
+    // The reference may be invalidated by pushSection
+    size_t end = pushSection(parent.position);
+    m_frames[m_frames.size() - 2].position = end;
+    return true;
   }
 
-  value >>= 2;
-  return value;
+  const Entry* entry = findEntry(name);
+  if (entry == nullptr) {
+    return false;
+  }
+
+  if (entry->isArray || entry->type != BIN_KV_SERIALIZE_TYPE_OBJECT) {
+    throw std::runtime_error("Value is not an object");
+  }
+
+  pushSection(entry->valueOffset);
+  return true;
 }
 
-std::string readString(Common::IInputStream& s) {
-  auto size = readVarint(s);
-  if (size > 100 * 1024 * 1024) {
-    throw std::runtime_error("string size is too big");
+void KVBinaryInputStreamSerializer::endObject() {
+  assert(!m_frames.empty() && !m_frames.back().isArray);
+
+  m_entries.resize(m_frames.back().firstEntry);
+  m_frames.pop_back();
+}
+
+bool KVBinaryInputStreamSerializer::beginArray(size_t& size, Common::StringView name) {
+  if (m_frames.back().isArray) {
+    throw std::runtime_error("Arrays of arrays are not supported");
   }
 
-  std::string str;
-  str.resize(size);
-  if (size) {
-    read(s, &str[0], size);
+  const Entry* entry = findEntry(name);
+  if (entry == nullptr) {
+    size = 0;
+    return false;
+  }
+
+  if (!entry->isArray) {
+    throw std::runtime_error("Value is not an array");
   }
-  return str;
+
+  Frame frame;
+  frame.isArray = true;
+  frame.itemType = entry->type;
+  frame.firstEntry = m_entries.size();
+  frame.position = entry->valueOffset;
+  frame.itemCount = readVarint(frame.position);
+  frame.nextItem = 0;
+  m_frames.push_back(frame);
+
+  size = frame.itemCount;
+  return true;
+}
+
+void KVBinaryInputStreamSerializer::endArray() {
+  assert(!m_frames.empty() && m_frames.back().isArray);
+  m_frames.pop_back();
+}
+
+bool KVBinaryInputStreamSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getInteger(name, value);
 }
 
-JsonValue readStringJson(Common::IInputStream& s) {
-  return JsonValue(readString(s));
+bool KVBinaryInputStreamSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getInteger(name, value);
 }
 
-void readName(Common::IInputStream& s, std::string& name) {
-  uint8_t len = readPod<uint8_t>(s);
-  if (len) {
-    name.resize(len);
-    read(s, &name[0], len);
+bool KVBinaryInputStreamSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getInteger(name, value);
+}
+
+bool KVBinaryInputStreamSerializer::operator()(double& value, Common::StringView name) {
+  uint8_t valueType;
+  size_t offset;
+  if (!findValue(name, valueType, offset)) {
+    return false;
   }
+
+  if (valueType == BIN_KV_SERIALIZE_TYPE_DOUBLE) {
+    value = readPod<double>(offset);
+  } else {
+    value = static_cast<double>(readInteger(valueType, offset));
+  }
+
+  return true;
 }
 
-JsonValue loadValue(Common::IInputStream& stream, uint8_t type);
-JsonValue loadSection(Common::IInputStream& stream);
-JsonValue loadEntry(Common::IInputStream& stream);
-JsonValue loadArray(Common::IInputStream& stream, uint8_t itemType);
+bool KVBinaryInputStreamSerializer::operator()(bool& value, Common::StringView name) {
+  uint8_t valueType;
+  size_t offset;
+  if (!findValue(name, valueType, offset)) {
+    return false;
+  }
 
+  if (valueType != BIN_KV_SERIALIZE_TYPE_BOOL) {
+    throw std::runtime_error("Value is not a bool");
+  }
 
-JsonValue loadSection(Common::IInputStream& stream) {
-  JsonValue sec(JsonValue::OBJECT);
-  size_t count = readVarint(stream);
-  std::string name;
+  value = m_data[offset] != 0;
+  return true;
+}
 
-  while (count--) {
-    readName(stream, name);
-    sec.insert(name, loadEntry(stream));
+bool KVBinaryInputStreamSerializer::operator()(std::string& value, Common::StringView name) {
+  uint8_t valueType;
+  size_t offset;
+  if (!findValue(name, valueType, offset)) {
+    return false;
   }
 
-  return sec;
+  value = readString(valueType, offset);
+  return true;
 }
 
-JsonValue loadValue(Common::IInputStream& stream, uint8_t type) {
-  switch (type) {
-  case BIN_KV_SERIALIZE_TYPE_INT64:  return readIntegerJson<int64_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT32:  return readIntegerJson<int32_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT16:  return readIntegerJson<int16_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_INT8:   return readIntegerJson<int8_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT64: return readIntegerJson<uint64_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT32: return readIntegerJson<uint32_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT16: return readIntegerJson<uint16_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readIntegerJson<uint8_t>(stream);
-  case BIN_KV_SERIALIZE_TYPE_DOUBLE: return readPodJson<double>(stream);
-  case BIN_KV_SERIALIZE_TYPE_BOOL:   return JsonValue(read<uint8_t>(stream) != 0);
-  case BIN_KV_SERIALIZE_TYPE_STRING: return readStringJson(stream);
-  case BIN_KV_SERIALIZE_TYPE_OBJECT: return loadSection(stream);
-  case BIN_KV_SERIALIZE_TYPE_ARRAY:  return loadArray(stream, type);
-  default:
-    throw std::runtime_error("Unknown data type");
-    break;
+bool KVBinaryInputStreamSerializer::binary(void* value, size_t size, Common::StringView name) {
+  uint8_t valueType;
+  size_t offset;
+  if (!findValue(name, valueType, offset)) {
+    return false;
+  }
+
+  if (valueType != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("Value is not a string");
   }
+
+  if (readStringSize(offset) != size) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  memcpy(value, m_data + offset, size);
+  return true;
+}
+
+bool KVBinaryInputStreamSerializer::binary(std::string& value, Common::StringView name) {
+  return (*this)(value, name); // load as string
 }
 
-JsonValue loadEntry(Common::IInputStream& stream) {
-  uint8_t type = readPod<uint8_t>(stream);
+size_t KVBinaryInputStreamSerializer::pushSection(size_t position) {
+  if (m_frames.size() >= MAX_NESTING_DEPTH) {
+    throw std::runtime_error("Binary storage nesting is too deep");
+  }
 
-  if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
-    type &= ~BIN_KV_SERIALIZE_FLAG_ARRAY;
-    return loadArray(stream, type);
+  Frame frame;
+  frame.isArray = false;
+  frame.itemType = BIN_KV_SERIALIZE_TYPE_OBJECT;
+  frame.firstEntry = m_entries.size();
+  frame.itemCount = readVarint(position);
+  frame.nextItem = 0;
+
+  for (size_t i = 0; i < frame.itemCount; ++i) {
+    Entry entry;
+    entry.nameSize = readByte(position);
+    entry.nameOffset = position;
+    checkAvailable(position, entry.nameSize);
+    position += entry.nameSize;
+
+    uint8_t type = readByte(position);
+    entry.isArray = (type & BIN_KV_SERIALIZE_FLAG_ARRAY) != 0;
+    entry.type = type & ~BIN_KV_SERIALIZE_FLAG_ARRAY;
+    entry.valueOffset = position;
+
+    if (entry.isArray) {
+      skipArray(entry.type, position, m_frames.size() + 1);
+    } else {
+      skipValue(entry.type, position, m_frames.size() + 1);
+    }
+
+    m_entries.push_back(entry);
   }
 
-  return loadValue(stream, type);
+  frame.position = position;
+  m_frames.push_back(frame);
+  return position;
 }
 
-JsonValue loadArray(Common::IInputStream& stream, uint8_t itemType) {
-  JsonValue arr(JsonValue::ARRAY);
-  size_t count = readVarint(stream);
+const KVBinaryInputStreamSerializer::Entry* KVBinaryInputStreamSerializer::findEntry(Common::StringView name) const {
+  // Sections have a handful of entries, a linear scan is cheaper than any index. The first of duplicate names wins
+  for (size_t i = m_frames.back().firstEntry; i < m_entries.size(); ++i) {
+    const Entry& entry = m_entries[i];
+    if (entry.nameSize == name.getSize() && memcmp(m_data + entry.nameOffset, name.getData(), entry.nameSize) == 0) {
+      return &entry;
+    }
+  }
 
-  while (count--) {
-    arr.pushBack(loadValue(stream, itemType));
+  return nullptr;
+}
+
+bool KVBinaryInputStreamSerializer::findValue(Common::StringView name, uint8_t& type, size_t& offset) {
+  Frame& frame = m_frames.back();
+  if (frame.isArray) {
+    if (frame.nextItem == frame.itemCount) {
+      throw std::runtime_error("Array index is out of range");
+    }
+
+    type = frame.itemType;
+    offset = frame.position;
+    skipValue(frame.itemType, frame.position, m_frames.size());
+    ++frame.nextItem;
+    return true;
   }
 
-  return arr;
+  const Entry* entry = findEntry(name);
+  if (entry == nullptr) {
+    return false;
+  }
+
+  if (entry->isArray) {
+    throw std::runtime_error("Value is an array");
+  }
+
+  type = entry->type;
+  offset = entry->valueOffset;
+  return true;
 }
 
+void KVBinaryInputStreamSerializer::checkAvailable(size_t position, size_t size) const {
+  if (position > m_size || size > m_size - position) {
+    throw std::runtime_error("Unexpected end of binary storage");
+  }
+}
 
-JsonValue parseBinary(Common::IInputStream& stream) {
-  auto hdr = readPod<KVBinaryStorageBlockHeader>(stream);
+uint8_t KVBinaryInputStreamSerializer::readByte(size_t& position) const {
+  checkAvailable(position, 1);
+  return m_data[position++];
+}
 
-  if (
-    hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA ||
-    hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
-    throw std::runtime_error("Invalid binary storage signature");
+size_t KVBinaryInputStreamSerializer::readVarint(size_t& position) const {
+  uint8_t b = readByte(position);
+  size_t bytesLeft = 0;
+
+  switch (b & PORTABLE_RAW_SIZE_MARK_MASK) {
+  case PORTABLE_RAW_SIZE_MARK_BYTE:
+    bytesLeft = 0;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_WORD:
+    bytesLeft = 1;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_DWORD:
+    bytesLeft = 3;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_INT64:
+    bytesLeft = 7;
+    break;
   }
 
-  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
-    throw std::runtime_error("Unknown binary storage format version");
+  size_t value = b;
+  for (size_t i = 1; i <= bytesLeft; ++i) {
+    size_t n = readByte(position);
+    value |= n << (i * 8);
   }
 
-  return loadSection(stream);
+  return value >> 2;
 }
 
+size_t KVBinaryInputStreamSerializer::readStringSize(size_t& position) const {
+  size_t size = readVarint(position);
+  if (size > MAX_STRING_SIZE) {
+    throw std::runtime_error("string size is too big");
+  }
+
+  checkAvailable(position, size);
+  return size;
 }
 
-KVBinaryInputStreamSerializer::KVBinaryInputStreamSerializer(Common::IInputStream& strm) : JsonInputValueSerializer(parseBinary(strm)) {
+void KVBinaryInputStreamSerializer::skipValue(uint8_t type, size_t& position, size_t depth) const {
+  size_t size = fixedValueSize(type);
+  if (size != 0) {
+    checkAvailable(position, size);
+    position += size;
+    return;
+  }
+
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_STRING:
+    size = readStringSize(position);
+    position += size;
+    break;
+  case BIN_KV_SERIALIZE_TYPE_OBJECT:
+    skipSection(position, depth + 1);
+    break;
+  case BIN_KV_SERIALIZE_TYPE_ARRAY:
+    skipArray(type, position, depth + 1);
+    break;
+  default:
+    throw std::runtime_error("Unknown data type");
+  }
 }
 
-bool KVBinaryInputStreamSerializer::binary(void* value, size_t size, Common::StringView name) {
-  std::string str;
+void KVBinaryInputStreamSerializer::skipArray(uint8_t itemType, size_t& position, size_t depth) const {
+  if (depth > MAX_NESTING_DEPTH) {
+    throw std::runtime_error("Binary storage nesting is too deep");
+  }
 
-  if (!(*this)(str, name)) {
-    return false;
+  size_t count = readVarint(position);
+  size_t size = fixedValueSize(itemType);
+  if (size != 0) {
+    if (count > (m_size - position) / size) {
+      throw std::runtime_error("Unexpected end of binary storage");
+    }
+
+    position += count * size;
+    return;
   }
 
-  if (str.size() != size) {
-    throw std::runtime_error("Binary block size mismatch");
+  while (count--) {
+    skipValue(itemType, position, depth);
   }
+}
 
-  memcpy(value, str.data(), size);
-  return true;
+void KVBinaryInputStreamSerializer::skipSection(size_t& position, size_t depth) const {
+  if (depth > MAX_NESTING_DEPTH) {
+    throw std::runtime_error("Binary storage nesting is too deep");
+  }
+
+  size_t count = readVarint(position);
+  while (count--) {
+    uint8_t nameSize = readByte(position);
+    checkAvailable(position, nameSize);
+    position += nameSize;
+
+    uint8_t type = readByte(position);
+    if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+      skipArray(type & ~BIN_KV_SERIALIZE_FLAG_ARRAY, position, depth);
+    } else {
+      skipValue(type, position, depth);
+    }
+  }
 }
 
-bool KVBinaryInputStreamSerializer::binary(std::string& value, Common::StringView name) {
-  return (*this)(value, name); // load as string
+template <typename T>
+T KVBinaryInputStreamSerializer::readPod(size_t offset) const {
+  T value;
+  memcpy(&value, m_data + offset, sizeof(T));
+  return value;
+}
+
+int64_t KVBinaryInputStreamSerializer::readInteger(uint8_t type, size_t offset) const {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  return readPod<int64_t>(offset);
+  case BIN_KV_SERIALIZE_TYPE_INT32:  return readPod<int32_t>(offset);
+  case BIN_KV_SERIALIZE_TYPE_INT16:  return readPod<int16_t>(offset);
+  case BIN_KV_SERIALIZE_TYPE_INT8:   return readPod<int8_t>(offset);
+  case BIN_KV_SERIALIZE_TYPE_UINT64: return static_cast<int64_t>(readPod<uint64_t>(offset));
+  case BIN_KV_SERIALIZE_TYPE_UINT32: return readPod<uint32_t>(offset);
+  case BIN_KV_SERIALIZE_TYPE_UINT16: return readPod<uint16_t>(offset);
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readPod<uint8_t>(offset);
+  default:
+    throw std::runtime_error("Value is not an integer");
+  }
 }
 
+std::string KVBinaryInputStreamSerializer::readString(uint8_t type, size_t offset) const {
+  if (type != BIN_KV_SERIALIZE_TYPE_STRING) {
+    throw std::runtime_error("Value is not a string");
+  }
+
+  size_t size = readStringSize(offset);
+  return std::string(reinterpret_cast<const char*>(m_data + offset), size);
+}
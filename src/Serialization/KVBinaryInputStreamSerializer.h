@@ -6,18 +6,99 @@
 
 #pragma once
 
+#include <vector>
 #include <Common/IInputStream.h>
 #include "ISerializer.h"
-#include "JsonInputValueSerializer.h"
 
 namespace CryptoNote {
 
-class KVBinaryInputStreamSerializer : public JsonInputValueSerializer {
+// Reads values straight from the serialized storage. Each section is indexed when it is entered (names, types
+// and value offsets only), so no intermediate tree of values is built
+class KVBinaryInputStreamSerializer : public ISerializer {
 public:
   KVBinaryInputStreamSerializer(Common::IInputStream& strm);
+  // The data is not copied and must outlive the serializer
+  KVBinaryInputStreamSerializer(const void* data, size_t size);
 
+  virtual ISerializer::SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
   virtual bool binary(void* value, size_t size, Common::StringView name) override;
   virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  struct Entry {
+    size_t nameOffset;
+    uint8_t nameSize;
+    uint8_t type;
+    bool isArray;
+    size_t valueOffset;
+  };
+
+  struct Frame {
+    bool isArray;
+    uint8_t itemType;
+    size_t firstEntry;
+    size_t itemCount;
+    size_t nextItem;
+    size_t position;
+  };
+
+  void parseHeader();
+  size_t pushSection(size_t position);
+  const Entry* findEntry(Common::StringView name) const;
+  bool findValue(Common::StringView name, uint8_t& type, size_t& offset);
+
+  void checkAvailable(size_t position, size_t size) const;
+  uint8_t readByte(size_t& position) const;
+  size_t readVarint(size_t& position) const;
+  size_t readStringSize(size_t& position) const;
+  void skipValue(uint8_t type, size_t& position, size_t depth) const;
+  void skipArray(uint8_t itemType, size_t& position, size_t depth) const;
+  void skipSection(size_t& position, size_t depth) const;
+
+  template <typename T>
+  T readPod(size_t offset) const;
+  int64_t readInteger(uint8_t type, size_t offset) const;
+  std::string readString(uint8_t type, size_t offset) const;
+
+  template <typename T>
+  bool getInteger(Common::StringView name, T& value) {
+    uint8_t valueType;
+    size_t offset;
+    if (!findValue(name, valueType, offset)) {
+      return false;
+    }
+
+    value = static_cast<T>(readInteger(valueType, offset));
+    return true;
+  }
+
+  std::vector<uint8_t> m_storage;
+  const uint8_t* m_data;
+  size_t m_size;
+  std::vector<Entry> m_entries;
+  std::vector<Frame> m_frames;
 };
 
 }
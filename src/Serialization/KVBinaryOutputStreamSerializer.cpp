@@ -8,6 +8,7 @@
 #include "KVBinaryCommon.h"
 
 #include <cassert>
+#include <cstring>
 #include <stdexcept>
 #include <Common/StreamTools.h>
 
@@ -22,10 +23,10 @@ void writePod(IOutputStream& s, const T& value) {
 }
 
 template<class T>
-size_t packVarint(IOutputStream& s, uint8_t type_or, size_t pv) {
+size_t packVarint(uint8_t* out, uint8_t type_or, size_t pv) {
   T v = static_cast<T>(pv << 2);
   v |= type_or;
-  write(s, &v, sizeof(T));
+  memcpy(out, &v, sizeof(T));
   return sizeof(T);
 }
 
@@ -39,31 +40,38 @@ void writeElementName(IOutputStream& s, Common::StringView name) {
   write(s, name.getData(), len);
 }
 
-size_t writeArraySize(IOutputStream& s, size_t val) {
+size_t packArraySize(uint8_t* out, size_t val) {
   if (val <= 63) {
-    return packVarint<uint8_t>(s, PORTABLE_RAW_SIZE_MARK_BYTE, val);
+    return packVarint<uint8_t>(out, PORTABLE_RAW_SIZE_MARK_BYTE, val);
   } else if (val <= 16383) {
-    return packVarint<uint16_t>(s, PORTABLE_RAW_SIZE_MARK_WORD, val);
+    return packVarint<uint16_t>(out, PORTABLE_RAW_SIZE_MARK_WORD, val);
   } else if (val <= 1073741823) {
-    return packVarint<uint32_t>(s, PORTABLE_RAW_SIZE_MARK_DWORD, val);
+    return packVarint<uint32_t>(out, PORTABLE_RAW_SIZE_MARK_DWORD, val);
   } else {
     if (val > 4611686018427387903) {
       throw std::runtime_error("failed to pack varint - too big amount");
     }
-    return packVarint<uint64_t>(s, PORTABLE_RAW_SIZE_MARK_INT64, val);
+    return packVarint<uint64_t>(out, PORTABLE_RAW_SIZE_MARK_INT64, val);
   }
 }
 
+size_t writeArraySize(IOutputStream& s, size_t val) {
+  uint8_t packed[sizeof(uint64_t)];
+  size_t size = packArraySize(packed, val);
+  write(s, packed, size);
+  return size;
+}
+
 }
 
 namespace CryptoNote {
 
-KVBinaryOutputStreamSerializer::KVBinaryOutputStreamSerializer() {
-  beginObject(std::string());
+KVBinaryOutputStreamSerializer::KVBinaryOutputStreamSerializer() : m_stream(m_buffer) {
+  // The root section has no prefix, its entry count is written by dump
+  m_stack.push_back(Level(std::string()));
 }
 
 void KVBinaryOutputStreamSerializer::dump(IOutputStream& target) {
-  assert(m_objectsStack.size() == 1);
   assert(m_stack.size() == 1);
 
   KVBinaryStorageBlockHeader hdr;
@@ -73,7 +81,7 @@ void KVBinaryOutputStreamSerializer::dump(IOutputStream& target) {
 
   Common::write(target, &hdr, sizeof(hdr));
   writeArraySize(target, m_stack.front().count);
-  write(target, stream().data(), stream().size());
+  write(target, m_buffer.data(), m_buffer.size());
 }
 
 ISerializer::SerializerType KVBinaryOutputStreamSerializer::type() const {
@@ -81,29 +89,27 @@ ISerializer::SerializerType KVBinaryOutputStreamSerializer::type() const {
 }
 
 bool KVBinaryOutputStreamSerializer::beginObject(Common::StringView name) {
-  checkArrayPreamble(BIN_KV_SERIALIZE_TYPE_OBJECT);
- 
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_OBJECT, name);
+
   m_stack.push_back(Level(name));
-  m_objectsStack.push_back(MemoryStream());
+  m_stack.back().countOffset = m_buffer.size();
+  m_buffer.push_back(0);
 
   return true;
 }
 
 void KVBinaryOutputStreamSerializer::endObject() {
-  assert(m_objectsStack.size());
+  assert(m_stack.size() > 1);
+
+  const Level& level = m_stack.back();
+  uint8_t packed[sizeof(uint64_t)];
+  size_t size = packArraySize(packed, level.count);
+  m_buffer[level.countOffset] = packed[0];
+  if (size > 1) {
+    m_buffer.insert(m_buffer.begin() + level.countOffset + 1, packed + 1, packed + size);
+  }
 
-  auto level = std::move(m_stack.back());
   m_stack.pop_back();
-
-  auto objStream = std::move(m_objectsStack.back());
-  m_objectsStack.pop_back();
-
-  auto& out = stream();
-
-  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_OBJECT, level.name);
-
-  writeArraySize(out, level.count);
-  write(out, objStream.data(), objStream.size());
 }
 
 bool KVBinaryOutputStreamSerializer::beginArray(size_t& size, Common::StringView name) {
@@ -231,9 +237,8 @@ void KVBinaryOutputStreamSerializer::checkArrayPreamble(uint8_t type) {
 }
 
 
-MemoryStream& KVBinaryOutputStreamSerializer::stream() {
-  assert(m_objectsStack.size());
-  return m_objectsStack.back();
+Common::IOutputStream& KVBinaryOutputStreamSerializer::stream() {
+  return m_stream;
 }
 
 }
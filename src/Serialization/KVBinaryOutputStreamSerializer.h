@@ -8,11 +8,13 @@
 
 #include <vector>
 #include <Common/IOutputStream.h>
+#include <Common/VectorOutputStream.h>
 #include "ISerializer.h"
-#include "MemoryStream.h"
 
 namespace CryptoNote {
 
+// All sections are written into one buffer. A nested section's entry count is written when it is closed: it takes
+// one byte for up to 63 entries, larger counts move the section contents to make room for the wider encoding
 class KVBinaryOutputStreamSerializer : public ISerializer {
 public:
 
@@ -52,7 +54,7 @@ private:
   void writeElementPrefix(uint8_t type, Common::StringView name);
   void checkArrayPreamble(uint8_t type);
   void updateState(uint8_t type);
-  MemoryStream& stream();
+  Common::IOutputStream& stream();
 
   enum class State {
     Root,
@@ -65,22 +67,25 @@ private:
     State state;
     std::string name;
     size_t count;
+    size_t countOffset;
 
     Level(Common::StringView nm) :
-      name(nm), state(State::Object), count(0) {}
+      name(nm), state(State::Object), count(0), countOffset(0) {}
 
     Level(Common::StringView nm, size_t arraySize) :
-      name(nm), state(State::ArrayPrefix), count(arraySize) {}
+      name(nm), state(State::ArrayPrefix), count(arraySize), countOffset(0) {}
 
     Level(Level&& rv) {
       state = rv.state;
       name = std::move(rv.name);
       count = rv.count;
+      countOffset = rv.countOffset;
     }
 
   };
 
-  std::vector<MemoryStream> m_objectsStack;
+  std::vector<uint8_t> m_buffer;
+  Common::VectorOutputStream m_stream;
   std::vector<Level> m_stack;
 };
 
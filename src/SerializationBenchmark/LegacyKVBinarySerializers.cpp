@@ -0,0 +1,422 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "LegacyKVBinarySerializers.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <Common/StreamTools.h>
+#include "Serialization/KVBinaryCommon.h"
+
+using namespace Common;
+using namespace CryptoNote;
+
+namespace SerializationBenchmark {
+
+namespace {
+
+template <typename T>
+T readPod(Common::IInputStream& s) {
+  T v;
+  read(s, &v, sizeof(T));
+  return v;
+}
+
+template <typename T, typename JsonT = T>
+JsonValue readPodJson(Common::IInputStream& s) {
+  JsonValue jv;
+  jv = static_cast<JsonT>(readPod<T>(s));
+  return jv;
+}
+
+template <typename T>
+JsonValue readIntegerJson(Common::IInputStream& s) {
+  return readPodJson<T, int64_t>(s);
+}
+
+size_t readVarint(Common::IInputStream& s) {
+  uint8_t b = read<uint8_t>(s);
+  uint8_t size_mask = b & PORTABLE_RAW_SIZE_MARK_MASK;
+  size_t bytesLeft = 0;
+
+  switch (size_mask){
+  case PORTABLE_RAW_SIZE_MARK_BYTE:
+    bytesLeft = 0;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_WORD:
+    bytesLeft = 1;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_DWORD:
+    bytesLeft = 3;
+    break;
+  case PORTABLE_RAW_SIZE_MARK_INT64:
+    bytesLeft = 7;
+    break;
+  }
+
+  size_t value = b;
+
+  for (size_t i = 1; i <= bytesLeft; ++i) {
+    size_t n = read<uint8_t>(s);
+    value |= n << (i * 8);
+  }
+
+  value >>= 2;
+  return value;
+}
+
+std::string readString(Common::IInputStream& s) {
+  auto size = readVarint(s);
+  if (size > 100 * 1024 * 1024) {
+    throw std::runtime_error("string size is too big");
+  }
+
+  std::string str;
+  str.resize(size);
+  if (size) {
+    read(s, &str[0], size);
+  }
+  return str;
+}
+
+JsonValue readStringJson(Common::IInputStream& s) {
+  return JsonValue(readString(s));
+}
+
+void readName(Common::IInputStream& s, std::string& name) {
+  uint8_t len = readPod<uint8_t>(s);
+  if (len) {
+    name.resize(len);
+    read(s, &name[0], len);
+  }
+}
+
+JsonValue loadValue(Common::IInputStream& stream, uint8_t type);
+JsonValue loadSection(Common::IInputStream& stream);
+JsonValue loadEntry(Common::IInputStream& stream);
+JsonValue loadArray(Common::IInputStream& stream, uint8_t itemType);
+
+
+JsonValue loadSection(Common::IInputStream& stream) {
+  JsonValue sec(JsonValue::OBJECT);
+  size_t count = readVarint(stream);
+  std::string name;
+
+  while (count--) {
+    readName(stream, name);
+    sec.insert(name, loadEntry(stream));
+  }
+
+  return sec;
+}
+
+JsonValue loadValue(Common::IInputStream& stream, uint8_t type) {
+  switch (type) {
+  case BIN_KV_SERIALIZE_TYPE_INT64:  return readIntegerJson<int64_t>(stream);
+  case BIN_KV_SERIALIZE_TYPE_INT32:  return readIntegerJson<int32_t>(stream);
+  case BIN_KV_SERIALIZE_TYPE_INT16:  return readIntegerJson<int16_t>(stream);
+  case BIN_KV_SERIALIZE_TYPE_INT8:   return readIntegerJson<int8_t>(stream);
+  case BIN_KV_SERIALIZE_TYPE_UINT64: return readIntegerJson<uint64_t>(stream);
+  case BIN_KV_SERIALIZE_TYPE_UINT32: return readIntegerJson<uint32_t>(stream);
+  case BIN_KV_SERIALIZE_TYPE_UINT16: return readIntegerJson<uint16_t>(stream);
+  case BIN_KV_SERIALIZE_TYPE_UINT8:  return readIntegerJson<uint8_t>(stream);
+  case BIN_KV_SERIALIZE_TYPE_DOUBLE: return readPodJson<double>(stream);
+  case BIN_KV_SERIALIZE_TYPE_BOOL:   return JsonValue(read<uint8_t>(stream) != 0);
+  case BIN_KV_SERIALIZE_TYPE_STRING: return readStringJson(stream);
+  case BIN_KV_SERIALIZE_TYPE_OBJECT: return loadSection(stream);
+  case BIN_KV_SERIALIZE_TYPE_ARRAY:  return loadArray(stream, type);
+  default:
+    throw std::runtime_error("Unknown data type");
+    break;
+  }
+}
+
+JsonValue loadEntry(Common::IInputStream& stream) {
+  uint8_t type = readPod<uint8_t>(stream);
+
+  if (type & BIN_KV_SERIALIZE_FLAG_ARRAY) {
+    type &= ~BIN_KV_SERIALIZE_FLAG_ARRAY;
+    return loadArray(stream, type);
+  }
+
+  return loadValue(stream, type);
+}
+
+JsonValue loadArray(Common::IInputStream& stream, uint8_t itemType) {
+  JsonValue arr(JsonValue::ARRAY);
+  size_t count = readVarint(stream);
+
+  while (count--) {
+    arr.pushBack(loadValue(stream, itemType));
+  }
+
+  return arr;
+}
+
+
+JsonValue parseBinary(Common::IInputStream& stream) {
+  auto hdr = readPod<KVBinaryStorageBlockHeader>(stream);
+
+  if (
+    hdr.m_signature_a != PORTABLE_STORAGE_SIGNATUREA ||
+    hdr.m_signature_b != PORTABLE_STORAGE_SIGNATUREB) {
+    throw std::runtime_error("Invalid binary storage signature");
+  }
+
+  if (hdr.m_ver != PORTABLE_STORAGE_FORMAT_VER) {
+    throw std::runtime_error("Unknown binary storage format version");
+  }
+
+  return loadSection(stream);
+}
+
+}
+
+LegacyKVBinaryInputStreamSerializer::LegacyKVBinaryInputStreamSerializer(Common::IInputStream& strm) : JsonInputValueSerializer(parseBinary(strm)) {
+}
+
+bool LegacyKVBinaryInputStreamSerializer::binary(void* value, size_t size, Common::StringView name) {
+  std::string str;
+
+  if (!(*this)(str, name)) {
+    return false;
+  }
+
+  if (str.size() != size) {
+    throw std::runtime_error("Binary block size mismatch");
+  }
+
+  memcpy(value, str.data(), size);
+  return true;
+}
+
+bool LegacyKVBinaryInputStreamSerializer::binary(std::string& value, Common::StringView name) {
+  return (*this)(value, name); // load as string
+}
+
+namespace {
+
+template <typename T>
+void writePod(IOutputStream& s, const T& value) {
+  write(s, &value, sizeof(T));
+}
+
+template<class T>
+size_t packVarint(IOutputStream& s, uint8_t type_or, size_t pv) {
+  T v = static_cast<T>(pv << 2);
+  v |= type_or;
+  write(s, &v, sizeof(T));
+  return sizeof(T);
+}
+
+void writeElementName(IOutputStream& s, Common::StringView name) {
+  if (name.getSize() > std::numeric_limits<uint8_t>::max()) {
+    throw std::runtime_error("Element name is too long");
+  }
+
+  uint8_t len = static_cast<uint8_t>(name.getSize());
+  write(s, &len, sizeof(len));
+  write(s, name.getData(), len);
+}
+
+size_t writeArraySize(IOutputStream& s, size_t val) {
+  if (val <= 63) {
+    return packVarint<uint8_t>(s, PORTABLE_RAW_SIZE_MARK_BYTE, val);
+  } else if (val <= 16383) {
+    return packVarint<uint16_t>(s, PORTABLE_RAW_SIZE_MARK_WORD, val);
+  } else if (val <= 1073741823) {
+    return packVarint<uint32_t>(s, PORTABLE_RAW_SIZE_MARK_DWORD, val);
+  } else {
+    if (val > 4611686018427387903) {
+      throw std::runtime_error("failed to pack varint - too big amount");
+    }
+    return packVarint<uint64_t>(s, PORTABLE_RAW_SIZE_MARK_INT64, val);
+  }
+}
+
+}
+
+LegacyKVBinaryOutputStreamSerializer::LegacyKVBinaryOutputStreamSerializer() {
+  beginObject(std::string());
+}
+
+void LegacyKVBinaryOutputStreamSerializer::dump(IOutputStream& target) {
+  assert(m_objectsStack.size() == 1);
+  assert(m_stack.size() == 1);
+
+  KVBinaryStorageBlockHeader hdr;
+  hdr.m_signature_a = PORTABLE_STORAGE_SIGNATUREA;
+  hdr.m_signature_b = PORTABLE_STORAGE_SIGNATUREB;
+  hdr.m_ver = PORTABLE_STORAGE_FORMAT_VER;
+
+  Common::write(target, &hdr, sizeof(hdr));
+  writeArraySize(target, m_stack.front().count);
+  write(target, stream().data(), stream().size());
+}
+
+ISerializer::SerializerType LegacyKVBinaryOutputStreamSerializer::type() const {
+  return ISerializer::OUTPUT;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::beginObject(Common::StringView name) {
+  checkArrayPreamble(BIN_KV_SERIALIZE_TYPE_OBJECT);
+ 
+  m_stack.push_back(Level(name));
+  m_objectsStack.push_back(MemoryStream());
+
+  return true;
+}
+
+void LegacyKVBinaryOutputStreamSerializer::endObject() {
+  assert(m_objectsStack.size());
+
+  auto level = std::move(m_stack.back());
+  m_stack.pop_back();
+
+  auto objStream = std::move(m_objectsStack.back());
+  m_objectsStack.pop_back();
+
+  auto& out = stream();
+
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_OBJECT, level.name);
+
+  writeArraySize(out, level.count);
+  write(out, objStream.data(), objStream.size());
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::beginArray(size_t& size, Common::StringView name) {
+  m_stack.push_back(Level(name, size));
+  return true;
+}
+
+void LegacyKVBinaryOutputStreamSerializer::endArray() {
+  bool validArray = m_stack.back().state == State::Array;
+  m_stack.pop_back();
+
+  if (m_stack.back().state == State::Object && validArray) {
+    ++m_stack.back().count;
+  }
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(uint8_t& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_UINT8, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(uint16_t& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_UINT16, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(int16_t& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_INT16, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(uint32_t& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_UINT32, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(int32_t& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_INT32, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(int64_t& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_INT64, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(uint64_t& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_UINT64, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(bool& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_BOOL, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(double& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_DOUBLE, name);
+  writePod(stream(), value);
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::operator()(std::string& value, Common::StringView name) {
+  writeElementPrefix(BIN_KV_SERIALIZE_TYPE_STRING, name);
+
+  auto& out = stream();
+  writeArraySize(out, value.size());
+  write(out, value.data(), value.size());
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::binary(void* value, size_t size, Common::StringView name) {
+  if (size > 0) {
+    writeElementPrefix(BIN_KV_SERIALIZE_TYPE_STRING, name);
+    auto& out = stream();
+    writeArraySize(out, size);
+    write(out, value, size);
+  }
+  return true;
+}
+
+bool LegacyKVBinaryOutputStreamSerializer::binary(std::string& value, Common::StringView name) {
+  return binary(const_cast<char*>(value.data()), value.size(), name);
+}
+
+void LegacyKVBinaryOutputStreamSerializer::writeElementPrefix(uint8_t type, Common::StringView name) {  
+  assert(m_stack.size());
+
+  checkArrayPreamble(type);
+  Level& level = m_stack.back();
+  
+  if (level.state != State::Array) {
+    if (!name.isEmpty()) {
+      auto& s = stream();
+      writeElementName(s, name);
+      write(s, &type, 1);
+    }
+    ++level.count;
+  }
+}
+
+void LegacyKVBinaryOutputStreamSerializer::checkArrayPreamble(uint8_t type) {
+  if (m_stack.empty()) {
+    return;
+  }
+
+  Level& level = m_stack.back();
+
+  if (level.state == State::ArrayPrefix) {
+    auto& s = stream();
+    writeElementName(s, level.name);
+    char c = BIN_KV_SERIALIZE_FLAG_ARRAY | type;
+    write(s, &c, 1);
+    writeArraySize(s, level.count);
+    level.state = State::Array;
+  }
+}
+
+MemoryStream& LegacyKVBinaryOutputStreamSerializer::stream() {
+  assert(m_objectsStack.size());
+  return m_objectsStack.back();
+}
+
+}
@@ -0,0 +1,100 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#pragma once
+
+#include <vector>
+#include <Common/IInputStream.h>
+#include <Common/IOutputStream.h>
+#include "Serialization/ISerializer.h"
+#include "Serialization/JsonInputValueSerializer.h"
+#include "Serialization/MemoryStream.h"
+
+namespace SerializationBenchmark {
+
+// The KV-binary serializers as they were before the streaming rewrite: the reader builds a JsonValue tree first
+// and the writer buffers every section separately. Kept only as the reference for the round-trip checks and the
+// throughput comparison
+class LegacyKVBinaryInputStreamSerializer : public CryptoNote::JsonInputValueSerializer {
+public:
+  LegacyKVBinaryInputStreamSerializer(Common::IInputStream& strm);
+
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+};
+
+class LegacyKVBinaryOutputStreamSerializer : public CryptoNote::ISerializer {
+public:
+
+  LegacyKVBinaryOutputStreamSerializer();
+  virtual ~LegacyKVBinaryOutputStreamSerializer() {}
+
+  void dump(Common::IOutputStream& target);
+
+  virtual CryptoNote::ISerializer::SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return CryptoNote::ISerializer::operator()(value, name);
+  }
+
+private:
+
+  void writeElementPrefix(uint8_t type, Common::StringView name);
+  void checkArrayPreamble(uint8_t type);
+  void updateState(uint8_t type);
+  CryptoNote::MemoryStream& stream();
+
+  enum class State {
+    Root,
+    Object,
+    ArrayPrefix,
+    Array
+  };
+
+  struct Level {
+    State state;
+    std::string name;
+    size_t count;
+
+    Level(Common::StringView nm) :
+      name(nm), state(State::Object), count(0) {}
+
+    Level(Common::StringView nm, size_t arraySize) :
+      name(nm), state(State::ArrayPrefix), count(arraySize) {}
+
+    Level(Level&& rv) {
+      state = rv.state;
+      name = std::move(rv.name);
+      count = rv.count;
+    }
+
+  };
+
+  std::vector<CryptoNote::MemoryStream> m_objectsStack;
+  std::vector<Level> m_stack;
+};
+
+}
@@ -0,0 +1,828 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <boost/program_options.hpp>
+
+#include "Common/CommandLine.h"
+#include "Common/JsonValue.h"
+#include "Common/Lz4.h"
+#include "Common/MemoryInputStream.h"
+#include "Common/StringTools.h"
+#include "Common/StringOutputStream.h"
+#include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteProtocol/CryptoNoteProtocolDefinitions.h"
+#include "PaymentGate/PaymentServiceJsonRpcMessages.h"
+#include "Rpc/CoreRpcServerCommandsDefinitions.h"
+#include "Rpc/RpcCompression.h"
+#include "Serialization/JsonInputValueSerializer.h"
+#include "Serialization/JsonOutputStreamSerializer.h"
+#include "Serialization/JsonTextInputSerializer.h"
+#include "Serialization/JsonTextOutputSerializer.h"
+#include "Serialization/KVBinaryInputStreamSerializer.h"
+#include "Serialization/KVBinaryOutputStreamSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+#include "LegacyKVBinarySerializers.h"
+
+namespace po = boost::program_options;
+using namespace CryptoNote;
+using namespace SerializationBenchmark;
+
+namespace {
+
+const command_line::arg_descriptor<uint32_t> arg_seed       = {"seed", "Seed of the random data generator", 1};
+const command_line::arg_descriptor<uint32_t> arg_samples    = {"samples", "Number of random structures to round-trip", 2000};
+const command_line::arg_descriptor<uint32_t> arg_mutations  = {"mutations", "Number of corrupted inputs fed to both readers", 20000};
+const command_line::arg_descriptor<uint32_t> arg_iterations = {"iterations", "Iterations of every throughput measurement", 200};
+const command_line::arg_descriptor<uint32_t> arg_blocks     = {"blocks", "Blocks in every generated payload", 200};
+const command_line::arg_descriptor<uint32_t> arg_sync_blocks = {"sync-blocks", "Blocks in the wallet sync window of the compression benchmark", 10000};
+const command_line::arg_descriptor<uint32_t> arg_link_speed = {"link-speed", "Link speed in Mbit/s used to estimate download times", 10};
+
+const uint64_t MAX_FIELD_COUNT = 1000;
+
+struct TestEntry {
+  uint64_t amount;
+  int64_t offset;
+  uint32_t index;
+  int16_t delta;
+  uint8_t flags;
+  bool enabled;
+  std::string name;
+  Crypto::Hash hash;
+  std::vector<uint64_t> amounts;
+  std::vector<std::string> blobs;
+  std::vector<Crypto::Hash> hashes;
+  // Written as one section with a field per value, so wide sections are covered too
+  std::vector<uint32_t> fields;
+  std::vector<TestEntry> children;
+
+  void serialize(ISerializer& s) {
+    KV_MEMBER(amount)
+    KV_MEMBER(offset)
+    KV_MEMBER(index)
+    KV_MEMBER(delta)
+    KV_MEMBER(flags)
+    KV_MEMBER(enabled)
+    KV_MEMBER(name)
+    KV_MEMBER(hash)
+    KV_MEMBER(amounts)
+    KV_MEMBER(blobs)
+    serializeAsBinary(hashes, "hashes", s);
+
+    uint64_t fieldCount = fields.size();
+    s(fieldCount, "field_count");
+    if (fieldCount > MAX_FIELD_COUNT) {
+      throw std::runtime_error("Too many fields");
+    }
+
+    if (s.beginObject("fields")) {
+      fields.resize(static_cast<size_t>(fieldCount));
+      for (size_t i = 0; i < fields.size(); ++i) {
+        s(fields[i], "f" + std::to_string(i));
+      }
+
+      s.endObject();
+    }
+
+    KV_MEMBER(children)
+  }
+};
+
+class Generator {
+public:
+  explicit Generator(uint32_t seed) : m_random(seed) {
+  }
+
+  size_t size(size_t max) {
+    return std::uniform_int_distribution<size_t>(0, max)(m_random);
+  }
+
+  uint64_t integer() {
+    return m_random();
+  }
+
+  std::string blob(size_t minSize, size_t maxSize) {
+    std::string result(minSize + size(maxSize - minSize), '\0');
+    for (auto& c : result) {
+      c = static_cast<char>(m_random());
+    }
+
+    return result;
+  }
+
+  std::string text(size_t minSize, size_t maxSize) {
+    static const char ALPHABET[] = "0123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    std::string result(minSize + size(maxSize - minSize), '\0');
+    for (auto& c : result) {
+      c = ALPHABET[size(sizeof(ALPHABET) - 2)];
+    }
+
+    return result;
+  }
+
+  Crypto::Hash hash() {
+    return pod<Crypto::Hash>();
+  }
+
+  template <typename T>
+  T pod() {
+    T result;
+    uint8_t* bytes = reinterpret_cast<uint8_t*>(&result);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+      bytes[i] = static_cast<uint8_t>(m_random());
+    }
+
+    return result;
+  }
+
+  // Amounts are split into single digit denominations
+  uint64_t denomination() {
+    uint64_t amount = 1 + size(8);
+    for (size_t i = size(10); i > 0; --i) {
+      amount *= 10;
+    }
+
+    return amount;
+  }
+
+  std::vector<uint8_t> transactionExtra() {
+    std::vector<uint8_t> extra(1, 1);
+    Crypto::PublicKey key = pod<Crypto::PublicKey>();
+    extra.insert(extra.end(), key.data, key.data + sizeof(key.data));
+    if (size(3) == 0) {
+      Crypto::Hash paymentId = hash();
+      extra.insert(extra.end(), { 2, 33, 0 });
+      extra.insert(extra.end(), paymentId.data, paymentId.data + sizeof(paymentId.data));
+    }
+
+    return extra;
+  }
+
+  // Shaped like a real transfer, with random keys, images and signatures
+  Transaction transaction() {
+    Transaction tx;
+    tx.version = 1;
+    tx.unlockTime = 0;
+    size_t inputCount = 1 + size(3);
+    for (size_t i = 0; i < inputCount; ++i) {
+      KeyInput input;
+      input.amount = denomination();
+      size_t mixin = 1 + size(4);
+      // Relative offsets, so only the first one is large
+      input.outputIndexes.push_back(static_cast<uint32_t>(size(200000)));
+      for (size_t j = 1; j < mixin; ++j) {
+        input.outputIndexes.push_back(static_cast<uint32_t>(1 + size(5000)));
+      }
+
+      input.keyImage = pod<Crypto::KeyImage>();
+      tx.inputs.push_back(input);
+
+      std::vector<Crypto::Signature> signatures;
+      for (size_t j = 0; j < mixin; ++j) {
+        signatures.push_back(pod<Crypto::Signature>());
+      }
+
+      tx.signatures.push_back(std::move(signatures));
+    }
+
+    size_t outputCount = 2 + size(4);
+    for (size_t i = 0; i < outputCount; ++i) {
+      KeyOutput target;
+      target.key = pod<Crypto::PublicKey>();
+      tx.outputs.push_back(TransactionOutput{ denomination(), target });
+    }
+
+    tx.extra = transactionExtra();
+    return tx;
+  }
+
+  Block block(uint32_t height, std::vector<Transaction>& transactions) {
+    Block block;
+    block.majorVersion = 1;
+    block.minorVersion = 0;
+    block.nonce = static_cast<uint32_t>(integer());
+    block.timestamp = 1550000000 + height * 120;
+    block.previousBlockHash = hash();
+
+    Transaction& base = block.baseTransaction;
+    base.version = 1;
+    base.unlockTime = height + 10;
+    base.inputs.push_back(BaseInput{ height });
+    size_t outputCount = 3 + size(4);
+    for (size_t i = 0; i < outputCount; ++i) {
+      KeyOutput target;
+      target.key = pod<Crypto::PublicKey>();
+      base.outputs.push_back(TransactionOutput{ denomination(), target });
+    }
+
+    base.extra = transactionExtra();
+
+    // Most blocks of a sync window are empty or nearly so
+    size_t txCount = size(3) == 0 ? size(8) : 0;
+    for (size_t i = 0; i < txCount; ++i) {
+      transactions.push_back(transaction());
+      block.transactionHashes.push_back(getObjectHash(transactions.back()));
+    }
+
+    return block;
+  }
+
+  // queryblockslite.bin and getblocks.bin responses for blockCount blocks, split the way the node pages them
+  void syncWindow(uint32_t blockCount, std::vector<COMMAND_RPC_QUERY_BLOCKS_LITE::response>& liteResponses,
+    std::vector<COMMAND_RPC_GET_BLOCKS_FAST::response>& fullResponses) {
+    const uint32_t startHeight = 500000;
+    for (uint32_t first = 0; first < blockCount; first += BLOCKS_SYNCHRONIZING_DEFAULT_COUNT) {
+      COMMAND_RPC_QUERY_BLOCKS_LITE::response lite;
+      lite.status = CORE_RPC_STATUS_OK;
+      lite.startHeight = startHeight + first;
+      lite.currentHeight = startHeight + blockCount;
+      lite.fullOffset = 0;
+
+      COMMAND_RPC_GET_BLOCKS_FAST::response full;
+      full.status = CORE_RPC_STATUS_OK;
+      full.start_height = startHeight + first;
+      full.current_height = startHeight + blockCount;
+
+      uint32_t last = std::min(blockCount, first + static_cast<uint32_t>(BLOCKS_SYNCHRONIZING_DEFAULT_COUNT));
+      for (uint32_t height = startHeight + first; height < startHeight + last; ++height) {
+        std::vector<Transaction> transactions;
+        Block b = block(height, transactions);
+
+        BlockShortInfo item;
+        item.blockId = getObjectHash(b);
+        item.block = Common::asString(toBinaryArray(b));
+        block_complete_entry entry;
+        entry.block = item.block;
+        for (const Transaction& tx : transactions) {
+          item.txPrefixes.push_back(TransactionPrefixInfo{ getObjectHash(tx), tx });
+          entry.txs.push_back(Common::asString(toBinaryArray(tx)));
+        }
+
+        lite.items.push_back(std::move(item));
+        full.blocks.push_back(std::move(entry));
+      }
+
+      liteResponses.push_back(std::move(lite));
+      fullResponses.push_back(std::move(full));
+    }
+  }
+
+  TestEntry entry(size_t depth) {
+    TestEntry e;
+    e.amount = integer();
+    e.offset = static_cast<int64_t>(integer());
+    e.index = static_cast<uint32_t>(integer());
+    e.delta = static_cast<int16_t>(integer());
+    e.flags = static_cast<uint8_t>(integer());
+    e.enabled = (integer() & 1) != 0;
+    e.name = blob(0, 40);
+    e.hash = hash();
+
+    // Mostly short arrays, sometimes ones that need a wider size prefix
+    size_t count = size(4) == 0 ? size(400) : size(8);
+    for (size_t i = 0; i < count; ++i) {
+      e.amounts.push_back(integer() >> size(63));
+    }
+
+    count = size(6);
+    for (size_t i = 0; i < count; ++i) {
+      e.blobs.push_back(blob(0, size(8) == 0 ? 20000 : 100));
+    }
+
+    count = size(5);
+    for (size_t i = 0; i < count; ++i) {
+      e.hashes.push_back(hash());
+    }
+
+    count = size(4) == 0 ? size(300) : size(4);
+    for (size_t i = 0; i < count; ++i) {
+      e.fields.push_back(static_cast<uint32_t>(integer()));
+    }
+
+    if (depth > 0) {
+      count = size(3);
+      for (size_t i = 0; i < count; ++i) {
+        e.children.push_back(entry(depth - 1));
+      }
+    }
+
+    return e;
+  }
+
+  NOTIFY_RESPONSE_GET_OBJECTS::request objects(size_t blockCount) {
+    NOTIFY_RESPONSE_GET_OBJECTS::request request;
+    for (size_t i = 0; i < blockCount; ++i) {
+      block_complete_entry block;
+      block.block = blob(300, 1000);
+      size_t txCount = size(20);
+      for (size_t j = 0; j < txCount; ++j) {
+        block.txs.push_back(blob(300, 3000));
+      }
+
+      request.blocks.push_back(std::move(block));
+    }
+
+    request.missed_ids.push_back(hash());
+    request.current_blockchain_height = static_cast<uint32_t>(integer());
+    return request;
+  }
+
+  // What the block explorer receives from f_blocks_list_json
+  F_COMMAND_RPC_GET_BLOCKS_LIST::response explorerBlocks(size_t blockCount) {
+    F_COMMAND_RPC_GET_BLOCKS_LIST::response response;
+    for (size_t i = 0; i < blockCount; ++i) {
+      f_block_short_response block;
+      block.timestamp = 1550000000 + i * 120;
+      block.height = static_cast<uint32_t>(i);
+      block.difficulty = integer() >> 24;
+      block.hash = Common::podToHex(hash());
+      block.tx_count = 1 + size(20);
+      block.cumul_size = 300 + size(100000);
+      response.blocks.push_back(block);
+    }
+
+    response.status = CORE_RPC_STATUS_OK;
+    return response;
+  }
+
+  // What walletd answers to getTransactions
+  PaymentService::GetTransactions::Response walletTransactions(size_t blockCount) {
+    PaymentService::GetTransactions::Response response;
+    for (size_t i = 0; i < blockCount; ++i) {
+      PaymentService::TransactionsInBlockRpcInfo block;
+      block.blockHash = Common::podToHex(hash());
+      size_t txCount = 1 + size(10);
+      for (size_t j = 0; j < txCount; ++j) {
+        PaymentService::TransactionRpcInfo tx;
+        tx.state = 0;
+        tx.transactionHash = Common::podToHex(hash());
+        tx.blockIndex = static_cast<uint32_t>(i);
+        tx.timestamp = 1550000000 + i * 120;
+        tx.confirmations = static_cast<uint32_t>(blockCount - i);
+        tx.isBase = j == 0;
+        tx.unlockTime = 0;
+        tx.amount = static_cast<int64_t>(integer() >> 20);
+        tx.fee = 1000;
+        std::string extra = blob(33, 80);
+        tx.extra = Common::toHex(extra.data(), extra.size());
+        tx.paymentId = size(3) == 0 ? Common::podToHex(hash()) : std::string();
+        size_t transferCount = 1 + size(4);
+        for (size_t k = 0; k < transferCount; ++k) {
+          PaymentService::TransferRpcInfo transfer;
+          transfer.type = 0;
+          transfer.address = text(98, 98);
+          transfer.amount = static_cast<int64_t>(integer() >> 20);
+          transfer.message = size(4) == 0 ? text(0, 60) : std::string();
+          tx.transfers.push_back(transfer);
+        }
+
+        block.transactions.push_back(tx);
+      }
+
+      response.items.push_back(block);
+    }
+
+    return response;
+  }
+
+private:
+  std::mt19937_64 m_random;
+};
+
+template <typename T>
+std::string storeLegacy(const T& value) {
+  LegacyKVBinaryOutputStreamSerializer serializer;
+  serialize(const_cast<T&>(value), serializer);
+
+  std::string result;
+  Common::StringOutputStream stream(result);
+  serializer.dump(stream);
+  return result;
+}
+
+template <typename T>
+std::string store(const T& value) {
+  KVBinaryOutputStreamSerializer serializer;
+  serialize(const_cast<T&>(value), serializer);
+
+  std::string result;
+  Common::StringOutputStream stream(result);
+  serializer.dump(stream);
+  return result;
+}
+
+template <typename T>
+T loadLegacy(const std::string& data) {
+  Common::MemoryInputStream stream(data.data(), data.size());
+  LegacyKVBinaryInputStreamSerializer serializer(stream);
+  T value;
+  serialize(value, serializer);
+  return value;
+}
+
+template <typename T>
+T load(const std::string& data) {
+  KVBinaryInputStreamSerializer serializer(data.data(), data.size());
+  T value;
+  serialize(value, serializer);
+  return value;
+}
+
+// Values are compared by their serialized form, which covers every member the serializers see
+bool checkRoundTrip(Generator& generator, uint32_t samples) {
+  for (uint32_t i = 0; i < samples; ++i) {
+    TestEntry entry = generator.entry(3);
+    std::string expected = storeLegacy(entry);
+    if (store(entry) != expected) {
+      std::cout << "sample " << i << ": written storage differs from the legacy writer" << std::endl;
+      return false;
+    }
+
+    TestEntry loaded = load<TestEntry>(expected);
+    if (storeLegacy(loaded) != expected) {
+      std::cout << "sample " << i << ": read value differs from the written one" << std::endl;
+      return false;
+    }
+
+    TestEntry loadedLegacy = loadLegacy<TestEntry>(expected);
+    if (storeLegacy(loadedLegacy) != expected) {
+      std::cout << "sample " << i << ": legacy reader disagrees with the written value" << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << "round-trip: " << samples << " samples identical" << std::endl;
+  return true;
+}
+
+// Corrupted storage must be rejected with an exception, never crash, and whenever both readers accept it they
+// must agree on the result
+bool checkMutations(Generator& generator, uint32_t mutations) {
+  size_t acceptedByBoth = 0;
+  size_t rejected = 0;
+  std::string source;
+  for (uint32_t i = 0; i < mutations; ++i) {
+    if (i % 100 == 0) {
+      TestEntry entry = generator.entry(2);
+      source = storeLegacy(entry);
+    }
+
+    std::string data = source;
+    size_t edits = 1 + generator.size(3);
+    for (size_t j = 0; j < edits; ++j) {
+      size_t position = generator.size(data.size() - 1);
+      switch (generator.size(3)) {
+      case 0:
+        data[position] = static_cast<char>(generator.integer());
+        break;
+      case 1:
+        data[position] ^= static_cast<char>(1 << generator.size(7));
+        break;
+      case 2:
+        data.erase(position, generator.size(16));
+        break;
+      default:
+        data.resize(position + 1);
+        break;
+      }
+
+      if (data.empty()) {
+        break;
+      }
+    }
+
+    std::string result;
+    std::string legacyResult;
+    bool accepted = true;
+    bool legacyAccepted = true;
+    try {
+      TestEntry loaded = load<TestEntry>(data);
+      result = storeLegacy(loaded);
+    } catch (std::exception&) {
+      accepted = false;
+    }
+
+    try {
+      TestEntry loaded = loadLegacy<TestEntry>(data);
+      legacyResult = storeLegacy(loaded);
+    } catch (std::exception&) {
+      legacyAccepted = false;
+    }
+
+    if (accepted && legacyAccepted) {
+      ++acceptedByBoth;
+      if (result != legacyResult) {
+        std::cout << "mutation " << i << ": readers disagree on the decoded value" << std::endl;
+        return false;
+      }
+    } else if (!accepted) {
+      ++rejected;
+    }
+  }
+
+  std::cout << "mutations: " << mutations << " inputs, " << rejected << " rejected, " << acceptedByBoth <<
+    " accepted by both readers with equal results" << std::endl;
+  return true;
+}
+
+// Values written by the DOM serializers: strings are not escaped there, so they must stay printable
+void makePrintable(TestEntry& entry, Generator& generator) {
+  entry.name = generator.text(entry.name.size(), entry.name.size());
+  for (auto& blob : entry.blobs) {
+    blob = generator.text(blob.size(), blob.size());
+  }
+
+  for (auto& child : entry.children) {
+    makePrintable(child, generator);
+  }
+}
+
+template <typename T>
+std::string storeJsonValue(const T& value) {
+  JsonOutputStreamSerializer serializer;
+  serialize(const_cast<T&>(value), serializer);
+  return serializer.getValue().toString();
+}
+
+template <typename T>
+T loadJsonValue(const std::string& text) {
+  JsonInputValueSerializer serializer(Common::JsonValue::fromString(text));
+  T value;
+  serialize(value, serializer);
+  return value;
+}
+
+template <typename T>
+std::string storeJsonText(const T& value) {
+  JsonTextOutputSerializer serializer;
+  serialize(const_cast<T&>(value), serializer);
+  return serializer.takeText();
+}
+
+template <typename T>
+T loadJsonText(const std::string& text) {
+  JsonTextInputSerializer serializer(text.data(), text.size());
+  T value;
+  serialize(value, serializer);
+  return value;
+}
+
+// The JSON serializers are compared with the JsonValue based ones through the canonical text of a JsonValue,
+// whose objects keep their members sorted. Arbitrary bytes in strings only round-trip through the new pair
+bool checkJsonRoundTrip(Generator& generator, uint32_t samples) {
+  for (uint32_t i = 0; i < samples; ++i) {
+    TestEntry entry = generator.entry(3);
+    std::string binary = storeLegacy(entry);
+    if (storeLegacy(loadJsonText<TestEntry>(storeJsonText(entry))) != binary) {
+      std::cout << "json sample " << i << ": value changed after a round-trip" << std::endl;
+      return false;
+    }
+
+    makePrintable(entry, generator);
+    binary = storeLegacy(entry);
+    std::string expected = storeJsonValue(entry);
+    if (Common::JsonValue::fromString(storeJsonText(entry)).toString() != expected) {
+      std::cout << "json sample " << i << ": written text differs from the JsonValue writer" << std::endl;
+      return false;
+    }
+
+    if (storeLegacy(loadJsonText<TestEntry>(expected)) != binary ||
+        storeLegacy(loadJsonValue<TestEntry>(storeJsonText(entry))) != binary) {
+      std::cout << "json sample " << i << ": readers disagree on the decoded value" << std::endl;
+      return false;
+    }
+  }
+
+  std::cout << "json round-trip: " << samples << " samples identical" << std::endl;
+  return true;
+}
+
+bool checkJsonMutations(Generator& generator, uint32_t mutations) {
+  static const char TOKENS[] = "{}[]\",:\\-.e0123456789 tfn";
+  size_t rejected = 0;
+  std::string source;
+  for (uint32_t i = 0; i < mutations; ++i) {
+    if (i % 100 == 0) {
+      TestEntry entry = generator.entry(2);
+      source = storeJsonText(entry);
+    }
+
+    std::string data = source;
+    size_t edits = 1 + generator.size(3);
+    for (size_t j = 0; j < edits && !data.empty(); ++j) {
+      size_t position = generator.size(data.size() - 1);
+      switch (generator.size(2)) {
+      case 0:
+        data[position] = TOKENS[generator.size(sizeof(TOKENS) - 2)];
+        break;
+      case 1:
+        data.erase(position, generator.size(16));
+        break;
+      default:
+        data.resize(position);
+        break;
+      }
+    }
+
+    try {
+      loadJsonText<TestEntry>(data);
+    } catch (std::exception&) {
+      ++rejected;
+    }
+  }
+
+  std::cout << "json mutations: " << mutations << " inputs, " << rejected << " rejected" << std::endl;
+  return true;
+}
+
+template <typename F>
+double measure(uint32_t iterations, F f) {
+  auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < iterations; ++i) {
+    f();
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count() / iterations;
+}
+
+void report(const std::string& name, size_t bytes, double legacySeconds, double seconds) {
+  auto throughput = [bytes](double s) { return static_cast<double>(bytes) / s / (1024 * 1024); };
+  std::cout << std::fixed << std::setprecision(1) << std::setw(28) << std::left << name << std::right <<
+    std::setw(10) << legacySeconds * 1e6 << " us " << std::setw(8) << throughput(legacySeconds) << " MB/s  ->" <<
+    std::setw(10) << seconds * 1e6 << " us " << std::setw(8) << throughput(seconds) << " MB/s  (x" <<
+    std::setprecision(2) << legacySeconds / seconds << ")" << std::endl;
+}
+
+template <typename T>
+void benchmarkJson(const std::string& name, T& value, uint32_t iterations) {
+  std::string text = storeJsonText(value);
+  size_t sink = 0;
+
+  double domWrite = measure(iterations, [&] { sink += storeJsonValue(value).size(); });
+  double write = measure(iterations, [&] { sink += storeJsonText(value).size(); });
+  report(name + " write", text.size(), domWrite, write);
+
+  double domRead = measure(iterations, [&] { T loaded = loadJsonValue<T>(text); sink += sizeof(loaded); });
+  double read = measure(iterations, [&] { T loaded = loadJsonText<T>(text); sink += sizeof(loaded); });
+  report(name + " read", text.size(), domRead, read);
+
+  if (sink == 0) {
+    std::cout << std::endl;
+  }
+}
+
+template <typename T>
+void benchmark(const std::string& name, T& value, uint32_t iterations) {
+  std::string data = store(value);
+  size_t sink = 0;
+
+  double legacyWrite = measure(iterations, [&] { sink += storeLegacy(value).size(); });
+  double write = measure(iterations, [&] { sink += store(value).size(); });
+  report(name + " write", data.size(), legacyWrite, write);
+
+  double legacyRead = measure(iterations, [&] { T loaded = loadLegacy<T>(data); sink += sizeof(loaded); });
+  double read = measure(iterations, [&] { T loaded = load<T>(data); sink += sizeof(loaded); });
+  report(name + " read", data.size(), legacyRead, read);
+
+  if (sink == 0) {
+    std::cout << std::endl;
+  }
+}
+
+void reportTransfer(const std::string& name, size_t bytes, size_t rawBytes, uint32_t linkSpeed) {
+  double seconds = static_cast<double>(bytes) * 8 / (static_cast<double>(linkSpeed) * 1000 * 1000);
+  std::cout << "  " << std::fixed << std::setprecision(1) << std::setw(20) << std::left << name << std::right <<
+    std::setw(12) << bytes << " bytes  (x" << std::setprecision(2) << static_cast<double>(rawBytes) / bytes << ")" <<
+    std::setprecision(1) << std::setw(8) << seconds << " s download" << std::endl;
+}
+
+// Sizes of a sync window with and without compression, and the time the node and the wallet spend on it
+template <typename T>
+void benchmarkCompression(const std::string& name, const std::vector<T>& responses, uint32_t linkSpeed) {
+  std::vector<std::string> bodies;
+  size_t rawBytes = 0;
+  size_t plainBytes = 0;
+  for (const T& response : responses) {
+    bodies.push_back(store(response));
+    rawBytes += bodies.back().size();
+
+    std::string plain;
+    Common::lz4Compress(bodies.back().data(), bodies.back().size(), std::string(), plain);
+    plainBytes += plain.size();
+  }
+
+  std::vector<std::string> compressed;
+  size_t bytes = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (const std::string& body : bodies) {
+    compressed.push_back(compressRpcBody(body));
+    bytes += compressed.back().size();
+  }
+
+  std::chrono::duration<double> compressTime = std::chrono::steady_clock::now() - start;
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < compressed.size(); ++i) {
+    std::string body;
+    if (!decompressRpcBody(compressed[i], body) || body != bodies[i]) {
+      throw std::runtime_error(name + ": response " + std::to_string(i) + " differs after decompression");
+    }
+  }
+
+  std::chrono::duration<double> decompressTime = std::chrono::steady_clock::now() - start;
+  std::cout << name << ", " << responses.size() << " responses:" << std::endl;
+  reportTransfer("uncompressed", rawBytes, rawBytes, linkSpeed);
+  reportTransfer("lz4", plainBytes, rawBytes, linkSpeed);
+  reportTransfer("lz4 + dictionary", bytes, rawBytes, linkSpeed);
+  std::cout << "  compression " << std::setprecision(1) << compressTime.count() * 1e3 << " ms, decompression " <<
+    decompressTime.count() * 1e3 << " ms" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+  po::options_description desc_general("General options");
+  command_line::add_arg(desc_general, command_line::arg_help);
+  po::options_description desc_params("Benchmark options");
+  command_line::add_arg(desc_params, arg_seed);
+  command_line::add_arg(desc_params, arg_samples);
+  command_line::add_arg(desc_params, arg_mutations);
+  command_line::add_arg(desc_params, arg_iterations);
+  command_line::add_arg(desc_params, arg_blocks);
+  command_line::add_arg(desc_params, arg_sync_blocks);
+  command_line::add_arg(desc_params, arg_link_speed);
+
+  po::options_description desc_all;
+  desc_all.add(desc_general).add(desc_params);
+
+  po::variables_map vm;
+  bool r = command_line::handle_error_helper(desc_all, [&]() {
+    po::store(po::parse_command_line(argc, argv, desc_all), vm);
+    if (command_line::get_arg(vm, command_line::arg_help)) {
+      std::cout << "Compares the KV-binary and JSON serializers with the implementations they replaced and measures" <<
+        " compressed wallet sync responses" << std::endl;
+      std::cout << desc_all << std::endl;
+      return false;
+    }
+
+    po::notify(vm);
+    return true;
+  });
+
+  if (!r) {
+    return 1;
+  }
+
+  Generator generator(command_line::get_arg(vm, arg_seed));
+  try {
+    if (!checkRoundTrip(generator, command_line::get_arg(vm, arg_samples)) ||
+        !checkMutations(generator, command_line::get_arg(vm, arg_mutations)) ||
+        !checkJsonRoundTrip(generator, command_line::get_arg(vm, arg_samples)) ||
+        !checkJsonMutations(generator, command_line::get_arg(vm, arg_mutations))) {
+      return 1;
+    }
+
+    uint32_t iterations = command_line::get_arg(vm, arg_iterations);
+    std::cout << "KV-binary, previous serializers -> current:" << std::endl;
+    auto objects = generator.objects(command_line::get_arg(vm, arg_blocks));
+    benchmark("get_objects response", objects, iterations);
+
+    TestEntry entry = generator.entry(4);
+    benchmark("nested structure", entry, iterations);
+
+    std::cout << "JSON, JsonValue tree -> direct text:" << std::endl;
+    auto explorerBlocks = generator.explorerBlocks(command_line::get_arg(vm, arg_blocks));
+    benchmarkJson("f_blocks_list_json", explorerBlocks, iterations);
+
+    auto walletTransactions = generator.walletTransactions(command_line::get_arg(vm, arg_blocks));
+    benchmarkJson("getTransactions", walletTransactions, iterations);
+
+    makePrintable(entry, generator);
+    benchmarkJson("nested structure", entry, iterations);
+
+    uint32_t syncBlocks = command_line::get_arg(vm, arg_sync_blocks);
+    uint32_t linkSpeed = std::max<uint32_t>(command_line::get_arg(vm, arg_link_speed), 1);
+    std::cout << "Wallet sync window of " << syncBlocks << " blocks over " << linkSpeed << " Mbit/s:" << std::endl;
+    std::vector<COMMAND_RPC_QUERY_BLOCKS_LITE::response> liteResponses;
+    std::vector<COMMAND_RPC_GET_BLOCKS_FAST::response> fullResponses;
+    generator.syncWindow(syncBlocks, liteResponses, fullResponses);
+    benchmarkCompression("queryblockslite.bin", liteResponses, linkSpeed);
+    benchmarkCompression("getblocks.bin", fullResponses, linkSpeed);
+  } catch (std::exception& e) {
+    std::cout << "error: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
@@ -269,6 +269,11 @@ void BlockchainSynchronizer::stop() {
   }
 
   workingThread.reset();
+
+  if (m_prefetchedQuery) {
+    m_prefetchedQuery->result.wait();
+    m_prefetchedQuery.reset();
+  }
 }
 
 void BlockchainSynchronizer::localBlockchainUpdated(uint32_t /*height*/) {
@@ -334,31 +339,25 @@ BlockchainSynchronizer::GetBlocksRequest BlockchainSynchronizer::getCommonHistor
 }
 
 void BlockchainSynchronizer::startBlockchainSync() {
-  GetBlocksResponse response;
   GetBlocksRequest req = getCommonHistory();
+  std::shared_ptr<BlocksQuery> query = std::move(m_prefetchedQuery);
 
   try {
     if (!req.knownBlocks.empty()) {
-      auto queryBlocksCompleted = std::promise<std::error_code>();
-      auto queryBlocksWaitFuture = queryBlocksCompleted.get_future();
-
-      m_node.queryBlocks(
-        std::move(req.knownBlocks),
-        req.syncStart.timestamp,
-        response.newBlocks,
-        response.startHeight,
-        [&queryBlocksCompleted](std::error_code ec) {
-          auto detachedPromise = std::move(queryBlocksCompleted);
-          detachedPromise.set_value(ec);
-        });
+      // The prefetched batch continues from the block the previous batch ended with. If the consumers stopped
+      // elsewhere, e.g. because one of them failed, it is dropped and the blocks are requested again
+      if (!query || query->expectedTopBlock != req.knownBlocks.front()) {
+        query = queryBlocks(std::vector<Crypto::Hash>(req.knownBlocks), req.syncStart.timestamp);
+      }
 
-      std::error_code ec = queryBlocksWaitFuture.get();
+      std::error_code ec = query->result.get();
 
       if (ec) {
         setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; });
         m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, ec);
       } else {
-        processBlocks(response);
+        prefetchBlocks(req, query->response);
+        processBlocks(query->response);
       }
     }
   } catch (std::exception&) {
@@ -367,6 +366,43 @@ void BlockchainSynchronizer::startBlockchainSync() {
   }
 }
 
+std::shared_ptr<BlockchainSynchronizer::BlocksQuery> BlockchainSynchronizer::queryBlocks(std::vector<Crypto::Hash>&& knownBlocks, uint64_t timestamp) {
+  auto query = std::make_shared<BlocksQuery>();
+  query->result = query->completed.get_future();
+
+  m_node.queryBlocks(
+    std::move(knownBlocks),
+    timestamp,
+    query->response.newBlocks,
+    query->response.startHeight,
+    [query](std::error_code ec) {
+      query->completed.set_value(ec);
+    });
+
+  return query;
+}
+
+void BlockchainSynchronizer::prefetchBlocks(const GetBlocksRequest& request, const GetBlocksResponse& response) {
+  if (response.newBlocks.empty() || checkIfShouldStop()) {
+    return;
+  }
+
+  // Only ask for more when the node knows of blocks past this batch, otherwise the answer could be stale by the time it is used
+  uint32_t lastBlockHeight = response.startHeight + static_cast<uint32_t>(response.newBlocks.size()) - 1;
+  if (lastBlockHeight >= m_node.getLastKnownBlockHeight()) {
+    return;
+  }
+
+  // Known blocks are sent newest first. Should the predicted block be orphaned, the node answers from an older common block
+  std::vector<Crypto::Hash> knownBlocks;
+  knownBlocks.reserve(request.knownBlocks.size() + 1);
+  knownBlocks.push_back(response.newBlocks.back().blockHash);
+  knownBlocks.insert(knownBlocks.end(), request.knownBlocks.begin(), request.knownBlocks.end());
+
+  m_prefetchedQuery = queryBlocks(std::move(knownBlocks), request.syncStart.timestamp);
+  m_prefetchedQuery->expectedTopBlock = response.newBlocks.back().blockHash;
+}
+
 void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
   BlockchainInterval interval;
   interval.startHeight = response.startHeight;
@@ -407,6 +443,7 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
 
     switch (result) {
     case UpdateConsumersResult::errorOccurred:
+      m_prefetchedQuery.reset();
       if (setFutureStateIf(State::idle, [this] { return m_futureState != State::stopped; })) {
         m_observerManager.notify(&IBlockchainSynchronizerObserver::synchronizationCompleted, std::make_error_code(std::errc::invalid_argument));
       }
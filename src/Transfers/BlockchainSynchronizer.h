@@ -64,6 +64,15 @@ private:
     std::vector<Crypto::Hash> knownBlocks;
   };
 
+  // A queryBlocks call that may still be in flight. It is shared with the node callback, so it can be dropped before it completes
+  struct BlocksQuery {
+    // Top block the consumers must have for a prefetched query to be used
+    Crypto::Hash expectedTopBlock;
+    GetBlocksResponse response;
+    std::promise<std::error_code> completed;
+    std::future<std::error_code> result;
+  };
+
   struct GetPoolResponse {
     bool isLastKnownBlockActual;
     std::vector<std::unique_ptr<ITransactionReader>> newTxs;
@@ -92,6 +101,8 @@ private:
   void startPoolSync();
   void startBlockchainSync();
 
+  std::shared_ptr<BlocksQuery> queryBlocks(std::vector<Crypto::Hash>&& knownBlocks, uint64_t timestamp);
+  void prefetchBlocks(const GetBlocksRequest& request, const GetBlocksResponse& response);
   void processBlocks(GetBlocksResponse& response);
   UpdateConsumersResult updateConsumers(const BlockchainInterval& interval, const std::vector<CompleteBlock>& blocks);
   std::error_code processPoolTxs(GetPoolResponse& response);
@@ -120,6 +131,8 @@ private:
   const Crypto::Hash m_genesisBlockHash;
 
   Crypto::Hash lastBlockId;
+  // Next batch of blocks, requested while the consumers process the current one
+  std::shared_ptr<BlocksQuery> m_prefetchedQuery;
 
   State m_currentState;
   State m_futureState;
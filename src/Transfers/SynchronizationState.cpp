@@ -6,6 +6,9 @@
 
 #include "SynchronizationState.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
@@ -79,6 +82,7 @@ SynchronizationState::CheckResult SynchronizationState::checkInterval(const Bloc
 void SynchronizationState::detach(uint32_t height) {
   assert(height < m_blockchain.size());
   m_blockchain.resize(height);
+  m_savedHeight = std::min(m_savedHeight, height);
 }
 
 void SynchronizationState::addBlocks(const Crypto::Hash* blockHashes, uint32_t height, uint32_t count) {
@@ -106,6 +110,39 @@ void SynchronizationState::load(std::istream& in) {
   StdInputStream stream(in);
   CryptoNote::BinaryInputStreamSerializer s(stream);
   serialize(s, "state");
+  clearChanges();
+}
+
+void SynchronizationState::saveChanges(std::ostream& os) {
+  StdOutputStream stream(os);
+  CryptoNote::BinaryOutputStreamSerializer s(stream);
+
+  uint32_t savedHeight = std::min(m_savedHeight, getHeight());
+  std::vector<Crypto::Hash> addedBlocks(m_blockchain.begin() + savedHeight, m_blockchain.end());
+  s(savedHeight, "height");
+  s(addedBlocks, "blocks");
+}
+
+void SynchronizationState::loadChanges(std::istream& in) {
+  StdInputStream stream(in);
+  CryptoNote::BinaryInputStreamSerializer s(stream);
+
+  uint32_t savedHeight = 0;
+  std::vector<Crypto::Hash> addedBlocks;
+  s(savedHeight, "height");
+  s(addedBlocks, "blocks");
+
+  if (savedHeight > getHeight() || (savedHeight == 0 && addedBlocks.empty())) {
+    throw std::runtime_error("Synchronization state changes don't follow the loaded state");
+  }
+
+  m_blockchain.resize(savedHeight);
+  m_blockchain.insert(m_blockchain.end(), addedBlocks.begin(), addedBlocks.end());
+  clearChanges();
+}
+
+void SynchronizationState::clearChanges() {
+  m_savedHeight = getHeight();
 }
 
 CryptoNote::ISerializer& SynchronizationState::serialize(CryptoNote::ISerializer& s, const std::string& name) {
@@ -26,7 +26,7 @@ public:
 
   typedef std::vector<Crypto::Hash> ShortHistory;
 
-  explicit SynchronizationState(const Crypto::Hash& genesisBlockHash) {
+  explicit SynchronizationState(const Crypto::Hash& genesisBlockHash) : m_savedHeight(0) {
     m_blockchain.push_back(genesisBlockHash);
   }
 
@@ -42,12 +42,19 @@ public:
   virtual void save(std::ostream& os) override;
   virtual void load(std::istream& in) override;
 
+  // Block hashes changed since the last save or clearChanges(): the height from which they differ and the hashes above it
+  void saveChanges(std::ostream& os);
+  void loadChanges(std::istream& in);
+  void clearChanges();
+
   // serialization
   CryptoNote::ISerializer& serialize(CryptoNote::ISerializer& s, const std::string& name);
 
 private:
 
   std::vector<Crypto::Hash> m_blockchain;
+  // Blocks below it are the same as in the last saved state
+  uint32_t m_savedHeight;
 };
 
 }
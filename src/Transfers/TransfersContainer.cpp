@@ -5,6 +5,9 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "TransfersContainer.h"
+
+#include <limits>
+
 #include "IWalletLegacy.h"
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
@@ -103,6 +106,18 @@ namespace {
 
     return job;
   }
+
+  // Index into the cached balance amounts
+  size_t getBalanceBucket(const TransactionOutputInformationEx& output) {
+    if (output.type == TransactionTypes::OutputType::Key) {
+      return 0;
+    }
+
+    return output.term == 0 ? 1 : 2;
+  }
+
+  const uint32_t BALANCE_BUCKET_TYPES[] = { ITransfersContainer::IncludeTypeKey, ITransfersContainer::IncludeTypeMultisignature,
+    ITransfersContainer::IncludeTypeDeposit };
 }
 
 size_t TransactionOutputKey::hash() const {
@@ -181,6 +196,8 @@ size_t SpentOutputDescriptor::hash() const {
 
 
 TransfersContainer::TransfersContainer(const Currency& currency, size_t transactionSpendableAge) :
+  m_availableAmounts(),
+  m_unconfirmedAmounts(),
   m_currentHeight(0),
   m_currency(currency),
   m_transactionSpendableAge(transactionSpendableAge) {
@@ -242,6 +259,7 @@ void TransfersContainer::addTransaction(const TransactionBlockInfo& block, const
   auto result = m_transactions.emplace(std::move(txInfo));
   (void)result; // Disable unused warning
   assert(result.second);
+  markTransactionChanged(txHash);
 }
 
 /**
@@ -271,6 +289,9 @@ bool TransfersContainer::addTransactionOutputs(const TransactionBlockInfo& block
     info.transactionHash = txHash;
     info.visible = true;
 
+    addBalanceEntry(info);
+    markTransactionChanged(txHash);
+
     if (transferIsUnconfirmed) {
       auto result = m_unconfirmedTransfers.emplace(std::move(info));
       (void)result; // Disable unused warning
@@ -346,7 +367,9 @@ bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block,
       }
 
       assert(spendingTransferIt->keyImage == input.keyImage);
+      markTransactionChanged(spendingTransferIt->transactionHash);
       deleteUnlockJob(*spendingTransferIt);
+      deleteBalanceEntry(*spendingTransferIt);
       copyToSpent(block, tx, i, *spendingTransferIt);
       // erase from available outputs
       outputDescriptorIndex.erase(spendingTransferIt);
@@ -360,7 +383,9 @@ bool TransfersContainer::addTransactionInputs(const TransactionBlockInfo& block,
       auto& outputDescriptorIndex = m_availableTransfers.get<SpentOutputDescriptorIndex>();
       auto availableOutputIt = outputDescriptorIndex.find(SpentOutputDescriptor(input.amount, input.outputIndex));
       if (availableOutputIt != outputDescriptorIndex.end()) {
+        markTransactionChanged(availableOutputIt->transactionHash);
         deleteUnlockJob(*availableOutputIt);
+        deleteBalanceEntry(*availableOutputIt);
         copyToSpent(block, tx, i, *availableOutputIt);
         // erase from available outputs
         outputDescriptorIndex.erase(availableOutputIt);
@@ -411,6 +436,7 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
   txInfo.blockHeight = block.height;
   txInfo.timestamp = block.timestamp;
   m_transactions.replace(transactionIt, txInfo);
+  markTransactionChanged(transactionHash);
 
   auto availableRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
   for (auto transferIt = availableRange.first; transferIt != availableRange.second; ) {
@@ -435,11 +461,13 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
     }
 
     addUnlockJob(transfer);
+    addBalanceEntry(transfer);
 
     auto result = m_availableTransfers.emplace(std::move(transfer));
     (void)result; // Disable unused warning
     assert(result.second);
 
+    deleteBalanceEntry(*transferIt);
     transferIt = m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(transferIt);
 
     if (transfer.type == TransactionTypes::OutputType::Key) {
@@ -455,6 +483,7 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
 
     transfer.spendingBlock = block;
     spendingTransactionIndex.replace(transferIt, transfer);
+    markTransactionChanged(transfer.transactionHash);
   }
 
   return true;
@@ -464,15 +493,19 @@ bool TransfersContainer::markTransactionConfirmed(const TransactionBlockInfo& bl
  * \pre m_mutex is locked.
  */
 void TransfersContainer::deleteTransactionTransfers(const Crypto::Hash& transactionHash) {
+  markTransactionChanged(transactionHash);
+
   auto& spendingTransactionIndex = m_spentTransfers.get<SpendingTransactionIndex>();
   auto spentTransfersRange = spendingTransactionIndex.equal_range(transactionHash);
   for (auto it = spentTransfersRange.first; it != spentTransfersRange.second;) {
     assert(it->blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT);
     assert(it->globalOutputIndex != UNCONFIRMED_TRANSACTION_GLOBAL_OUTPUT_INDEX);
+    markTransactionChanged(it->transactionHash);
 
     const TransactionOutputInformationEx& unspendingTransfer = static_cast<const TransactionOutputInformationEx&>(*it);
 
     addUnlockJob(unspendingTransfer);
+    addBalanceEntry(unspendingTransfer);
     auto result = m_availableTransfers.emplace(unspendingTransfer);
     assert(result.second);
     it = spendingTransactionIndex.erase(it);
@@ -484,6 +517,8 @@ void TransfersContainer::deleteTransactionTransfers(const Crypto::Hash& transact
 
   auto unconfirmedTransfersRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
   for (auto it = unconfirmedTransfersRange.first; it != unconfirmedTransfersRange.second;) {
+    deleteBalanceEntry(*it);
+
     if (it->type == TransactionTypes::OutputType::Key) {
       KeyImage keyImage = it->keyImage;
       it = m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(it);
@@ -497,6 +532,7 @@ void TransfersContainer::deleteTransactionTransfers(const Crypto::Hash& transact
   auto transactionTransfersRange = transactionTransfersIndex.equal_range(transactionHash);
   for (auto it = transactionTransfersRange.first; it != transactionTransfersRange.second;) {
     deleteUnlockJob(*it);
+    deleteBalanceEntry(*it);
 
     if (it->type == TransactionTypes::OutputType::Key) {
       KeyImage keyImage = it->keyImage;
@@ -597,6 +633,19 @@ void TransfersContainer::updateTransfersVisibility(const KeyImage& keyImage) {
   size_t spentCount = std::distance(spentRange.first, spentRange.second);
   assert(spentCount == 0 || spentCount == 1);
 
+  markTransactionsChanged(unconfirmedRange);
+  markTransactionsChanged(availableRange);
+  markTransactionsChanged(spentRange);
+
+  // Visibility is recalculated below, the cached amounts are brought up to date afterwards
+  for (auto it = unconfirmedRange.first; it != unconfirmedRange.second; ++it) {
+    subtractVisibleAmount(*it);
+  }
+
+  for (auto it = availableRange.first; it != availableRange.second; ++it) {
+    subtractVisibleAmount(*it);
+  }
+
   if (spentCount > 0) {
     updateVisibility(unconfirmedIndex, unconfirmedRange, false);
     updateVisibility(availableIndex, availableRange, false);
@@ -615,6 +664,14 @@ void TransfersContainer::updateTransfersVisibility(const KeyImage& keyImage) {
   } else {
     updateVisibility(unconfirmedIndex, unconfirmedRange, unconfirmedCount == 1);
   }
+
+  for (auto it = unconfirmedRange.first; it != unconfirmedRange.second; ++it) {
+    addVisibleAmount(*it);
+  }
+
+  for (auto it = availableRange.first; it != availableRange.second; ++it) {
+    addVisibleAmount(*it);
+  }
 }
 
 std::vector<TransactionOutputInformation> TransfersContainer::advanceHeight(uint32_t height) {
@@ -650,6 +707,48 @@ uint64_t TransfersContainer::balance(uint32_t flags) const {
   std::lock_guard<std::mutex> lk(m_mutex);
   uint64_t amount = 0;
 
+  for (size_t bucket = 0; bucket < m_availableAmounts.size(); ++bucket) {
+    if ((flags & BALANCE_BUCKET_TYPES[bucket]) == 0) {
+      continue;
+    }
+
+    if ((flags & IncludeStateUnlocked) != 0) {
+      amount += m_availableAmounts[bucket];
+    }
+
+    if ((flags & IncludeStateLocked) != 0) {
+      amount += m_unconfirmedAmounts[bucket];
+    }
+  }
+
+  // Outputs that may still be locked were counted above as unlocked, correct them by their actual state
+  auto& availableIndex = m_availableTransfers.get<TransactionOutputKeyIndex>();
+  for (auto it = m_maturingTransfers.upper_bound(m_currentHeight); it != m_maturingTransfers.end(); ++it) {
+    auto transferIt = availableIndex.find(it->second);
+    assert(transferIt != availableIndex.end());
+    if (!transferIt->visible) {
+      continue;
+    }
+
+    bool counted = isIncluded(*transferIt, IncludeStateUnlocked, flags);
+    bool included = isIncluded(*transferIt, flags);
+    if (counted && !included) {
+      amount -= transferIt->amount;
+    } else if (!counted && included) {
+      amount += transferIt->amount;
+    }
+  }
+
+  assert(amount == scanBalance(flags));
+  return amount;
+}
+
+/**
+ * \pre m_mutex is locked.
+ */
+uint64_t TransfersContainer::scanBalance(uint32_t flags) const {
+  uint64_t amount = 0;
+
   for (const auto& t : m_availableTransfers) {
     if (t.visible && isIncluded(t, flags)) {
       amount += t.amount;
@@ -904,6 +1003,151 @@ void TransfersContainer::load(std::istream& in) {
   m_availableTransfers = std::move(availableTransfers);
   m_spentTransfers = std::move(spentTransfers);
   m_transfersUnlockJobs = std::move(transfersUnlockJobs);
+
+  rebuildBalanceEntries();
+  m_changedTransactions.clear();
+}
+
+void TransfersContainer::saveChanges(std::ostream& os) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  StdOutputStream stream(os);
+  CryptoNote::BinaryOutputStreamSerializer s(stream);
+
+  s(const_cast<uint32_t&>(TRANSFERS_CONTAINER_STORAGE_VERSION), "version");
+  s(m_currentHeight, "height");
+
+  size_t count = m_changedTransactions.size();
+  s.beginArray(count, "transactions");
+  for (const Crypto::Hash& transactionHash : m_changedTransactions) {
+    s.beginObject("");
+    s(const_cast<Crypto::Hash&>(transactionHash), "hash");
+
+    // A transaction that isn't there anymore is written without information and outputs, which deletes it on load
+    auto transactionIt = m_transactions.find(transactionHash);
+    bool exists = transactionIt != m_transactions.end();
+    s(exists, "exists");
+    if (exists) {
+      s(const_cast<TransactionInformation&>(*transactionIt), "information");
+
+      auto unconfirmedRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
+      auto availableRange = m_availableTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
+      auto spentRange = m_spentTransfers.get<ContainingTransactionIndex>().equal_range(transactionHash);
+      writeSequence<TransactionOutputInformationEx>(unconfirmedRange.first, unconfirmedRange.second, "unconfirmedTransfers", s);
+      writeSequence<TransactionOutputInformationEx>(availableRange.first, availableRange.second, "availableTransfers", s);
+      writeSequence<SpentTransactionOutput>(spentRange.first, spentRange.second, "spentTransfers", s);
+    }
+
+    s.endObject();
+  }
+  s.endArray();
+}
+
+void TransfersContainer::loadChanges(std::istream& in) {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  StdInputStream stream(in);
+  CryptoNote::BinaryInputStreamSerializer s(stream);
+
+  uint32_t version = 0;
+  s(version, "version");
+
+  if (version > TRANSFERS_CONTAINER_STORAGE_VERSION) {
+    throw std::runtime_error("Unsupported transfers storage version");
+  }
+
+  struct TransactionChange {
+    Crypto::Hash hash;
+    bool exists;
+    TransactionInformation information;
+    std::vector<TransactionOutputInformationEx> unconfirmedTransfers;
+    std::vector<TransactionOutputInformationEx> availableTransfers;
+    std::vector<SpentTransactionOutput> spentTransfers;
+  };
+
+  // Everything is read before anything is changed, so a damaged record leaves the container as it was
+  uint32_t currentHeight = 0;
+  std::vector<TransactionChange> changes;
+  s(currentHeight, "height");
+
+  size_t count = 0;
+  s.beginArray(count, "transactions");
+  changes.resize(count);
+  for (TransactionChange& change : changes) {
+    s.beginObject("");
+    s(change.hash, "hash");
+    s(change.exists, "exists");
+    if (change.exists) {
+      s(change.information, "information");
+      readSequence<TransactionOutputInformationEx>(std::back_inserter(change.unconfirmedTransfers), "unconfirmedTransfers", s);
+      readSequence<TransactionOutputInformationEx>(std::back_inserter(change.availableTransfers), "availableTransfers", s);
+      readSequence<SpentTransactionOutput>(std::back_inserter(change.spentTransfers), "spentTransfers", s);
+    }
+
+    s.endObject();
+  }
+  s.endArray();
+
+  for (const TransactionChange& change : changes) {
+    auto unconfirmedRange = m_unconfirmedTransfers.get<ContainingTransactionIndex>().equal_range(change.hash);
+    for (auto it = unconfirmedRange.first; it != unconfirmedRange.second;) {
+      deleteBalanceEntry(*it);
+      it = m_unconfirmedTransfers.get<ContainingTransactionIndex>().erase(it);
+    }
+
+    auto availableRange = m_availableTransfers.get<ContainingTransactionIndex>().equal_range(change.hash);
+    for (auto it = availableRange.first; it != availableRange.second;) {
+      deleteUnlockJob(*it);
+      deleteBalanceEntry(*it);
+      it = m_availableTransfers.get<ContainingTransactionIndex>().erase(it);
+    }
+
+    m_spentTransfers.get<ContainingTransactionIndex>().erase(change.hash);
+    m_transactions.erase(change.hash);
+  }
+
+  for (const TransactionChange& change : changes) {
+    if (!change.exists) {
+      continue;
+    }
+
+    m_transactions.insert(change.information);
+
+    for (const auto& transfer : change.unconfirmedTransfers) {
+      addBalanceEntry(transfer);
+      m_unconfirmedTransfers.insert(transfer);
+    }
+
+    for (const auto& transfer : change.availableTransfers) {
+      addUnlockJob(transfer);
+      addBalanceEntry(transfer);
+      m_availableTransfers.insert(transfer);
+    }
+
+    m_spentTransfers.insert(change.spentTransfers.begin(), change.spentTransfers.end());
+  }
+
+  m_currentHeight = currentHeight;
+  m_changedTransactions.clear();
+}
+
+void TransfersContainer::clearChanges() {
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_changedTransactions.clear();
+}
+
+/**
+ *  \pre m_mutex is locked
+ */
+void TransfersContainer::markTransactionChanged(const Crypto::Hash& transactionHash) {
+  m_changedTransactions.insert(transactionHash);
+}
+
+/**
+ *  \pre m_mutex is locked
+ */
+template<class Range> void TransfersContainer::markTransactionsChanged(const Range& range) {
+  for (auto it = range.first; it != range.second; ++it) {
+    m_changedTransactions.insert(it->transactionHash);
+  }
 }
 
 void TransfersContainer::rebuildTransfersUnlockJobs(TransfersUnlockMultiIndex& transfersUnlockJobs, const AvailableTransfersMultiIndex& availableTransfers,
@@ -985,6 +1229,94 @@ void TransfersContainer::deleteUnlockJob(const TransactionOutputInformationEx& o
   index.erase(it);
 }
 
+/**
+ *  Returns the height from which the output is unlocked whatever the current time is
+ */
+uint64_t TransfersContainer::getFinalUnlockHeight(const TransactionOutputInformationEx& output) const {
+  if (output.unlockTime >= m_currency.maxBlockHeight()) {
+    // unlock time is a timestamp, such outputs have to be checked every time
+    return std::numeric_limits<uint64_t>::max();
+  }
+
+  uint64_t unlockHeight = static_cast<uint64_t>(output.blockHeight) + m_transactionSpendableAge;
+  uint64_t allowedDelta = m_currency.lockedTxAllowedDeltaBlocks();
+  if (output.unlockTime > allowedDelta) {
+    unlockHeight = std::max(unlockHeight, output.unlockTime - allowedDelta);
+  }
+
+  if (output.type == TransactionTypes::OutputType::Multisignature && output.term != 0) {
+    unlockHeight = std::max(unlockHeight, static_cast<uint64_t>(output.blockHeight) + output.term - 1);
+  }
+
+  return unlockHeight;
+}
+
+/**
+ *  \pre m_mutex is locked
+ */
+void TransfersContainer::addBalanceEntry(const TransactionOutputInformationEx& output) {
+  addVisibleAmount(output);
+
+  if (output.blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) {
+    m_maturingTransfers.emplace(getFinalUnlockHeight(output), output.getTransactionOutputKey());
+  }
+}
+
+/**
+ *  \pre m_mutex is locked
+ */
+void TransfersContainer::deleteBalanceEntry(const TransactionOutputInformationEx& output) {
+  subtractVisibleAmount(output);
+
+  if (output.blockHeight != WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT) {
+    auto range = m_maturingTransfers.equal_range(getFinalUnlockHeight(output));
+    auto it = std::find_if(range.first, range.second, [&output](const std::pair<const uint64_t, TransactionOutputKey>& entry) {
+      return entry.second == output.getTransactionOutputKey();
+    });
+
+    assert(it != range.second);
+    if (it != range.second) {
+      m_maturingTransfers.erase(it);
+    }
+  }
+}
+
+void TransfersContainer::addVisibleAmount(const TransactionOutputInformationEx& output) {
+  if (!output.visible) {
+    return;
+  }
+
+  auto& amounts = output.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT ? m_unconfirmedAmounts : m_availableAmounts;
+  amounts[getBalanceBucket(output)] += output.amount;
+}
+
+void TransfersContainer::subtractVisibleAmount(const TransactionOutputInformationEx& output) {
+  if (!output.visible) {
+    return;
+  }
+
+  auto& amounts = output.blockHeight == WALLET_LEGACY_UNCONFIRMED_TRANSACTION_HEIGHT ? m_unconfirmedAmounts : m_availableAmounts;
+  assert(amounts[getBalanceBucket(output)] >= output.amount);
+  amounts[getBalanceBucket(output)] -= output.amount;
+}
+
+/**
+ *  \pre m_mutex is locked
+ */
+void TransfersContainer::rebuildBalanceEntries() {
+  m_availableAmounts.fill(0);
+  m_unconfirmedAmounts.fill(0);
+  m_maturingTransfers.clear();
+
+  for (const auto& output : m_unconfirmedTransfers) {
+    addBalanceEntry(output);
+  }
+
+  for (const auto& output : m_availableTransfers) {
+    addBalanceEntry(output);
+  }
+}
+
 /**
  *  \pre m_mutex is locked
  */
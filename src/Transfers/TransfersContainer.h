@@ -6,8 +6,11 @@
 
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <map>
 #include <unordered_map>
+#include <unordered_set>
 #include <mutex>
 
 #include <boost/multi_index_container.hpp>
@@ -216,6 +219,11 @@ public:
   virtual void save(std::ostream& os) override;
   virtual void load(std::istream& in) override;
 
+  // Transactions changed since the last load or clearChanges(), each written with all the outputs it contains
+  void saveChanges(std::ostream& os);
+  void loadChanges(std::istream& in);
+  void clearChanges();
+
 private:
   struct ContainingTransactionIndex { };
   struct SpendingTransactionIndex { };
@@ -363,6 +371,16 @@ private:
                                   const SpentTransfersMultiIndex& spentTransfers);
   std::vector<TransactionOutputInformation> doAdvanceHeight(uint32_t height);
 
+  uint64_t getFinalUnlockHeight(const TransactionOutputInformationEx& output) const;
+  void addBalanceEntry(const TransactionOutputInformationEx& output);
+  void deleteBalanceEntry(const TransactionOutputInformationEx& output);
+  void addVisibleAmount(const TransactionOutputInformationEx& output);
+  void subtractVisibleAmount(const TransactionOutputInformationEx& output);
+  void rebuildBalanceEntries();
+  uint64_t scanBalance(uint32_t flags) const;
+  void markTransactionChanged(const Crypto::Hash& transactionHash);
+  template<class Range> void markTransactionsChanged(const Range& range);
+
 private:
   TransactionMultiIndex m_transactions;
   UnconfirmedTransfersMultiIndex m_unconfirmedTransfers;
@@ -371,6 +389,15 @@ private:
   TransfersUnlockMultiIndex m_transfersUnlockJobs;
   //std::unordered_map<KeyImage, KeyOutputInfo, boost::hash<KeyImage>> m_keyImages;
 
+  // Amounts of visible outputs indexed by output kind: key, multisignature, deposit
+  std::array<uint64_t, 3> m_availableAmounts;
+  std::array<uint64_t, 3> m_unconfirmedAmounts;
+  // Available outputs by the height from which they are unlocked for good. balance() only has to look
+  // at the ones above the current height, everything below counts as unlocked
+  std::multimap<uint64_t, TransactionOutputKey> m_maturingTransfers;
+  // Transactions whose information or outputs changed since the last save, including deleted ones
+  std::unordered_set<Crypto::Hash> m_changedTransactions;
+
   uint32_t m_currentHeight; // current height is needed to check if a transfer is unlocked
   size_t m_transactionSpendableAge;
   const CryptoNote::Currency& m_currency;
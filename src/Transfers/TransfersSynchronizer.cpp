@@ -6,6 +6,8 @@
 
 #include "TransfersSynchronizer.h"
 #include "TransfersConsumer.h"
+#include "TransfersContainer.h"
+#include "SynchronizationState.h"
 
 #include "Common/StdInputStream.h"
 #include "Common/StdOutputStream.h"
@@ -19,6 +21,20 @@ namespace CryptoNote {
 
 const uint32_t TRANSFERS_STORAGE_ARCHIVE_VERSION = 0;
 
+namespace {
+
+// Changes are kept by the implementations behind the interfaces the synchronizer holds
+template<class T, class Interface> T& changesOf(Interface& object) {
+  T* result = dynamic_cast<T*>(&object);
+  if (result == nullptr) {
+    throw std::runtime_error("TransfersSyncronizer state doesn't keep changes");
+  }
+
+  return *result;
+}
+
+}
+
 TransfersSyncronizer::TransfersSyncronizer(const CryptoNote::Currency& currency, Logging::ILogger& logger, IBlockchainSynchronizer& sync, INode& node) :
   m_currency(currency), m_logger(logger, "TransfersSyncronizer"), m_sync(sync), m_node(node) {
 }
@@ -328,4 +344,112 @@ TransfersSyncronizer::SubscribersContainer::const_iterator TransfersSyncronizer:
   return m_subscribers.end();
 }
 
+void TransfersSyncronizer::saveChanges(std::ostream& os) {
+  StdOutputStream stream(os);
+  CryptoNote::BinaryOutputStreamSerializer s(stream);
+  s(const_cast<uint32_t&>(TRANSFERS_STORAGE_ARCHIVE_VERSION), "version");
+
+  size_t consumerCount = m_consumers.size();
+  s.beginArray(consumerCount, "consumers");
+
+  for (const auto& consumer : m_consumers) {
+    s.beginObject("");
+    s(const_cast<PublicKey&>(consumer.first), "view_key");
+
+    std::stringstream consumerChanges;
+    changesOf<SynchronizationState>(*m_sync.getConsumerState(consumer.second.get())).saveChanges(consumerChanges);
+    std::string blob = consumerChanges.str();
+    s(blob, "state");
+
+    std::vector<AccountPublicAddress> subscriptions;
+    consumer.second->getSubscriptions(subscriptions);
+    size_t subCount = subscriptions.size();
+    s.beginArray(subCount, "subscriptions");
+
+    for (auto& addr : subscriptions) {
+      auto sub = consumer.second->getSubscription(addr);
+      assert(sub != nullptr);
+      s.beginObject("");
+
+      std::stringstream subChanges;
+      changesOf<TransfersContainer>(sub->getContainer()).saveChanges(subChanges);
+      std::string blob = subChanges.str();
+      s(addr, "address");
+      s(blob, "state");
+
+      s.endObject();
+    }
+
+    s.endArray();
+    s.endObject();
+  }
+
+  s.endArray();
+}
+
+void TransfersSyncronizer::loadChanges(std::istream& is) {
+  StdInputStream inputStream(is);
+  CryptoNote::BinaryInputStreamSerializer s(inputStream);
+
+  uint32_t version = 0;
+  s(version, "version");
+  if (version > TRANSFERS_STORAGE_ARCHIVE_VERSION) {
+    throw std::runtime_error("TransfersSyncronizer version mismatch");
+  }
+
+  size_t consumerCount = 0;
+  s.beginArray(consumerCount, "consumers");
+
+  while (consumerCount--) {
+    s.beginObject("");
+    PublicKey viewKey;
+    std::string blob;
+    s(viewKey, "view_key");
+    s(blob, "state");
+
+    // Changes of consumers and subscriptions removed since then are skipped, as load() skips their state
+    auto consumerIt = m_consumers.find(viewKey);
+    if (consumerIt != m_consumers.end()) {
+      std::stringstream consumerChanges(blob);
+      changesOf<SynchronizationState>(*m_sync.getConsumerState(consumerIt->second.get())).loadChanges(consumerChanges);
+    }
+
+    size_t subCount = 0;
+    s.beginArray(subCount, "subscriptions");
+
+    while (subCount--) {
+      s.beginObject("");
+      AccountPublicAddress acc;
+      std::string state;
+      s(acc, "address");
+      s(state, "state");
+
+      ITransfersSubscription* sub = consumerIt != m_consumers.end() ? consumerIt->second->getSubscription(acc) : nullptr;
+      if (sub != nullptr) {
+        std::stringstream subChanges(state);
+        changesOf<TransfersContainer>(sub->getContainer()).loadChanges(subChanges);
+      }
+
+      s.endObject();
+    }
+
+    s.endArray();
+    s.endObject();
+  }
+
+  s.endArray();
+}
+
+void TransfersSyncronizer::clearChanges() {
+  for (const auto& consumer : m_consumers) {
+    changesOf<SynchronizationState>(*m_sync.getConsumerState(consumer.second.get())).clearChanges();
+
+    std::vector<AccountPublicAddress> subscriptions;
+    consumer.second->getSubscriptions(subscriptions);
+    for (auto& addr : subscriptions) {
+      changesOf<TransfersContainer>(consumer.second->getSubscription(addr)->getContainer()).clearChanges();
+    }
+  }
+}
+
 }
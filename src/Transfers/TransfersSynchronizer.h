@@ -48,6 +48,11 @@ public:
   virtual void save(std::ostream& os) override;
   virtual void load(std::istream& in) override;
 
+  // Block hashes and transfers changed since the last load or clearChanges(), to be applied over the last saved state
+  void saveChanges(std::ostream& os);
+  void loadChanges(std::istream& in);
+  void clearChanges();
+
 private:
   Logging::LoggerRef m_logger;
 
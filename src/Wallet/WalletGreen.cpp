@@ -287,7 +287,11 @@ namespace CryptoNote
                                                                                                                                                                 m_pendingBalance(0),
                                                                                                                                                                 m_lockedDepositBalance(0),
                                                                                                                                                                 m_unlockedDepositBalance(0),
-                                                                                                                                                                m_transactionSoftLockTime(transactionSoftLockTime)
+                                                                                                                                                                m_transactionSoftLockTime(transactionSoftLockTime),
+                                                                                                                                                                m_journalTransactionCount(0),
+                                                                                                                                                                m_journalDepositCount(0),
+                                                                                                                                                                m_journalSnapshotSize(0),
+                                                                                                                                                                m_journalCompactionRequired(true)
   {
     m_readyEvent.set();
   }
@@ -803,13 +807,194 @@ namespace CryptoNote
         m_transactionSoftLockTime);
     s.save(containerStream, saveLevel);
     encryptAndSaveContainerData(storage, key, containerData.data(), containerData.size());
+
+    // The snapshot replaced any journal records, so older versions can read the container again
+    ContainerStoragePrefix *prefix = reinterpret_cast<ContainerStoragePrefix *>(storage.prefix());
+    if (prefix->version == WalletSerializerV2::JOURNAL_VERSION)
+    {
+      prefix->version = WalletSerializerV2::SERIALIZATION_VERSION;
+    }
+
     storage.flush();
 
+    if (&storage == &m_containerStorage)
+    {
+      resetWalletJournal();
+      m_synchronizer.clearChanges();
+      // Journal records address transactions by index, so they can only follow a snapshot that kept all of them
+      m_journalCompactionRequired = saveLevel != WalletSaveLevel::SAVE_ALL || transactions.size() != m_transactions.size();
+    }
+
     m_extra = extra;
 
     m_logger(INFO) << "Container saving finished";
   }
 
+  bool WalletGreen::saveWalletJournalRecord(const std::string &extra)
+  {
+    if (m_journalCompactionRequired || m_containerStorage.suffixSize() == 0)
+    {
+      return false;
+    }
+
+    // Compact once the journal outgrows the snapshot it is based on
+    uint64_t journalSize = m_containerStorage.suffixSize() - m_journalSnapshotSize;
+    if (journalSize >= m_journalSnapshotSize)
+    {
+      return false;
+    }
+
+    std::set<size_t> transactionIds = m_journalTransactions;
+    for (size_t id = m_journalTransactionCount; id < m_transactions.size(); ++id)
+    {
+      transactionIds.insert(id);
+    }
+
+    std::set<size_t> depositIds = m_journalDeposits;
+    for (size_t id = m_journalDepositCount; id < m_deposits.size(); ++id)
+    {
+      depositIds.insert(id);
+    }
+
+    m_logger(INFO) << "Saving moonbank journal record, " << m_journalWallets.size() << " balances, " << transactionIds.size() << " transactions, " << depositIds.size() << " deposits changed";
+
+    std::string recordData;
+    Common::StringOutputStream recordStream(recordData);
+    WalletSerializerV2 s(
+        *this,
+        m_viewPublicKey,
+        m_viewSecretKey,
+        m_actualBalance,
+        m_pendingBalance,
+        m_lockedDepositBalance,
+        m_unlockedDepositBalance,
+        m_walletsContainer,
+        m_synchronizer,
+        m_unlockTransactionsJob,
+        m_transactions,
+        m_transfers,
+        m_deposits,
+        m_uncommitedTransactions,
+        const_cast<std::string &>(extra),
+        m_transactionSoftLockTime);
+    s.saveJournalRecord(recordStream, m_journalWallets, transactionIds, depositIds);
+
+    // Persist the IV increment before the record, so a crash can never lead to IV reuse
+    ContainerStoragePrefix *prefix = reinterpret_cast<ContainerStoragePrefix *>(m_containerStorage.prefix());
+    Crypto::chacha8_iv recordIv = prefix->nextIv;
+    incIv(prefix->nextIv);
+    prefix->version = WalletSerializerV2::JOURNAL_VERSION;
+    m_containerStorage.flush();
+
+    BinaryArray encryptedRecord;
+    encryptedRecord.resize(recordData.size());
+    chacha8(recordData.data(), recordData.size(), m_key, recordIv, reinterpret_cast<char *>(encryptedRecord.data()));
+    Crypto::Hash checksum = Crypto::cn_fast_hash(encryptedRecord.data(), encryptedRecord.size());
+
+    std::string record;
+    Common::StringOutputStream stream(record);
+    BinaryOutputStreamSerializer serializer(stream);
+    serializer(recordIv, "recordIv");
+    serializer(encryptedRecord, "encryptedRecord");
+    serializer(checksum, "checksum");
+
+    m_containerStorage.appendSuffix(record.data(), record.size());
+
+    m_synchronizer.clearChanges();
+    m_journalWallets.clear();
+    m_journalTransactions.clear();
+    m_journalDeposits.clear();
+    m_journalTransactionCount = m_transactions.size();
+    m_journalDepositCount = m_deposits.size();
+    m_extra = extra;
+
+    m_logger(INFO) << "Container journal saving finished, journal size " << m_containerStorage.suffixSize() - m_journalSnapshotSize;
+    return true;
+  }
+
+  void WalletGreen::loadWalletJournal(WalletSerializerV2 &serializer, size_t snapshotSize)
+  {
+    Common::MemoryInputStream journalStream(m_containerStorage.suffix() + snapshotSize, m_containerStorage.suffixSize() - snapshotSize);
+
+    std::vector<BinaryArray> records;
+    bool damaged = false;
+    try
+    {
+      while (!journalStream.endOfStream())
+      {
+        BinaryInputStreamSerializer recordSerializer(journalStream);
+        Crypto::chacha8_iv recordIv;
+        BinaryArray encryptedRecord;
+        Crypto::Hash checksum;
+        recordSerializer(recordIv, "recordIv");
+        recordSerializer(encryptedRecord, "encryptedRecord");
+        recordSerializer(checksum, "checksum");
+
+        if (Crypto::cn_fast_hash(encryptedRecord.data(), encryptedRecord.size()) != checksum)
+        {
+          damaged = true;
+          break;
+        }
+
+        BinaryArray record(encryptedRecord.size());
+        chacha8(encryptedRecord.data(), encryptedRecord.size(), m_key, recordIv, reinterpret_cast<char *>(record.data()));
+        records.emplace_back(std::move(record));
+      }
+    }
+    catch (const std::exception &)
+    {
+      damaged = true;
+    }
+
+    if (damaged)
+    {
+      // An interrupted append leaves a partial record at the end; earlier records are still consistent
+      m_logger(WARNING, BRIGHT_YELLOW) << "Container journal has a damaged tail, " << records.size() << " records are used";
+    }
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+      Common::MemoryInputStream recordStream(records[i].data(), records[i].size());
+      serializer.loadJournalRecord(recordStream);
+    }
+
+    resetWalletJournal();
+    m_journalSnapshotSize = snapshotSize;
+    // Records only hold changes of the keys in the snapshot, keys added or removed since then need a new one
+    m_journalCompactionRequired = damaged || !serializer.addedKeys().empty() || !serializer.deletedKeys().empty();
+
+    if (!records.empty())
+    {
+      m_logger(INFO) << "Container journal loaded, " << records.size() << " records";
+    }
+  }
+
+  void WalletGreen::resetWalletJournal()
+  {
+    m_journalWallets.clear();
+    m_journalTransactions.clear();
+    m_journalDeposits.clear();
+    m_journalTransactionCount = m_transactions.size();
+    m_journalDepositCount = m_deposits.size();
+    m_journalSnapshotSize = m_containerStorage.isOpened() ? m_containerStorage.suffixSize() : 0;
+  }
+
+  void WalletGreen::markTransactionChanged(size_t transactionId)
+  {
+    if (transactionId < m_journalTransactionCount)
+    {
+      m_journalTransactions.insert(transactionId);
+    }
+  }
+
+  void WalletGreen::markDepositChanged(size_t depositId)
+  {
+    if (depositId < m_journalDepositCount)
+    {
+      m_journalDeposits.insert(depositId);
+    }
+  }
+
   void WalletGreen::doShutdown()
   {
     if (m_walletsContainer.size() != 0)
@@ -892,7 +1077,10 @@ namespace CryptoNote
 
     try
     {
-      saveWalletMoonBank(m_containerStorage, m_key, saveLevel, extra);
+      if (saveLevel != WalletSaveLevel::SAVE_ALL || !saveWalletJournalRecord(extra))
+      {
+        saveWalletMoonBank(m_containerStorage, m_key, saveLevel, extra);
+      }
     }
     catch (const std::exception &e)
     {
@@ -1068,7 +1256,7 @@ namespace CryptoNote
     incIv(prefix->nextIv);
   }
 
-  void WalletGreen::loadAndDecryptContainerData(ContainerStorage &storage, const Crypto::chacha8_key &key, BinaryArray &containerData)
+  size_t WalletGreen::loadAndDecryptContainerData(ContainerStorage &storage, const Crypto::chacha8_key &key, BinaryArray &containerData)
   {
     Common::MemoryInputStream suffixStream(storage.suffix(), storage.suffixSize());
     BinaryInputStreamSerializer suffixSerializer(suffixStream);
@@ -1079,6 +1267,8 @@ namespace CryptoNote
 
     containerData.resize(encryptedContainer.size());
     chacha8(encryptedContainer.data(), encryptedContainer.size(), key, suffixIv, reinterpret_cast<char *>(containerData.data()));
+
+    return suffixStream.getPosition();
   }
 
   void WalletGreen::loadWalletMoonBank(std::unordered_set<Crypto::PublicKey> &addedKeys, std::unordered_set<Crypto::PublicKey> &deletedKeys, std::string &extra)
@@ -1086,7 +1276,7 @@ namespace CryptoNote
     assert(m_containerStorage.isOpened());
 
     BinaryArray contanerData;
-    loadAndDecryptContainerData(m_containerStorage, m_key, contanerData);
+    size_t snapshotSize = loadAndDecryptContainerData(m_containerStorage, m_key, contanerData);
 
     WalletSerializerV2 s(
         *this,
@@ -1108,6 +1298,7 @@ namespace CryptoNote
 
     Common::MemoryInputStream containerStream(contanerData.data(), contanerData.size());
     s.load(containerStream, reinterpret_cast<const ContainerStoragePrefix *>(m_containerStorage.prefix())->version);
+    loadWalletJournal(s, snapshotSize);
     addedKeys = std::move(s.addedKeys());
     deletedKeys = std::move(s.deletedKeys());
 
@@ -1211,7 +1402,7 @@ namespace CryptoNote
     {
       walletFileStream.close();
 
-      if (version > WalletSerializerV2::SERIALIZATION_VERSION)
+      if (version > WalletSerializerV2::JOURNAL_VERSION)
       {
         m_logger(ERROR, BRIGHT_RED) << "Unsupported wallet version: " << version;
         throw std::system_error(make_error_code(error::WRONG_VERSION), "Unsupported wallet version");
@@ -1255,6 +1446,8 @@ namespace CryptoNote
       }
     }
 
+    rebuildTransactionIndices();
+
     // Read all output keys moonbank
     try
     {
@@ -1312,11 +1505,15 @@ namespace CryptoNote
 
   void WalletGreen::clearMoonBanks(bool clearTransactions, bool clearMoonBankdData)
   {
+    m_journalCompactionRequired = true;
+
     if (clearTransactions)
     {
       m_transactions.clear();
       m_transfers.clear();
       m_deposits.clear();
+      m_paymentIdTransactions.clear();
+      m_addressTransactions.clear();
     }
 
     if (clearMoonBankdData)
@@ -1632,6 +1829,8 @@ namespace CryptoNote
 
     m_containerStorage.push_back(encryptKeyPair(spendPublicKey, spendSecretKey, creationTimestamp));
     incNextIv();
+    // Journal records only carry balances of the keys in the snapshot
+    m_journalCompactionRequired = true;
 
     try
     {
@@ -2112,6 +2311,7 @@ namespace CryptoNote
       d.amount = dest.amount;
 
       m_transfers.emplace_back(txId, std::move(d));
+      addAddressIndexEntry(txId, dest.address);
     }
   }
 
@@ -2133,6 +2333,7 @@ namespace CryptoNote
 
     size_t txId = m_transactions.get<RandomAccessIndex>().size();
     m_transactions.get<RandomAccessIndex>().push_back(std::move(insertTx));
+    addPaymentIdIndexEntry(txId);
 
     pushEvent(makeTransactionCreatedEvent(txId));
 
@@ -2148,6 +2349,7 @@ namespace CryptoNote
       m_transactions.get<RandomAccessIndex>().modify(it, [state](WalletTransaction &tx) {
         tx.state = state;
       });
+      markTransactionChanged(transactionId);
 
       pushEvent(makeTransactionUpdatedEvent(transactionId));
     }
@@ -2173,6 +2375,11 @@ namespace CryptoNote
       std::cout << "Unable to update wallet deposit information." << std::endl;
     }
 
+    if (updated)
+    {
+      markDepositChanged(depositId);
+    }
+
     return updated;
   }
 
@@ -2183,7 +2390,9 @@ namespace CryptoNote
     auto it = std::next(txIdIndex.begin(), transactionId);
 
     bool updated = false;
-    bool r = txIdIndex.modify(it, [&info, totalAmount, &updated](WalletTransaction &transaction) {
+    bool extraUpdated = false;
+    std::string previousExtra;
+    bool r = txIdIndex.modify(it, [&info, totalAmount, &updated, &extraUpdated, &previousExtra](WalletTransaction &transaction) {
       if (transaction.firstDepositId != info.firstDepositId)
       {
         transaction.firstDepositId = info.firstDepositId;
@@ -2223,8 +2432,10 @@ namespace CryptoNote
       // Fix LegacyWallet error. Some old versions didn't fill extra field
       if (transaction.extra.empty() && !info.extra.empty())
       {
+        previousExtra = std::move(transaction.extra);
         transaction.extra = Common::asString(info.extra);
         updated = true;
+        extraUpdated = true;
       }
 
       bool isBase = info.totalAmountIn == 0;
@@ -2240,6 +2451,17 @@ namespace CryptoNote
       std::cout << "Unable to update wallet transaction information." << std::endl;
     }
 
+    if (extraUpdated)
+    {
+      removePaymentIdIndexEntry(transactionId, previousExtra);
+      addPaymentIdIndexEntry(transactionId);
+    }
+
+    if (updated)
+    {
+      markTransactionChanged(transactionId);
+    }
+
     return updated;
   }
 
@@ -2271,6 +2493,7 @@ namespace CryptoNote
 
     size_t txId = index.size();
     index.push_back(std::move(tx));
+    addPaymentIdIndexEntry(txId);
 
     return txId;
   }
@@ -2430,6 +2653,11 @@ namespace CryptoNote
     updated |= updateUnknownTransfers(transactionId, firstTransferIdx, myInputAddresses, knownInputsAmount, myInputsAmount, allInputsAmount, false);
     updated |= updateUnknownTransfers(transactionId, firstTransferIdx, myOutputAddresses, knownOutputsAmount, myOutputsAmount, allOutputsAmount, true);
 
+    if (updated)
+    {
+      markTransactionChanged(transactionId);
+    }
+
     return updated;
   }
 
@@ -2526,6 +2754,7 @@ namespace CryptoNote
 
     WalletTransfer transfer{WalletTransferType::USUAL, address, amount};
     m_transfers.emplace(insertIt, std::piecewise_construct, std::forward_as_tuple(transactionId), std::forward_as_tuple(transfer));
+    addAddressIndexEntry(transactionId, address);
   }
 
   bool WalletGreen::adjustTransfer(size_t transactionId, size_t firstTransferIdx, const std::string &address, int64_t amount)
@@ -2569,6 +2798,7 @@ namespace CryptoNote
     {
       WalletTransfer transfer{WalletTransferType::USUAL, address, amount};
       m_transfers.emplace(it, std::piecewise_construct, std::forward_as_tuple(transactionId), std::forward_as_tuple(transfer));
+      addAddressIndexEntry(transactionId, address);
       updated = true;
     }
 
@@ -3036,7 +3266,7 @@ namespace CryptoNote
     return walletTransaction;
   }
 
-  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(const Crypto::Hash &blockHash, size_t count) const
+  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(const Crypto::Hash &blockHash, size_t count, bool skipEmptyBlocks) const
   {
     throwIfNotInitialized();
     throwIfStopped();
@@ -3051,10 +3281,10 @@ namespace CryptoNote
     auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
 
     uint32_t blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
-    return getTransactionsInBlocks(blockIndex, count);
+    return getTransactionsInBlocks(blockIndex, count, skipEmptyBlocks);
   }
 
-  std::vector<DepositsInBlockInfo> WalletGreen::getDeposits(const Crypto::Hash &blockHash, size_t count) const
+  std::vector<DepositsInBlockInfo> WalletGreen::getDeposits(const Crypto::Hash &blockHash, size_t count, bool skipEmptyBlocks) const
   {
     throwIfNotInitialized();
     throwIfStopped();
@@ -3069,23 +3299,73 @@ namespace CryptoNote
     auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
 
     uint32_t blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
-    return getDepositsInBlocks(blockIndex, count);
+    return getDepositsInBlocks(blockIndex, count, skipEmptyBlocks);
   }
 
-  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(uint32_t blockIndex, size_t count) const
+  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(uint32_t blockIndex, size_t count, bool skipEmptyBlocks) const
   {
     throwIfNotInitialized();
     throwIfStopped();
 
-    return getTransactionsInBlocks(blockIndex, count);
+    return getTransactionsInBlocks(blockIndex, count, skipEmptyBlocks);
   }
 
-  std::vector<DepositsInBlockInfo> WalletGreen::getDeposits(uint32_t blockIndex, size_t count) const
+  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsByPaymentId(const Crypto::Hash &paymentId, const Crypto::Hash &blockHash, size_t count) const
   {
     throwIfNotInitialized();
     throwIfStopped();
 
-    return getDepositsInBlocks(blockIndex, count);
+    uint32_t blockIndex;
+    if (!getBlockIndexByHash(blockHash, blockIndex))
+    {
+      return std::vector<TransactionsInBlockInfo>();
+    }
+
+    return getTransactionsByPaymentId(paymentId, blockIndex, count);
+  }
+
+  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsByPaymentId(const Crypto::Hash &paymentId, uint32_t blockIndex, size_t count) const
+  {
+    throwIfNotInitialized();
+    throwIfStopped();
+
+    auto it = m_paymentIdTransactions.find(paymentId);
+    if (it == m_paymentIdTransactions.end())
+    {
+      return getTransactionsInBlocks(std::vector<size_t>(), blockIndex, count);
+    }
+
+    return getTransactionsInBlocks(it->second, blockIndex, count);
+  }
+
+  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsByAddresses(const std::vector<std::string> &addresses, const Crypto::Hash &blockHash, size_t count) const
+  {
+    throwIfNotInitialized();
+    throwIfStopped();
+
+    uint32_t blockIndex;
+    if (!getBlockIndexByHash(blockHash, blockIndex))
+    {
+      return std::vector<TransactionsInBlockInfo>();
+    }
+
+    return getTransactionsByAddresses(addresses, blockIndex, count);
+  }
+
+  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsByAddresses(const std::vector<std::string> &addresses, uint32_t blockIndex, size_t count) const
+  {
+    throwIfNotInitialized();
+    throwIfStopped();
+
+    return getTransactionsInBlocks(getTransactionIdsByAddresses(addresses), blockIndex, count);
+  }
+
+  std::vector<DepositsInBlockInfo> WalletGreen::getDeposits(uint32_t blockIndex, size_t count, bool skipEmptyBlocks) const
+  {
+    throwIfNotInitialized();
+    throwIfStopped();
+
+    return getDepositsInBlocks(blockIndex, count, skipEmptyBlocks);
   }
 
   std::vector<Crypto::Hash> WalletGreen::getBlockHashes(uint32_t blockIndex, size_t count) const
@@ -3140,6 +3420,31 @@ namespace CryptoNote
     return result;
   }
 
+  std::vector<WalletTransactionWithTransfers> WalletGreen::getUnconfirmedTransactions(const std::vector<std::string> &addresses) const
+  {
+    throwIfNotInitialized();
+    throwIfStopped();
+
+    std::vector<WalletTransactionWithTransfers> result;
+    auto &transactions = m_transactions.get<RandomAccessIndex>();
+    for (size_t transactionId : getTransactionIdsByAddresses(addresses))
+    {
+      const WalletTransaction &transaction = transactions[transactionId];
+      if (transaction.blockHeight != WALLET_UNCONFIRMED_TRANSACTION_HEIGHT || transaction.state != WalletTransactionState::SUCCEEDED)
+      {
+        continue;
+      }
+
+      WalletTransactionWithTransfers transactionWithTransfers;
+      transactionWithTransfers.transaction = transaction;
+      transactionWithTransfers.transfers = getTransactionTransfers(transaction);
+
+      result.push_back(std::move(transactionWithTransfers));
+    }
+
+    return result;
+  }
+
   std::vector<size_t> WalletGreen::getDelayedTransactionIds() const
   {
     throwIfNotInitialized();
@@ -3610,6 +3915,7 @@ namespace CryptoNote
     if (updated)
     {
       auto transactionId = getTransactionId(transactionHash);
+      markTransactionChanged(transactionId);
       pushEvent(makeTransactionUpdatedEvent(transactionId));
     }
   }
@@ -3774,6 +4080,7 @@ namespace CryptoNote
         wallet.lockedDepositBalance = locked;
         wallet.unlockedDepositBalance = unlocked;
       });
+      m_journalWallets.insert(it->spendPublicKey);
 
       /* Keep the logging to debugging */
       m_logger(DEBUGGING, BRIGHT_WHITE) << "Wallet balance updated, address "
@@ -4206,7 +4513,7 @@ namespace CryptoNote
     return trimmedSelectedOuts;
   }
 
-  std::vector<DepositsInBlockInfo> WalletGreen::getDepositsInBlocks(uint32_t blockIndex, size_t count) const
+  std::vector<DepositsInBlockInfo> WalletGreen::getDepositsInBlocks(uint32_t blockIndex, size_t count, bool skipEmptyBlocks) const
   {
     if (count == 0)
     {
@@ -4223,6 +4530,27 @@ namespace CryptoNote
     auto &blockHeightIndex = m_deposits.get<BlockHeightIndex>();
     uint32_t stopIndex = static_cast<uint32_t>(std::min(m_blockchain.size(), blockIndex + count));
 
+    if (skipEmptyBlocks)
+    {
+      auto it = blockHeightIndex.lower_bound(blockIndex);
+      auto end = blockHeightIndex.lower_bound(stopIndex);
+      while (it != end)
+      {
+        uint32_t height = static_cast<uint32_t>(it->height);
+
+        DepositsInBlockInfo info;
+        info.blockHash = m_blockchain[height];
+        for (; it != end && it->height == height; ++it)
+        {
+          info.deposits.push_back(*it);
+        }
+
+        result.emplace_back(std::move(info));
+      }
+
+      return result;
+    }
+
     for (uint32_t height = blockIndex; height < stopIndex; ++height)
     {
       DepositsInBlockInfo info;
@@ -4242,7 +4570,7 @@ namespace CryptoNote
     return result;
   }
 
-  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsInBlocks(uint32_t blockIndex, size_t count) const
+  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsInBlocks(uint32_t blockIndex, size_t count, bool skipEmptyBlocks) const
   {
     if (count == 0)
     {
@@ -4259,6 +4587,40 @@ namespace CryptoNote
     auto &blockHeightIndex = m_transactions.get<BlockHeightIndex>();
     uint32_t stopIndex = static_cast<uint32_t>(std::min(m_blockchain.size(), blockIndex + count));
 
+    if (skipEmptyBlocks)
+    {
+      // Only heights present in the wallet's own index are visited, however large the requested range is
+      auto it = blockHeightIndex.lower_bound(blockIndex);
+      auto end = blockHeightIndex.lower_bound(stopIndex);
+      while (it != end)
+      {
+        uint32_t height = it->blockHeight;
+
+        TransactionsInBlockInfo info;
+        info.blockHash = m_blockchain[height];
+        for (; it != end && it->blockHeight == height; ++it)
+        {
+          if (it->state != WalletTransactionState::SUCCEEDED)
+          {
+            continue;
+          }
+
+          WalletTransactionWithTransfers transaction;
+          transaction.transaction = *it;
+          transaction.transfers = getTransactionTransfers(*it);
+
+          info.transactions.emplace_back(std::move(transaction));
+        }
+
+        if (!info.transactions.empty())
+        {
+          result.emplace_back(std::move(info));
+        }
+      }
+
+      return result;
+    }
+
     for (uint32_t height = blockIndex; height < stopIndex; ++height)
     {
       TransactionsInBlockInfo info;
@@ -4286,6 +4648,176 @@ namespace CryptoNote
     return result;
   }
 
+  std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsInBlocks(const std::vector<size_t> &transactionIds, uint32_t blockIndex, size_t count) const
+  {
+    if (count == 0)
+    {
+      throw std::system_error(make_error_code(error::WRONG_PARAMETERS), "blocks count must be greater than zero");
+    }
+
+    std::vector<TransactionsInBlockInfo> result;
+
+    if (blockIndex >= m_blockchain.size())
+    {
+      return result;
+    }
+
+    auto &transactions = m_transactions.get<RandomAccessIndex>();
+    uint32_t stopIndex = static_cast<uint32_t>(std::min(m_blockchain.size(), blockIndex + count));
+
+    std::vector<std::pair<uint32_t, size_t>> selected;
+    for (size_t transactionId : transactionIds)
+    {
+      const WalletTransaction &transaction = transactions[transactionId];
+      if (transaction.state == WalletTransactionState::SUCCEEDED && transaction.blockHeight >= blockIndex && transaction.blockHeight < stopIndex)
+      {
+        selected.emplace_back(transaction.blockHeight, transactionId);
+      }
+    }
+
+    std::sort(selected.begin(), selected.end());
+
+    for (size_t i = 0; i < selected.size(); ++i)
+    {
+      if (i == 0 || selected[i].first != selected[i - 1].first)
+      {
+        TransactionsInBlockInfo info;
+        info.blockHash = m_blockchain[selected[i].first];
+        result.emplace_back(std::move(info));
+      }
+
+      const WalletTransaction &walletTransaction = transactions[selected[i].second];
+      WalletTransactionWithTransfers transaction;
+      transaction.transaction = walletTransaction;
+      transaction.transfers = getTransactionTransfers(walletTransaction);
+
+      result.back().transactions.emplace_back(std::move(transaction));
+    }
+
+    return result;
+  }
+
+  void WalletGreen::addPaymentIdIndexEntry(size_t transactionId)
+  {
+    const WalletTransaction &transaction = m_transactions.get<RandomAccessIndex>()[transactionId];
+
+    Crypto::Hash paymentId;
+    std::vector<uint8_t> extra(transaction.extra.begin(), transaction.extra.end());
+    if (getPaymentIdFromTxExtra(extra, paymentId))
+    {
+      // Kept ascending without duplicates like the address index, entries can be added again when extra is updated
+      auto &transactionIds = m_paymentIdTransactions[paymentId];
+      auto it = std::lower_bound(transactionIds.begin(), transactionIds.end(), transactionId);
+      if (it == transactionIds.end() || *it != transactionId)
+      {
+        transactionIds.insert(it, transactionId);
+      }
+    }
+  }
+
+  void WalletGreen::removePaymentIdIndexEntry(size_t transactionId, const std::string &extra)
+  {
+    Crypto::Hash paymentId;
+    std::vector<uint8_t> extraBytes(extra.begin(), extra.end());
+    if (!getPaymentIdFromTxExtra(extraBytes, paymentId))
+    {
+      return;
+    }
+
+    auto entry = m_paymentIdTransactions.find(paymentId);
+    if (entry == m_paymentIdTransactions.end())
+    {
+      return;
+    }
+
+    auto &transactionIds = entry->second;
+    auto it = std::lower_bound(transactionIds.begin(), transactionIds.end(), transactionId);
+    if (it != transactionIds.end() && *it == transactionId)
+    {
+      transactionIds.erase(it);
+    }
+
+    if (transactionIds.empty())
+    {
+      m_paymentIdTransactions.erase(entry);
+    }
+  }
+
+  void WalletGreen::addAddressIndexEntry(size_t transactionId, const std::string &address)
+  {
+    AccountPublicAddress publicAddress;
+    if (address.empty() || !m_currency.parseAccountAddressString(address, publicAddress))
+    {
+      return;
+    }
+
+    // Transfers of older transactions may be updated, so ids are not always appended at the end
+    auto &transactionIds = m_addressTransactions[publicAddress.spendPublicKey];
+    auto it = std::lower_bound(transactionIds.begin(), transactionIds.end(), transactionId);
+    if (it == transactionIds.end() || *it != transactionId)
+    {
+      transactionIds.insert(it, transactionId);
+    }
+  }
+
+  std::vector<size_t> WalletGreen::getTransactionIdsByAddresses(const std::vector<std::string> &addresses) const
+  {
+    std::unordered_set<std::string> addressSet(addresses.begin(), addresses.end());
+    std::vector<size_t> transactionIds;
+    for (const auto &address : addressSet)
+    {
+      auto it = m_addressTransactions.find(parseAddress(address).spendPublicKey);
+      if (it != m_addressTransactions.end())
+      {
+        transactionIds.insert(transactionIds.end(), it->second.begin(), it->second.end());
+      }
+    }
+
+    std::sort(transactionIds.begin(), transactionIds.end());
+    transactionIds.erase(std::unique(transactionIds.begin(), transactionIds.end()), transactionIds.end());
+
+    // Entries are not removed when transfers are, and different addresses may share a spend key
+    auto end = std::remove_if(transactionIds.begin(), transactionIds.end(), [this, &addressSet](size_t transactionId) {
+      auto range = getTransactionTransfersRange(transactionId);
+      return std::none_of(range.first, range.second, [&addressSet](const TransactionTransferPair &transfer) {
+        return addressSet.count(transfer.second.address) != 0;
+      });
+    });
+
+    transactionIds.erase(end, transactionIds.end());
+    return transactionIds;
+  }
+
+  void WalletGreen::rebuildTransactionIndices()
+  {
+    m_paymentIdTransactions.clear();
+    m_addressTransactions.clear();
+
+    for (size_t transactionId = 0; transactionId < m_transactions.size(); ++transactionId)
+    {
+      addPaymentIdIndexEntry(transactionId);
+    }
+
+    for (const auto &transfer : m_transfers)
+    {
+      addAddressIndexEntry(transfer.first, transfer.second.address);
+    }
+  }
+
+  bool WalletGreen::getBlockIndexByHash(const Crypto::Hash &blockHash, uint32_t &blockIndex) const
+  {
+    auto &hashIndex = m_blockchain.get<BlockHashIndex>();
+    auto it = hashIndex.find(blockHash);
+    if (it == hashIndex.end())
+    {
+      return false;
+    }
+
+    auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
+    blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
+    return true;
+  }
+
   Crypto::Hash WalletGreen::getBlockHashByIndex(uint32_t blockIndex) const
   {
     assert(blockIndex < m_blockchain.size());
@@ -4405,6 +4937,9 @@ namespace CryptoNote
     bool transfersLeft = false;
     size_t firstTransactionTransfer = 0;
 
+    // Deleted transactions are dropped from the next snapshot, which renumbers them
+    m_journalCompactionRequired = true;
+
     std::vector<size_t> updatedTransactions;
 
     for (size_t i = 0; i < m_transfers.size(); ++i)
@@ -11,6 +11,8 @@
 #include "IWallet.h"
 
 #include <queue>
+#include <set>
+#include <unordered_set>
 #include <unordered_map>
 
 #include "IFusionManager.h"
@@ -25,6 +27,8 @@
 namespace CryptoNote
 {
 
+class WalletSerializerV2;
+
 class WalletGreen : public IWallet,
                     ITransfersObserver,
                     IBlockchainSynchronizerObserver,
@@ -87,15 +91,20 @@ public:
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash &transactionHash) const override;
   virtual Crypto::SecretKey getTransactionSecretKey(size_t transactionIndex) const override;
 
-  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash &blockHash, size_t count) const;
-  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash &blockHash, size_t count, bool skipEmptyBlocks = false) const;
+  virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count, bool skipEmptyBlocks = false) const;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByPaymentId(const Crypto::Hash &paymentId, const Crypto::Hash &blockHash, size_t count) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByPaymentId(const Crypto::Hash &paymentId, uint32_t blockIndex, size_t count) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByAddresses(const std::vector<std::string> &addresses, const Crypto::Hash &blockHash, size_t count) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByAddresses(const std::vector<std::string> &addresses, uint32_t blockIndex, size_t count) const override;
   
-  virtual std::vector<DepositsInBlockInfo> getDeposits(const Crypto::Hash &blockHash, size_t count) const;
-  virtual std::vector<DepositsInBlockInfo> getDeposits(uint32_t blockIndex, size_t count) const;
+  virtual std::vector<DepositsInBlockInfo> getDeposits(const Crypto::Hash &blockHash, size_t count, bool skipEmptyBlocks = false) const;
+  virtual std::vector<DepositsInBlockInfo> getDeposits(uint32_t blockIndex, size_t count, bool skipEmptyBlocks = false) const;
   
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const override;
   virtual uint32_t getBlockCount() const override;
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const override;
+  virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions(const std::vector<std::string> &addresses) const override;
 
   virtual std::vector<size_t> getDelayedTransactionIds() const override;
 
@@ -327,7 +336,7 @@ protected:
   void addUnconfirmedTransaction(const ITransactionReader &transaction);
   void removeUnconfirmedTransaction(const Crypto::Hash &transactionHash);
   void initTransactionPool();
-  static void loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData);
+  static size_t loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData);
   static void encryptAndSaveContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, const void* containerData, size_t containerDataSize);
   void loadWalletMoonBank(std::unordered_set<Crypto::PublicKey>& addedKeys, std::unordered_set<Crypto::PublicKey>& deletedKeys, std::string& extra);
 
@@ -336,6 +345,11 @@ protected:
   
     void deleteOrphanTransactions(const std::unordered_set<Crypto::PublicKey>& deletedKeys);
   void saveWalletMoonBank(ContainerStorage& storage, const Crypto::chacha8_key& key, WalletSaveLevel saveLevel, const std::string& extra);
+  bool saveWalletJournalRecord(const std::string& extra);
+  void loadWalletJournal(WalletSerializerV2& serializer, size_t snapshotSize);
+  void resetWalletJournal();
+  void markTransactionChanged(size_t transactionId);
+  void markDepositChanged(size_t depositId);
   void loadSpendKeys();
     void loadContainerStorage(const std::string& path);
 
@@ -362,8 +376,15 @@ protected:
   WalletTrackingMode getTrackingMode() const;
 
   TransfersRange getTransactionTransfersRange(size_t transactionIndex) const;
-  std::vector<TransactionsInBlockInfo> getTransactionsInBlocks(uint32_t blockIndex, size_t count) const;
-  std::vector<DepositsInBlockInfo> getDepositsInBlocks(uint32_t blockIndex, size_t count) const;
+  std::vector<TransactionsInBlockInfo> getTransactionsInBlocks(uint32_t blockIndex, size_t count, bool skipEmptyBlocks) const;
+  std::vector<DepositsInBlockInfo> getDepositsInBlocks(uint32_t blockIndex, size_t count, bool skipEmptyBlocks) const;
+  std::vector<TransactionsInBlockInfo> getTransactionsInBlocks(const std::vector<size_t> &transactionIds, uint32_t blockIndex, size_t count) const;
+  bool getBlockIndexByHash(const Crypto::Hash &blockHash, uint32_t &blockIndex) const;
+  void addPaymentIdIndexEntry(size_t transactionId);
+  void removePaymentIdIndexEntry(size_t transactionId, const std::string &extra);
+  void addAddressIndexEntry(size_t transactionId, const std::string &address);
+  std::vector<size_t> getTransactionIdsByAddresses(const std::vector<std::string> &addresses) const;
+  void rebuildTransactionIndices();
   Crypto::Hash getBlockHashByIndex(uint32_t blockIndex) const;
 
   std::vector<WalletTransfer> getTransactionTransfers(const WalletTransaction &transaction) const;
@@ -416,6 +437,20 @@ protected:
 
   uint32_t m_transactionSoftLockTime;
 
+  // Transaction ids by payment ID and by spend public key of the transfer addresses, in ascending order.
+  // Not stored, rebuilt on load
+  std::unordered_map<Crypto::Hash, std::vector<size_t>> m_paymentIdTransactions;
+  std::unordered_map<Crypto::PublicKey, std::vector<size_t>> m_addressTransactions;
+
+  // Changes since the last save, appended to the container suffix as journal records
+  std::unordered_set<Crypto::PublicKey> m_journalWallets;
+  std::set<size_t> m_journalTransactions;
+  std::set<size_t> m_journalDeposits;
+  size_t m_journalTransactionCount;
+  size_t m_journalDepositCount;
+  uint64_t m_journalSnapshotSize;
+  bool m_journalCompactionRequired;
+
   BlockHashesContainer m_blockchain;
 };
 
@@ -5,6 +5,11 @@
 // Please read MoonBank/License.md
 
 #include "WalletSerializationV2.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+
 #include "IWallet.h"
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
@@ -155,6 +160,59 @@ void serialize(WalletDepositDtoV2& value, CryptoNote::ISerializer& serializer) {
   serializer(value.address, "address");
 }
 
+CryptoNote::WalletTransaction makeWalletTransaction(const WalletTransactionDtoV2& dto) {
+  CryptoNote::WalletTransaction tx;
+  tx.state = dto.state;
+  tx.timestamp = dto.timestamp;
+  tx.blockHeight = dto.blockHeight;
+  tx.hash = dto.hash;
+  tx.depositCount = dto.depositCount;
+  tx.firstDepositId = dto.firstDepositId;
+  tx.totalAmount = dto.totalAmount;
+  tx.fee = dto.fee;
+  tx.creationTime = dto.creationTime;
+  tx.unlockTime = dto.unlockTime;
+  tx.extra = dto.extra;
+  tx.isBase = dto.isBase;
+  if (dto.secretKey)
+    tx.secretKey = reinterpret_cast<const Crypto::SecretKey&>(dto.secretKey.get());
+
+  return tx;
+}
+
+CryptoNote::Deposit makeDeposit(const WalletDepositDtoV2& dto) {
+  CryptoNote::Deposit dp;
+  dp.creatingTransactionId = dto.creatingTransactionId;
+  dp.spendingTransactionId = dto.spendingTransactionId;
+  dp.term = dto.term;
+  dp.amount = dto.amount;
+  dp.interest = dto.interest;
+  dp.height = dto.height;
+  dp.unlockHeight = dto.unlockHeight;
+  dp.locked = dto.locked;
+  dp.transactionHash = dto.transactionHash;
+  dp.outputInTransaction = dto.outputInTransaction;
+  dp.address = dto.address;
+
+  return dp;
+}
+
+CryptoNote::WalletTransfer makeWalletTransfer(const WalletTransferDtoV2& dto) {
+  CryptoNote::WalletTransfer tr;
+  tr.address = dto.address;
+  tr.amount = dto.amount;
+  tr.type = static_cast<CryptoNote::WalletTransferType>(dto.type);
+
+  return tr;
+}
+
+std::pair<CryptoNote::WalletTransfers::iterator, CryptoNote::WalletTransfers::iterator> transactionTransfersRange(CryptoNote::WalletTransfers& transfers, size_t transactionId) {
+  CryptoNote::TransactionTransferPair val{ transactionId, {} };
+  return std::equal_range(transfers.begin(), transfers.end(), val, [](const CryptoNote::TransactionTransferPair& a, const CryptoNote::TransactionTransferPair& b) {
+    return a.first < b.first;
+  });
+}
+
 }
 
 namespace CryptoNote {
@@ -241,6 +299,232 @@ void WalletSerializerV2::save(Common::IOutputStream& destination, WalletSaveLeve
   s(m_extra, "extra");
 }
 
+void WalletSerializerV2::saveJournalRecord(Common::IOutputStream& destination, const std::unordered_set<Crypto::PublicKey>& walletKeys,
+  const std::set<size_t>& transactionIds, const std::set<size_t>& depositIds) {
+  CryptoNote::BinaryOutputStreamSerializer s(destination);
+
+  auto& walletIndex = m_walletsContainer.get<KeysIndex>();
+  uint64_t changedWalletCount = walletKeys.size();
+  s(changedWalletCount, "changedWalletCount");
+  for (const Crypto::PublicKey& key : walletKeys) {
+    auto it = walletIndex.find(key);
+    assert(it != walletIndex.end());
+
+    WalletRecord wallet = *it;
+    s(wallet.spendPublicKey, "spendPublicKey");
+    s(wallet.actualBalance, "actualBalance");
+    s(wallet.pendingBalance, "pendingBalance");
+    s(wallet.lockedDepositBalance, "lockedDepositBalance");
+    s(wallet.unlockedDepositBalance, "unlockedDepositBalance");
+  }
+
+  auto& transactionIndex = m_transactions.get<RandomAccessIndex>();
+  uint64_t transactionCount = transactionIndex.size();
+  uint64_t changedTransactionCount = transactionIds.size();
+  s(transactionCount, "transactionCount");
+  s(changedTransactionCount, "changedTransactionCount");
+
+  for (size_t id : transactionIds) {
+    assert(id < transactionIndex.size());
+
+    uint64_t txId = id;
+    WalletTransactionDtoV2 dto(transactionIndex[id]);
+    s(txId, "transactionId");
+    s(dto, "transaction");
+
+    auto transfers = transactionTransfersRange(m_transfers, id);
+    uint64_t transferCount = std::distance(transfers.first, transfers.second);
+    s(transferCount, "transferCount");
+    for (auto it = transfers.first; it != transfers.second; ++it) {
+      WalletTransferDtoV2 tr(it->second);
+      s(tr, "transfer");
+    }
+  }
+
+  auto& depositIndex = m_deposits.get<RandomAccessIndex>();
+  uint64_t depositCount = depositIndex.size();
+  uint64_t changedDepositCount = depositIds.size();
+  s(depositCount, "depositCount");
+  s(changedDepositCount, "changedDepositCount");
+
+  for (size_t id : depositIds) {
+    assert(id < depositIndex.size());
+
+    uint64_t depositId = id;
+    WalletDepositDtoV2 dto(depositIndex[id]);
+    s(depositId, "depositId");
+    s(dto, "deposit");
+  }
+
+  std::stringstream synchronizerChanges;
+  m_synchronizer.saveChanges(synchronizerChanges);
+  std::string transfersSynchronizerChanges = synchronizerChanges.str();
+  s(transfersSynchronizerChanges, "transfersSynchronizerChanges");
+
+  saveUnlockTransactionsJobs(s);
+  s(m_uncommitedTransactions, "uncommitedTransactions");
+  s(m_extra, "extra");
+}
+
+void WalletSerializerV2::loadJournalRecord(Common::IInputStream& source) {
+  CryptoNote::BinaryInputStreamSerializer s(source);
+
+  // Keys are never added or removed between a snapshot and its records, only their balances change
+  auto& walletIndex = m_walletsContainer.get<KeysIndex>();
+  uint64_t changedWalletCount = 0;
+  s(changedWalletCount, "changedWalletCount");
+  for (uint64_t i = 0; i < changedWalletCount; ++i) {
+    Crypto::PublicKey spendPublicKey;
+    uint64_t actualBalance;
+    uint64_t pendingBalance;
+    uint64_t lockedDepositBalance;
+    uint64_t unlockedDepositBalance;
+    s(spendPublicKey, "spendPublicKey");
+    s(actualBalance, "actualBalance");
+    s(pendingBalance, "pendingBalance");
+    s(lockedDepositBalance, "lockedDepositBalance");
+    s(unlockedDepositBalance, "unlockedDepositBalance");
+
+    auto it = walletIndex.find(spendPublicKey);
+    if (it == walletIndex.end()) {
+      continue;
+    }
+
+    m_actualBalance += actualBalance - it->actualBalance;
+    m_pendingBalance += pendingBalance - it->pendingBalance;
+    m_lockedDepositBalance += lockedDepositBalance - it->lockedDepositBalance;
+    m_unlockedDepositBalance += unlockedDepositBalance - it->unlockedDepositBalance;
+
+    walletIndex.modify(it, [actualBalance, pendingBalance, lockedDepositBalance, unlockedDepositBalance](WalletRecord& wallet) {
+      wallet.actualBalance = actualBalance;
+      wallet.pendingBalance = pendingBalance;
+      wallet.lockedDepositBalance = lockedDepositBalance;
+      wallet.unlockedDepositBalance = unlockedDepositBalance;
+    });
+  }
+
+  auto& transactionIndex = m_transactions.get<RandomAccessIndex>();
+  uint64_t transactionCount = 0;
+  uint64_t changedTransactionCount = 0;
+  s(transactionCount, "transactionCount");
+  s(changedTransactionCount, "changedTransactionCount");
+
+  size_t lastTransferTransactionId = m_transfers.empty() ? 0 : m_transfers.back().first;
+  bool appendTransfers = true;
+  std::map<size_t, std::vector<WalletTransfer>> updatedTransfers;
+  for (uint64_t i = 0; i < changedTransactionCount; ++i) {
+    uint64_t txId = 0;
+    WalletTransactionDtoV2 dto;
+    s(txId, "transactionId");
+    s(dto, "transaction");
+
+    if (txId < transactionIndex.size()) {
+      if (!transactionIndex.replace(std::next(transactionIndex.begin(), txId), makeWalletTransaction(dto))) {
+        throw std::runtime_error("Wallet journal contains duplicate transaction");
+      }
+    } else if (txId == transactionIndex.size()) {
+      if (!transactionIndex.emplace_back(makeWalletTransaction(dto)).second) {
+        throw std::runtime_error("Wallet journal contains duplicate transaction");
+      }
+    } else {
+      throw std::runtime_error("Wallet journal transaction is out of sequence");
+    }
+
+    uint64_t transferCount = 0;
+    s(transferCount, "transferCount");
+
+    std::vector<WalletTransfer>& transfers = updatedTransfers[txId];
+    transfers.reserve(transferCount);
+    for (uint64_t j = 0; j < transferCount; ++j) {
+      WalletTransferDtoV2 dto;
+      s(dto, "transfer");
+      transfers.emplace_back(makeWalletTransfer(dto));
+    }
+
+    if (!m_transfers.empty() && txId <= lastTransferTransactionId) {
+      appendTransfers = false;
+    }
+  }
+
+  if (transactionIndex.size() != transactionCount) {
+    throw std::runtime_error("Wallet journal transaction count mismatch");
+  }
+
+  if (appendTransfers) {
+    // Usual case: the record only adds transactions newer than every known transfer
+    for (auto& kv : updatedTransfers) {
+      for (auto& tr : kv.second) {
+        m_transfers.emplace_back(kv.first, std::move(tr));
+      }
+    }
+  } else {
+    WalletTransfers transfers;
+    transfers.reserve(m_transfers.size());
+
+    auto updatedIt = updatedTransfers.begin();
+    for (auto& kv : m_transfers) {
+      for (; updatedIt != updatedTransfers.end() && updatedIt->first <= kv.first; ++updatedIt) {
+        for (auto& tr : updatedIt->second) {
+          transfers.emplace_back(updatedIt->first, std::move(tr));
+        }
+      }
+
+      if (updatedTransfers.count(kv.first) == 0) {
+        transfers.emplace_back(std::move(kv));
+      }
+    }
+
+    for (; updatedIt != updatedTransfers.end(); ++updatedIt) {
+      for (auto& tr : updatedIt->second) {
+        transfers.emplace_back(updatedIt->first, std::move(tr));
+      }
+    }
+
+    m_transfers.swap(transfers);
+  }
+
+  auto& depositIndex = m_deposits.get<RandomAccessIndex>();
+  uint64_t depositCount = 0;
+  uint64_t changedDepositCount = 0;
+  s(depositCount, "depositCount");
+  s(changedDepositCount, "changedDepositCount");
+
+  for (uint64_t i = 0; i < changedDepositCount; ++i) {
+    uint64_t depositId = 0;
+    WalletDepositDtoV2 dto;
+    s(depositId, "depositId");
+    s(dto, "deposit");
+
+    if (depositId < depositIndex.size()) {
+      if (!depositIndex.replace(std::next(depositIndex.begin(), depositId), makeDeposit(dto))) {
+        throw std::runtime_error("Wallet journal contains duplicate deposit");
+      }
+    } else if (depositId == depositIndex.size()) {
+      if (!depositIndex.emplace_back(makeDeposit(dto)).second) {
+        throw std::runtime_error("Wallet journal contains duplicate deposit");
+      }
+    } else {
+      throw std::runtime_error("Wallet journal deposit is out of sequence");
+    }
+  }
+
+  if (depositIndex.size() != depositCount) {
+    throw std::runtime_error("Wallet journal deposit count mismatch");
+  }
+
+  std::string transfersSynchronizerChanges;
+  s(transfersSynchronizerChanges, "transfersSynchronizerChanges");
+  std::stringstream synchronizerChanges(transfersSynchronizerChanges);
+  m_synchronizer.loadChanges(synchronizerChanges);
+
+  m_unlockTransactions.clear();
+  loadUnlockTransactionsJobs(s);
+
+  m_uncommitedTransactions.clear();
+  s(m_uncommitedTransactions, "uncommitedTransactions");
+  s(m_extra, "extra");
+}
+
 std::unordered_set<Crypto::PublicKey>& WalletSerializerV2::addedKeys() {
   return m_addedKeys;
 }
@@ -329,23 +613,7 @@ void WalletSerializerV2::loadTransactions(CryptoNote::ISerializer& serializer) {
     WalletTransactionDtoV2 dto;
     serializer(dto, "transaction");
 
-    WalletTransaction tx;
-    tx.state = dto.state;
-    tx.timestamp = dto.timestamp;
-    tx.blockHeight = dto.blockHeight;
-    tx.hash = dto.hash;
-    tx.depositCount = dto.depositCount;
-    tx.firstDepositId = dto.firstDepositId;
-    tx.totalAmount = dto.totalAmount;
-    tx.fee = dto.fee;
-    tx.creationTime = dto.creationTime;
-    tx.unlockTime = dto.unlockTime;
-    tx.extra = dto.extra;
-    tx.isBase = dto.isBase;
-    if (dto.secretKey)
-      tx.secretKey = reinterpret_cast<const Crypto::SecretKey&>(dto.secretKey.get());
-
-    m_transactions.get<RandomAccessIndex>().emplace_back(std::move(tx));
+    m_transactions.get<RandomAccessIndex>().emplace_back(makeWalletTransaction(dto));
   }
 }
 
@@ -359,20 +627,7 @@ void WalletSerializerV2::loadDeposits(CryptoNote::ISerializer& serializer) {
     WalletDepositDtoV2 dto;
     serializer(dto, "deposit");
 
-    Deposit dp;
-    dp.creatingTransactionId = dto.creatingTransactionId;
-    dp.spendingTransactionId = dto.spendingTransactionId;
-    dp.term = dto.term;
-    dp.amount = dto.amount;
-    dp.interest = dto.interest;
-    dp.height = dto.height;
-    dp.unlockHeight = dto.unlockHeight;
-    dp.locked = dto.locked;
-    dp.transactionHash = dto.transactionHash;
-    dp.outputInTransaction = dto.outputInTransaction;
-    dp.address = dto.address;
-
-    m_deposits.get<RandomAccessIndex>().emplace_back(std::move(dp));
+    m_deposits.get<RandomAccessIndex>().emplace_back(makeDeposit(dto));
   }
 }
 
@@ -409,12 +664,7 @@ void WalletSerializerV2::loadTransfers(CryptoNote::ISerializer& serializer) {
     WalletTransferDtoV2 dto;
     serializer(dto, "transfer");
 
-    WalletTransfer tr;
-    tr.address = dto.address;
-    tr.amount = dto.amount;
-    tr.type = static_cast<WalletTransferType>(dto.type);
-
-    m_transfers.emplace_back(std::piecewise_construct, std::forward_as_tuple(txId), std::forward_as_tuple(std::move(tr)));
+    m_transfers.emplace_back(std::piecewise_construct, std::forward_as_tuple(txId), std::forward_as_tuple(makeWalletTransfer(dto)));
   }
 }
 
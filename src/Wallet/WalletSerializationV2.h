@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <set>
+
 #include "Common/IInputStream.h"
 #include "Common/IOutputStream.h"
 #include "Serialization/ISerializer.h"
@@ -39,11 +41,20 @@ public:
   void load(Common::IInputStream& source, uint8_t version);
   void save(Common::IOutputStream& destination, WalletSaveLevel saveLevel);
 
+  // Journal records are appended after a full SAVE_ALL snapshot. A record stores the balances of the given keys, the given
+  // transactions (with their transfers) and deposits and the synchronizer changes since the previous record; the pending
+  // unlock jobs and uncommitted transactions are stored in full
+  void saveJournalRecord(Common::IOutputStream& destination, const std::unordered_set<Crypto::PublicKey>& walletKeys,
+    const std::set<size_t>& transactionIds, const std::set<size_t>& depositIds);
+  void loadJournalRecord(Common::IInputStream& source);
+
   std::unordered_set<Crypto::PublicKey>& addedKeys();
   std::unordered_set<Crypto::PublicKey>& deletedKeys();
 
   static const uint8_t MIN_VERSION = 6;
   static const uint8_t SERIALIZATION_VERSION = 6;
+  // Containers with journal records must not be opened by versions that only read the snapshot
+  static const uint8_t JOURNAL_VERSION = 7;
 
 private:
   void loadKeyListAndBanalces(CryptoNote::ISerializer& serializer, bool saveMoonBank);
@@ -0,0 +1,119 @@
+// Copyright (c) 2011-2017 The Cryptonote developers
+// Copyright (c) 2017-2018 The Circle Foundation & Conceal Devs
+// Copyright (c) 2018-2019 Conceal Network & Conceal Devs
+// Copyright (c) 2020 - The MoonBank Developers
+//
+// Distributed under the GNU Lesser General Public License v3.0.
+// Please read MoonBank/License.md
+
+#include "hash.h"
+
+#include <cstdint>
+
+#include <boost/align/aligned_alloc.hpp>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace Crypto {
+
+namespace {
+
+const size_t HUGE_PAGE_SIZE = 2097152;
+
+static_assert(CN_PAGE_SIZE % HUGE_PAGE_SIZE == 0, "The scratchpad must consist of whole huge pages");
+
+#if defined(__linux__)
+
+// Explicit huge pages, only available when the administrator reserved them with vm.nr_hugepages
+uint8_t* mapHugePages() {
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE;
+#if defined(MAP_HUGE_SHIFT)
+  // Without the size the default one is used, which may be 1 GB
+  flags |= 21 << MAP_HUGE_SHIFT;
+#endif
+  void* mapping = mmap(nullptr, CN_PAGE_SIZE, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return mapping == MAP_FAILED ? nullptr : static_cast<uint8_t*>(mapping);
+}
+
+// A mapping aligned to the huge page size, which the kernel may back with transparent huge pages when asked to
+uint8_t* mapTransparentHugePages() {
+#if defined(MADV_HUGEPAGE)
+  size_t size = CN_PAGE_SIZE + HUGE_PAGE_SIZE;
+  void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+
+  uintptr_t start = reinterpret_cast<uintptr_t>(mapping);
+  uintptr_t alignedStart = (start + HUGE_PAGE_SIZE - 1) & ~static_cast<uintptr_t>(HUGE_PAGE_SIZE - 1);
+  if (alignedStart != start) {
+    munmap(mapping, alignedStart - start);
+  }
+
+  if (alignedStart + CN_PAGE_SIZE != start + size) {
+    munmap(reinterpret_cast<void*>(alignedStart + CN_PAGE_SIZE), start + size - alignedStart - CN_PAGE_SIZE);
+  }
+
+  uint8_t* state = reinterpret_cast<uint8_t*>(alignedStart);
+  if (madvise(state, CN_PAGE_SIZE, MADV_HUGEPAGE) != 0) {
+    munmap(state, CN_PAGE_SIZE);
+    return nullptr;
+  }
+
+  // The pages are touched here so they come from the node of the constructing thread, as huge ones if the kernel can
+  for (size_t offset = 0; offset < CN_PAGE_SIZE; offset += 4096) {
+    state[offset] = 0;
+  }
+
+  return state;
+#else
+  return nullptr;
+#endif
+}
+
+#endif
+
+}
+
+cn_context::cn_context(bool try_huge_pages) : long_state_pages(page_type::normal) {
+#if defined(__linux__)
+  if (try_huge_pages) {
+    long_state = mapHugePages();
+    if (long_state != nullptr) {
+      long_state_pages = page_type::huge;
+    } else {
+      long_state = mapTransparentHugePages();
+      if (long_state != nullptr) {
+        long_state_pages = page_type::transparent_huge;
+      }
+    }
+  }
+#endif
+
+  if (long_state == nullptr) {
+    long_state = (uint8_t*)boost::alignment::aligned_alloc(4096, CN_PAGE_SIZE);
+  }
+
+  hash_state = (uint8_t*)boost::alignment::aligned_alloc(4096, 4096);
+}
+
+cn_context::~cn_context() {
+#if defined(__linux__)
+  if (long_state_pages != page_type::normal) {
+    munmap(long_state, CN_PAGE_SIZE);
+    long_state = nullptr;
+  }
+#endif
+
+  if (long_state != nullptr) {
+    boost::alignment::aligned_free(long_state);
+  }
+
+  if (hash_state != nullptr) {
+    boost::alignment::aligned_free(hash_state);
+  }
+}
+
+}
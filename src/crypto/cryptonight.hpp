@@ -7,7 +7,9 @@
 #include <string.h>
 #include <fenv.h>
 
+extern "C" {
 #include "keccak.h"
+}
 #include "hash.h"
 #include "cn_aux.hpp"
 #include "aux_hash.h"
@@ -10,7 +10,6 @@
 
 #include <CryptoTypes.h>
 #include "generic-ops.h"
-#include <boost/align/aligned_alloc.hpp>
 
 /* Standard Cryptonight */
 #define CN_PAGE_SIZE                    2097152
@@ -42,28 +41,28 @@ namespace Crypto {
     return h;
   }
 
+  // Scratchpad of the CryptoNight variants. Its pages are touched by the constructing thread, so a context belongs on
+  // the thread, and NUMA node, that hashes with it
   class cn_context {
   public:
+    enum class page_type { normal, transparent_huge, huge };
 
-    cn_context()
-    {
-        long_state = (uint8_t*)boost::alignment::aligned_alloc(4096, CN_PAGE_SIZE);
-        hash_state = (uint8_t*)boost::alignment::aligned_alloc(4096, 4096);
-    }
-
-    ~cn_context()
-    {
-        if(long_state != nullptr)
-            boost::alignment::aligned_free(long_state);
-        if(hash_state != nullptr)
-            boost::alignment::aligned_free(hash_state);
-    }
+    // Huge pages keep the random accesses to the scratchpad from missing the TLB. They are a scarce reserve, so only
+    // the contexts hashing for long, like those of the mining threads, try them; the scratchpad falls back to normal
+    // pages when none are available
+    explicit cn_context(bool try_huge_pages = false);
+    ~cn_context();
 
     cn_context(const cn_context &) = delete;
     void operator=(const cn_context &) = delete;
 
+    page_type scratchpad_pages() const { return long_state_pages; }
+
      uint8_t* long_state = nullptr;
      uint8_t* hash_state = nullptr;
+
+  private:
+    page_type long_state_pages;
   };
 
   void cn_slow_hash(cn_context &context, const void *data, size_t length, Hash &hash);
@@ -112,3 +112,66 @@ void keccak1600(const uint8_t *in, int inlen, uint8_t *md)
 {
     keccak(in, inlen, md, sizeof(state_t));
 }
+
+static void keccak1600_absorb(uint64_t st[25], const uint8_t *in)
+{
+    int i;
+    uint64_t w;
+
+    for (i = 0; i < KECCAK1600_RATE / 8; i++) {
+        memcpy(&w, in + 8 * i, sizeof(w));
+        st[i] ^= w;
+    }
+
+    keccakf(st, KECCAK_ROUNDS);
+}
+
+void keccak1600_init(keccak1600_ctx *ctx)
+{
+    memset(ctx->st, 0, sizeof(ctx->st));
+    ctx->bufsize = 0;
+}
+
+void keccak1600_update(keccak1600_ctx *ctx, const uint8_t *in, size_t inlen)
+{
+    size_t n;
+
+    if (ctx->bufsize != 0) {
+        n = KECCAK1600_RATE - ctx->bufsize;
+        if (n > inlen)
+            n = inlen;
+
+        memcpy(ctx->buf + ctx->bufsize, in, n);
+        ctx->bufsize += n;
+        in += n;
+        inlen -= n;
+        if (ctx->bufsize < KECCAK1600_RATE)
+            return;
+
+        keccak1600_absorb(ctx->st, ctx->buf);
+        ctx->bufsize = 0;
+    }
+
+    for ( ; inlen >= KECCAK1600_RATE; inlen -= KECCAK1600_RATE, in += KECCAK1600_RATE)
+        keccak1600_absorb(ctx->st, in);
+
+    memcpy(ctx->buf, in, inlen);
+    ctx->bufsize = inlen;
+}
+
+// the context is left untouched, so more data can still be appended
+void keccak1600_final(const keccak1600_ctx *ctx, uint8_t *md, int mdlen)
+{
+    state_t st;
+    uint8_t temp[KECCAK1600_RATE];
+
+    memcpy(st, ctx->st, sizeof(st));
+    memcpy(temp, ctx->buf, ctx->bufsize);
+    temp[ctx->bufsize] = 1;
+    memset(temp + ctx->bufsize + 1, 0, KECCAK1600_RATE - ctx->bufsize - 1);
+    temp[KECCAK1600_RATE - 1] |= 0x80;
+
+    keccak1600_absorb(st, temp);
+
+    memcpy(md, st, mdlen);
+}
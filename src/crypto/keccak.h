@@ -23,4 +23,17 @@ void keccakf(uint64_t st[25], int norounds);
 
 void keccak1600(const uint8_t *in, int inlen, uint8_t *md);
 
+// incremental form of keccak1600, for input that is produced piece by piece
+#define KECCAK1600_RATE 136
+
+typedef struct {
+    uint64_t st[25];
+    uint8_t buf[KECCAK1600_RATE];
+    size_t bufsize;
+} keccak1600_ctx;
+
+void keccak1600_init(keccak1600_ctx *ctx);
+void keccak1600_update(keccak1600_ctx *ctx, const uint8_t *in, size_t inlen);
+void keccak1600_final(const keccak1600_ctx *ctx, uint8_t *md, int mdlen);
+
 #endif